@@ -13,6 +13,11 @@
  *     sweeps; this is multiplied with each entry in the sweep sequence to compute the number of
  *     apply sweeps to use.
  *
+ * The preconditioner is set as a shell preconditioner (for instance, with -pc_type shell or
+ * -sub_pc_type shell). If FVENS is built with BLASTed, the BLASTed preconditioner given by
+ * -blasted_pc_type is used; otherwise, the native block preconditioner given by -native_pc_type
+ * (such as ASYNCILU0 or ASYNCSGS) is used.
+ *
  * \author Aditya Kashi
  * \date 2018-03
  */
@@ -50,7 +55,11 @@ int main(int argc, char *argv[])
 
 	// write a message to stdout about which preconditioner is being used -
 	//  could be useful for reading the Moab log file
+#ifdef USE_BLASTED
 	std::string prec = parsePetscCmd_string("-blasted_pc_type", 10);
+#else
+	std::string prec = parsePetscCmd_string("-native_pc_type", 10);
+#endif
 	std::cout << ">>> Benchmark " << testtype << ", preconditioner " << prec << std::endl;
 
 	if(testtype == "speedup_sweeps")
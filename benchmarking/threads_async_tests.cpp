@@ -17,7 +17,11 @@
 #include "../src/afactory.hpp"
 #include "../src/ameshutils.hpp"
 
+#ifdef USE_BLASTED
 #include <blasted_petsc.h>
+#else
+#include "../src/ashellpc.hpp"
+#endif
 
 #include "threads_async_tests.hpp"
 
@@ -25,8 +29,10 @@ namespace benchmark {
 
 using namespace acfd;
 
+#ifdef USE_BLASTED
 /// Set -blasted_async_sweeps in the default Petsc options database and throws if not successful
 static void set_blasted_sweeps(const int nbswp, const int naswp);
+#endif
 
 StatusCode test_speedup_sweeps(const FlowParserOptions& opts, const int numrepeat, const int numthreads,
 		const std::vector<int>& sweep_seq, const double sweepratio, std::ofstream& outf)
@@ -45,7 +51,8 @@ StatusCode test_speedup_sweeps(const FlowParserOptions& opts, const int numrepea
 	// numerics for main solver
 	const FlowNumericsConfig nconfmain = extract_spatial_numerics_config(opts);
 	// simpler numerics for startup
-	const FlowNumericsConfig nconfstart {opts.invflux, opts.invfluxjac, "NONE", "NONE", false};
+	const FlowNumericsConfig nconfstart {opts.invflux, opts.invfluxjac, "NONE", "NONE", false,
+		opts.residual_engine};
 
 	std::cout << "Setting up main spatial scheme.\n";
 	const Spatial<NVARS> *const prob = create_const_flowSpatialDiscretization(&m, pconf, nconfmain);
@@ -110,15 +117,26 @@ StatusCode test_speedup_sweeps(const FlowParserOptions& opts, const int numrepea
 	// Ask the spatial discretization context to initialize flow variables
 	startprob->initializeUnknowns(u);
 
+	omp_set_num_threads(1);
+
+#ifdef USE_BLASTED
 	// setup BLASTed preconditioning
+	set_blasted_sweeps(1,1);
 	Blasted_data bctx = newBlastedDataContext();
 	ierr = setup_blasted<NVARS>(ksp,u,startprob,bctx); CHKERRQ(ierr);
+#else
+	// setup native preconditioning, with one sweep each for the starting computation
+	BlockSolverConfig bconf;
+	ierr = getBlockSolverConfig(ksp, &bconf); CHKERRQ(ierr);
+	bconf.nbuildsweeps = 1;
+	bconf.napplysweeps = 1;
+	NativeShellPreconditioner<NVARS> startnpc(&m, bconf);
+	ierr = setup_native_shellpc<NVARS>(ksp,u,startprob,startnpc); CHKERRQ(ierr);
+#endif
 
 	std::cout << "\n***\n";
 
 	// starting computation
-	omp_set_num_threads(1);
-	set_blasted_sweeps(1,1);
 	if(opts.usestarter != 0) {
 
 		mfjac.set_spatial(startprob);
@@ -137,10 +155,11 @@ StatusCode test_speedup_sweeps(const FlowParserOptions& opts, const int numrepea
 
 	omp_set_num_threads(1);
 
+	PrecTimingData ptimes;
 	TimingData tdata = run_sweeps(startprob, prob, maintconf, 1, 1, &ksp, u, A, M, 
-			mfjac, mf_flg, bctx);
+			mfjac, mf_flg, ptimes);
 
-	const double prec_basewtime = bctx.factorwalltime + bctx.applywalltime;
+	const double prec_basewtime = ptimes.factorwalltime + ptimes.applywalltime;
 	const int w = 11;
 	
 	if(mpirank == 0) {
@@ -154,7 +173,7 @@ StatusCode test_speedup_sweeps(const FlowParserOptions& opts, const int numrepea
 
 		outf << "#" <<std::setw(w) << 1 
 			<< std::setw(w/2) << 1 << std::setw(w/2) << 1 << std::setw(w) << 1.0
-			<< std::setw(w+5) << bctx.factorcputime + bctx.applycputime
+			<< std::setw(w+5) << ptimes.factorcputime + ptimes.applycputime
 			<< std::setw(w+6) << tdata.total_lin_iters
 			<< std::setw(w+5) << tdata.avg_lin_iters << std::setw(w+1) << tdata.num_timesteps 
 			<< std::setw(w) << (tdata.converged ? 1 : 0) << "\n#---\n";
@@ -174,7 +193,7 @@ StatusCode test_speedup_sweeps(const FlowParserOptions& opts, const int numrepea
 		for(irpt = 0; irpt < numrepeat; irpt++) 
 		{
 			TimingData td = run_sweeps(startprob, prob, maintconf, nswp, naswp, 
-					&ksp, u, A, M, mfjac, mf_flg, bctx);
+					&ksp, u, A, M, mfjac, mf_flg, ptimes);
 
 			tdata.nelem = td.nelem;
 			tdata.num_threads = td.num_threads;
@@ -185,8 +204,8 @@ StatusCode test_speedup_sweeps(const FlowParserOptions& opts, const int numrepea
 			tdata.total_lin_iters += td.total_lin_iters;
 			tdata.num_timesteps += td.num_timesteps;
 			tdata.converged = tdata.converged && td.converged;
-			precwalltime += bctx.factorwalltime + bctx.applywalltime;
-			preccputime += bctx.factorcputime + bctx.applycputime;
+			precwalltime += ptimes.factorwalltime + ptimes.applywalltime;
+			preccputime += ptimes.factorcputime + ptimes.applycputime;
 
 			if(!td.converged) {
 				irpt++;
@@ -232,11 +251,13 @@ StatusCode test_speedup_sweeps(const FlowParserOptions& opts, const int numrepea
 TimingData run_sweeps(const Spatial<NVARS> *const startprob, const Spatial<NVARS> *const prob,
 		const SteadySolverConfig& maintconf, const int nbswps, const int naswps,
 		KSP *ksp, Vec u, Mat A, Mat M, MatrixFreeSpatialJacobian<NVARS>& mfjac, const PetscBool mf_flg,
-		Blasted_data& bctx)
+		PrecTimingData& ptimes)
 {
 	StatusCode ierr = 0;
 
+#ifdef USE_BLASTED
 	set_blasted_sweeps(nbswps,naswps);
+#endif
 
 	std::cout << "Using sweeps " << nbswps << "," << naswps << ".\n";
 
@@ -253,9 +274,20 @@ TimingData run_sweeps(const Spatial<NVARS> *const startprob, const Spatial<NVARS
 	}
 	ierr = KSPSetFromOptions(*ksp); petsc_throw(ierr, "run_sweeps: Couldn't set KSP from options");
 	
-	bctx = newBlastedDataContext();
+#ifdef USE_BLASTED
+	Blasted_data bctx = newBlastedDataContext();
 	ierr = setup_blasted<NVARS>(*ksp,u,startprob,bctx);
 	fvens_throw(ierr, "run_sweeps: Couldn't setup BLASTed");
+#else
+	BlockSolverConfig bconf;
+	ierr = getBlockSolverConfig(*ksp, &bconf);
+	fvens_throw(ierr, "run_sweeps: Couldn't get native preconditioner settings");
+	bconf.nbuildsweeps = nbswps;
+	bconf.napplysweeps = naswps;
+	NativeShellPreconditioner<NVARS> npc(prob->mesh(), bconf);
+	ierr = setup_native_shellpc<NVARS>(*ksp,u,startprob,npc);
+	fvens_throw(ierr, "run_sweeps: Couldn't setup native preconditioner");
+#endif
 
 	// setup nonlinear ODE solver for main solve
 	SteadyBackwardEulerSolver<NVARS>* time 
@@ -270,6 +302,11 @@ TimingData run_sweeps(const Spatial<NVARS> *const startprob, const Spatial<NVARS
 	
 	ierr = time->solve(ut); fvens_throw(ierr, "run_sweeps: Couldn't solve ODE");
 	const TimingData tdata = time->getTimingData();
+#ifdef USE_BLASTED
+	ptimes = {bctx.factorwalltime, bctx.applywalltime, bctx.factorcputime, bctx.applycputime};
+#else
+	ptimes = {npc.factorwalltime, npc.applywalltime, npc.factorcputime, npc.applycputime};
+#endif
 
 	delete time;
 	ierr = VecDestroy(&ut); petsc_throw(ierr, "run_sweeps: Couldn't delete vec");
@@ -277,6 +314,7 @@ TimingData run_sweeps(const Spatial<NVARS> *const startprob, const Spatial<NVARS
 	return tdata;
 }
 
+#ifdef USE_BLASTED
 void set_blasted_sweeps(const int nbswp, const int naswp)
 {
 	// add option
@@ -293,6 +331,7 @@ void set_blasted_sweeps(const int nbswp, const int naswp)
 	fvens_throw(checksweeps[0] != nbswp || checksweeps[1] != naswp, 
 			"Async sweeps not set properly!");
 }
+#endif
 
 }
 
@@ -18,6 +18,14 @@ namespace benchmark {
 
 using namespace acfd;
 
+/// Time taken by the (shell) preconditioner during a run
+struct PrecTimingData {
+	double factorwalltime;       ///< Wall time taken to compute the preconditioner
+	double applywalltime;        ///< Wall time taken to apply the preconditioner
+	double factorcputime;        ///< CPU time taken to compute the preconditioner
+	double applycputime;         ///< CPU time taken to apply the preconditioner
+};
+
 /// Find the dependence of the speed-up from a certain thread-count on the number of async sweeps
 /** Only for implicit solves.
  * Runs a nonlinear solve first with 1 thread and 1 sweep (for reference) and then with as many threads
@@ -38,17 +46,16 @@ StatusCode test_speedup_sweeps(const FlowParserOptions& opts, const int numrepea
 		const std::vector<int>& sweep_seq, const double sweepratio, std::ofstream& outfile);
 
 /// Run a timing test with a specific number of sweeps with a specific number of threads
-/** 
+/** The KSP is re-created, and a new shell preconditioner (BLASTed or native) is set up.
  * \param nbswps Number of build sweeps
  * \para, naswps Number of apply sweeps
- * \param bctx BLASTed data context which is re-constructed and thus initialized to zero before use,
- *   and contains timing data of the preconditioner on exit.
+ * \param ptimes On exit, timing data of the preconditioner during this run
  * \return Performance data for the run
  */
 TimingData run_sweeps(const Spatial<NVARS> *const startprob, const Spatial<NVARS> *const prob,
 		const SteadySolverConfig& maintconf, const int nbswps, const int naswps,
 		KSP *ksp, Vec u, Mat A, Mat M, MatrixFreeSpatialJacobian<NVARS>& mfjac, const PetscBool mf_flg,
-		Blasted_data& bctx);
+		PrecTimingData& ptimes);
 
 }
 
@@ -0,0 +1,288 @@
+/** @file aagglomeration.cpp
+ * @brief Implementation of agglomerated coarse meshes
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <deque>
+#include <algorithm>
+#include "aagglomeration.hpp"
+
+namespace acfd {
+
+AgglomeratedMesh::AgglomeratedMesh(const UMesh2dh *const m, const int periodicmarker)
+	: nelem{m->gnelem()}, nbface{0}
+{
+	area.resize(nelem);
+	finetocoarse.resize(nelem);
+	for(a_int iel = 0; iel < nelem; iel++) {
+		area[iel] = m->garea(iel);
+		finetocoarse[iel] = iel;
+	}
+
+	// boundary faces, except periodic ones
+	for(a_int iface = 0; iface < m->gnbface(); iface++)
+	{
+		if(periodicmarker >= 0 && m->gintfacbtags(iface,0) == periodicmarker)
+			continue;
+		intfac.push_back(m->gintfac(iface,0));
+		intfac.push_back(-1);
+		for(int i = 0; i < 3; i++)
+			facemetric.push_back(m->gfacemetric(iface,i));
+		meshface.push_back(iface);
+		nbface++;
+	}
+
+	// each pair of periodic faces is one interior face, with the normal of the first one
+	for(a_int iface = 0; iface < m->gnbface(); iface++)
+	{
+		if(periodicmarker < 0 || m->gintfacbtags(iface,0) != periodicmarker)
+			continue;
+		const a_int pface = m->gperiodicmap(iface);
+		if(pface < iface)
+			continue;
+		const a_int lelem = m->gintfac(iface,0), relem = m->gintfac(pface,0);
+		const int sign = lelem < relem ? 1 : -1;
+		intfac.push_back(std::min(lelem,relem));
+		intfac.push_back(std::max(lelem,relem));
+		facemetric.push_back(sign*m->gfacemetric(iface,0));
+		facemetric.push_back(sign*m->gfacemetric(iface,1));
+		facemetric.push_back(m->gfacemetric(iface,2));
+	}
+
+	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
+	{
+		intfac.push_back(m->gintfac(iface,0));
+		intfac.push_back(m->gintfac(iface,1));
+		for(int i = 0; i < 3; i++)
+			facemetric.push_back(m->gfacemetric(iface,i));
+	}
+
+	compute_cell_face_map();
+	compute_coarse_fine_map();
+}
+
+AgglomeratedMesh::AgglomeratedMesh(const AgglomeratedMesh *const fine)
+	: nbface{fine->gnbface()}
+{
+	const a_int nfine = fine->gnelem();
+	finetocoarse.assign(nfine, -1);
+
+	/* Grow agglomerates from seeds. Seeds are taken first from the boundary cells, then from
+	 * the neighbours of the agglomerates made so far, and finally in order of index.
+	 */
+	std::deque<a_int> seeds;
+	for(a_int iface = 0; iface < fine->gnbface(); iface++)
+		seeds.push_back(fine->gintfac(iface,0));
+
+	std::vector<a_int> aggsize;
+	a_int nextcell = 0;
+	while(true)
+	{
+		a_int seed = -1;
+		while(!seeds.empty() && seed < 0) {
+			if(finetocoarse[seeds.front()] < 0)
+				seed = seeds.front();
+			seeds.pop_front();
+		}
+		if(seed < 0) {
+			while(nextcell < nfine && finetocoarse[nextcell] >= 0)
+				nextcell++;
+			if(nextcell == nfine)
+				break;
+			seed = nextcell;
+		}
+
+		const a_int iagg = static_cast<a_int>(aggsize.size());
+		finetocoarse[seed] = iagg;
+		aggsize.push_back(1);
+		for(a_int i = fine->gcellface_p(seed); i < fine->gcellface_p(seed+1); i++)
+		{
+			const a_int iface = fine->gcellface(i);
+			if(iface < fine->gnbface())
+				continue;
+			const a_int nbr = fine->gintfac(iface, fine->gcellfacesign(i) > 0 ? 1 : 0);
+			if(finetocoarse[nbr] < 0) {
+				finetocoarse[nbr] = iagg;
+				aggsize[iagg]++;
+			}
+		}
+
+		// the cells next to the new agglomerate are the next seeds
+		for(a_int i = fine->gcellface_p(seed); i < fine->gcellface_p(seed+1); i++)
+		{
+			const a_int iface = fine->gcellface(i);
+			if(iface < fine->gnbface())
+				continue;
+			const a_int nbr = fine->gintfac(iface, fine->gcellfacesign(i) > 0 ? 1 : 0);
+			if(finetocoarse[nbr] != iagg)
+				continue;
+			for(a_int j = fine->gcellface_p(nbr); j < fine->gcellface_p(nbr+1); j++)
+			{
+				const a_int jface = fine->gcellface(j);
+				if(jface < fine->gnbface())
+					continue;
+				const a_int nbr2 = fine->gintfac(jface, fine->gcellfacesign(j) > 0 ? 1 : 0);
+				if(finetocoarse[nbr2] < 0)
+					seeds.push_back(nbr2);
+			}
+		}
+	}
+
+	// merge lone cells into the neighbouring agglomerate sharing the longest face with them
+	for(a_int icell = 0; icell < nfine; icell++)
+	{
+		const a_int iagg = finetocoarse[icell];
+		if(aggsize[iagg] != 1)
+			continue;
+		a_int bestagg = -1;
+		a_real bestlen = 0;
+		for(a_int i = fine->gcellface_p(icell); i < fine->gcellface_p(icell+1); i++)
+		{
+			const a_int iface = fine->gcellface(i);
+			if(iface < fine->gnbface())
+				continue;
+			const a_int nbr = fine->gintfac(iface, fine->gcellfacesign(i) > 0 ? 1 : 0);
+			if(fine->gfacemetric(iface,2) > bestlen && finetocoarse[nbr] != iagg) {
+				bestlen = fine->gfacemetric(iface,2);
+				bestagg = finetocoarse[nbr];
+			}
+		}
+		if(bestagg >= 0) {
+			finetocoarse[icell] = bestagg;
+			aggsize[iagg] = 0;
+			aggsize[bestagg]++;
+		}
+	}
+
+	// number the remaining agglomerates consecutively
+	std::vector<a_int> newindex(aggsize.size(), -1);
+	nelem = 0;
+	for(size_t iagg = 0; iagg < aggsize.size(); iagg++)
+		if(aggsize[iagg] > 0)
+			newindex[iagg] = nelem++;
+	for(a_int icell = 0; icell < nfine; icell++)
+		finetocoarse[icell] = newindex[finetocoarse[icell]];
+
+	area.assign(nelem, 0);
+	for(a_int icell = 0; icell < nfine; icell++)
+		area[finetocoarse[icell]] += fine->garea(icell);
+
+	// boundary faces are kept as they are
+	for(a_int iface = 0; iface < fine->gnbface(); iface++)
+	{
+		intfac.push_back(finetocoarse[fine->gintfac(iface,0)]);
+		intfac.push_back(-1);
+		for(int i = 0; i < 3; i++)
+			facemetric.push_back(fine->gfacemetric(iface,i));
+		meshface.push_back(fine->gmeshface(iface));
+	}
+
+	/* Interior faces between the same two agglomerates are merged by sorting them by their
+	 * coarse cells and summing their normals, oriented from the lower to the higher index.
+	 * Faces inside an agglomerate are dropped.
+	 */
+	struct FinePiece {
+		a_int left, right;
+		a_real nx, ny;
+		bool operator<(const FinePiece& other) const {
+			return left < other.left || (left == other.left && right < other.right);
+		}
+	};
+	std::vector<FinePiece> pieces;
+	for(a_int iface = fine->gnbface(); iface < fine->gnaface(); iface++)
+	{
+		const a_int lc = finetocoarse[fine->gintfac(iface,0)];
+		const a_int rc = finetocoarse[fine->gintfac(iface,1)];
+		if(lc == rc)
+			continue;
+		const a_real sign = lc < rc ? 1.0 : -1.0;
+		const a_real len = fine->gfacemetric(iface,2);
+		pieces.push_back({std::min(lc,rc), std::max(lc,rc),
+				sign*len*fine->gfacemetric(iface,0), sign*len*fine->gfacemetric(iface,1)});
+	}
+	std::stable_sort(pieces.begin(), pieces.end());
+
+	for(size_t i = 0; i < pieces.size(); )
+	{
+		a_real nx = 0, ny = 0;
+		size_t j = i;
+		for( ; j < pieces.size() && pieces[j].left == pieces[i].left
+				&& pieces[j].right == pieces[i].right; j++)
+		{
+			nx += pieces[j].nx;
+			ny += pieces[j].ny;
+		}
+
+		const a_real len = std::sqrt(nx*nx + ny*ny);
+		if(len > 0) {
+			intfac.push_back(pieces[i].left);
+			intfac.push_back(pieces[i].right);
+			facemetric.push_back(nx/len);
+			facemetric.push_back(ny/len);
+			facemetric.push_back(len);
+		}
+		i = j;
+	}
+
+	compute_cell_face_map();
+	compute_coarse_fine_map();
+}
+
+void AgglomeratedMesh::compute_cell_face_map()
+{
+	const a_int naface = gnaface();
+	cellface_p.assign(nelem+1, 0);
+	for(a_int iface = 0; iface < naface; iface++) {
+		cellface_p[intfac[2*iface]+1]++;
+		if(iface >= nbface)
+			cellface_p[intfac[2*iface+1]+1]++;
+	}
+	for(a_int iel = 0; iel < nelem; iel++)
+		cellface_p[iel+1] += cellface_p[iel];
+
+	cellface.resize(cellface_p[nelem]);
+	cellfacesign.resize(cellface_p[nelem]);
+	std::vector<a_int> pos(cellface_p.begin(), cellface_p.end()-1);
+	for(a_int iface = 0; iface < naface; iface++) {
+		const a_int lelem = intfac[2*iface];
+		cellface[pos[lelem]] = iface;
+		cellfacesign[pos[lelem]++] = 1;
+		if(iface >= nbface) {
+			const a_int relem = intfac[2*iface+1];
+			cellface[pos[relem]] = iface;
+			cellfacesign[pos[relem]++] = -1;
+		}
+	}
+}
+
+void AgglomeratedMesh::compute_coarse_fine_map()
+{
+	const a_int nfine = gnfineelem();
+	coarsetofine_p.assign(nelem+1, 0);
+	for(a_int icell = 0; icell < nfine; icell++)
+		coarsetofine_p[finetocoarse[icell]+1]++;
+	for(a_int iel = 0; iel < nelem; iel++)
+		coarsetofine_p[iel+1] += coarsetofine_p[iel];
+
+	coarsetofine.resize(nfine);
+	std::vector<a_int> pos(coarsetofine_p.begin(), coarsetofine_p.end()-1);
+	for(a_int icell = 0; icell < nfine; icell++)
+		coarsetofine[pos[finetocoarse[icell]]++] = icell;
+}
+
+}
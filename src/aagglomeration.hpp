@@ -0,0 +1,124 @@
+/** @file aagglomeration.hpp
+ * @brief Coarse meshes made by agglomerating the cells of a finer mesh, for multigrid
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AAGGLOMERATION_H
+#define AAGGLOMERATION_H
+
+#include <vector>
+#include "amesh2dh.hpp"
+
+namespace acfd {
+
+/// A mesh of cells, each of which is a set of cells of a finer mesh
+/** Only what a first-order finite volume discretization needs is stored: the measure of each
+ * cell and, for each face, the cells on either side and the (integrated) face normal.
+ * Like in \ref UMesh2dh, boundary faces come first, then interior faces; the normal points
+ * from the left cell to the right cell, and the left cell has the lower index.
+ *
+ * An interior face is the union of all faces of the finer mesh between two agglomerates; its
+ * normal is the sum of the normals of those faces, weighted by their lengths. Boundary faces
+ * are not merged, so that each one corresponds to a boundary face of the original mesh and
+ * boundary conditions can be imposed as they are on the original mesh.
+ */
+class AgglomeratedMesh
+{
+public:
+	/// Sets up a mesh in which each cell of the original mesh is an agglomerate by itself
+	/** This is the finest level of an agglomeration hierarchy.
+	 * \param m The original mesh, with topological and face data computed
+	 * \param periodicmarker Boundary marker of periodic boundaries, or -1 if there are none;
+	 *   the two faces of a periodic pair become one interior face
+	 */
+	AgglomeratedMesh(const UMesh2dh *const m, const int periodicmarker);
+
+	/// Agglomerates the cells of a finer mesh
+	/** Agglomerates are grown from seed cells, starting at the boundaries and advancing into
+	 * the interior. Each one consists of the seed and its neighbours which do not belong to
+	 * any agglomerate yet. A seed without such neighbours joins the neighbouring agglomerate
+	 * which it shares the longest face with.
+	 */
+	AgglomeratedMesh(const AgglomeratedMesh *const fine);
+
+	/// Returns the number of cells
+	a_int gnelem() const { return nelem; }
+
+	/// Returns the number of boundary faces
+	a_int gnbface() const { return nbface; }
+
+	/// Returns the total number of faces, boundary and interior
+	a_int gnaface() const { return static_cast<a_int>(intfac.size()/2); }
+
+	/// Returns the measure of a cell
+	a_real garea(const a_int ielem) const { return area[ielem]; }
+
+	/// Returns the left (0) or right (1) cell of a face; the right cell of a boundary face is -1
+	a_int gintfac(const a_int iface, const int i) const { return intfac[2*iface+i]; }
+
+	/// Returns the components of the unit normal (0 and 1) or the length (2) of a face
+	a_real gfacemetric(const a_int iface, const int i) const { return facemetric[3*iface+i]; }
+
+	/// Returns the index in the original mesh of a boundary face
+	a_int gmeshface(const a_int iface) const { return meshface[iface]; }
+
+	/// Returns the index for \ref gcellface at which the list of faces of a cell starts
+	a_int gcellface_p(const a_int ielem) const { return cellface_p[ielem]; }
+
+	/// Returns a face from the cell-to-face adjacency list; to be used with \ref gcellface_p
+	a_int gcellface(const a_int i) const { return cellface[i]; }
+
+	/// Returns +1 if the cell is the left cell of the corresponding face in \ref gcellface, else -1
+	int gcellfacesign(const a_int i) const { return cellfacesign[i]; }
+
+	/// Returns the number of cells of the finer mesh
+	a_int gnfineelem() const { return static_cast<a_int>(finetocoarse.size()); }
+
+	/// Returns the cell which a cell of the finer mesh belongs to
+	a_int gcoarsecell(const a_int finecell) const { return finetocoarse[finecell]; }
+
+	/// Returns the index for \ref gfinecell at which the list of finer cells in a cell starts
+	a_int gfinecell_p(const a_int ielem) const { return coarsetofine_p[ielem]; }
+
+	/// Returns a cell of the finer mesh from the list of those in each cell; to be used with
+	/// \ref gfinecell_p
+	a_int gfinecell(const a_int i) const { return coarsetofine[i]; }
+
+protected:
+	a_int nelem;                            ///< Number of cells
+	a_int nbface;                           ///< Number of boundary faces
+	std::vector<a_real> area;               ///< Measure of each cell
+	std::vector<a_int> intfac;              ///< Left and right cells of each face
+	std::vector<a_real> facemetric;         ///< Unit normal and length of each face
+	std::vector<a_int> meshface;            ///< Original mesh face of each boundary face
+	std::vector<a_int> cellface_p;          ///< Start of the list of faces of each cell
+	std::vector<a_int> cellface;            ///< Faces of each cell
+	std::vector<int> cellfacesign;          ///< Orientation of each face in \ref cellface
+	/// Cell of this mesh containing each cell of the finer mesh (identity for the finest level)
+	std::vector<a_int> finetocoarse;
+	std::vector<a_int> coarsetofine_p;      ///< Start of the list of finer cells of each cell
+	std::vector<a_int> coarsetofine;        ///< Finer cells of each cell
+
+	/// Computes the cell-to-face adjacency from \ref intfac
+	void compute_cell_face_map();
+
+	/// Computes the lists of finer cells in each cell from \ref finetocoarse
+	void compute_coarse_fine_map();
+};
+
+}
+#endif
@@ -0,0 +1,127 @@
+/** @file ablockmatrix.cpp
+ * @brief Implementation of the block sparse matrix
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include "ablockmatrix.hpp"
+
+namespace acfd {
+
+template <int bs>
+BSRMatrix<bs>::BSRMatrix(const UMesh2dh *const mesh)
+	: m{mesh}, nbr{mesh->gnelem()}
+{
+	// count the blocks in each row: the diagonal block and one for each interior face
+	browptr.assign(nbr+1, 0);
+	for(a_int iel = 0; iel < nbr; iel++)
+		browptr[iel+1] = 1;
+	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++) {
+		browptr[m->gintfac(iface,0)+1]++;
+		browptr[m->gintfac(iface,1)+1]++;
+	}
+	for(a_int iel = 0; iel < nbr; iel++)
+		browptr[iel+1] += browptr[iel];
+
+	bcolind.resize(browptr[nbr]);
+	std::vector<a_int> pos(browptr.begin(), browptr.end()-1);
+	for(a_int iel = 0; iel < nbr; iel++)
+		bcolind[pos[iel]++] = iel;
+	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++) {
+		const a_int lelem = m->gintfac(iface,0), relem = m->gintfac(iface,1);
+		bcolind[pos[lelem]++] = relem;
+		bcolind[pos[relem]++] = lelem;
+	}
+	for(a_int iel = 0; iel < nbr; iel++)
+		std::sort(bcolind.begin()+browptr[iel], bcolind.begin()+browptr[iel+1]);
+
+	auto findBlock = [this](const a_int i, const a_int j) {
+		const auto it = std::lower_bound(bcolind.begin()+browptr[i], bcolind.begin()+browptr[i+1],j);
+		assert(it != bcolind.begin()+browptr[i+1] && *it == j);
+		return static_cast<a_int>(it-bcolind.begin());
+	};
+
+	diagind.resize(nbr);
+	locs.diag.resize(nbr);
+	for(a_int iel = 0; iel < nbr; iel++) {
+		diagind[iel] = findBlock(iel,iel);
+		locs.diag[iel] = diagind[iel];
+	}
+	locs.lower.assign(m->gnaface(), -1);
+	locs.upper.assign(m->gnaface(), -1);
+	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++) {
+		const a_int lelem = m->gintfac(iface,0), relem = m->gintfac(iface,1);
+		locs.lower[iface] = findBlock(relem,lelem);
+		locs.upper[iface] = findBlock(lelem,relem);
+	}
+
+	vals.assign(static_cast<size_t>(browptr[nbr])*bs*bs, 0);
+}
+
+template <int bs>
+StatusCode BSRMatrix<bs>::copyFrom(Mat A)
+{
+	StatusCode ierr = 0;
+	const JacobianBlockLocations *alocs;
+	ierr = getJacobianBlockLocations(A, &alocs); CHKERRQ(ierr);
+	if(!alocs)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONG, "Matrix does not have block locations!");
+	assert(static_cast<a_int>(alocs->diag.size()) == nbr);
+
+	PetscScalar *avals;
+	ierr = getJacobianBlockValues(A, &avals); CHKERRQ(ierr);
+
+	// both matrices store blocks column-major
+#pragma omp parallel default(shared)
+	{
+#pragma omp for
+		for(a_int iel = 0; iel < nbr; iel++)
+			std::copy(avals + alocs->diag[iel]*bs*bs, avals + (alocs->diag[iel]+1)*bs*bs,
+					&vals[locs.diag[iel]*bs*bs]);
+
+#pragma omp for
+		for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++) {
+			std::copy(avals + alocs->lower[iface]*bs*bs, avals + (alocs->lower[iface]+1)*bs*bs,
+					&vals[locs.lower[iface]*bs*bs]);
+			std::copy(avals + alocs->upper[iface]*bs*bs, avals + (alocs->upper[iface]+1)*bs*bs,
+					&vals[locs.upper[iface]*bs*bs]);
+		}
+	}
+
+	ierr = restoreJacobianBlockValues(A, &avals); CHKERRQ(ierr);
+	return ierr;
+}
+
+template <int bs>
+void BSRMatrix<bs>::apply(const a_real *const x, a_real *const y) const
+{
+#pragma omp parallel for default(shared)
+	for(a_int irow = 0; irow < nbr; irow++)
+	{
+		Matrix<a_real,bs,1> yr = Matrix<a_real,bs,1>::Zero();
+		for(a_int jj = browptr[irow]; jj < browptr[irow+1]; jj++)
+			yr.noalias() += ConstBlockMap<bs>(&vals[jj*bs*bs])
+				* ConstSegmentMap<bs>(x + bcolind[jj]*bs);
+		SegmentMap<bs>(y + irow*bs) = yr;
+	}
+}
+
+template class BSRMatrix<NVARS>;
+template class BSRMatrix<1>;
+
+}
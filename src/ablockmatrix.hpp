@@ -0,0 +1,123 @@
+/** @file ablockmatrix.hpp
+ * @brief A thread-parallel sparse matrix of small dense blocks
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ABLOCKMATRIX_H
+#define ABLOCKMATRIX_H
+
+#include <vector>
+#include "aconstants.hpp"
+#include "amesh2dh.hpp"
+#include "alinalg.hpp"
+
+namespace acfd {
+
+/// Type of a (column-major) block of a \ref BSRMatrix
+template <int bs>
+using BlockMap = Eigen::Map<Matrix<a_real,bs,bs,ColMajor>>;
+/// Type of a read-only block of a \ref BSRMatrix
+template <int bs>
+using ConstBlockMap = Eigen::Map<const Matrix<a_real,bs,bs,ColMajor>>;
+/// Type of a block stored in some floating-point type, eg., in single precision by preconditioners
+template <int bs, typename scalar>
+using StoredBlockMap = Eigen::Map<Matrix<scalar,bs,bs,ColMajor>>;
+/// Type of a read-only block stored in some floating-point type
+template <int bs, typename scalar>
+using ConstStoredBlockMap = Eigen::Map<const Matrix<scalar,bs,bs,ColMajor>>;
+/// Type of the segment of a vector corresponding to one block row
+template <int bs>
+using SegmentMap = Eigen::Map<Matrix<a_real,bs,1>>;
+/// Type of the read-only segment of a vector corresponding to one block row
+template <int bs>
+using ConstSegmentMap = Eigen::Map<const Matrix<a_real,bs,1>>;
+
+/// A linear operator on vectors made of one block of bs entries per cell
+/** This is what the native Krylov solvers need from the system matrix.
+ */
+template <int bs>
+class BlockOperator
+{
+public:
+	virtual ~BlockOperator() { }
+
+	/// Computes y = A x
+	virtual void apply(const a_real *const x, a_real *const y) const = 0;
+};
+
+/// Sparse matrix with square dense blocks in block compressed sparse row (BSR) storage
+/** The non-zero structure is that of the Jacobian of a cell-centred finite volume discretization:
+ * each block row corresponds to a cell, and has the diagonal block and one block for each
+ * neighbouring cell, in increasing order of column index. This is the structure that
+ * \ref setJacobianPreallocation sets for PETSc BAIJ matrices.
+ * Blocks are stored column-major like those of BAIJ matrices.
+ *
+ * The blocks are multiplied using fixed-size Eigen kernels, which are unrolled and vectorized
+ * for the block size. Products with vectors are parallelized over block rows with OpenMP.
+ */
+template <int bs>
+class BSRMatrix : public BlockOperator<bs>
+{
+public:
+	/// Sets the non-zero structure from the mesh and allocates the (zero) values
+	BSRMatrix(const UMesh2dh *const mesh);
+
+	/// Number of block rows (and block columns)
+	a_int nbrows() const { return nbr; }
+
+	/// Number of non-zero blocks
+	a_int nnzb() const { return browptr[nbr]; }
+
+	/// Start of each block row in \ref colInd; has \ref nbrows + 1 entries
+	const a_int *rowPtr() const { return &browptr[0]; }
+
+	/// Block column index of each non-zero block
+	const a_int *colInd() const { return &bcolind[0]; }
+
+	/// Location of the diagonal block of each block row
+	const a_int *diagInd() const { return &diagind[0]; }
+
+	/// Locations of the blocks corresponding to the cells and faces of the mesh
+	const JacobianBlockLocations& blockLocations() const { return locs; }
+
+	/// Values of the non-zero blocks; block k starts at index k*bs*bs
+	a_real *values() { return &vals[0]; }
+	const a_real *values() const { return &vals[0]; }
+
+	/// Copies the values of a PETSc matrix having \ref JacobianBlockLocations
+	/** The non-zero blocks of this matrix must be among those of the PETSc matrix, as is the
+	 * case for matrices set up by \ref setupSystemMatrix on the same mesh. Blocks of matrices
+	 * preallocated for a wider stencil which couple cells that are not face neighbours are
+	 * dropped.
+	 */
+	StatusCode copyFrom(Mat A);
+
+	/// Computes y = A x
+	void apply(const a_real *const x, a_real *const y) const;
+
+protected:
+	const UMesh2dh *const m;                ///< The mesh
+	const a_int nbr;                        ///< Number of block rows
+	std::vector<a_int> browptr;             ///< Start of each block row
+	std::vector<a_int> bcolind;             ///< Block column indices
+	std::vector<a_int> diagind;             ///< Locations of the diagonal blocks
+	JacobianBlockLocations locs;            ///< Locations of cell and face blocks
+	std::vector<a_real> vals;               ///< Non-zero values
+};
+
+}
+#endif
@@ -0,0 +1,657 @@
+/** @file ablockprecond.cpp
+ * @brief Implementation of preconditioners for block sparse matrices
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <Eigen/LU>
+#include "ablockprecond.hpp"
+#include "ameshutils.hpp"
+
+namespace acfd {
+
+template <int bs>
+StatusCode NoBlockPreconditioner<bs>::compute(const BSRMatrix<bs>& A)
+{
+	nbr = A.nbrows();
+	return 0;
+}
+
+template <int bs>
+void NoBlockPreconditioner<bs>::apply(const a_real *const r, a_real *const z) const
+{
+#pragma omp parallel for simd default(shared)
+	for(a_int i = 0; i < nbr*bs; i++)
+		z[i] = r[i];
+}
+
+template <int bs>
+BlockRowRefresh<bs>::BlockRowRefresh(const a_real tolerance)
+	: tol{tolerance}, refreshfrac{1.0}
+{ }
+
+template <int bs>
+void BlockRowRefresh<bs>::detect(const BSRMatrix<bs>& A, const bool diagonalonly)
+{
+	const a_int nbr = A.nbrows();
+	const size_t nvals = static_cast<size_t>(A.nnzb())*bs*bs;
+	if(tol <= 0 || oldvals.size() != nvals) {
+		refresh.assign(nbr, 1);
+		return;
+	}
+
+	const a_int *const rowp = A.rowPtr();
+	const a_int *const diagind = A.diagInd();
+	const a_real *const vals = A.values();
+
+#pragma omp parallel for default(shared)
+	for(a_int irow = 0; irow < nbr; irow++)
+	{
+		const a_int start = diagonalonly ? diagind[irow] : rowp[irow];
+		const a_int end = diagonalonly ? diagind[irow]+1 : rowp[irow+1];
+		char changed = 0;
+		for(a_int jj = start; jj < end && !changed; jj++) {
+			const ConstBlockMap<bs> oldblock(&oldvals[jj*bs*bs]);
+			const ConstBlockMap<bs> newblock(vals + jj*bs*bs);
+			changed = (newblock - oldblock).norm() > tol*oldblock.norm();
+		}
+		refresh[irow] = changed;
+	}
+}
+
+template <int bs>
+void BlockRowRefresh<bs>::accept(const BSRMatrix<bs>& A)
+{
+	const a_int nbr = A.nbrows();
+	a_int nrefresh = 0;
+	if(tol > 0)
+	{
+		oldvals.resize(static_cast<size_t>(A.nnzb())*bs*bs);
+		const a_int *const rowp = A.rowPtr();
+		const a_real *const vals = A.values();
+
+#pragma omp parallel for default(shared) reduction(+:nrefresh)
+		for(a_int irow = 0; irow < nbr; irow++)
+			if(refresh[irow]) {
+				std::copy(vals + rowp[irow]*bs*bs, vals + rowp[irow+1]*bs*bs,
+						&oldvals[rowp[irow]*bs*bs]);
+				nrefresh++;
+			}
+	}
+	else
+		nrefresh = nbr;
+
+	refreshfrac = static_cast<a_real>(nrefresh)/nbr;
+}
+
+template <int bs, typename scalar>
+BlockJacobiPreconditioner<bs,scalar>::BlockJacobiPreconditioner(const a_real refreshtol)
+	: refresher(refreshtol)
+{ }
+
+template <int bs, typename scalar>
+StatusCode BlockJacobiPreconditioner<bs,scalar>::compute(const BSRMatrix<bs>& A)
+{
+	nbr = A.nbrows();
+	dinv.resize(static_cast<size_t>(nbr)*bs*bs);
+	const a_real *const vals = A.values();
+	const a_int *const diagind = A.diagInd();
+	refresher.detect(A, true);
+
+#pragma omp parallel for default(shared)
+	for(a_int irow = 0; irow < nbr; irow++) 
+		if(refresher.needed(irow)) {
+			StoredBlockMap<bs,scalar> d(&dinv[irow*bs*bs]);
+			d = ConstBlockMap<bs>(vals + diagind[irow]*bs*bs).inverse().template cast<scalar>();
+		}
+
+	refresher.accept(A);
+	return 0;
+}
+
+template <int bs, typename scalar>
+void BlockJacobiPreconditioner<bs,scalar>::apply(const a_real *const r, a_real *const z) const
+{
+#pragma omp parallel for default(shared)
+	for(a_int irow = 0; irow < nbr; irow++)
+		SegmentMap<bs>(z + irow*bs) = (ConstStoredBlockMap<bs,scalar>(&dinv[irow*bs*bs])
+			* ConstSegmentMap<bs>(r + irow*bs).template cast<scalar>()).template cast<a_real>();
+}
+
+template <int bs, typename scalar>
+LevelScheduledPreconditioner<bs,scalar>::LevelScheduledPreconditioner(const UMesh2dh *const mesh)
+	: mat{nullptr}
+{
+	triangularLevelSchedule(*mesh, levelptr, levelcells);
+}
+
+template <int bs, typename scalar>
+BlockILU0Preconditioner<bs,scalar>::BlockILU0Preconditioner(const UMesh2dh *const mesh,
+		const a_real refreshtol)
+	: LevelScheduledPreconditioner<bs,scalar>(mesh), refresher(refreshtol)
+{ }
+
+/** For each row i, in level order, and each k < i in the row:
+ * \f$ L_{ik} = A_{ik} U_{kk}^{-1} \f$ and \f$ A_{ij} \leftarrow A_{ij} - L_{ik} U_{kj} \f$
+ * for j > k in both rows i and k. Row i only reads rows in earlier levels, so whether those
+ * have been factored again is known by the time row i is reached.
+ */
+template <int bs, typename scalar>
+StatusCode BlockILU0Preconditioner<bs,scalar>::compute(const BSRMatrix<bs>& A)
+{
+	mat = &A;
+	const a_int *const rowp = A.rowPtr();
+	const a_int *const colind = A.colInd();
+	const a_int *const diagind = A.diagInd();
+	const a_real *const vals = A.values();
+	iluvals.resize(static_cast<size_t>(A.nnzb())*bs*bs);
+	dinv.resize(static_cast<size_t>(A.nbrows())*bs*bs);
+	refresher.detect(A, false);
+
+#pragma omp parallel default(shared)
+	for(a_int ilevel = 0; ilevel < static_cast<a_int>(levelptr.size())-1; ilevel++)
+	{
+#pragma omp for
+		for(a_int ic = levelptr[ilevel]; ic < levelptr[ilevel+1]; ic++)
+		{
+			const a_int irow = levelcells[ic];
+			if(!refresher.needed(irow)) {
+				for(a_int jj = rowp[irow]; jj < diagind[irow]; jj++)
+					if(refresher.needed(colind[jj])) {
+						refresher.require(irow);
+						break;
+					}
+				if(!refresher.needed(irow))
+					continue;
+			}
+
+			std::copy(vals + rowp[irow]*bs*bs, vals + rowp[irow+1]*bs*bs,
+					&iluvals[rowp[irow]*bs*bs]);
+
+			for(a_int jj = rowp[irow]; jj < diagind[irow]; jj++)
+			{
+				const a_int krow = colind[jj];
+				StoredBlockMap<bs,scalar> lik(&iluvals[jj*bs*bs]);
+				lik = lik * ConstStoredBlockMap<bs,scalar>(&dinv[krow*bs*bs]);
+
+				// both rows are sorted, so walk them together
+				a_int kk = diagind[krow]+1;
+				for(a_int ll = jj+1; ll < rowp[irow+1] && kk < rowp[krow+1]; ) {
+					if(colind[ll] == colind[kk]) {
+						StoredBlockMap<bs,scalar> aij(&iluvals[ll*bs*bs]);
+						aij.noalias() -= lik * ConstStoredBlockMap<bs,scalar>(&iluvals[kk*bs*bs]);
+						ll++; kk++;
+					}
+					else if(colind[ll] < colind[kk])
+						ll++;
+					else
+						kk++;
+				}
+			}
+
+			// the pivots are inverted in double precision
+			StoredBlockMap<bs,scalar> d(&dinv[irow*bs*bs]);
+			d = ConstStoredBlockMap<bs,scalar>(&iluvals[diagind[irow]*bs*bs])
+				.template cast<a_real>().inverse().template cast<scalar>();
+		}
+	}
+
+	refresher.accept(A);
+	return 0;
+}
+
+template <int bs, typename scalar>
+void BlockILU0Preconditioner<bs,scalar>::apply(const a_real *const r, a_real *const z) const
+{
+	const a_int *const rowp = mat->rowPtr();
+	const a_int *const colind = mat->colInd();
+	const a_int *const diagind = mat->diagInd();
+	const a_int nlevels = static_cast<a_int>(levelptr.size())-1;
+
+#pragma omp parallel default(shared)
+	{
+		// forward solve L y = r, with y stored in z
+		for(a_int ilevel = 0; ilevel < nlevels; ilevel++)
+		{
+#pragma omp for
+			for(a_int ic = levelptr[ilevel]; ic < levelptr[ilevel+1]; ic++)
+			{
+				const a_int irow = levelcells[ic];
+				Matrix<scalar,bs,1> sum = Matrix<scalar,bs,1>::Zero();
+				for(a_int jj = rowp[irow]; jj < diagind[irow]; jj++)
+					sum.noalias() += ConstStoredBlockMap<bs,scalar>(&iluvals[jj*bs*bs])
+						* ConstSegmentMap<bs>(z + colind[jj]*bs).template cast<scalar>();
+				SegmentMap<bs>(z + irow*bs) = ConstSegmentMap<bs>(r + irow*bs)
+					- sum.template cast<a_real>();
+			}
+		}
+
+		// backward solve U z = y in place
+		for(a_int ilevel = nlevels-1; ilevel >= 0; ilevel--)
+		{
+#pragma omp for
+			for(a_int ic = levelptr[ilevel]; ic < levelptr[ilevel+1]; ic++)
+			{
+				const a_int irow = levelcells[ic];
+				Matrix<scalar,bs,1> sum = Matrix<scalar,bs,1>::Zero();
+				for(a_int jj = diagind[irow]+1; jj < rowp[irow+1]; jj++)
+					sum.noalias() += ConstStoredBlockMap<bs,scalar>(&iluvals[jj*bs*bs])
+						* ConstSegmentMap<bs>(z + colind[jj]*bs).template cast<scalar>();
+				const Matrix<a_real,bs,1> yi = ConstSegmentMap<bs>(z + irow*bs)
+					- sum.template cast<a_real>();
+				SegmentMap<bs>(z + irow*bs) = (ConstStoredBlockMap<bs,scalar>(&dinv[irow*bs*bs])
+					* yi.template cast<scalar>()).template cast<a_real>();
+			}
+		}
+	}
+}
+
+template <int bs>
+BlockSGSPreconditioner<bs>::BlockSGSPreconditioner(const UMesh2dh *const mesh)
+	: LevelScheduledPreconditioner<bs>(mesh)
+{ }
+
+template <int bs>
+StatusCode BlockSGSPreconditioner<bs>::compute(const BSRMatrix<bs>& A)
+{
+	mat = &A;
+	dinv.resize(static_cast<size_t>(A.nbrows())*bs*bs);
+	const a_real *const vals = A.values();
+	const a_int *const diagind = A.diagInd();
+
+#pragma omp parallel for default(shared)
+	for(a_int irow = 0; irow < A.nbrows(); irow++) {
+		BlockMap<bs> d(&dinv[irow*bs*bs]);
+		d = ConstBlockMap<bs>(vals + diagind[irow]*bs*bs).inverse();
+	}
+
+	return 0;
+}
+
+template <int bs>
+void BlockSGSPreconditioner<bs>::apply(const a_real *const r, a_real *const z) const
+{
+	const a_int *const rowp = mat->rowPtr();
+	const a_int *const colind = mat->colInd();
+	const a_int *const diagind = mat->diagInd();
+	const a_real *const vals = mat->values();
+	const a_int nlevels = static_cast<a_int>(levelptr.size())-1;
+
+#pragma omp parallel default(shared)
+	{
+		// forward sweep (D+L) y = r, with y stored in z
+		for(a_int ilevel = 0; ilevel < nlevels; ilevel++)
+		{
+#pragma omp for
+			for(a_int ic = levelptr[ilevel]; ic < levelptr[ilevel+1]; ic++)
+			{
+				const a_int irow = levelcells[ic];
+				Matrix<a_real,bs,1> yi = ConstSegmentMap<bs>(r + irow*bs);
+				for(a_int jj = rowp[irow]; jj < diagind[irow]; jj++)
+					yi.noalias() -= ConstBlockMap<bs>(vals + jj*bs*bs)
+						* ConstSegmentMap<bs>(z + colind[jj]*bs);
+				SegmentMap<bs>(z + irow*bs).noalias() = ConstBlockMap<bs>(&dinv[irow*bs*bs]) * yi;
+			}
+		}
+
+		// backward sweep (D+U) z = D y in place
+		for(a_int ilevel = nlevels-1; ilevel >= 0; ilevel--)
+		{
+#pragma omp for
+			for(a_int ic = levelptr[ilevel]; ic < levelptr[ilevel+1]; ic++)
+			{
+				const a_int irow = levelcells[ic];
+				Matrix<a_real,bs,1> ui = Matrix<a_real,bs,1>::Zero();
+				for(a_int jj = diagind[irow]+1; jj < rowp[irow+1]; jj++)
+					ui.noalias() += ConstBlockMap<bs>(vals + jj*bs*bs)
+						* ConstSegmentMap<bs>(z + colind[jj]*bs);
+				SegmentMap<bs>(z + irow*bs).noalias() -= ConstBlockMap<bs>(&dinv[irow*bs*bs]) * ui;
+			}
+		}
+	}
+}
+
+template <int bs>
+BlockLinePreconditioner<bs>::BlockLinePreconditioner(const UMesh2dh *const mesh,
+		const a_real anisotropy)
+	: mat{nullptr}
+{
+	implicitLines(*mesh, anisotropy, lineptr, linecells);
+}
+
+template <int bs>
+a_real BlockLinePreconditioner<bs>::lineFraction() const
+{
+	a_int ninlines = 0;
+	for(a_int iline = 0; iline < nlines(); iline++)
+		if(lineptr[iline+1]-lineptr[iline] > 1)
+			ninlines += lineptr[iline+1]-lineptr[iline];
+	return static_cast<a_real>(ninlines)/linecells.size();
+}
+
+/** For a line with diagonal blocks D, blocks L coupling each cell to the previous one and blocks
+ * U coupling each cell to the next one, the pivots are \f$ S_0 = D_0 \f$ and
+ * \f$ S_p = D_p - L_p S_{p-1}^{-1} U_{p-1} \f$.
+ */
+template <int bs>
+StatusCode BlockLinePreconditioner<bs>::compute(const BSRMatrix<bs>& A)
+{
+	const a_int *const rowp = A.rowPtr();
+	const a_int *const colind = A.colInd();
+	const a_int *const diagind = A.diagInd();
+	const a_real *const vals = A.values();
+	const a_int ncells = static_cast<a_int>(linecells.size());
+
+	// the matrices all have the non-zero structure of the mesh, so the blocks are located once
+	mat = &A;
+	if(lowerloc.empty())
+	{
+		lowerloc.assign(ncells, -1);
+		upperloc.assign(ncells, -1);
+		dinv.resize(static_cast<size_t>(ncells)*bs*bs);
+		upper.resize(static_cast<size_t>(ncells)*bs*bs);
+
+#pragma omp parallel for default(shared)
+		for(a_int iline = 0; iline < nlines(); iline++)
+			for(a_int ic = lineptr[iline]; ic < lineptr[iline+1]; ic++)
+			{
+				const a_int irow = linecells[ic];
+				for(a_int jj = rowp[irow]; jj < rowp[irow+1]; jj++) {
+					if(ic > lineptr[iline] && colind[jj] == linecells[ic-1])
+						lowerloc[ic] = jj;
+					if(ic < lineptr[iline+1]-1 && colind[jj] == linecells[ic+1])
+						upperloc[ic] = jj;
+				}
+			}
+	}
+
+#pragma omp parallel for default(shared) schedule(dynamic,64)
+	for(a_int iline = 0; iline < nlines(); iline++)
+		for(a_int ic = lineptr[iline]; ic < lineptr[iline+1]; ic++)
+		{
+			Matrix<a_real,bs,bs> pivot = ConstBlockMap<bs>(vals + diagind[linecells[ic]]*bs*bs);
+			if(ic > lineptr[iline])
+				pivot.noalias() -= ConstBlockMap<bs>(vals + lowerloc[ic]*bs*bs)
+					* ConstBlockMap<bs>(&upper[(ic-1)*bs*bs]);
+
+			BlockMap<bs> d(&dinv[ic*bs*bs]);
+			d = pivot.inverse();
+			if(ic < lineptr[iline+1]-1) {
+				BlockMap<bs> u(&upper[ic*bs*bs]);
+				u.noalias() = d * ConstBlockMap<bs>(vals + upperloc[ic]*bs*bs);
+			}
+		}
+
+	return 0;
+}
+
+template <int bs>
+void BlockLinePreconditioner<bs>::apply(const a_real *const r, a_real *const z) const
+{
+	const a_real *const vals = mat->values();
+
+#pragma omp parallel for default(shared) schedule(dynamic,64)
+	for(a_int iline = 0; iline < nlines(); iline++)
+	{
+		// forward elimination, with the intermediate vector stored in z
+		for(a_int ic = lineptr[iline]; ic < lineptr[iline+1]; ic++)
+		{
+			const a_int irow = linecells[ic];
+			Matrix<a_real,bs,1> yi = ConstSegmentMap<bs>(r + irow*bs);
+			if(ic > lineptr[iline])
+				yi.noalias() -= ConstBlockMap<bs>(vals + lowerloc[ic]*bs*bs)
+					* ConstSegmentMap<bs>(z + linecells[ic-1]*bs);
+			SegmentMap<bs>(z + irow*bs).noalias() = ConstBlockMap<bs>(&dinv[ic*bs*bs]) * yi;
+		}
+
+		// back substitution
+		for(a_int ic = lineptr[iline+1]-2; ic >= lineptr[iline]; ic--)
+			SegmentMap<bs>(z + linecells[ic]*bs).noalias() -= ConstBlockMap<bs>(&upper[ic*bs*bs])
+				* ConstSegmentMap<bs>(z + linecells[ic+1]*bs);
+	}
+}
+
+template <int bs>
+AsyncBlockPreconditioner<bs>::AsyncBlockPreconditioner(const int nbuildsweeps,
+		const int napplysweeps)
+	: nbuildswps{nbuildsweeps}, napplyswps{napplysweeps}, mat{nullptr}
+{ }
+
+template <int bs>
+AsyncBlockILU0Preconditioner<bs>::AsyncBlockILU0Preconditioner(const int nbuildsweeps,
+		const int napplysweeps)
+	: AsyncBlockPreconditioner<bs>(nbuildsweeps, napplysweeps)
+{ }
+
+/** In a sweep, each row is updated from left to right, so one sweep in the natural order of the
+ * rows gives the exact ILU(0) factorization.
+ */
+template <int bs>
+StatusCode AsyncBlockILU0Preconditioner<bs>::compute(const BSRMatrix<bs>& A)
+{
+	mat = &A;
+	const a_int nbr = A.nbrows();
+	const a_int *const rowp = A.rowPtr();
+	const a_int *const colind = A.colInd();
+	const a_int *const diagind = A.diagInd();
+	const a_real *const vals = A.values();
+	iluvals.assign(vals, vals + static_cast<size_t>(A.nnzb())*bs*bs);
+	dinv.resize(static_cast<size_t>(nbr)*bs*bs);
+	ytemp.resize(static_cast<size_t>(nbr)*bs);
+
+#pragma omp parallel default(shared)
+	{
+#pragma omp for schedule(static)
+		for(a_int irow = 0; irow < nbr; irow++) {
+			BlockMap<bs> d(&dinv[irow*bs*bs]);
+			d = ConstBlockMap<bs>(vals + diagind[irow]*bs*bs).inverse();
+		}
+
+		for(int isweep = 0; isweep < nbuildswps; isweep++)
+		{
+#pragma omp for schedule(static) nowait
+			for(a_int irow = 0; irow < nbr; irow++)
+			{
+				for(a_int jj = rowp[irow]; jj < rowp[irow+1]; jj++)
+				{
+					const a_int jcol = colind[jj];
+					Matrix<a_real,bs,bs> sum = ConstBlockMap<bs>(vals + jj*bs*bs);
+
+					// subtract L_ik U_kj for all k < min(i,j) in row i which have a block (k,j)
+					for(a_int ll = rowp[irow]; ll < diagind[irow] && colind[ll] < jcol; ll++)
+					{
+						const a_int krow = colind[ll];
+						a_int kk = diagind[krow]+1;
+						while(kk < rowp[krow+1] && colind[kk] < jcol)
+							kk++;
+						if(kk < rowp[krow+1] && colind[kk] == jcol)
+							sum.noalias() -= ConstBlockMap<bs>(&iluvals[ll*bs*bs])
+								* ConstBlockMap<bs>(&iluvals[kk*bs*bs]);
+					}
+
+					BlockMap<bs> lu(&iluvals[jj*bs*bs]);
+					if(jcol < irow)
+						lu.noalias() = sum * ConstBlockMap<bs>(&dinv[jcol*bs*bs]);
+					else {
+						lu = sum;
+						if(jcol == irow) {
+							BlockMap<bs> d(&dinv[irow*bs*bs]);
+							d = sum.inverse();
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+template <int bs>
+void AsyncBlockILU0Preconditioner<bs>::apply(const a_real *const r, a_real *const z) const
+{
+	const a_int nbr = mat->nbrows();
+	const a_int *const rowp = mat->rowPtr();
+	const a_int *const colind = mat->colInd();
+	const a_int *const diagind = mat->diagInd();
+	a_real *const y = &ytemp[0];
+
+#pragma omp parallel default(shared)
+	{
+#pragma omp for simd schedule(static)
+		for(a_int i = 0; i < nbr*bs; i++) {
+			y[i] = r[i];
+			z[i] = 0;
+		}
+
+		// forward sweeps for L y = r
+		for(int isweep = 0; isweep < napplyswps; isweep++)
+		{
+#pragma omp for schedule(static) nowait
+			for(a_int irow = 0; irow < nbr; irow++)
+			{
+				Matrix<a_real,bs,1> yi = ConstSegmentMap<bs>(r + irow*bs);
+				for(a_int jj = rowp[irow]; jj < diagind[irow]; jj++)
+					yi.noalias() -= ConstBlockMap<bs>(&iluvals[jj*bs*bs])
+						* ConstSegmentMap<bs>(y + colind[jj]*bs);
+				SegmentMap<bs>(y + irow*bs) = yi;
+			}
+		}
+
+#pragma omp barrier
+
+		// backward sweeps for U z = y, going up the rows
+		for(int isweep = 0; isweep < napplyswps; isweep++)
+		{
+#pragma omp for schedule(static) nowait
+			for(a_int i = 0; i < nbr; i++)
+			{
+				const a_int irow = nbr-1-i;
+				Matrix<a_real,bs,1> yi = ConstSegmentMap<bs>(y + irow*bs);
+				for(a_int jj = diagind[irow]+1; jj < rowp[irow+1]; jj++)
+					yi.noalias() -= ConstBlockMap<bs>(&iluvals[jj*bs*bs])
+						* ConstSegmentMap<bs>(z + colind[jj]*bs);
+				SegmentMap<bs>(z + irow*bs).noalias() = ConstBlockMap<bs>(&dinv[irow*bs*bs]) * yi;
+			}
+		}
+	}
+}
+
+template <int bs>
+AsyncBlockSGSPreconditioner<bs>::AsyncBlockSGSPreconditioner(const int nbuildsweeps,
+		const int napplysweeps)
+	: AsyncBlockPreconditioner<bs>(nbuildsweeps, napplysweeps)
+{ }
+
+template <int bs>
+StatusCode AsyncBlockSGSPreconditioner<bs>::compute(const BSRMatrix<bs>& A)
+{
+	mat = &A;
+	dinv.resize(static_cast<size_t>(A.nbrows())*bs*bs);
+	ytemp.resize(static_cast<size_t>(A.nbrows())*bs);
+	const a_real *const vals = A.values();
+	const a_int *const diagind = A.diagInd();
+
+#pragma omp parallel for default(shared)
+	for(a_int irow = 0; irow < A.nbrows(); irow++) {
+		BlockMap<bs> d(&dinv[irow*bs*bs]);
+		d = ConstBlockMap<bs>(vals + diagind[irow]*bs*bs).inverse();
+	}
+
+	return 0;
+}
+
+template <int bs>
+void AsyncBlockSGSPreconditioner<bs>::apply(const a_real *const r, a_real *const z) const
+{
+	const a_int nbr = mat->nbrows();
+	const a_int *const rowp = mat->rowPtr();
+	const a_int *const colind = mat->colInd();
+	const a_int *const diagind = mat->diagInd();
+	const a_real *const vals = mat->values();
+	a_real *const y = &ytemp[0];
+
+#pragma omp parallel default(shared)
+	{
+#pragma omp for simd schedule(static)
+		for(a_int i = 0; i < nbr*bs; i++) {
+			y[i] = 0;
+			z[i] = 0;
+		}
+
+		// forward sweeps for (D+L) y = r
+		for(int isweep = 0; isweep < napplyswps; isweep++)
+		{
+#pragma omp for schedule(static) nowait
+			for(a_int irow = 0; irow < nbr; irow++)
+			{
+				Matrix<a_real,bs,1> yi = ConstSegmentMap<bs>(r + irow*bs);
+				for(a_int jj = rowp[irow]; jj < diagind[irow]; jj++)
+					yi.noalias() -= ConstBlockMap<bs>(vals + jj*bs*bs)
+						* ConstSegmentMap<bs>(y + colind[jj]*bs);
+				SegmentMap<bs>(y + irow*bs).noalias() = ConstBlockMap<bs>(&dinv[irow*bs*bs]) * yi;
+			}
+		}
+
+#pragma omp barrier
+
+		// backward sweeps for (D+U) z = D y, going up the rows
+		for(int isweep = 0; isweep < napplyswps; isweep++)
+		{
+#pragma omp for schedule(static) nowait
+			for(a_int i = 0; i < nbr; i++)
+			{
+				const a_int irow = nbr-1-i;
+				Matrix<a_real,bs,1> ui = Matrix<a_real,bs,1>::Zero();
+				for(a_int jj = diagind[irow]+1; jj < rowp[irow+1]; jj++)
+					ui.noalias() += ConstBlockMap<bs>(vals + jj*bs*bs)
+						* ConstSegmentMap<bs>(z + colind[jj]*bs);
+				SegmentMap<bs>(z + irow*bs).noalias() = ConstSegmentMap<bs>(y + irow*bs)
+					- ConstBlockMap<bs>(&dinv[irow*bs*bs]) * ui;
+			}
+		}
+	}
+}
+
+template class BlockRowRefresh<NVARS>;
+template class BlockRowRefresh<1>;
+template class NoBlockPreconditioner<NVARS>;
+template class NoBlockPreconditioner<1>;
+template class BlockJacobiPreconditioner<NVARS>;
+template class BlockJacobiPreconditioner<1>;
+template class BlockJacobiPreconditioner<NVARS,float>;
+template class BlockJacobiPreconditioner<1,float>;
+template class LevelScheduledPreconditioner<NVARS>;
+template class LevelScheduledPreconditioner<1>;
+template class LevelScheduledPreconditioner<NVARS,float>;
+template class LevelScheduledPreconditioner<1,float>;
+template class BlockILU0Preconditioner<NVARS>;
+template class BlockILU0Preconditioner<1>;
+template class BlockILU0Preconditioner<NVARS,float>;
+template class BlockILU0Preconditioner<1,float>;
+template class BlockSGSPreconditioner<NVARS>;
+template class BlockSGSPreconditioner<1>;
+template class BlockLinePreconditioner<NVARS>;
+template class BlockLinePreconditioner<1>;
+template class AsyncBlockPreconditioner<NVARS>;
+template class AsyncBlockPreconditioner<1>;
+template class AsyncBlockILU0Preconditioner<NVARS>;
+template class AsyncBlockILU0Preconditioner<1>;
+template class AsyncBlockSGSPreconditioner<NVARS>;
+template class AsyncBlockSGSPreconditioner<1>;
+
+}
@@ -0,0 +1,323 @@
+/** @file ablockprecond.hpp
+ * @brief Preconditioners for the native block sparse linear solvers
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ABLOCKPRECOND_H
+#define ABLOCKPRECOND_H
+
+#include "ablockmatrix.hpp"
+
+namespace acfd {
+
+/// Interface for preconditioners of \ref BSRMatrix systems
+template <int bs>
+class BlockPreconditioner
+{
+public:
+	virtual ~BlockPreconditioner() { }
+
+	/// Computes the preconditioner from the current values of a matrix
+	/** The matrix must stay alive, with the same structure, while the preconditioner is used.
+	 */
+	virtual StatusCode compute(const BSRMatrix<bs>& A) = 0;
+
+	/// Applies the preconditioner: z = P^{-1} r
+	virtual void apply(const a_real *const r, a_real *const z) const = 0;
+
+	/// Fraction of the block rows of the preconditioner which the latest \ref compute computed
+	/** This is less than one only for preconditioners which are refreshed incrementally.
+	 */
+	virtual a_real refreshedFraction() const { return 1.0; }
+
+	/// Number of bytes taken by the blocks stored by the preconditioner itself
+	/** This does not count the matrix, even if the preconditioner reads its blocks.
+	 */
+	virtual size_t storageBytes() const { return 0; }
+};
+
+/// Decides which block rows of a preconditioner need to be computed again for a new matrix
+/** A block row needs to be computed again if any of its blocks differs from the block used the
+ * last time the row was computed by more than a tolerance, relative to the Frobenius norm of the
+ * old block. The first time, or if the tolerance is not positive, all rows are computed.
+ */
+template <int bs>
+class BlockRowRefresh
+{
+public:
+	/// Sets the relative tolerance on the change in blocks
+	BlockRowRefresh(const a_real tolerance);
+
+	/// Marks the block rows of a matrix which have changed too much to be reused
+	/** \param diagonalonly If true, only the diagonal blocks are compared
+	 */
+	void detect(const BSRMatrix<bs>& A, const bool diagonalonly);
+
+	/// Whether a block row is to be computed again
+	bool needed(const a_int irow) const { return refresh[irow]; }
+
+	/// Marks a block row to be computed again, eg., because it depends on a row which is
+	void require(const a_int irow) { refresh[irow] = 1; }
+
+	/// Stores the blocks of the rows which are computed again, for comparison next time
+	void accept(const BSRMatrix<bs>& A);
+
+	/// Fraction of block rows marked to be computed again
+	a_real fraction() const { return refreshfrac; }
+
+protected:
+	const a_real tol;               ///< Relative tolerance on the change in blocks
+	std::vector<char> refresh;      ///< Flag for each block row, true if it is to be computed
+	std::vector<a_real> oldvals;    ///< Blocks as they were when their rows were last computed
+	a_real refreshfrac;             ///< Fraction of rows marked to be computed again
+};
+
+/// The identity operator
+template <int bs>
+class NoBlockPreconditioner : public BlockPreconditioner<bs>
+{
+public:
+	StatusCode compute(const BSRMatrix<bs>& A);
+	void apply(const a_real *const r, a_real *const z) const;
+
+protected:
+	a_int nbr;                      ///< Number of block rows
+};
+
+/// Block Jacobi preconditioner, which stores the inverse of each diagonal block
+/** The preconditioner can be refreshed incrementally: only the diagonal blocks which changed
+ * by more than a tolerance since they were last inverted are inverted again.
+ *
+ * The inverses are computed in double precision and stored as the type scalar. If that is float,
+ * they take half the memory, and are applied in single precision: each segment of the
+ * (double-precision) vector is rounded to float, multiplied by the block and widened back.
+ */
+template <int bs, typename scalar = a_real>
+class BlockJacobiPreconditioner : public BlockPreconditioner<bs>
+{
+public:
+	/// Sets the tolerance for incremental refreshes
+	/** \param refreshtol Relative change in a block above which it is inverted again;
+	 *   if this is not positive, all blocks are inverted every time
+	 */
+	BlockJacobiPreconditioner(const a_real refreshtol = 0);
+
+	StatusCode compute(const BSRMatrix<bs>& A);
+	void apply(const a_real *const r, a_real *const z) const;
+	a_real refreshedFraction() const { return refresher.fraction(); }
+	size_t storageBytes() const { return dinv.size()*sizeof(scalar); }
+
+protected:
+	a_int nbr;                      ///< Number of block rows
+	std::vector<scalar> dinv;       ///< Inverses of the diagonal blocks, column-major
+	BlockRowRefresh<bs> refresher;  ///< Decides which blocks to invert again
+};
+
+/// Base class for preconditioners which sweep over the cells of the mesh in triangular order
+/** The cells are processed level by level, as given by \ref triangularLevelSchedule. Cells in a
+ * level are processed concurrently by OpenMP threads, and each level starts after the previous
+ * one is done. The result does not depend on the number of threads.
+ * \tparam scalar The floating-point type in which the blocks of the preconditioner are stored
+ */
+template <int bs, typename scalar = a_real>
+class LevelScheduledPreconditioner : public BlockPreconditioner<bs>
+{
+public:
+	/// Computes the level schedule of the mesh
+	LevelScheduledPreconditioner(const UMesh2dh *const mesh);
+
+	/// Number of levels
+	a_int nlevels() const { return static_cast<a_int>(levelptr.size())-1; }
+
+protected:
+	std::vector<a_int> levelptr;    ///< Start of each level in \ref levelcells
+	std::vector<a_int> levelcells;  ///< Cells sorted by level
+	const BSRMatrix<bs> *mat;       ///< The matrix, for its non-zero structure (and values)
+	/// Inverses of the diagonal blocks (of U for ILU), column-major
+	std::vector<scalar> dinv;
+};
+
+/// Block incomplete LU factorization with no fill-in, ILU(0)
+/** The factors L and U have the non-zero structure of the matrix; L has identity diagonal blocks.
+ * Both the factorization and the triangular solves are level-scheduled.
+ *
+ * The factorization can be refreshed incrementally: a block row is factored again only if one of
+ * its blocks changed by more than a tolerance since the row was last factored, or if it depends
+ * on a row (in an earlier level) which is factored again. Other rows keep their old factors.
+ *
+ * The factors are stored as the type scalar. If that is float, the matrix is rounded to single
+ * precision as it is copied in, the factorization is carried out in single precision except for
+ * the inversion of the diagonal blocks. In the triangular solves, which are limited by memory
+ * bandwidth and so read half as many bytes, the products of the off-diagonal blocks in a block
+ * row are summed in single precision, and the sum is widened to double precision once per
+ * block row before it is subtracted from the (double-precision) right hand side.
+ */
+template <int bs, typename scalar = a_real>
+class BlockILU0Preconditioner : public LevelScheduledPreconditioner<bs,scalar>
+{
+public:
+	/// Computes the level schedule and sets the tolerance for incremental refreshes
+	/** \param refreshtol Relative change in a block above which its row is factored again;
+	 *   if this is not positive, the whole matrix is factored every time
+	 */
+	BlockILU0Preconditioner(const UMesh2dh *const mesh, const a_real refreshtol = 0);
+
+	StatusCode compute(const BSRMatrix<bs>& A);
+	void apply(const a_real *const r, a_real *const z) const;
+	a_real refreshedFraction() const { return refresher.fraction(); }
+	size_t storageBytes() const { return (iluvals.size()+dinv.size())*sizeof(scalar); }
+
+protected:
+	using LevelScheduledPreconditioner<bs,scalar>::levelptr;
+	using LevelScheduledPreconditioner<bs,scalar>::levelcells;
+	using LevelScheduledPreconditioner<bs,scalar>::mat;
+	using LevelScheduledPreconditioner<bs,scalar>::dinv;
+
+	std::vector<scalar> iluvals;    ///< Blocks of L (strictly lower part) and U, column-major
+	BlockRowRefresh<bs> refresher;  ///< Decides which rows to factor again
+};
+
+/// Block symmetric Gauss-Seidel preconditioner
+/** Applies \f$ (D+U)^{-1} D (D+L)^{-1} \f$ where D, L and U are the block diagonal, the strictly
+ * lower and the strictly upper parts of the matrix. The sweeps are level-scheduled.
+ */
+template <int bs>
+class BlockSGSPreconditioner : public LevelScheduledPreconditioner<bs>
+{
+public:
+	BlockSGSPreconditioner(const UMesh2dh *const mesh);
+	StatusCode compute(const BSRMatrix<bs>& A);
+	void apply(const a_real *const r, a_real *const z) const;
+	size_t storageBytes() const { return dinv.size()*sizeof(a_real); }
+
+protected:
+	using LevelScheduledPreconditioner<bs>::levelptr;
+	using LevelScheduledPreconditioner<bs>::levelcells;
+	using LevelScheduledPreconditioner<bs>::mat;
+	using LevelScheduledPreconditioner<bs>::dinv;
+};
+
+/// Line-implicit block Jacobi preconditioner
+/** The cells are divided into lines by \ref implicitLines. The block tridiagonal part of the
+ * matrix along each line is factored by the block Thomas algorithm, and the couplings between
+ * different lines are ignored. Lines are processed concurrently by OpenMP threads.
+ * For cells not in any line of more than one cell, this is the same as block Jacobi.
+ */
+template <int bs>
+class BlockLinePreconditioner : public BlockPreconditioner<bs>
+{
+public:
+	/// Extracts the lines of the mesh
+	/** \param anisotropy Minimum anisotropy of cells in lines, see \ref implicitLines
+	 */
+	BlockLinePreconditioner(const UMesh2dh *const mesh, const a_real anisotropy);
+
+	StatusCode compute(const BSRMatrix<bs>& A);
+	void apply(const a_real *const r, a_real *const z) const;
+	size_t storageBytes() const { return (dinv.size()+upper.size())*sizeof(a_real); }
+
+	/// Number of lines, including those of one cell
+	a_int nlines() const { return static_cast<a_int>(lineptr.size())-1; }
+
+	/// Fraction of cells which are in lines of more than one cell
+	a_real lineFraction() const;
+
+protected:
+	std::vector<a_int> lineptr;     ///< Start of each line in \ref linecells
+	std::vector<a_int> linecells;   ///< Cells in order along each line
+	/// Location in the matrix of the block coupling each entry of \ref linecells to the previous
+	/// cell in its line, and of the block coupling it to the next cell; -1 at the ends of lines
+	std::vector<a_int> lowerloc, upperloc;
+	const BSRMatrix<bs> *mat;       ///< The matrix, for the blocks coupling cells in a line
+	/// Inverses of the pivot blocks of the Thomas algorithm, in the order of \ref linecells
+	std::vector<a_real> dinv;
+	/// The pivot inverse times the block coupling each cell to the next one in its line
+	std::vector<a_real> upper;
+};
+
+/// Base class for asynchronous (chaotic) preconditioners
+/** The triangular factors are computed and applied by fixed-point sweeps over the block rows.
+ * Rows are divided among OpenMP threads statically, and threads go through their sweeps without
+ * waiting for each other; a thread uses whatever values the other threads have written by then.
+ * With one thread and one sweep, the result is that of the corresponding sequential method.
+ */
+template <int bs>
+class AsyncBlockPreconditioner : public BlockPreconditioner<bs>
+{
+public:
+	/// Sets the number of sweeps
+	/** \param nbuildsweeps Number of sweeps used to compute the preconditioner
+	 * \param napplysweeps Number of sweeps used for each triangular solve
+	 */
+	AsyncBlockPreconditioner(const int nbuildsweeps, const int napplysweeps);
+
+protected:
+	const int nbuildswps;           ///< Number of build sweeps
+	const int napplyswps;           ///< Number of apply sweeps
+	const BSRMatrix<bs> *mat;       ///< The matrix, for its non-zero structure (and values)
+	/// Inverses of the diagonal blocks (of U for ILU), column-major
+	std::vector<a_real> dinv;
+	/// Intermediate vector between the lower and upper triangular solves
+	mutable std::vector<a_real> ytemp;
+};
+
+/// Asynchronous block ILU(0)
+/** The factorization is computed by the fixed-point iteration of Chow and Patel,
+ * \f$ L_{ij} = (A_{ij} - \sum_{k<j} L_{ik} U_{kj}) U_{jj}^{-1} \f$ for j < i and
+ * \f$ U_{ij} = A_{ij} - \sum_{k<i} L_{ik} U_{kj} \f$ for j >= i, starting from L = A = U,
+ * and the triangular solves are done by block Jacobi-Gauss-Seidel sweeps.
+ */
+template <int bs>
+class AsyncBlockILU0Preconditioner : public AsyncBlockPreconditioner<bs>
+{
+public:
+	AsyncBlockILU0Preconditioner(const int nbuildsweeps, const int napplysweeps);
+	StatusCode compute(const BSRMatrix<bs>& A);
+	void apply(const a_real *const r, a_real *const z) const;
+	size_t storageBytes() const { return (iluvals.size()+dinv.size())*sizeof(a_real); }
+
+protected:
+	using AsyncBlockPreconditioner<bs>::nbuildswps;
+	using AsyncBlockPreconditioner<bs>::napplyswps;
+	using AsyncBlockPreconditioner<bs>::mat;
+	using AsyncBlockPreconditioner<bs>::dinv;
+	using AsyncBlockPreconditioner<bs>::ytemp;
+
+	std::vector<a_real> iluvals;    ///< Blocks of L (strictly lower part) and U, column-major
+};
+
+/// Asynchronous block symmetric Gauss-Seidel
+/** Only the inverses of the diagonal blocks are computed, so the number of build sweeps is unused.
+ */
+template <int bs>
+class AsyncBlockSGSPreconditioner : public AsyncBlockPreconditioner<bs>
+{
+public:
+	AsyncBlockSGSPreconditioner(const int nbuildsweeps, const int napplysweeps);
+	StatusCode compute(const BSRMatrix<bs>& A);
+	void apply(const a_real *const r, a_real *const z) const;
+	size_t storageBytes() const { return dinv.size()*sizeof(a_real); }
+
+protected:
+	using AsyncBlockPreconditioner<bs>::napplyswps;
+	using AsyncBlockPreconditioner<bs>::mat;
+	using AsyncBlockPreconditioner<bs>::dinv;
+	using AsyncBlockPreconditioner<bs>::ytemp;
+};
+
+}
+#endif
@@ -30,6 +30,8 @@
 
 /// Number of quadrature points in each face
 #define NGAUSS 1
+/// Number of faces whose numerical fluxes are computed together in batched flux computations
+#define FLUX_BATCH_SIZE 8
 
 #ifndef MESHDATA_DOUBLE_PRECISION
 #define MESHDATA_DOUBLE_PRECISION 20
@@ -0,0 +1,127 @@
+/** @file adual.hpp
+ * @brief Forward-mode dual numbers for exact directional derivatives of the residual
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADUAL_H
+#define ADUAL_H
+
+#include <cmath>
+#include "aconstants.hpp"
+
+namespace acfd {
+
+/// A real number carrying its derivative along one direction
+/** Arithmetic on dual numbers propagates the derivative by the chain rule, so a kernel
+ * templated on the scalar type and evaluated with dual inputs \f$ u + \epsilon x \f$ gives
+ * both its value and the exact directional derivative \f$ f'(u) x \f$ in one sweep.
+ *
+ * Comparisons only look at the value, so branches (upwinding, limiters, entropy fixes) are
+ * taken exactly as in the real-valued kernel and the derivative is that of the branch taken.
+ *
+ * The mathematical functions are friends defined in the class, so they are found only by
+ * argument-dependent lookup. Templated kernels should therefore call them unqualified, eg.
+ * `sqrt(x)` rather than `std::sqrt(x)`; for a_real arguments the usual functions are used.
+ */
+class Dual
+{
+public:
+	/// Value
+	a_real val;
+	/// Directional derivative
+	a_real der;
+
+	/// A constant, whose derivative is zero
+	Dual(const a_real value = 0) : val{value}, der{0}
+	{ }
+
+	Dual(const a_real value, const a_real derivative) : val{value}, der{derivative}
+	{ }
+
+	Dual& operator+=(const Dual& b) { val += b.val; der += b.der; return *this; }
+	Dual& operator-=(const Dual& b) { val -= b.val; der -= b.der; return *this; }
+	Dual& operator*=(const Dual& b) { der = der*b.val + val*b.der; val *= b.val; return *this; }
+	Dual& operator/=(const Dual& b) {
+		der = (der*b.val - val*b.der)/(b.val*b.val); val /= b.val; return *this;
+	}
+
+	Dual& operator+=(const a_real b) { val += b; return *this; }
+	Dual& operator-=(const a_real b) { val -= b; return *this; }
+	Dual& operator*=(const a_real b) { val *= b; der *= b; return *this; }
+	Dual& operator/=(const a_real b) { val /= b; der /= b; return *this; }
+
+	friend Dual operator-(const Dual& a) { return Dual(-a.val, -a.der); }
+	friend Dual operator+(const Dual& a) { return a; }
+
+	friend Dual operator+(const Dual& a, const Dual& b) { return Dual(a.val+b.val, a.der+b.der); }
+	friend Dual operator+(const Dual& a, const a_real b) { return Dual(a.val+b, a.der); }
+	friend Dual operator+(const a_real a, const Dual& b) { return Dual(a+b.val, b.der); }
+
+	friend Dual operator-(const Dual& a, const Dual& b) { return Dual(a.val-b.val, a.der-b.der); }
+	friend Dual operator-(const Dual& a, const a_real b) { return Dual(a.val-b, a.der); }
+	friend Dual operator-(const a_real a, const Dual& b) { return Dual(a-b.val, -b.der); }
+
+	friend Dual operator*(const Dual& a, const Dual& b) {
+		return Dual(a.val*b.val, a.der*b.val + a.val*b.der);
+	}
+	friend Dual operator*(const Dual& a, const a_real b) { return Dual(a.val*b, a.der*b); }
+	friend Dual operator*(const a_real a, const Dual& b) { return Dual(a*b.val, a*b.der); }
+
+	friend Dual operator/(const Dual& a, const Dual& b) {
+		return Dual(a.val/b.val, (a.der*b.val - a.val*b.der)/(b.val*b.val));
+	}
+	friend Dual operator/(const Dual& a, const a_real b) { return Dual(a.val/b, a.der/b); }
+	friend Dual operator/(const a_real a, const Dual& b) {
+		return Dual(a/b.val, -a*b.der/(b.val*b.val));
+	}
+
+	friend bool operator<(const Dual& a, const Dual& b) { return a.val < b.val; }
+	friend bool operator<(const Dual& a, const a_real b) { return a.val < b; }
+	friend bool operator<(const a_real a, const Dual& b) { return a < b.val; }
+	friend bool operator>(const Dual& a, const Dual& b) { return a.val > b.val; }
+	friend bool operator>(const Dual& a, const a_real b) { return a.val > b; }
+	friend bool operator>(const a_real a, const Dual& b) { return a > b.val; }
+	friend bool operator<=(const Dual& a, const Dual& b) { return a.val <= b.val; }
+	friend bool operator<=(const Dual& a, const a_real b) { return a.val <= b; }
+	friend bool operator<=(const a_real a, const Dual& b) { return a <= b.val; }
+	friend bool operator>=(const Dual& a, const Dual& b) { return a.val >= b.val; }
+	friend bool operator>=(const Dual& a, const a_real b) { return a.val >= b; }
+	friend bool operator>=(const a_real a, const Dual& b) { return a >= b.val; }
+
+	friend Dual sqrt(const Dual& a) {
+		const a_real s = std::sqrt(a.val);
+		return Dual(s, 0.5*a.der/s);
+	}
+
+	/// The derivative at zero is taken to be zero, like the Jacobian routines do
+	friend Dual fabs(const Dual& a) {
+		return a.val < 0 ? Dual(-a.val, -a.der) : Dual(a.val, a.val > 0 ? a.der : 0);
+	}
+
+	friend Dual pow(const Dual& a, const a_real e) {
+		const a_real pm1 = std::pow(a.val, e-1.0);
+		return Dual(pm1*a.val, e*pm1*a.der);
+	}
+};
+
+/// Value part of a scalar; the identity for real numbers
+inline a_real value(const a_real a) { return a; }
+/// Value part of a scalar
+inline a_real value(const Dual& a) { return a.val; }
+
+}
+#endif
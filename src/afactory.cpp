@@ -177,6 +177,24 @@ Spatial<NVARS>* create_mutable_flowSpatialDiscretization(
 	const FlowPhysicsConfig& pconf,
 	const FlowNumericsConfig& nconf)
 {
+	Spatial<NVARS> *prob = nullptr;
+	if(nconf.order2)
+		if(pconf.const_visc)
+			prob = create_static_flowfv<true,true>(m, pconf, nconf);
+		else
+			prob = create_static_flowfv<true,false>(m, pconf, nconf);
+	else
+		if(pconf.const_visc)
+			prob = create_static_flowfv<false,true>(m, pconf, nconf);
+		else
+			prob = create_static_flowfv<false,false>(m, pconf, nconf);
+
+	if(prob) {
+		std::cout << " FlowSpatialFactory: Using a residual specialized for the chosen schemes.\n";
+		return prob;
+	}
+
+	// fall back to calling the schemes through virtual functions
 	if(nconf.order2)
 		if(pconf.const_visc)
 			return new FlowFV<true,true>(m, pconf, nconf);
@@ -197,4 +215,107 @@ const Spatial<NVARS>* create_const_flowSpatialDiscretization(
 	return create_mutable_flowSpatialDiscretization(m, pconf, nconf);
 }
 
+template <int bs>
+BlockPreconditioner<bs>* create_blockpreconditioner(const std::string& type,
+		const UMesh2dh *const m, const int nbuildsweeps, const int napplysweeps,
+		const a_real refreshtol, const a_real lineanisotropy, const bool singleprec)
+{
+	BlockPreconditioner<bs> *prec = nullptr;
+	if(singleprec && type != "JACOBI" && type != "ILU0")
+		std::cout << " BlockPreconditionerFactory: Single-precision storage is only available for"
+			<< " JACOBI and ILU0; using double precision." << std::endl;
+
+	if(type == "NONE")
+		prec = new NoBlockPreconditioner<bs>();
+	else if(type == "JACOBI" && singleprec) {
+		prec = new BlockJacobiPreconditioner<bs,float>(refreshtol);
+		std::cout << " BlockPreconditionerFactory: Using block Jacobi in single precision."
+			<< std::endl;
+	}
+	else if(type == "JACOBI")
+		prec = new BlockJacobiPreconditioner<bs>(refreshtol);
+	else if(type == "ILU0" && singleprec) {
+		BlockILU0Preconditioner<bs,float> *const ilu
+			= new BlockILU0Preconditioner<bs,float>(m, refreshtol);
+		std::cout << " BlockPreconditionerFactory: Using ILU(0) in single precision with "
+			<< ilu->nlevels() << " levels." << std::endl;
+		prec = ilu;
+	}
+	else if(type == "ILU0") {
+		BlockILU0Preconditioner<bs> *const ilu = new BlockILU0Preconditioner<bs>(m, refreshtol);
+		std::cout << " BlockPreconditionerFactory: Using ILU(0) with " << ilu->nlevels() 
+			<< " levels." << std::endl;
+		prec = ilu;
+	}
+	else if(type == "SGS") {
+		BlockSGSPreconditioner<bs> *const sgs = new BlockSGSPreconditioner<bs>(m);
+		std::cout << " BlockPreconditionerFactory: Using SGS with " << sgs->nlevels() 
+			<< " levels." << std::endl;
+		prec = sgs;
+	}
+	else if(type == "LINE") {
+		BlockLinePreconditioner<bs> *const line
+			= new BlockLinePreconditioner<bs>(m, lineanisotropy);
+		std::cout << " BlockPreconditionerFactory: Using line-implicit Jacobi with " << line->nlines()
+			<< " lines; " << 100*line->lineFraction() << "% of the cells are in lines of more than"
+			<< " one cell." << std::endl;
+		prec = line;
+	}
+	else if(type == "ASYNCILU0") {
+		prec = new AsyncBlockILU0Preconditioner<bs>(nbuildsweeps, napplysweeps);
+		std::cout << " BlockPreconditionerFactory: Using asynchronous ILU(0) with " << nbuildsweeps
+			<< " build and " << napplysweeps << " apply sweeps." << std::endl;
+	}
+	else if(type == "ASYNCSGS") {
+		prec = new AsyncBlockSGSPreconditioner<bs>(nbuildsweeps, napplysweeps);
+		std::cout << " BlockPreconditionerFactory: Using asynchronous SGS with " << napplysweeps
+			<< " apply sweeps." << std::endl;
+		if(nbuildsweeps != 1)
+			std::cout << " BlockPreconditionerFactory: Asynchronous SGS only inverts the diagonal"
+				<< " blocks, so the " << nbuildsweeps << " build sweeps requested are ignored."
+				<< std::endl;
+	}
+	else
+		std::cout << " BlockPreconditionerFactory: ! Preconditioner not available!" << std::endl;
+
+	if(refreshtol > 0 && (type == "JACOBI" || type == "ILU0"))
+		std::cout << " BlockPreconditionerFactory: Refreshing the preconditioner incrementally,"
+			<< " with relative tolerance " << refreshtol << "." << std::endl;
+	return prec;
+}
+
+template <int bs>
+BlockKrylovSolver<bs>* create_blocksolver(const BlockSolverConfig& conf, const a_int nbrows)
+{
+	BlockKrylovSolver<bs> *solver = nullptr;
+	if(conf.solver == "GMRES" || conf.solver == "FGMRES") {
+		solver = new BlockGMRES<bs>(conf, nbrows);
+		std::cout << " BlockSolverFactory: Using " << conf.solver << "(" << conf.restart << ")."
+			<< std::endl;
+	}
+	else if(conf.solver == "GCRODR") {
+		solver = new BlockGCRODR<bs>(conf, nbrows);
+		std::cout << " BlockSolverFactory: Using GCRO-DR(" << conf.restart << "," << conf.recycle
+			<< ")." << std::endl;
+	}
+	else if(conf.solver == "BICGSTAB") {
+		solver = new BlockBiCGStab<bs>(conf, nbrows);
+		std::cout << " BlockSolverFactory: Using BiCGStab." << std::endl;
+	}
+	else
+		std::cout << " BlockSolverFactory: ! Solver not available!" << std::endl;
+	return solver;
+}
+
+template BlockPreconditioner<NVARS>* create_blockpreconditioner<NVARS>(const std::string& type,
+		const UMesh2dh *const m, const int nbuildsweeps, const int napplysweeps,
+		const a_real refreshtol, const a_real lineanisotropy, const bool singleprec);
+template BlockPreconditioner<1>* create_blockpreconditioner<1>(const std::string& type,
+		const UMesh2dh *const m, const int nbuildsweeps, const int napplysweeps,
+		const a_real refreshtol, const a_real lineanisotropy, const bool singleprec);
+template BlockKrylovSolver<NVARS>* create_blocksolver<NVARS>(const BlockSolverConfig& conf,
+		const a_int nbrows);
+template BlockKrylovSolver<1>* create_blocksolver<1>(const BlockSolverConfig& conf,
+		const a_int nbrows);
+
 }
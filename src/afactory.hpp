@@ -28,6 +28,7 @@
 #include "agradientschemes.hpp"
 #include "areconstruction.hpp"
 #include "aspatial.hpp"
+#include "akrylov.hpp"
 
 namespace acfd {
 
@@ -59,6 +60,9 @@ const SolutionReconstruction* create_const_reconstruction(const std::string& typ
 
 /// Creates the appropriate flow solver class
 /** This function is needed to instantiate the appropriate class from the \ref FlowFV template.
+ * If the residual was compiled for the flux, gradient scheme and limiter named in nconf,
+ * a \ref FlowFVStatic is returned, which calls them without virtual dispatch;
+ * otherwise, the schemes are called through virtual functions.
  */
 Spatial<NVARS>* create_mutable_flowSpatialDiscretization(
 	const UMesh2dh *const m,                       ///< Mesh context
@@ -73,6 +77,28 @@ const Spatial<NVARS>* create_const_flowSpatialDiscretization(
 	const FlowPhysicsConfig& pconf,                ///< Physical data about the problem
 	const FlowNumericsConfig& nconf);              ///< Options controlling the numerical method
 
+/// Returns a new preconditioner for block sparse matrices, or nullptr if the type is not known
+/** \param type NONE, JACOBI, ILU0, SGS, LINE, ASYNCILU0 or ASYNCSGS
+ * \param m The mesh whose Jacobians are to be preconditioned
+ * \param nbuildsweeps Number of build sweeps, for ASYNCILU0; ASYNCSGS has none
+ * \param napplysweeps Number of apply sweeps, for the asynchronous preconditioners
+ * \param refreshtol Tolerance for incremental refreshes of JACOBI and ILU0; none if zero
+ * \param lineanisotropy Minimum anisotropy of cells in lines, for LINE
+ * \param singleprec Whether JACOBI and ILU0 store their blocks in single precision
+ */
+template <int bs>
+BlockPreconditioner<bs>* create_blockpreconditioner(const std::string& type,
+		const UMesh2dh *const m, const int nbuildsweeps = 1, const int napplysweeps = 1,
+		const a_real refreshtol = 0, const a_real lineanisotropy = 4.0,
+		const bool singleprec = false);
+
+/// Returns a new Krylov solver for block sparse matrices, or nullptr if the type is not known
+/** \param conf Settings of the solver, whose type is GMRES, FGMRES or BICGSTAB
+ * \param nbrows Number of block rows of the matrices to be solved
+ */
+template <int bs>
+BlockKrylovSolver<bs>* create_blocksolver(const BlockSolverConfig& conf, const a_int nbrows);
+
 }
 
 #endif
@@ -65,71 +65,57 @@ void GreenGaussGradients<nvars>::compute_gradients(
 					grad[iel](j,i) = 0;
 		}
 		
-#pragma omp for
-		for(a_int iface = 0; iface < m->gnbface(); iface++)
+		// faces of one colour do not share any cell, so no two threads update the same gradient
+		for(int icolour = 0; icolour < m->gnfacecolours(); icolour++)
 		{
-			a_real areainv1;
-			a_real ut[nvars];
-			a_real dL, dR, mid[NDIM];
-		
-			const a_int ielem = m->gintfac(iface,0);
-			const a_int jelem = m->gintfac(iface,1);   // ghost cell index
-			const a_int ip1 = m->gintfac(iface,2);
-			const a_int ip2 = m->gintfac(iface,3);
-			dL = 0; dR = 0;
-			for(int idim = 0; idim < NDIM; idim++)
-			{
-				mid[idim] = (m->gcoords(ip1,idim) + m->gcoords(ip2,idim)) * 0.5;
-				dL += (mid[idim]-rc(ielem,idim))*(mid[idim]-rc(ielem,idim));
-				dR += (mid[idim]-rc(jelem,idim))*(mid[idim]-rc(jelem,idim));
-			}
-			dL = 1.0/sqrt(dL);
-			dR = 1.0/sqrt(dR);
-			areainv1 = 1.0/m->garea(ielem);
-			
-			for(int ivar = 0; ivar < nvars; ivar++)
-			{
-				ut[ivar]= (u(ielem,ivar)*dL + ug(iface,ivar)*dR)/(dL+dR) * m->gfacemetric(iface,2);
-
-				for(int idim = 0; idim < NDIM; idim++)
-					grad[ielem](idim,ivar) += (ut[ivar] * m->gfacemetric(iface,idim))*areainv1;
-			}
-		}
-
 #pragma omp for
-		for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
-		{
-			a_int ielem, jelem, ip1, ip2;
-			a_real areainv1, areainv2;
-			a_real ut[nvars];
-			a_real dL, dR, mid[NDIM];
-		
-			ielem = m->gintfac(iface,0);
-			jelem = m->gintfac(iface,1);
-			ip1 = m->gintfac(iface,2);
-			ip2 = m->gintfac(iface,3);
-			dL = 0; dR = 0;
-			for(int idim = 0; idim < NDIM; idim++)
+			for(a_int ifc = m->gfacecolour_p(icolour); ifc < m->gfacecolour_p(icolour+1); ifc++)
 			{
-				mid[idim] = (m->gcoords(ip1,idim) + m->gcoords(ip2,idim)) * 0.5;
-				dL += (mid[idim]-rc(ielem,idim))*(mid[idim]-rc(ielem,idim));
-				dR += (mid[idim]-rc(jelem,idim))*(mid[idim]-rc(jelem,idim));
-			}
-			dL = 1.0/sqrt(dL);
-			dR = 1.0/sqrt(dR);
-			areainv1 = 1.0/m->garea(ielem);
-			areainv2 = 1.0/m->garea(jelem);
+				const a_int iface = m->gfacecolour(ifc);
+				const bool isboundary = iface < m->gnbface();
+				a_real ut[nvars];
+				a_real dL, dR, mid[NDIM];
 			
-			for(int ivar = 0; ivar < nvars; ivar++)
-			{
-				ut[ivar] = (u(ielem,ivar)*dL + u(jelem,ivar)*dR)/(dL+dR) * m->gfacemetric(iface,2);
-
+				const a_int ielem = m->gintfac(iface,0);
+				const a_int jelem = m->gintfac(iface,1);   // ghost cell index for boundary faces
+				const a_int ip1 = m->gintfac(iface,2);
+				const a_int ip2 = m->gintfac(iface,3);
+				dL = 0; dR = 0;
 				for(int idim = 0; idim < NDIM; idim++)
 				{
-#pragma omp atomic update
-					grad[ielem](idim,ivar) += (ut[ivar] * m->gfacemetric(iface,idim))*areainv1;
-#pragma omp atomic update
-					grad[jelem](idim,ivar) -= (ut[ivar] * m->gfacemetric(iface,idim))*areainv2;
+					mid[idim] = (m->gcoords(ip1,idim) + m->gcoords(ip2,idim)) * 0.5;
+					dL += (mid[idim]-rc(ielem,idim))*(mid[idim]-rc(ielem,idim));
+					dR += (mid[idim]-rc(jelem,idim))*(mid[idim]-rc(jelem,idim));
+				}
+				dL = 1.0/sqrt(dL);
+				dR = 1.0/sqrt(dR);
+				const a_real areainv1 = 1.0/m->garea(ielem);
+
+				if(isboundary)
+				{
+					for(int ivar = 0; ivar < nvars; ivar++)
+					{
+						ut[ivar]= (u(ielem,ivar)*dL + ug(iface,ivar)*dR)/(dL+dR) 
+							* m->gfacemetric(iface,2);
+
+						for(int idim = 0; idim < NDIM; idim++)
+							grad[ielem](idim,ivar) += (ut[ivar] * m->gfacemetric(iface,idim))*areainv1;
+					}
+				}
+				else
+				{
+					const a_real areainv2 = 1.0/m->garea(jelem);
+					for(int ivar = 0; ivar < nvars; ivar++)
+					{
+						ut[ivar] = (u(ielem,ivar)*dL + u(jelem,ivar)*dR)/(dL+dR) 
+							* m->gfacemetric(iface,2);
+
+						for(int idim = 0; idim < NDIM; idim++)
+						{
+							grad[ielem](idim,ivar) += (ut[ivar] * m->gfacemetric(iface,idim))*areainv1;
+							grad[jelem](idim,ivar) -= (ut[ivar] * m->gfacemetric(iface,idim))*areainv2;
+						}
+					}
 				}
 			}
 		}
@@ -152,47 +138,32 @@ WeightedLeastSquaresGradients<nvars>::WeightedLeastSquaresGradients(
 	}
 
 	// compute LHS of least-squares problem
+	// faces of one colour do not share any cell, so they can be processed concurrently
 
-#pragma omp parallel for default(shared)
-	for(a_int iface = 0; iface < m->gnbface(); iface++)
+#pragma omp parallel default(shared)
+	for(int icolour = 0; icolour < m->gnfacecolours(); icolour++)
 	{
-		const a_int ielem = m->gintfac(iface,0);
-		const a_int jelem = m->gintfac(iface,1);
-		a_real w2 = 0, dr[NDIM];
-		for(short idim = 0; idim < NDIM; idim++)
+#pragma omp for
+		for(a_int ifc = m->gfacecolour_p(icolour); ifc < m->gfacecolour_p(icolour+1); ifc++)
 		{
-			w2 += (rc(ielem,idim)-rc(jelem,idim))*(rc(ielem,idim)-rc(jelem,idim));
-			dr[idim] = rc(ielem,idim)-rc(jelem,idim);
-		}
-		w2 = 1.0/(w2);
-		
-		for(int i = 0; i<NDIM; i++)
-			for(int j = 0; j < NDIM; j++) {
-#pragma omp atomic update
-				V[ielem](i,j) += w2*dr[i]*dr[j];
+			const a_int iface = m->gfacecolour(ifc);
+			const a_int ielem = m->gintfac(iface,0);
+			const a_int jelem = m->gintfac(iface,1);
+			a_real w2 = 0, dr[NDIM];
+			for(int idim = 0; idim < NDIM; idim++)
+			{
+				w2 += (rc(ielem,idim)-rc(jelem,idim))*(rc(ielem,idim)-rc(jelem,idim));
+				dr[idim] = rc(ielem,idim)-rc(jelem,idim);
 			}
-	}
-
-#pragma omp parallel for default(shared)
-	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
-	{
-		a_int ielem = m->gintfac(iface,0);
-		a_int jelem = m->gintfac(iface,1);
-		a_real w2 = 0, dr[NDIM];
-		for(int idim = 0; idim < NDIM; idim++)
-		{
-			w2 += (rc(ielem,idim)-rc(jelem,idim))*(rc(ielem,idim)-rc(jelem,idim));
-			dr[idim] = rc(ielem,idim)-rc(jelem,idim);
+			w2 = 1.0/(w2);
+			
+			for(int i = 0; i<NDIM; i++)
+				for(int j = 0; j < NDIM; j++) {
+					V[ielem](i,j) += w2*dr[i]*dr[j];
+					if(iface >= m->gnbface())
+						V[jelem](i,j) += w2*dr[i]*dr[j];
+				}
 		}
-		w2 = 1.0/(w2);
-		
-		for(int i = 0; i<NDIM; i++)
-			for(int j = 0; j < NDIM; j++) {
-#pragma omp atomic update
-				V[ielem](i,j) += w2*dr[i]*dr[j];
-#pragma omp atomic update
-				V[jelem](i,j) += w2*dr[i]*dr[j];
-			}
 	}
 
 #pragma omp parallel for default(shared)
@@ -208,70 +179,36 @@ void WeightedLeastSquaresGradients<nvars>::compute_gradients(
 		const amat::Array2d<a_real>& ug, 
 		std::vector<FArray<NDIM,nvars>, aligned_allocator<FArray<NDIM,nvars>>>& grad ) const
 {
-	std::vector<Matrix<a_real,NDIM,nvars>, aligned_allocator<Matrix<a_real,NDIM,nvars>> > f;
-	f.resize(m->gnelem());
+	// compute least-squares RHS of each cell by gathering from its faces, so that no temporary
+	// storage is needed and each thread only writes to its own cells
 
 #pragma omp parallel for default(shared)
 	for(a_int ielem = 0; ielem < m->gnelem(); ielem++)
-		f[ielem] = Matrix<a_real,NDIM,nvars>::Zero();
-	
-	// compute least-squares RHS
-
-#pragma omp parallel for default(shared)
-	for(a_int iface = 0; iface < m->gnbface(); iface++)
-	{
-		const a_int ielem = m->gintfac(iface,0);
-		const a_int jelem = m->gintfac(iface,1);
-		a_real w2 = 0, dr[NDIM], du[nvars];
-		for(short idim = 0; idim < NDIM; idim++)
-		{
-			w2 += (rc(ielem,idim)-rc(jelem,idim))*(rc(ielem,idim)-rc(jelem,idim));
-			dr[idim] = rc(ielem,idim)-rc(jelem,idim);
-		}
-		w2 = 1.0/(w2);
-		
-		for(short ivar = 0; ivar < nvars; ivar++)
-			du[ivar] = u(ielem,ivar) - ug(iface,ivar);
-		
-		for(short ivar = 0; ivar < nvars; ivar++)
-		{
-			for(int jdim = 0; jdim < NDIM; jdim++)
-#pragma omp atomic update
-				f[ielem](jdim,ivar) += w2*dr[jdim]*du[ivar];
-		}
-	}
-
-#pragma omp parallel for default(shared)
-	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
 	{
-		a_int ielem = m->gintfac(iface,0);
-		a_int jelem = m->gintfac(iface,1);
-		a_real w2 = 0, dr[NDIM], du[nvars];
-		for(short idim = 0; idim < NDIM; idim++)
-		{
-			w2 += (rc(ielem,idim)-rc(jelem,idim))*(rc(ielem,idim)-rc(jelem,idim));
-			dr[idim] = rc(ielem,idim)-rc(jelem,idim);
-		}
-		w2 = 1.0/(w2);
-		
-		for(short ivar = 0; ivar < nvars; ivar++)
-			du[ivar] = u(ielem,ivar) - u(jelem,ivar);
+		Matrix<a_real,NDIM,nvars> f = Matrix<a_real,NDIM,nvars>::Zero();
 
-		for(short ivar = 0; ivar < nvars; ivar++)
+		for(a_int icf = m->gcellface_p(ielem); icf < m->gcellface_p(ielem+1); icf++)
 		{
-			for(int jdim = 0; jdim < NDIM; jdim++) {
-#pragma omp atomic update
-				f[ielem](jdim,ivar) += w2*dr[jdim]*du[ivar];
-#pragma omp atomic update
-				f[jelem](jdim,ivar) += w2*dr[jdim]*du[ivar];
+			const a_int iface = m->gcellface(icf);
+			const bool isboundary = iface < m->gnbface();
+			const a_int jelem = m->gintfac(iface, m->gcellfacesign(icf) > 0 ? 1 : 0);
+			a_real w2 = 0, dr[NDIM], du[nvars];
+			for(short idim = 0; idim < NDIM; idim++)
+			{
+				w2 += (rc(ielem,idim)-rc(jelem,idim))*(rc(ielem,idim)-rc(jelem,idim));
+				dr[idim] = rc(ielem,idim)-rc(jelem,idim);
 			}
+			w2 = 1.0/(w2);
+			
+			for(short ivar = 0; ivar < nvars; ivar++)
+				du[ivar] = isboundary ? u(ielem,ivar) - ug(iface,ivar) : u(ielem,ivar) - u(jelem,ivar);
+
+			for(short ivar = 0; ivar < nvars; ivar++)
+				for(int jdim = 0; jdim < NDIM; jdim++)
+					f(jdim,ivar) += w2*dr[jdim]*du[ivar];
 		}
-	}
 
-#pragma omp parallel for default(shared)
-	for(a_int ielem = 0; ielem < m->gnelem(); ielem++)
-	{
-		Matrix <a_real,NDIM,nvars> d = V[ielem]*f[ielem];
+		const Matrix<a_real,NDIM,nvars> d = V[ielem]*f;
 		for(short ivar = 0; ivar < nvars; ivar++)
 		{
 			for(short idim = 0; idim < NDIM; idim++)
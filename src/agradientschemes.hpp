@@ -37,7 +37,7 @@ public:
 
 /// Simply sets the gradient to zero
 template<short nvars>
-class ZeroGradients : public GradientScheme<nvars>
+class ZeroGradients final : public GradientScheme<nvars>
 {
 public:
 	ZeroGradients(const UMesh2dh *const mesh, 
@@ -58,7 +58,7 @@ protected:
  * An inverse-distance weighted average is used to obtain the conserved variables at the faces.
  */
 template<short nvars>
-class GreenGaussGradients : public GradientScheme<nvars>
+class GreenGaussGradients final : public GradientScheme<nvars>
 {
 public:
 	GreenGaussGradients(const UMesh2dh *const mesh, 
@@ -75,7 +75,7 @@ protected:
 
 /// Class implementing linear weighted least-squares reconstruction
 template<short nvars>
-class WeightedLeastSquaresGradients : public GradientScheme<nvars>
+class WeightedLeastSquaresGradients final : public GradientScheme<nvars>
 {
 public:
 	WeightedLeastSquaresGradients(const UMesh2dh *const mesh, 
@@ -0,0 +1,687 @@
+/** @file akrylov.cpp
+ * @brief Implementation of thread-parallel Krylov subspace solvers
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <complex>
+#include <Eigen/LU>
+#include <Eigen/QR>
+#include <Eigen/Eigenvalues>
+#include "akrylov.hpp"
+#include "autilities.hpp"
+
+namespace acfd {
+
+StatusCode getBlockSolverConfig(KSP ksp, BlockSolverConfig *const conf)
+{
+	StatusCode ierr = 0;
+	PetscReal rtol, atol, dtol;
+	PetscInt maxits;
+	ierr = KSPGetTolerances(ksp, &rtol, &atol, &dtol, &maxits); CHKERRQ(ierr);
+	conf->rtol = rtol;
+	conf->atol = atol;
+	conf->maxiter = maxits;
+
+	char str[PETSCOPTION_STR_LEN];
+	PetscBool set = PETSC_FALSE;
+	ierr = PetscOptionsGetString(NULL, NULL, "-native_ksp_type", str, PETSCOPTION_STR_LEN, &set);
+	CHKERRQ(ierr);
+	conf->solver = set ? str : "GMRES";
+
+	set = PETSC_FALSE;
+	ierr = PetscOptionsGetString(NULL, NULL, "-native_pc_type", str, PETSCOPTION_STR_LEN, &set);
+	CHKERRQ(ierr);
+	conf->precond = set ? str : "JACOBI";
+
+	PetscInt restart = 30;
+	ierr = PetscOptionsGetInt(NULL, NULL, "-native_ksp_gmres_restart", &restart, &set);
+	CHKERRQ(ierr);
+	conf->restart = restart;
+
+	PetscInt sweeps[2] = {1, 1};
+	PetscInt nmax = 2;
+	ierr = PetscOptionsGetIntArray(NULL, NULL, "-native_async_sweeps", sweeps, &nmax, &set);
+	CHKERRQ(ierr);
+	conf->nbuildsweeps = sweeps[0];
+	conf->napplysweeps = sweeps[1];
+
+	PetscReal refreshtol = 0;
+	ierr = PetscOptionsGetReal(NULL, NULL, "-native_pc_refresh_tol", &refreshtol, &set);
+	CHKERRQ(ierr);
+	conf->refreshtol = refreshtol;
+
+	PetscReal anisotropy = 4.0;
+	ierr = PetscOptionsGetReal(NULL, NULL, "-native_line_anisotropy", &anisotropy, &set);
+	CHKERRQ(ierr);
+	conf->lineanisotropy = anisotropy;
+
+	ierr = PetscOptionsHasName(NULL, NULL, "-native_pc_single_precision", &set); CHKERRQ(ierr);
+	conf->singleprec = set;
+
+	PetscInt recycle = 10;
+	ierr = PetscOptionsGetInt(NULL, NULL, "-native_ksp_gcrodr_recycle", &recycle, &set);
+	CHKERRQ(ierr);
+	conf->recycle = recycle;
+
+	return ierr;
+}
+
+/// Euclidean norm of a vector
+static a_real norm2(const a_int n, const a_real *const x)
+{
+	a_real sum = 0;
+#pragma omp parallel for simd default(shared) reduction(+:sum)
+	for(a_int i = 0; i < n; i++)
+		sum += x[i]*x[i];
+	return std::sqrt(sum);
+}
+
+/// Dot product of two vectors
+static a_real dot(const a_int n, const a_real *const x, const a_real *const y)
+{
+	a_real sum = 0;
+#pragma omp parallel for simd default(shared) reduction(+:sum)
+	for(a_int i = 0; i < n; i++)
+		sum += x[i]*y[i];
+	return sum;
+}
+
+/// Dot products of a vector with several vectors stored one after another
+static void multiDot(const a_int n, const a_real *const vecs, const int nv, const a_real *const x,
+		a_real *const out)
+{
+	for(int l = 0; l < nv; l++)
+		out[l] = 0;
+#pragma omp parallel for default(shared) reduction(+:out[:nv])
+	for(a_int i = 0; i < n; i++)
+		for(int l = 0; l < nv; l++)
+			out[l] += vecs[l*n+i]*x[i];
+}
+
+/// Subtracts a linear combination of several vectors stored one after another from a vector
+static void multiSubtract(const a_int n, const a_real *const vecs, const int nv,
+		const a_real *const coeffs, a_real *const x)
+{
+#pragma omp parallel for default(shared)
+	for(a_int i = 0; i < n; i++)
+		for(int l = 0; l < nv; l++)
+			x[i] -= vecs[l*n+i]*coeffs[l];
+}
+
+/// Computes the columns of out = X a + Y b, where X and Y are sets of vectors stored one after
+/// another
+static void combine(const a_int n, const a_real *const X, const Eigen::MatrixXd& a,
+		const a_real *const Y, const Eigen::MatrixXd& b, a_real *const out)
+{
+#pragma omp parallel for default(shared)
+	for(a_int i = 0; i < n; i++)
+		for(int j = 0; j < a.cols(); j++) {
+			a_real sum = 0;
+			for(int l = 0; l < a.rows(); l++)
+				sum += X[l*n+i]*a(l,j);
+			for(int l = 0; l < b.rows(); l++)
+				sum += Y[l*n+i]*b(l,j);
+			out[j*n+i] = sum;
+		}
+}
+
+template <int bs>
+PetscBlockOperator<bs>::PetscBlockOperator(Mat mat) : A{mat}
+{
+	StatusCode ierr = MatCreateVecs(A, &xvec, &yvec);
+	petsc_throw(ierr, "PetscBlockOperator: Could not create work vectors!");
+}
+
+template <int bs>
+PetscBlockOperator<bs>::~PetscBlockOperator()
+{
+	int ierr = VecDestroy(&xvec);
+	ierr |= VecDestroy(&yvec);
+	if(ierr)
+		std::cout << "! PetscBlockOperator: Could not destroy work vectors!\n";
+}
+
+template <int bs>
+void PetscBlockOperator<bs>::apply(const a_real *const x, a_real *const y) const
+{
+	StatusCode ierr = VecPlaceArray(xvec, x);
+	petsc_throw(ierr, "PetscBlockOperator: Could not place input array!");
+	ierr = VecPlaceArray(yvec, y);
+	petsc_throw(ierr, "PetscBlockOperator: Could not place output array!");
+	ierr = MatMult(A, xvec, yvec);
+	petsc_throw(ierr, "PetscBlockOperator: Could not apply the matrix!");
+	ierr = VecResetArray(xvec);
+	petsc_throw(ierr, "PetscBlockOperator: Could not reset input array!");
+	ierr = VecResetArray(yvec);
+	petsc_throw(ierr, "PetscBlockOperator: Could not reset output array!");
+}
+
+template <int bs>
+BlockKrylovSolver<bs>::BlockKrylovSolver(const BlockSolverConfig& conf, const a_int nbrows)
+	: config(conf), n{nbrows*bs}, A{nullptr}, P{nullptr}, resnorm{0}
+{ }
+
+template <int bs>
+void BlockKrylovSolver<bs>::setOperators(const BlockOperator<bs> *const op,
+		const BlockPreconditioner<bs> *const prec)
+{
+	A = op;
+	P = prec;
+}
+
+template <int bs>
+BlockGMRES<bs>::BlockGMRES(const BlockSolverConfig& conf, const a_int nbrows)
+	: BlockKrylovSolver<bs>(conf, nbrows), flexible{conf.solver == "FGMRES"},
+	  V(static_cast<size_t>(conf.restart+1)*nbrows*bs),
+	  Z(flexible ? static_cast<size_t>(conf.restart)*nbrows*bs : 0), w(nbrows*bs), z(nbrows*bs),
+	  H((conf.restart+1)*conf.restart), g(conf.restart+1), cs(conf.restart), sn(conf.restart),
+	  y(conf.restart), h(conf.restart+1)
+{ }
+
+template <int bs>
+int BlockGMRES<bs>::solve(const a_real *const b, a_real *const x)
+{
+	const int mr = config.restart;
+	const a_real tol = std::max(config.rtol*norm2(n,b), config.atol);
+	a_real *const hp = &h[0];
+
+#pragma omp parallel for simd default(shared)
+	for(a_int i = 0; i < n; i++)
+		x[i] = 0;
+
+	int its = 0;
+	bool converged = false;
+	while(!converged && its < config.maxiter)
+	{
+		// the first basis vector is the normalized residual; the operator is not applied to the
+		//  zero initial guess, as a finite difference product with zero is not defined
+		if(its > 0)
+			A->apply(x, &w[0]);
+		else
+			std::fill(w.begin(), w.end(), 0.0);
+		a_real beta = 0;
+#pragma omp parallel for simd default(shared) reduction(+:beta)
+		for(a_int i = 0; i < n; i++) {
+			V[i] = b[i] - w[i];
+			beta += V[i]*V[i];
+		}
+		beta = std::sqrt(beta);
+		resnorm = beta;
+		if(beta <= tol)
+			break;
+
+#pragma omp parallel for simd default(shared)
+		for(a_int i = 0; i < n; i++)
+			V[i] /= beta;
+		std::fill(g.begin(), g.end(), 0.0);
+		g[0] = beta;
+
+		int j = 0;
+		while(j < mr && its < config.maxiter)
+		{
+			a_real *const zj = flexible ? &Z[j*n] : &z[0];
+			P->apply(&V[j*n], zj);
+			A->apply(zj, &w[0]);
+
+			a_real *const hj = &H[j*(mr+1)];
+			for(int l = 0; l <= j; l++)
+				hj[l] = 0;
+
+			for(int pass = 0; pass < 2; pass++)
+			{
+				for(int l = 0; l <= j; l++)
+					hp[l] = 0;
+#pragma omp parallel for default(shared) reduction(+:hp[:j+1])
+				for(a_int i = 0; i < n; i++)
+					for(int l = 0; l <= j; l++)
+						hp[l] += V[l*n+i]*w[i];
+
+#pragma omp parallel for default(shared)
+				for(a_int i = 0; i < n; i++)
+					for(int l = 0; l <= j; l++)
+						w[i] -= V[l*n+i]*hp[l];
+
+				for(int l = 0; l <= j; l++)
+					hj[l] += hp[l];
+			}
+
+			hj[j+1] = norm2(n, &w[0]);
+			if(hj[j+1] > 0) {
+#pragma omp parallel for simd default(shared)
+				for(a_int i = 0; i < n; i++)
+					V[(j+1)*n+i] = w[i]/hj[j+1];
+			}
+
+			// apply the previous rotations to the new column and compute a new rotation
+			for(int l = 0; l < j; l++) {
+				const a_real temp = cs[l]*hj[l] + sn[l]*hj[l+1];
+				hj[l+1] = -sn[l]*hj[l] + cs[l]*hj[l+1];
+				hj[l] = temp;
+			}
+			const a_real d = std::hypot(hj[j], hj[j+1]);
+			cs[j] = d > 0 ? hj[j]/d : 1.0;
+			sn[j] = d > 0 ? hj[j+1]/d : 0.0;
+			hj[j] = d;
+			hj[j+1] = 0;
+			g[j+1] = -sn[j]*g[j];
+			g[j] = cs[j]*g[j];
+
+			its++; j++;
+			resnorm = std::fabs(g[j]);
+			if(resnorm <= tol || d == 0) {
+				converged = true;
+				break;
+			}
+		}
+
+		// solve the triangular system for the coefficients of the update
+		for(int i = j-1; i >= 0; i--) {
+			a_real sum = g[i];
+			for(int l = i+1; l < j; l++)
+				sum -= H[l*(mr+1)+i]*y[l];
+			y[i] = H[i*(mr+1)+i] != 0 ? sum/H[i*(mr+1)+i] : 0;
+		}
+
+		const a_real *const yp = &y[0];
+		if(flexible) {
+#pragma omp parallel for default(shared)
+			for(a_int i = 0; i < n; i++) {
+				a_real sum = 0;
+				for(int l = 0; l < j; l++)
+					sum += Z[l*n+i]*yp[l];
+				z[i] = sum;
+			}
+		}
+		else {
+#pragma omp parallel for default(shared)
+			for(a_int i = 0; i < n; i++) {
+				a_real sum = 0;
+				for(int l = 0; l < j; l++)
+					sum += V[l*n+i]*yp[l];
+				w[i] = sum;
+			}
+			P->apply(&w[0], &z[0]);
+		}
+
+#pragma omp parallel for simd default(shared)
+		for(a_int i = 0; i < n; i++)
+			x[i] += z[i];
+	}
+
+	return its;
+}
+
+template <int bs>
+BlockGCRODR<bs>::BlockGCRODR(const BlockSolverConfig& conf, const a_int nbrows)
+	: BlockKrylovSolver<bs>(conf, nbrows), nrec{0}, nsetupapps{0},
+	  U(static_cast<size_t>(conf.recycle)*nbrows*bs),
+	  C(static_cast<size_t>(conf.recycle)*nbrows*bs),
+	  V(static_cast<size_t>(conf.restart+1)*nbrows*bs), r(nbrows*bs), s(nbrows*bs), w(nbrows*bs),
+	  z(nbrows*bs), T(static_cast<size_t>(conf.recycle)*nbrows*bs)
+{
+	if(conf.recycle < 1 || conf.recycle >= conf.restart)
+		throw "BlockGCRODR: The recycled dimension must be positive and less than the restart!";
+}
+
+template <int bs>
+void BlockGCRODR<bs>::applyOperator(const a_real *const v, a_real *const wout)
+{
+	P->apply(v, &z[0]);
+	A->apply(&z[0], wout);
+}
+
+template <int bs>
+int BlockGCRODR<bs>::arnoldi(const int nc, const int maxsteps, const a_real beta, const a_real tol,
+		Eigen::MatrixXd& H, Eigen::MatrixXd& B, Eigen::VectorXd& y, int& its)
+{
+	H.setZero(maxsteps+1, maxsteps);
+	B.setZero(nc, maxsteps);
+
+	// H reduced to upper triangular form by Givens rotations, and the rotated right hand side
+	Eigen::MatrixXd R = Eigen::MatrixXd::Zero(maxsteps+1, maxsteps);
+	Eigen::VectorXd g = Eigen::VectorXd::Zero(maxsteps+1);
+	g(0) = beta;
+	std::vector<a_real> cs(maxsteps), sn(maxsteps), h(std::max(nc, maxsteps+1));
+
+#pragma omp parallel for simd default(shared)
+	for(a_int i = 0; i < n; i++)
+		V[i] = r[i]/beta;
+
+	int j = 0;
+	while(j < maxsteps && its < config.maxiter)
+	{
+		applyOperator(&V[j*n], &w[0]);
+
+		// orthogonalize against C and the previous basis vectors, in two passes
+		for(int pass = 0; pass < 2; pass++)
+		{
+			if(nc > 0) {
+				multiDot(n, &C[0], nc, &w[0], &h[0]);
+				multiSubtract(n, &C[0], nc, &h[0], &w[0]);
+				for(int l = 0; l < nc; l++)
+					B(l,j) += h[l];
+			}
+			multiDot(n, &V[0], j+1, &w[0], &h[0]);
+			multiSubtract(n, &V[0], j+1, &h[0], &w[0]);
+			for(int l = 0; l <= j; l++)
+				H(l,j) += h[l];
+		}
+
+		const a_real hnext = norm2(n, &w[0]);
+		H(j+1,j) = hnext;
+		if(hnext > 0) {
+#pragma omp parallel for simd default(shared)
+			for(a_int i = 0; i < n; i++)
+				V[(j+1)*n+i] = w[i]/hnext;
+		}
+
+		R.col(j) = H.col(j);
+		for(int l = 0; l < j; l++) {
+			const a_real temp = cs[l]*R(l,j) + sn[l]*R(l+1,j);
+			R(l+1,j) = -sn[l]*R(l,j) + cs[l]*R(l+1,j);
+			R(l,j) = temp;
+		}
+		const a_real d = std::hypot(R(j,j), R(j+1,j));
+		cs[j] = d > 0 ? R(j,j)/d : 1.0;
+		sn[j] = d > 0 ? R(j+1,j)/d : 0.0;
+		R(j,j) = d;
+		R(j+1,j) = 0;
+		g(j+1) = -sn[j]*g(j);
+		g(j) = cs[j]*g(j);
+
+		its++; j++;
+		resnorm = std::fabs(g(j));
+		if(resnorm <= tol || hnext == 0 || d == 0)
+			break;
+	}
+
+	y.setZero(j);
+	for(int i = j-1; i >= 0; i--) {
+		a_real sum = g(i);
+		for(int l = i+1; l < j; l++)
+			sum -= R(i,l)*y(l);
+		y(i) = R(i,i) != 0 ? sum/R(i,i) : 0;
+	}
+	return j;
+}
+
+template <int bs>
+void BlockGCRODR<bs>::updateRecycledSubspace(const Eigen::MatrixXd& G, const Eigen::MatrixXd& WtV,
+		const int p)
+{
+	const int k = config.recycle;
+	const int nc = nrec;
+	const int mm = nc + p;
+
+	const Eigen::FullPivLU<Eigen::MatrixXd> lu(G.transpose()*WtV);
+	if(!lu.isInvertible())
+		return;
+	const Eigen::EigenSolver<Eigen::MatrixXd> es(lu.solve(G.transpose()*G));
+	if(es.info() != Eigen::Success)
+		return;
+
+	// Real basis of the eigenvectors of the k harmonic Ritz values of smallest magnitude.
+	//  Complex conjugate pairs are sorted with the positive imaginary part first.
+	std::vector<int> idx(mm);
+	for(int i = 0; i < mm; i++)
+		idx[i] = i;
+	const auto& theta = es.eigenvalues();
+	std::sort(idx.begin(), idx.end(), [&theta](const int a, const int b) {
+		return std::abs(theta(a)) < std::abs(theta(b))
+			|| (std::abs(theta(a)) == std::abs(theta(b)) && theta(a).imag() > theta(b).imag());
+	});
+
+	Eigen::MatrixXd Pk(mm, k);
+	int col = 0;
+	for(int i = 0; i < mm && col < k; i++) {
+		const auto v = es.eigenvectors().col(idx[i]);
+		if(theta(idx[i]).imag() == 0)
+			Pk.col(col++) = v.real();
+		else if(theta(idx[i]).imag() > 0) {
+			Pk.col(col++) = v.real();
+			if(col < k)
+				Pk.col(col++) = v.imag();
+		}
+	}
+	if(col < k)
+		return;
+
+	const Eigen::HouseholderQR<Eigen::MatrixXd> qr(G*Pk);
+	const Eigen::MatrixXd Q = qr.householderQ()*Eigen::MatrixXd::Identity(mm+1, k);
+	const Eigen::MatrixXd Rq = qr.matrixQR().topLeftCorner(k,k).triangularView<Eigen::Upper>();
+	const a_real rscale = Rq.norm();
+	for(int i = 0; i < k; i++)
+		if(std::fabs(Rq(i,i)) <= 1e-14*rscale)
+			return;
+
+	// C = W Q and U = Vh Pk R^{-1}, so that A P^{-1} U = C still
+	const Eigen::MatrixXd Y = Rq.triangularView<Eigen::Upper>().solve<Eigen::OnTheRight>(Pk);
+	combine(n, &C[0], Q.topRows(nc), &V[0], Q.bottomRows(p+1), &T[0]);
+	std::swap(C, T);
+	combine(n, &U[0], G.topLeftCorner(nc,nc)*Y.topRows(nc), &V[0], Y.bottomRows(p), &T[0]);
+	std::swap(U, T);
+	nrec = k;
+}
+
+template <int bs>
+int BlockGCRODR<bs>::solve(const a_real *const b, a_real *const x)
+{
+	const int m = config.restart;
+	const a_real tol = std::max(config.rtol*norm2(n,b), config.atol);
+
+#pragma omp parallel for simd default(shared)
+	for(a_int i = 0; i < n; i++) {
+		r[i] = b[i];
+		s[i] = 0;
+	}
+
+	int its = 0;
+	nsetupapps = nrec;
+	if(nrec > 0)
+	{
+		// recompute C = A P^{-1} U for the current operators and make it orthonormal by
+		//  modified Gram-Schmidt, applying the same transformation to U
+		for(int l = 0; l < nrec; l++)
+			applyOperator(&U[l*n], &C[l*n]);
+		for(int l = 0; l < nrec; l++)
+		{
+			const a_real cnorm0 = norm2(n, &C[l*n]);
+			for(int pass = 0; pass < 2; pass++)
+				for(int q = 0; q < l; q++) {
+					const a_real rql = dot(n, &C[q*n], &C[l*n]);
+#pragma omp parallel for simd default(shared)
+					for(a_int i = 0; i < n; i++) {
+						C[l*n+i] -= rql*C[q*n+i];
+						U[l*n+i] -= rql*U[q*n+i];
+					}
+				}
+
+			const a_real cnorm = norm2(n, &C[l*n]);
+			if(cnorm <= 1e-10*cnorm0) {
+				// the rest of the subspace is (nearly) linearly dependent; drop it
+				nrec = l;
+				break;
+			}
+#pragma omp parallel for simd default(shared)
+			for(a_int i = 0; i < n; i++) {
+				C[l*n+i] /= cnorm;
+				U[l*n+i] /= cnorm;
+			}
+		}
+
+		// minimize the residual over the recycled subspace
+		std::vector<a_real> c(nrec);
+		multiDot(n, &C[0], nrec, &r[0], &c[0]);
+		const a_real *const cp = &c[0];
+#pragma omp parallel for default(shared)
+		for(a_int i = 0; i < n; i++)
+			for(int l = 0; l < nrec; l++) {
+				s[i] += U[l*n+i]*cp[l];
+				r[i] -= C[l*n+i]*cp[l];
+			}
+	}
+
+	resnorm = norm2(n, &r[0]);
+	Eigen::MatrixXd H, B;
+	Eigen::VectorXd y;
+	while(resnorm > tol && its < config.maxiter)
+	{
+		const int nc = nrec;
+		const a_real beta = resnorm;
+		const int p = arnoldi(nc, m-nc, beta, tol, H, B, y, its);
+
+		// s += V_p y - U B y, and r = V_{p+1} (beta e_1 - H y)
+		const Eigen::VectorXd uc = B.leftCols(p)*y;
+		Eigen::VectorXd rc = -H.topLeftCorner(p+1,p)*y;
+		rc(0) += beta;
+		const a_real *const yp = y.data();
+		const a_real *const ucp = uc.data();
+		const a_real *const rcp = rc.data();
+#pragma omp parallel for default(shared)
+		for(a_int i = 0; i < n; i++) {
+			for(int l = 0; l < p; l++)
+				s[i] += V[l*n+i]*yp[l];
+			for(int l = 0; l < nc; l++)
+				s[i] -= U[l*n+i]*ucp[l];
+			a_real ri = 0;
+			for(int l = 0; l <= p; l++)
+				ri += V[l*n+i]*rcp[l];
+			r[i] = ri;
+		}
+		resnorm = norm2(n, &r[0]);
+
+		if(nc + p > config.recycle)
+		{
+			// A P^{-1} [U D V_p] = [C V_{p+1}] G, where D scales the columns of U to unit length
+			Eigen::MatrixXd G = Eigen::MatrixXd::Zero(nc+p+1, nc+p);
+			Eigen::MatrixXd WtV = Eigen::MatrixXd::Zero(nc+p+1, nc+p);
+			for(int l = 0; l < nc; l++) {
+				const a_real dl = 1.0/norm2(n, &U[l*n]);
+				G(l,l) = dl;
+				multiDot(n, &C[0], nc, &U[l*n], WtV.col(l).data());
+				multiDot(n, &V[0], p+1, &U[l*n], WtV.col(l).data()+nc);
+				WtV.col(l) *= dl;
+			}
+			G.topRightCorner(nc,p) = B.leftCols(p);
+			G.bottomRightCorner(p+1,p) = H.topLeftCorner(p+1,p);
+			WtV.block(nc,nc,p,p).setIdentity();
+
+			updateRecycledSubspace(G, WtV, p);
+		}
+	}
+
+	P->apply(&s[0], x);
+	return its;
+}
+
+template <int bs>
+BlockBiCGStab<bs>::BlockBiCGStab(const BlockSolverConfig& conf, const a_int nbrows)
+	: BlockKrylovSolver<bs>(conf, nbrows),
+	  r(nbrows*bs), rhat(nbrows*bs), p(nbrows*bs), v(nbrows*bs), s(nbrows*bs), t(nbrows*bs),
+	  phat(nbrows*bs), shat(nbrows*bs)
+{ }
+
+template <int bs>
+int BlockBiCGStab<bs>::solve(const a_real *const b, a_real *const x)
+{
+	const a_real bnorm = norm2(n,b);
+	const a_real tol = std::max(config.rtol*bnorm, config.atol);
+
+#pragma omp parallel for simd default(shared)
+	for(a_int i = 0; i < n; i++) {
+		x[i] = 0;
+		r[i] = b[i];
+		rhat[i] = b[i];
+		p[i] = 0;
+		v[i] = 0;
+	}
+
+	resnorm = bnorm;
+	a_real rho = 1, alpha = 1, omega = 1;
+	int its = 0;
+	while(resnorm > tol && its < config.maxiter)
+	{
+		const a_real rhonew = dot(n, &rhat[0], &r[0]);
+		if(rhonew == 0)
+			break;
+		const a_real beta = (rhonew/rho)*(alpha/omega);
+#pragma omp parallel for simd default(shared)
+		for(a_int i = 0; i < n; i++)
+			p[i] = r[i] + beta*(p[i] - omega*v[i]);
+
+		P->apply(&p[0], &phat[0]);
+		A->apply(&phat[0], &v[0]);
+		alpha = rhonew / dot(n, &rhat[0], &v[0]);
+
+		a_real snorm = 0;
+#pragma omp parallel for simd default(shared) reduction(+:snorm)
+		for(a_int i = 0; i < n; i++) {
+			s[i] = r[i] - alpha*v[i];
+			snorm += s[i]*s[i];
+		}
+		snorm = std::sqrt(snorm);
+		its++;
+
+		if(snorm <= tol) {
+#pragma omp parallel for simd default(shared)
+			for(a_int i = 0; i < n; i++)
+				x[i] += alpha*phat[i];
+			resnorm = snorm;
+			break;
+		}
+
+		P->apply(&s[0], &shat[0]);
+		A->apply(&shat[0], &t[0]);
+		a_real ts = 0, tt = 0;
+#pragma omp parallel for simd default(shared) reduction(+:ts,tt)
+		for(a_int i = 0; i < n; i++) {
+			ts += t[i]*s[i];
+			tt += t[i]*t[i];
+		}
+		omega = tt > 0 ? ts/tt : 0;
+
+		a_real rnorm = 0;
+#pragma omp parallel for simd default(shared) reduction(+:rnorm)
+		for(a_int i = 0; i < n; i++) {
+			x[i] += alpha*phat[i] + omega*shat[i];
+			r[i] = s[i] - omega*t[i];
+			rnorm += r[i]*r[i];
+		}
+		resnorm = std::sqrt(rnorm);
+		rho = rhonew;
+		if(omega == 0)
+			break;
+	}
+
+	return its;
+}
+
+template class PetscBlockOperator<NVARS>;
+template class PetscBlockOperator<1>;
+template class BlockKrylovSolver<NVARS>;
+template class BlockKrylovSolver<1>;
+template class BlockGMRES<NVARS>;
+template class BlockGMRES<1>;
+template class BlockGCRODR<NVARS>;
+template class BlockGCRODR<1>;
+template class BlockBiCGStab<NVARS>;
+template class BlockBiCGStab<1>;
+
+}
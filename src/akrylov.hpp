@@ -0,0 +1,254 @@
+/** @file akrylov.hpp
+ * @brief Thread-parallel Krylov subspace solvers for block sparse matrices
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AKRYLOV_H
+#define AKRYLOV_H
+
+#include <string>
+#include <vector>
+#include <petscksp.h>
+#include "ablockprecond.hpp"
+
+namespace acfd {
+
+/// Settings for the native block sparse linear solvers
+struct BlockSolverConfig {
+	std::string solver;          ///< Krylov solver - GMRES, FGMRES, GCRODR or BICGSTAB
+	/// Preconditioner - NONE, JACOBI, ILU0, SGS, LINE, ASYNCILU0 or ASYNCSGS
+	std::string precond;
+	int restart;                 ///< Dimension of the Krylov subspace after which GMRES restarts
+	a_real rtol;                 ///< Tolerance on the residual norm relative to that of the RHS
+	a_real atol;                 ///< Tolerance on the absolute residual norm
+	int maxiter;                 ///< Maximum number of iterations
+	int nbuildsweeps;            ///< Number of sweeps to compute asynchronous preconditioners
+	int napplysweeps;            ///< Number of sweeps to apply asynchronous preconditioners
+	/// Relative change in the blocks of a row above which the row of the preconditioner is
+	/// computed again; zero to compute the whole preconditioner every time
+	a_real refreshtol;
+	a_real lineanisotropy;       ///< Minimum anisotropy of cells in lines of the LINE preconditioner
+	bool singleprec;             ///< Whether JACOBI and ILU0 store their blocks in single precision
+	int recycle;                 ///< Dimension of the subspace GCRODR carries between solves
+};
+
+/// Reads the settings of the native solvers from the PETSc options database
+/** The tolerances and the maximum number of iterations are those of a PETSc KSP, so that
+ * the usual -ksp_rtol, -ksp_atol and -ksp_max_it options apply to the native solvers as well.
+ * The other settings are read from the following options:
+ *  - -native_ksp_type (GMRES (default), FGMRES, GCRODR or BICGSTAB)
+ *  - -native_pc_type (JACOBI (default), ILU0, SGS, LINE, ASYNCILU0, ASYNCSGS or NONE)
+ *  - -native_ksp_gmres_restart (default 30)
+ *  - -native_async_sweeps (build and apply sweeps of asynchronous preconditioners, default 1,1)
+ *  - -native_pc_refresh_tol (tolerance for incremental refreshes of JACOBI and ILU0, default 0)
+ *  - -native_line_anisotropy (minimum anisotropy of cells in lines of LINE, default 4)
+ *  - -native_pc_single_precision (flag; JACOBI and ILU0 store their blocks in single precision)
+ *  - -native_ksp_gcrodr_recycle (dimension of the subspace recycled by GCRODR, default 10)
+ * \param ksp The PETSc solver whose tolerances to use
+ */
+StatusCode getBlockSolverConfig(KSP ksp, BlockSolverConfig *const conf);
+
+/// A PETSc matrix, possibly matrix-free, seen as a \ref BlockOperator by the native solvers
+/** The arrays passed to \ref apply are placed in work vectors of the matrix, so nothing is copied.
+ * Errors from PETSc are thrown as \ref Petsc_exception s.
+ */
+template <int bs>
+class PetscBlockOperator : public BlockOperator<bs>
+{
+public:
+	/// Creates work vectors for a matrix, which must outlive this object
+	PetscBlockOperator(Mat mat);
+	~PetscBlockOperator();
+
+	void apply(const a_real *const x, a_real *const y) const;
+
+protected:
+	Mat A;                                    ///< The matrix
+	Vec xvec;                                 ///< Work vector for the input
+	Vec yvec;                                 ///< Work vector for the output
+};
+
+/// Base class for iterative solvers of linear systems with a \ref BSRMatrix
+/** All vector operations are parallelized with OpenMP. The initial guess is zero.
+ * Convergence is checked with the norm of the (unpreconditioned) residual
+ * relative to the norm of the right hand side, so preconditioning is applied from the right.
+ */
+template <int bs>
+class BlockKrylovSolver
+{
+public:
+	/// Sets the settings and allocates work vectors
+	/** \param nbrows Number of block rows of the matrices the solver is used with
+	 */
+	BlockKrylovSolver(const BlockSolverConfig& conf, const a_int nbrows);
+
+	virtual ~BlockKrylovSolver() { }
+
+	/// Sets the operator and the preconditioner, which must be computed before \ref solve
+	/** The operator need not be the matrix the preconditioner was computed from; it may be, eg.,
+	 * a matrix-free Jacobian wrapped in a \ref PetscBlockOperator.
+	 */
+	void setOperators(const BlockOperator<bs> *const op, const BlockPreconditioner<bs> *const prec);
+
+	/// Solves A x = b, returning the number of iterations used
+	virtual int solve(const a_real *const b, a_real *const x) = 0;
+
+	/// The norm of the residual after the latest solve
+	a_real residualNorm() const { return resnorm; }
+
+	/// Changes the tolerance on the residual norm relative to that of the RHS for later solves
+	void setRelativeTolerance(const a_real rtol) { config.rtol = rtol; }
+
+protected:
+	BlockSolverConfig config;                 ///< Solver settings
+	const a_int n;                            ///< Number of scalar unknowns
+	const BlockOperator<bs> *A;               ///< The matrix
+	const BlockPreconditioner<bs> *P;         ///< The preconditioner
+	a_real resnorm;                           ///< Residual norm after the latest solve
+};
+
+/// Restarted GMRES, with right preconditioning
+/** The Krylov basis is orthogonalized by classical Gram-Schmidt with one reorthogonalization,
+ * so that orthogonalizing against all the basis vectors takes two passes over them.
+ * The flexible variant (FGMRES) stores the preconditioned basis vectors too, so that the
+ * preconditioner may change from one application to the next, as asynchronous ones do.
+ */
+template <int bs>
+class BlockGMRES : public BlockKrylovSolver<bs>
+{
+public:
+	BlockGMRES(const BlockSolverConfig& conf, const a_int nbrows);
+	int solve(const a_real *const b, a_real *const x);
+
+protected:
+	using BlockKrylovSolver<bs>::config;
+	using BlockKrylovSolver<bs>::n;
+	using BlockKrylovSolver<bs>::A;
+	using BlockKrylovSolver<bs>::P;
+	using BlockKrylovSolver<bs>::resnorm;
+
+	const bool flexible;                      ///< Whether this is FGMRES
+	std::vector<a_real> V;                    ///< Krylov basis, one vector after another
+	std::vector<a_real> Z;                    ///< Preconditioned basis vectors, for FGMRES
+	std::vector<a_real> w;                    ///< Work vector
+	std::vector<a_real> z;                    ///< Work vector for preconditioned vectors
+	/// Hessenberg matrix, stored column-major with (restart+1) rows
+	std::vector<a_real> H;
+	std::vector<a_real> g;                    ///< Rotated residual vector
+	std::vector<a_real> cs;                   ///< Cosines of the Givens rotations
+	std::vector<a_real> sn;                   ///< Sines of the Givens rotations
+	std::vector<a_real> y;                    ///< Coefficients of the basis vectors in the update
+	std::vector<a_real> h;                    ///< Projections in one Gram-Schmidt pass
+};
+
+/// GCRO-DR: GMRES with deflated restarting and recycling of a subspace between solves
+/** Following Parks et al., "Recycling Krylov subspaces for sequences of linear systems",
+ * SIAM J. Sci. Comput. 28 (2006). Each cycle of m = restart iterations keeps k = recycle
+ * harmonic Ritz vectors U of the (right-preconditioned) operator, approximating the eigenvectors
+ * of its smallest eigenvalues, and the next cycle builds its Krylov basis orthogonal to
+ * C = A P^{-1} U, so that those eigenvalues do not slow it down. Only m-k new basis vectors are
+ * generated per cycle.
+ *
+ * The subspace U is kept at the end of a solve. The next solve, which may be with a different
+ * operator and preconditioner, begins by computing C = A P^{-1} U again (k operator applications,
+ * reported by \ref recycleSetupApplications rather than counted as iterations) and projecting
+ * the right hand side on it. This pays off when
+ * consecutive systems are close, as in pseudo-time stepping. The first solve begins with one
+ * plain GMRES cycle. The preconditioner must be a fixed linear operator.
+ */
+template <int bs>
+class BlockGCRODR : public BlockKrylovSolver<bs>
+{
+public:
+	BlockGCRODR(const BlockSolverConfig& conf, const a_int nbrows);
+	int solve(const a_real *const b, a_real *const x);
+
+	/// Number of vectors currently in the recycled subspace
+	int recycledDimension() const { return nrec; }
+
+	/// Number of operator applications used by the last solve to set up the recycled subspace
+	/** These recompute C = A P^{-1} U for the current operators, and are not counted in the
+	 * iterations returned by \ref solve.
+	 */
+	int recycleSetupApplications() const { return nsetupapps; }
+
+	/// Discards the recycled subspace, so that the next solve starts from scratch
+	void clearRecycledSubspace() { nrec = 0; }
+
+protected:
+	using BlockKrylovSolver<bs>::config;
+	using BlockKrylovSolver<bs>::n;
+	using BlockKrylovSolver<bs>::A;
+	using BlockKrylovSolver<bs>::P;
+	using BlockKrylovSolver<bs>::resnorm;
+
+	int nrec;                                 ///< Number of vectors in \ref U and \ref C
+	int nsetupapps;                           ///< See \ref recycleSetupApplications
+	std::vector<a_real> U;                    ///< Recycled subspace, in the preconditioned space
+	std::vector<a_real> C;                    ///< Orthonormal basis, A P^{-1} U
+	std::vector<a_real> V;                    ///< Krylov basis of a cycle
+	std::vector<a_real> r;                    ///< Residual
+	std::vector<a_real> s;                    ///< Update of the solution, in the preconditioned space
+	std::vector<a_real> w;                    ///< Work vector
+	std::vector<a_real> z;                    ///< Work vector for preconditioned vectors
+	std::vector<a_real> T;                    ///< Work space for new recycled vectors
+
+	/// Computes w = A P^{-1} v
+	void applyOperator(const a_real *const v, a_real *const wout);
+
+	/// Runs Arnoldi iterations of A P^{-1} orthogonalized against the first nc columns of C
+	/** Starts from the normalized \ref r, with norm beta.
+	 * \param[out] H The Hessenberg matrix ((maxsteps+1) x maxsteps)
+	 * \param[out] B Projections of the new basis vectors on C (nc x maxsteps)
+	 * \param[out] y Coefficients of the first basis vectors which minimize the residual
+	 * \param[in,out] its Total number of iterations
+	 * \return Number of iterations carried out; fewer than maxsteps if converged
+	 */
+	int arnoldi(const int nc, const int maxsteps, const a_real beta, const a_real tol,
+			Eigen::MatrixXd& H, Eigen::MatrixXd& B, Eigen::VectorXd& y, int& its);
+
+	/// Computes the new recycled subspace from a cycle
+	/** The vectors of the cycle are W = [C V_{p+1}] and Vh = [U D V_p], where D scales the columns
+	 * of U to unit length, and A P^{-1} Vh = W G. The harmonic Ritz vectors are the solutions of
+	 * \f$ G^T G z = \theta G^T W^T Vh z \f$ of the smallest magnitude.
+	 * \param G The matrix of the cycle
+	 * \param WtV \f$ W^T Vh \f$
+	 * \param p Number of Krylov basis vectors of the cycle, besides the last one
+	 */
+	void updateRecycledSubspace(const Eigen::MatrixXd& G, const Eigen::MatrixXd& WtV, const int p);
+};
+
+/// Stabilized bi-conjugate gradient method (BiCGStab), with right preconditioning
+template <int bs>
+class BlockBiCGStab : public BlockKrylovSolver<bs>
+{
+public:
+	BlockBiCGStab(const BlockSolverConfig& conf, const a_int nbrows);
+	int solve(const a_real *const b, a_real *const x);
+
+protected:
+	using BlockKrylovSolver<bs>::config;
+	using BlockKrylovSolver<bs>::n;
+	using BlockKrylovSolver<bs>::A;
+	using BlockKrylovSolver<bs>::P;
+	using BlockKrylovSolver<bs>::resnorm;
+
+	std::vector<a_real> r, rhat, p, v, s, t, phat, shat;     ///< Work vectors
+};
+
+}
+#endif
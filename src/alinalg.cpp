@@ -1,8 +1,10 @@
 #include "alinalg.hpp"
+#include "ameshutils.hpp"
 #include <iostream>
 #include <vector>
 #include <cstring>
 #include <limits>
+#include <algorithm>
 
 namespace acfd {
 
@@ -16,41 +18,217 @@ static StatusCode setJacobianSizes(const UMesh2dh *const m, Mat A)
 	return ierr;
 }
 
+/// Name under which the Jacobian block locations are composed with the matrix
+static const char *const blocklocations_name = "JacobianBlockLocations";
+
+static PetscErrorCode destroyJacobianBlockLocations(void *const ctx)
+{
+	delete reinterpret_cast<JacobianBlockLocations*>(ctx);
+	return 0;
+}
+
+/// Gets the sequential BAIJ matrix that stores the local rows of a matrix
+/** \param[out] Ad The matrix itself if it is SeqBAIJ, the diagonal part if it is MPIBAIJ on
+ *   a single process, and NULL otherwise.
+ */
+static StatusCode getLocalBAIJ(Mat A, Mat *const Ad)
+{
+	StatusCode ierr = 0;
+	*Ad = NULL;
+	PetscBool isseq, ismpi;
+	ierr = PetscObjectTypeCompare((PetscObject)A, MATSEQBAIJ, &isseq); CHKERRQ(ierr);
+	ierr = PetscObjectTypeCompare((PetscObject)A, MATMPIBAIJ, &ismpi); CHKERRQ(ierr);
+	if(isseq)
+		*Ad = A;
+	else if(ismpi) {
+		MPI_Comm comm; PetscMPIInt size;
+		ierr = PetscObjectGetComm((PetscObject)A, &comm); CHKERRQ(ierr);
+		ierr = MPI_Comm_size(comm, &size); CHKERRQ(ierr);
+		if(size == 1) {
+			Mat Ao; const PetscInt *colmap;
+			ierr = MatMPIBAIJGetSeqBAIJ(A, Ad, &Ao, &colmap); CHKERRQ(ierr);
+		}
+	}
+	return ierr;
+}
+
+/// Sets the non-zero structure of a BAIJ Jacobian matrix and attaches its block locations
+/** Does nothing for other matrices. 
+ * The structure is set by assembling zero blocks for all cells and faces of the mesh, and for
+ * all the other cells within the stencil radius of each cell.
+ * \param nbhdptr,nbhd The neighbourhoods of cells from \ref cellNeighbourhoods at the
+ *   stencil radius
+ */
 template <int nvars>
-StatusCode setJacobianPreallocation(const UMesh2dh *const m, Mat A) 
+static StatusCode setJacobianBlockLocations(const UMesh2dh *const m, Mat A,
+		const int stencilradius, const std::vector<a_int>& nbhdptr, const std::vector<a_int>& nbhd)
+{
+	StatusCode ierr = 0;
+	Mat Ad;
+	ierr = getLocalBAIJ(A, &Ad); CHKERRQ(ierr);
+	if(!Ad)
+		return ierr;
+
+	const PetscScalar zeros[nvars*nvars] = {0};
+	for(a_int iel = 0; iel < m->gnelem(); iel++) {
+		ierr = MatSetValuesBlocked(A, 1, &iel, 1, &iel, zeros, INSERT_VALUES); CHKERRQ(ierr);
+	}
+	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++) {
+		const a_int lelem = m->gintfac(iface,0), relem = m->gintfac(iface,1);
+		ierr = MatSetValuesBlocked(A, 1, &lelem, 1, &relem, zeros, INSERT_VALUES); CHKERRQ(ierr);
+		ierr = MatSetValuesBlocked(A, 1, &relem, 1, &lelem, zeros, INSERT_VALUES); CHKERRQ(ierr);
+	}
+	if(stencilradius > 1)
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+			for(a_int k = nbhdptr[iel]; k < nbhdptr[iel+1]; k++) {
+				ierr = MatSetValuesBlocked(A, 1, &iel, 1, &nbhd[k], zeros, INSERT_VALUES);
+				CHKERRQ(ierr);
+			}
+	ierr = MatAssemblyBegin(A, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+	ierr = MatAssemblyEnd(A, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+
+	PetscInt nrows; const PetscInt *ia, *ja; PetscBool done;
+	ierr = MatGetRowIJ(Ad, 0, PETSC_FALSE, PETSC_TRUE, &nrows, &ia, &ja, &done); CHKERRQ(ierr);
+	if(!done || nrows != m->gnelem()) {
+		ierr = MatRestoreRowIJ(Ad, 0, PETSC_FALSE, PETSC_TRUE, &nrows, &ia, &ja, &done); 
+		CHKERRQ(ierr);
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_PLIB, "Could not get the block structure!");
+	}
+
+	/* Finds the location of block (i,j), or returns -1 if the block is not stored.
+	 * Columns in a row of a BAIJ matrix are sorted.
+	 */
+	auto findBlock = [ia,ja](const PetscInt i, const PetscInt j) {
+		const PetscInt *const pos = std::lower_bound(ja+ia[i], ja+ia[i+1], j);
+		return pos != ja+ia[i+1] && *pos == j ? static_cast<PetscInt>(pos-ja) : -1;
+	};
+
+	JacobianBlockLocations *const locs = new JacobianBlockLocations;
+	locs->stencilradius = stencilradius;
+	locs->nbhdcolumn.resize(nbhd.size());
+	locs->diag.resize(m->gnelem());
+	locs->lower.assign(m->gnaface(), -1);
+	locs->upper.assign(m->gnaface(), -1);
+	bool found = true;
+	for(a_int iel = 0; iel < m->gnelem(); iel++) {
+		locs->diag[iel] = findBlock(iel,iel);
+		found = found && locs->diag[iel] >= 0;
+	}
+	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++) {
+		const a_int lelem = m->gintfac(iface,0), relem = m->gintfac(iface,1);
+		locs->lower[iface] = findBlock(relem,lelem);
+		locs->upper[iface] = findBlock(lelem,relem);
+		found = found && locs->lower[iface] >= 0 && locs->upper[iface] >= 0;
+	}
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		for(a_int k = nbhdptr[iel]; k < nbhdptr[iel+1]; k++) {
+			locs->nbhdcolumn[k] = findBlock(nbhd[k],iel);
+			found = found && locs->nbhdcolumn[k] >= 0;
+		}
+
+	ierr = MatRestoreRowIJ(Ad, 0, PETSC_FALSE, PETSC_TRUE, &nrows, &ia, &ja, &done); 
+	CHKERRQ(ierr);
+	if(!found) {
+		delete locs;
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_PLIB, "The matrix does not store all Jacobian blocks!");
+	}
+
+	PetscContainer container;
+	ierr = PetscContainerCreate(PETSC_COMM_SELF, &container); CHKERRQ(ierr);
+	ierr = PetscContainerSetPointer(container, locs); CHKERRQ(ierr);
+	ierr = PetscContainerSetUserDestroy(container, destroyJacobianBlockLocations); CHKERRQ(ierr);
+	ierr = PetscObjectCompose((PetscObject)A, blocklocations_name, (PetscObject)container);
+	CHKERRQ(ierr);
+	// the matrix now holds a reference to the container
+	ierr = PetscContainerDestroy(&container); CHKERRQ(ierr);
+
+	return ierr;
+}
+
+StatusCode getJacobianBlockLocations(Mat A, const JacobianBlockLocations **const locs)
+{
+	StatusCode ierr = 0;
+	PetscContainer container;
+	ierr = PetscObjectQuery((PetscObject)A, blocklocations_name, (PetscObject*)&container);
+	CHKERRQ(ierr);
+	*locs = NULL;
+	if(container) {
+		void *ptr;
+		ierr = PetscContainerGetPointer(container, &ptr); CHKERRQ(ierr);
+		*locs = reinterpret_cast<const JacobianBlockLocations*>(ptr);
+	}
+	return ierr;
+}
+
+StatusCode getJacobianBlockValues(Mat A, PetscScalar **const vals)
+{
+	StatusCode ierr = 0;
+	Mat Ad;
+	ierr = getLocalBAIJ(A, &Ad); CHKERRQ(ierr);
+	if(!Ad)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONG, "Matrix does not have block locations!");
+	ierr = MatSeqBAIJGetArray(Ad, vals); CHKERRQ(ierr);
+	return ierr;
+}
+
+StatusCode restoreJacobianBlockValues(Mat A, PetscScalar **const vals)
+{
+	StatusCode ierr = 0;
+	Mat Ad;
+	ierr = getLocalBAIJ(A, &Ad); CHKERRQ(ierr);
+	ierr = MatSeqBAIJRestoreArray(Ad, vals); CHKERRQ(ierr);
+	ierr = PetscObjectStateIncrease((PetscObject)Ad); CHKERRQ(ierr);
+	if(Ad != A) {
+		ierr = PetscObjectStateIncrease((PetscObject)A); CHKERRQ(ierr);
+	}
+	return ierr;
+}
+
+template <int nvars>
+StatusCode setJacobianPreallocation(const UMesh2dh *const m, Mat A, const int stencilradius) 
 {
 	// The implementation must be changed for the multi-process case
 	
 	StatusCode ierr = 0;
 
+	// cells coupled to each cell; beyond the face neighbours only if the radius is more than 1
+	std::vector<a_int> nbhdptr, nbhd;
+	cellNeighbourhoods(*m, stencilradius, nbhdptr, nbhd);
+
 	// set block preallocation
 	std::vector<PetscInt> dnnz(m->gnelem());
 	for(a_int iel = 0; iel < m->gnelem(); iel++)
 	{
-		dnnz[iel] = m->gnfael(iel)+1;
+		dnnz[iel] = stencilradius > 1 ? nbhdptr[iel+1]-nbhdptr[iel] : m->gnfael(iel)+1;
 	}
 	ierr = MatSeqBAIJSetPreallocation(A, nvars, 0, &dnnz[0]); CHKERRQ(ierr);
 	ierr = MatMPIBAIJSetPreallocation(A, nvars, 0, &dnnz[0], 1, NULL); CHKERRQ(ierr);
 
 	// set scalar (non-block) preallocation
+	const std::vector<PetscInt> blockdnnz = dnnz;
 	dnnz.resize(m->gnelem()*nvars);
 	for(a_int iel = 0; iel < m->gnelem(); iel++)
 	{
 		for(int i = 0; i < nvars; i++) {
-			dnnz[iel*nvars+i] = (m->gnfael(iel)+1)*nvars;
+			dnnz[iel*nvars+i] = blockdnnz[iel]*nvars;
 		}
 	}
 
 	ierr = MatSeqAIJSetPreallocation(A, 0, &dnnz[0]); CHKERRQ(ierr);
 	ierr = MatMPIAIJSetPreallocation(A, 0, &dnnz[0], nvars, NULL); CHKERRQ(ierr);
 
+	ierr = setJacobianBlockLocations<nvars>(m, A, stencilradius, nbhdptr, nbhd); CHKERRQ(ierr);
+
 	return ierr;
 }
 
-template StatusCode setJacobianPreallocation<1>(const UMesh2dh *const m, Mat A);
+template StatusCode setJacobianPreallocation<NVARS>(const UMesh2dh *const m, Mat A,
+		const int stencilradius);
+template StatusCode setJacobianPreallocation<1>(const UMesh2dh *const m, Mat A,
+		const int stencilradius);
 
 template <int nvars>
-StatusCode setupSystemMatrix(const UMesh2dh *const m, Mat *const A)
+StatusCode setupSystemMatrix(const UMesh2dh *const m, Mat *const A, const int stencilradius)
 {
 	StatusCode ierr = 0;
 	ierr = MatCreate(PETSC_COMM_WORLD, A); CHKERRQ(ierr);
@@ -60,7 +238,7 @@ StatusCode setupSystemMatrix(const UMesh2dh *const m, Mat *const A)
 
 	ierr = MatSetFromOptions(*A); CHKERRQ(ierr);
 
-	ierr = setJacobianPreallocation<nvars>(m, *A); CHKERRQ(ierr);
+	ierr = setJacobianPreallocation<nvars>(m, *A, stencilradius); CHKERRQ(ierr);
 
 	ierr = MatSetUp(*A); CHKERRQ(ierr);
 
@@ -69,8 +247,10 @@ StatusCode setupSystemMatrix(const UMesh2dh *const m, Mat *const A)
 	return ierr;
 }
 
-template StatusCode setupSystemMatrix<NVARS>(const UMesh2dh *const m, Mat *const A);
-template StatusCode setupSystemMatrix<1>(const UMesh2dh *const m, Mat *const A);
+template StatusCode setupSystemMatrix<NVARS>(const UMesh2dh *const m, Mat *const A,
+		const int stencilradius);
+template StatusCode setupSystemMatrix<1>(const UMesh2dh *const m, Mat *const A,
+		const int stencilradius);
 
 #ifdef USE_BLASTED
 /// Recursive function to setup the BLASTed preconditioner wherever possible
@@ -164,23 +344,48 @@ template StatusCode setup_blasted(KSP ksp, Vec u, const Spatial<1> *const startp
 
 template<int nvars>
 MatrixFreeSpatialJacobian<nvars>::MatrixFreeSpatialJacobian()
-	: eps{1e-7}
+	: eps{1e-7}, dualnumbers{false}, frozenreconstruction{false}, frozen{nullptr}
 {
 	PetscBool set = PETSC_FALSE;
 	PetscOptionsGetReal(NULL, NULL, "-matrix_free_difference_step", &eps, &set);
+	PetscBool dual = PETSC_FALSE;
+	set = PETSC_FALSE;
+	PetscOptionsGetBool(NULL, NULL, "-matrix_free_dual_numbers", &dual, &set);
+	dualnumbers = (dual == PETSC_TRUE);
+	PetscBool freeze = PETSC_FALSE;
+	set = PETSC_FALSE;
+	PetscOptionsGetBool(NULL, NULL, "-matrix_free_frozen_reconstruction", &freeze, &set);
+	frozenreconstruction = (freeze == PETSC_TRUE);
+}
+
+template<int nvars>
+MatrixFreeSpatialJacobian<nvars>::~MatrixFreeSpatialJacobian()
+{
+	delete frozen;
 }
 
 template<int nvars>
 void MatrixFreeSpatialJacobian<nvars>::set_spatial(const Spatial<nvars> *const space) {
 	spatial = space;
+	delete frozen;
+	frozen = nullptr;
 }
 
 template<int nvars>
 StatusCode MatrixFreeSpatialJacobian<nvars>::setup_work_storage(const Mat system_matrix)
 {
+	// dual-number products are exact, so there is no difference of residuals to freeze
+	if(dualnumbers && frozenreconstruction)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_INCOMP, "-matrix_free_frozen_reconstruction "
+				"cannot be used with -matrix_free_dual_numbers!");
+
 	StatusCode ierr = MatCreateVecs(system_matrix, NULL, &aux); CHKERRQ(ierr);
 	ierr = VecSet(aux,0.0); CHKERRQ(ierr);
-	std::cout << " MatrixFreeSpatialJacobian: Using finite difference step " << eps << '\n';
+	if(dualnumbers)
+		std::cout << " MatrixFreeSpatialJacobian: Using exact products by dual numbers\n";
+	else
+		std::cout << " MatrixFreeSpatialJacobian: Using finite difference step " << eps 
+			<< (frozenreconstruction ? " with frozen reconstruction\n" : "\n");
 	return ierr;
 }
 
@@ -200,19 +405,55 @@ void MatrixFreeSpatialJacobian<nvars>::set_state(const Vec u_state, const Vec r_
 	mdt = dtms;
 }
 
+template<int nvars>
+StatusCode MatrixFreeSpatialJacobian<nvars>::update_state()
+{
+	StatusCode ierr = 0;
+	if(frozenreconstruction) {
+		ierr = spatial->freeze_reconstruction(u, &frozen); CHKERRQ(ierr);
+	}
+	return ierr;
+}
+
 template<int nvars>
 StatusCode MatrixFreeSpatialJacobian<nvars>::apply(const Vec x, Vec y) const
 {
 	StatusCode ierr = 0;
-	std::vector<a_real> dummy;
 	const UMesh2dh *const m = spatial->mesh();
-	ierr = VecSet(y, 0.0); CHKERRQ(ierr);
+
+	if(dualnumbers) {
+		// y <- dr/du x, exactly
+		ierr = spatial->compute_jacobian_vector_product(u, x, y); CHKERRQ(ierr);
+	}
+	else {
+		ierr = computeDifferenceProduct(x, y); CHKERRQ(ierr);
+	}
 
 	const a_real *xr;
 	a_real *yr;
 	ierr = VecGetArray(y, &yr); CHKERRQ(ierr);
 	ierr = VecGetArrayRead(x, &xr); CHKERRQ(ierr);
 
+	// finally, add the pseudo-time term (Vol/dt du = Vol/dt x)
+#pragma omp parallel for simd default(shared)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+	{
+		for(int i = 0; i < nvars; i++)
+			yr[iel*nvars+i] += (*mdt)[iel] * xr[iel*nvars+i];
+	}
+	
+	ierr = VecRestoreArray(y, &yr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(x, &xr); CHKERRQ(ierr);
+	return ierr;
+}
+
+template<int nvars>
+StatusCode MatrixFreeSpatialJacobian<nvars>::computeDifferenceProduct(const Vec x, Vec y) const
+{
+	StatusCode ierr = 0;
+	std::vector<a_real> dummy;
+	ierr = VecSet(y, 0.0); CHKERRQ(ierr);
+
 	PetscScalar xnorm = 0;
 	ierr = VecNorm(x, NORM_2, &xnorm); CHKERRQ(ierr);
 #ifdef DEBUG
@@ -227,23 +468,17 @@ StatusCode MatrixFreeSpatialJacobian<nvars>::apply(const Vec x, Vec y) const
 	// aux <- u + eps/xnorm * x
 	ierr = VecAXPY(aux, 1.0, u); CHKERRQ(ierr);
 	// y <- -r(u + eps/xnorm * x)
-	ierr = spatial->compute_residual(aux, y, false, dummy); CHKERRQ(ierr);
+	if(frozenreconstruction) {
+		ierr = spatial->compute_frozen_residual(aux, frozen, y); CHKERRQ(ierr);
+	}
+	else {
+		ierr = spatial->compute_residual(aux, y, false, dummy); CHKERRQ(ierr);
+	}
 	// y <- -(-r(u + eps/xnorm * x)) + (-r(u)) = r(u + eps/xnorm * x) - r(u)
 	ierr = VecAXPBY(y, 1.0, -1.0, res); CHKERRQ(ierr);
 	
 	/* divide by the normalized step length */
 	ierr = VecScale(y, 1.0/xnorm); CHKERRQ(ierr);
-
-	// finally, add the pseudo-time term (Vol/dt du = Vol/dt x)
-#pragma omp parallel for simd default(shared)
-	for(a_int iel = 0; iel < m->gnelem(); iel++)
-	{
-		for(int i = 0; i < nvars; i++)
-			yr[iel*nvars+i] += (*mdt)[iel] * xr[iel*nvars+i];
-	}
-	
-	ierr = VecRestoreArray(y, &yr); CHKERRQ(ierr);
-	ierr = VecRestoreArrayRead(x, &xr); CHKERRQ(ierr);
 	return ierr;
 }
 
@@ -23,6 +23,7 @@ namespace acfd {
 /// Sets up storage preallocation for sparse matrix formats
 /** \param[in] m Mesh context
  * \param[in|out] A The matrix to pre-allocate for
+ * \param[in] stencilradius See \ref setJacobianPreallocation
  *
  * We assume there's only 1 neighboring cell that's not in this subdomain
  * \todo TODO: Once a partitioned mesh is used, set the preallocation properly.
@@ -31,11 +32,55 @@ namespace acfd {
  * only MPI matrices are supported.
  */
 template <int nvars>
-StatusCode setupSystemMatrix(const UMesh2dh *const m, Mat *const A);
+StatusCode setupSystemMatrix(const UMesh2dh *const m, Mat *const A, const int stencilradius = 1);
 
 /// Computes the amount of memory to be reserved for the Jacobian matrix
+/** For block (BAIJ) matrices on a single process, the non-zero structure is also set from the
+ * mesh, and the locations of the blocks are attached to the matrix; 
+ * see \ref getJacobianBlockLocations.
+ * \param stencilradius Number of steps across faces within which cells are coupled; 1 for
+ *   the usual nearest-neighbour Jacobian, 2 for the exact Jacobian of a second-order scheme
+ *   (see \ref Spatial::jacobian_stencil_radius)
+ */
 template <int nvars>
-StatusCode setJacobianPreallocation(const UMesh2dh *const m, Mat A);
+StatusCode setJacobianPreallocation(const UMesh2dh *const m, Mat A, const int stencilradius = 1);
+
+/// Locations of the blocks of a cell-centred finite volume Jacobian in block-CSR storage
+/** Each location is the index of a block in the array of values of the matrix (for MPIBAIJ
+ * matrices, of its diagonal part); the entries of the block start at location*nvars*nvars and
+ * are stored column-major. Each face owns its off-diagonal blocks, so they can be written
+ * concurrently. Diagonal blocks can be written concurrently by faces of the same colour.
+ * The blocks of the whole stencil are also listed by column, for the coloured assembly of
+ * the Jacobian (see \ref Spatial::jacobian_stencil_radius).
+ */
+struct JacobianBlockLocations
+{
+	/// The stencil radius for which the matrix was preallocated
+	int stencilradius;
+	/// For each cell and each cell of its neighbourhood, in the order given by
+	/// \ref cellNeighbourhoods at \ref stencilradius, the block coupling the neighbour to the cell
+	std::vector<PetscInt> nbhdcolumn;
+	/// The diagonal block of each cell
+	std::vector<PetscInt> diag;
+	/// For each face, the block coupling the right cell to the left cell (-1 for boundary faces)
+	std::vector<PetscInt> lower;
+	/// For each face, the block coupling the left cell to the right cell (-1 for boundary faces)
+	std::vector<PetscInt> upper;
+};
+
+/// Gets the block locations attached to a matrix by \ref setJacobianPreallocation
+/** \param[out] locs The block locations, or NULL if the matrix has none; for instance, when it
+ *   is not a BAIJ matrix. They are owned by the matrix.
+ */
+StatusCode getJacobianBlockLocations(Mat A, const JacobianBlockLocations **const locs);
+
+/// Gives access to the array of values of a matrix which has \ref JacobianBlockLocations
+StatusCode getJacobianBlockValues(Mat A, PetscScalar **const vals);
+
+/// Ends access to the array obtained from \ref getJacobianBlockValues
+/** The matrix is marked as changed, so that preconditioners using it are recomputed.
+ */
+StatusCode restoreJacobianBlockValues(Mat A, PetscScalar **const vals);
 
 #ifdef USE_BLASTED
 /// Sets BLASTed preconditioners
@@ -53,6 +98,11 @@ StatusCode setup_blasted(KSP ksp, Vec u, const Spatial<nvars> *const startprob,
 /// Matrix-free Jacobian of the flux
 /** The normalized step length epsilon for the finite-difference Jacobian is set to a default value,
  * but it also queried from the PETSc options database.
+ * If the option -matrix_free_dual_numbers is set, the products are instead computed exactly
+ * by Spatial::compute_jacobian_vector_product. If the option -matrix_free_frozen_reconstruction
+ * is set, the finite differences are of Spatial::compute_frozen_residual, with the
+ * reconstruction frozen at the state by \ref update_state. The two options cannot be
+ * used together; \ref setup_work_storage returns an error if both are set.
  */
 template <int nvars>
 class MatrixFreeSpatialJacobian
@@ -63,7 +113,14 @@ public:
 	 */
 	MatrixFreeSpatialJacobian();
 
+	~MatrixFreeSpatialJacobian();
+
+	MatrixFreeSpatialJacobian(const MatrixFreeSpatialJacobian&) = delete;
+	MatrixFreeSpatialJacobian& operator=(const MatrixFreeSpatialJacobian&) = delete;
+
 	/// Set the spatial dscretization whose Jacobian is needed
+	/** Any reconstruction frozen by the previous discretization is discarded.
+	 */
 	void set_spatial(const Spatial<nvars> *const space);
 
 	/// Allocate storage for work vectors using the (possibly matrix-free) Mat as a template
@@ -79,6 +136,12 @@ public:
 	 */
 	void set_state(const Vec u_state, const Vec r_state, const std::vector<a_real> *const mdts);
 
+	/// To be called whenever the state set by \ref set_state has changed, before products are
+	/// computed at the new state
+	/** Freezes the reconstruction at the state, if that is requested.
+	 */
+	StatusCode update_state();
+
 	/// Compute a Jacobian-vector product
 	StatusCode apply(const Vec x, Vec y) const;
 
@@ -89,6 +152,15 @@ protected:
 	/// step length for finite difference Jacobian
 	a_real eps;
 
+	/// Whether products are computed exactly with dual numbers rather than by differencing
+	bool dualnumbers;
+
+	/// Whether the residuals that are differenced have the reconstruction frozen at the state
+	bool frozenreconstruction;
+
+	/// The reconstruction frozen at the state by \ref update_state
+	typename Spatial<nvars>::FrozenReconstruction *frozen;
+
 	/// The state at which to compute the Jacobian
 	Vec u;
 
@@ -100,6 +172,9 @@ protected:
 
 	/// Temporary storage
 	mutable Vec aux;
+
+	/// Compute the product of the spatial Jacobian with x by a finite difference of residuals
+	StatusCode computeDifferenceProduct(const Vec x, Vec y) const;
 };
 
 /// Setup a matrix-free Mat for the Jacobian
@@ -27,7 +27,7 @@
 namespace acfd {
 
 UMesh2dh::UMesh2dh() 
-	: isBoundaryMaps{false}
+	: nfacecolours{0}, isBoundaryMaps{false}
 {  }
 
 UMesh2dh::~UMesh2dh()
@@ -1240,11 +1240,82 @@ void UMesh2dh::compute_topological()
 			bpoints(ibp,1) = iface;
 		}
 	}*/
+
+	compute_face_colouring();
+	compute_cell_face_map();
+
 #ifdef DEBUG
 	std::cout << "UMesh2dh: compute_topological(): Done." << std::endl;
 #endif
 }
 
+void UMesh2dh::compute_cell_face_map()
+{
+	cellface_p.resize(nelem+1);
+	cellface_p[0] = 0;
+	for(a_int iel = 0; iel < nelem; iel++)
+		cellface_p[iel+1] = cellface_p[iel] + nfael[iel];
+
+	cellface.resize(cellface_p[nelem]);
+	cellfacesign.resize(cellface_p[nelem]);
+	for(a_int iel = 0; iel < nelem; iel++)
+	{
+		for(int jfa = 0; jfa < nfael[iel]; jfa++)
+		{
+			const a_int iface = elemface(iel,jfa);
+			cellface[cellface_p[iel]+jfa] = iface;
+			// the left cell of a face is always the one with the smaller index
+			cellfacesign[cellface_p[iel]+jfa] = (iel < esuel(iel,jfa)) ? 1 : -1;
+		}
+	}
+}
+
+void UMesh2dh::compute_face_colouring()
+{
+	std::vector<int> colour(naface, -1);
+	nfacecolours = 0;
+
+	// greedy colouring - each face gets the lowest colour not used by any face of its cells
+	for(a_int iface = 0; iface < naface; iface++)
+	{
+		std::vector<bool> used(nfacecolours, false);
+		for(int iside = 0; iside < 2; iside++)
+		{
+			const a_int iel = intfac(iface,iside);
+			if(iel >= nelem)
+				continue;
+			for(int jfa = 0; jfa < nfael[iel]; jfa++) {
+				const int jcolour = colour[elemface(iel,jfa)];
+				if(jcolour >= 0)
+					used[jcolour] = true;
+			}
+		}
+
+		int icolour = 0;
+		while(icolour < nfacecolours && used[icolour])
+			icolour++;
+
+		colour[iface] = icolour;
+		if(icolour == nfacecolours)
+			nfacecolours++;
+	}
+
+	// store the faces in CSR format, grouped by colour
+	facecolour_p.assign(nfacecolours+1, 0);
+	for(a_int iface = 0; iface < naface; iface++)
+		facecolour_p[colour[iface]+1]++;
+	for(int icolour = 0; icolour < nfacecolours; icolour++)
+		facecolour_p[icolour+1] += facecolour_p[icolour];
+
+	std::vector<a_int> pos(facecolour_p.begin(), facecolour_p.end()-1);
+	facecolour.resize(naface);
+	for(a_int iface = 0; iface < naface; iface++)
+		facecolour[pos[colour[iface]]++] = iface;
+
+	std::cout << "UMesh2dh: compute_face_colouring(): Number of face colours = " 
+		<< nfacecolours << std::endl;
+}
+
 /** Assumption: order of nodes of boundary faces is such that normal points outside, 
  * when normal is calculated as
  * 		nx = y2 - y1, ny = -(x2-x1).
@@ -87,6 +87,30 @@ public:
 	/// Returns the components of the unit normal or the length of a face \sa facemetric
 	a_real gfacemetric(const a_int iface, const int index) const {return facemetric.get(iface,index);}
 
+	/// Returns the number of face colours \sa compute_face_colouring
+	int gnfacecolours() const { return nfacecolours; }
+
+	/// Returns the index for \ref gfacecolour at which the list of faces of a colour starts
+	/** The faces of colour icolour are gfacecolour(i) for 
+	 * gfacecolour_p(icolour) <= i < gfacecolour_p(icolour+1).
+	 */
+	a_int gfacecolour_p(const int icolour) const { return facecolour_p[icolour]; }
+
+	/// Returns a face from the colour-ordered list of faces; to be used with \ref gfacecolour_p
+	a_int gfacecolour(const a_int i) const { return facecolour[i]; }
+
+	/// Returns the index for \ref gcellface at which the list of faces of a cell starts
+	a_int gcellface_p(const a_int ielem) const { return cellface_p[ielem]; }
+
+	/// Returns a face from the cell-to-face adjacency list; to be used with \ref gcellface_p
+	a_int gcellface(const a_int i) const { return cellface[i]; }
+
+	/// Returns +1 if the cell is the left cell of the corresponding face in \ref gcellface, else -1
+	/** Since face normals point from left cell to right cell, this is the sign with which
+	 * a face flux leaves the cell.
+	 */
+	int gcellfacesign(const a_int i) const { return cellfacesign[i]; }
+
 	/// Returns paired faces in case of periodic boundaries \sa periodicmap
 	a_int gperiodicmap(const a_int face) const { return periodicmap[face]; }
 
@@ -207,6 +231,22 @@ public:
 	 * it stores the intfac face number)
 	 */
 	void compute_topological();
+
+	/// Partitions the faces into colours such that no two faces of a colour share a cell
+	/** Faces of one colour can then be processed concurrently, with each face scattering
+	 * contributions to its left and right cells without any synchronization.
+	 * A greedy algorithm is used, which visits faces in the order of \ref intfac,
+	 * so the faces of each colour are sorted by face index and the boundary faces
+	 * of each colour precede its interior faces.
+	 * \note Called at the end of \ref compute_topological.
+	 */
+	void compute_face_colouring();
+
+	/// Computes the cell-to-face adjacency in compressed sparse row format from \ref elemface
+	/** The orientation of each face with respect to the cell is stored as well.
+	 * \note Called at the end of \ref compute_topological.
+	 */
+	void compute_cell_face_map();
 	
 	/// Computes unit normals and lengths, and sets boundary face tags for all faces in intfacbtags
 	/** \note Uses intfac, so call only after compute_topological, only for linear mesh
@@ -312,6 +352,26 @@ private:
 	/// Holds face numbers of faces making up an element
 	amat::Array2d<a_int> elemface;
 
+	/// Number of colours in the face colouring \sa compute_face_colouring
+	int nfacecolours;
+
+	/// Indices into \ref facecolour at which the face list of each colour starts
+	/** Has length \ref nfacecolours + 1.
+	 */
+	std::vector<a_int> facecolour_p;
+
+	/// Face indices grouped by colour \sa compute_face_colouring
+	std::vector<a_int> facecolour;
+
+	/// Indices into \ref cellface at which the face list of each cell starts (length nelem+1)
+	std::vector<a_int> cellface_p;
+
+	/// Faces of each cell, in the local order of \ref elemface \sa compute_cell_face_map
+	std::vector<a_int> cellface;
+
+	/// Orientation of each face in \ref cellface with respect to the cell \sa gcellfacesign
+	std::vector<int> cellfacesign;
+
 	/// Maps each face of periodic boundaries to the face that it is identified with
 	/** Stores -1 for faces that are not on a periodic bounary.
 	 * Stored according to \ref intfac indices.
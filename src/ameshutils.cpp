@@ -4,6 +4,8 @@
 
 #include "ameshutils.hpp"
 #include <vector>
+#include <algorithm>
+#include <deque>
 #include <iostream>
 #include "alinalg.hpp"
 
@@ -114,4 +116,194 @@ std::vector<a_int> levelSchedule(const UMesh2dh& m)
 	return levels;
 }
 
+void triangularLevelSchedule(const UMesh2dh& m, std::vector<a_int>& levelptr,
+		std::vector<a_int>& cells)
+{
+	std::vector<a_int> celllevel(m.gnelem(), 0);
+	a_int nlevels = 0;
+	for(a_int icell = 0; icell < m.gnelem(); icell++)
+	{
+		for(int iface = 0; iface < m.gnfael(icell); iface++) {
+			const a_int othercell = m.gesuel(icell,iface);
+			if(othercell < icell)
+				celllevel[icell] = std::max(celllevel[icell], celllevel[othercell]+1);
+		}
+		nlevels = std::max(nlevels, celllevel[icell]+1);
+	}
+
+	// counting sort of the cells by level, which keeps them in increasing order in each level
+	levelptr.assign(nlevels+1, 0);
+	for(a_int icell = 0; icell < m.gnelem(); icell++)
+		levelptr[celllevel[icell]+1]++;
+	for(a_int ilevel = 0; ilevel < nlevels; ilevel++)
+		levelptr[ilevel+1] += levelptr[ilevel];
+
+	cells.resize(m.gnelem());
+	std::vector<a_int> pos(levelptr.begin(), levelptr.end()-1);
+	for(a_int icell = 0; icell < m.gnelem(); icell++)
+		cells[pos[celllevel[icell]]++] = icell;
+}
+
+/// Adds the cells within a number of steps of a cell to a list, in the order they are reached
+/** \param stamp Marks the cells already reached; cells marked with \p mark are skipped
+ */
+static void addCellsWithin(const UMesh2dh& m, const a_int icell, const int distance,
+		const a_int mark, std::vector<a_int>& stamp, std::vector<a_int>& list)
+{
+	const size_t start = list.size();
+	list.push_back(icell);
+	stamp[icell] = mark;
+	size_t levelstart = start;
+	for(int istep = 0; istep < distance; istep++)
+	{
+		const size_t levelend = list.size();
+		for(size_t i = levelstart; i < levelend; i++)
+			for(int iface = 0; iface < m.gnfael(list[i]); iface++) {
+				const a_int othercell = m.gesuel(list[i],iface);
+				if(othercell < m.gnelem() && stamp[othercell] != mark) {
+					stamp[othercell] = mark;
+					list.push_back(othercell);
+				}
+			}
+		levelstart = levelend;
+	}
+}
+
+void cellNeighbourhoods(const UMesh2dh& m, const int distance, std::vector<a_int>& ptr,
+		std::vector<a_int>& cells)
+{
+	std::vector<a_int> stamp(m.gnelem(), -1);
+	ptr.assign(1, 0);
+	cells.clear();
+	for(a_int icell = 0; icell < m.gnelem(); icell++)
+	{
+		addCellsWithin(m, icell, distance, icell, stamp, cells);
+		std::sort(cells.begin()+ptr.back(), cells.end());
+		ptr.push_back(cells.size());
+	}
+}
+
+void distanceColouring(const UMesh2dh& m, const int distance, std::vector<a_int>& colourptr,
+		std::vector<a_int>& cells)
+{
+	std::vector<a_int> colour(m.gnelem(), -1);
+	std::vector<a_int> stamp(m.gnelem(), -1);
+	// the last cell that found each colour in use near it
+	std::vector<a_int> used;
+	std::vector<a_int> near;
+	a_int ncolours = 0;
+
+	for(a_int icell = 0; icell < m.gnelem(); icell++)
+	{
+		near.clear();
+		addCellsWithin(m, icell, distance, icell, stamp, near);
+		for(const a_int othercell : near)
+			if(colour[othercell] >= 0)
+				used[colour[othercell]] = icell;
+
+		a_int c = 0;
+		while(c < ncolours && used[c] == icell)
+			c++;
+		if(c == ncolours) {
+			ncolours++;
+			used.push_back(-1);
+		}
+		colour[icell] = c;
+	}
+
+	// counting sort of the cells by colour, as for the levels of triangularLevelSchedule
+	colourptr.assign(ncolours+1, 0);
+	for(a_int icell = 0; icell < m.gnelem(); icell++)
+		colourptr[colour[icell]+1]++;
+	for(a_int ic = 0; ic < ncolours; ic++)
+		colourptr[ic+1] += colourptr[ic];
+
+	cells.resize(m.gnelem());
+	std::vector<a_int> pos(colourptr.begin(), colourptr.end()-1);
+	for(a_int icell = 0; icell < m.gnelem(); icell++)
+		cells[pos[colour[icell]]++] = icell;
+}
+
+void implicitLines(const UMesh2dh& m, const a_real anisotropy, std::vector<a_int>& lineptr,
+		std::vector<a_int>& cells)
+{
+	const a_int nelem = m.gnelem();
+
+	// the two most strongly coupled local faces of each cell, and the anisotropy of each cell
+	std::vector<int> strongfaces(2*nelem);
+	std::vector<a_real> ratio(nelem);
+	for(a_int icell = 0; icell < nelem; icell++)
+	{
+		a_real wmax[2] = {-1.0, -1.0}, wmin = -1.0;
+		for(int iface = 0; iface < m.gnfael(icell); iface++)
+		{
+			const a_real w = m.gfacemetric(m.gelemface(icell,iface),2) / m.garea(icell);
+			if(w > wmax[0]) {
+				wmax[1] = wmax[0]; strongfaces[2*icell+1] = strongfaces[2*icell];
+				wmax[0] = w; strongfaces[2*icell] = iface;
+			}
+			else if(w > wmax[1]) {
+				wmax[1] = w; strongfaces[2*icell+1] = iface;
+			}
+			if(wmin < 0 || w < wmin)
+				wmin = w;
+		}
+		ratio[icell] = wmax[0]/wmin;
+	}
+
+	std::vector<a_int> seeds(nelem);
+	for(a_int icell = 0; icell < nelem; icell++)
+		seeds[icell] = icell;
+	std::stable_sort(seeds.begin(), seeds.end(),
+			[&ratio](const a_int a, const a_int b) { return ratio[a] > ratio[b]; });
+
+	std::vector<char> assigned(nelem, 0);
+
+	/* Returns the neighbour of a cell across one of its strong faces if the line can be extended
+	 * to it, or -1 otherwise.
+	 */
+	auto next = [&](const a_int icell, const int istrong) -> a_int {
+		const a_int other = m.gesuel(icell, strongfaces[2*icell+istrong]);
+		if(other >= nelem || assigned[other] || ratio[other] < anisotropy)
+			return -1;
+		for(int j = 0; j < 2; j++)
+			if(m.gesuel(other, strongfaces[2*other+j]) == icell)
+				return other;
+		return -1;
+	};
+
+	lineptr.assign(1, 0);
+	cells.resize(0);
+	cells.reserve(nelem);
+	std::deque<a_int> line;
+	for(const a_int seed : seeds)
+	{
+		if(assigned[seed])
+			continue;
+		line.assign(1, seed);
+		assigned[seed] = 1;
+
+		if(ratio[seed] >= anisotropy)
+			for(int idir = 0; idir < 2; idir++)
+			{
+				// go in the direction of one strong face of the seed, then keep going through the
+				// strong face of each cell which does not lead back
+				a_int prev = seed, cur = next(seed, idir);
+				while(cur >= 0) {
+					assigned[cur] = 1;
+					if(idir == 0)
+						line.push_back(cur);
+					else
+						line.push_front(cur);
+					const int back = m.gesuel(cur, strongfaces[2*cur]) == prev ? 0 : 1;
+					prev = cur;
+					cur = next(cur, 1-back);
+				}
+			}
+
+		cells.insert(cells.end(), line.begin(), line.end());
+		lineptr.push_back(static_cast<a_int>(cells.size()));
+	}
+}
+
 }
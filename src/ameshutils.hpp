@@ -38,5 +38,56 @@ StatusCode reorderMesh(const char *const ordering, const Spatial<1>& sd, UMesh2d
  */
 std::vector<a_int> levelSchedule(const UMesh2dh& m);
 
+/// Divides mesh cells into levels for triangular solves with matrices coupling neighbouring cells
+/** A cell is put in the level following the last level of its neighbours numbered before it.
+ * So, as with \ref levelSchedule, no cell is coupled to another cell of its level; in addition,
+ * the lower (upper) triangular part of the row of a cell only couples it to cells in earlier
+ * (later) levels. The levels are not contiguous ranges of cells, so they are much larger than
+ * those of \ref levelSchedule.
+ * \param[out] levelptr Start of each level in \p cells; one more entry than the number of levels
+ * \param[out] cells All cells, sorted by level and in increasing order within each level
+ */
+void triangularLevelSchedule(const UMesh2dh& m, std::vector<a_int>& levelptr,
+		std::vector<a_int>& cells);
+
+/// Divides mesh cells into lines of strongly coupled cells, for line-implicit solvers
+/** The coupling of a cell to a neighbour across a face is the length of the face divided by the
+ * area of the cell, and the anisotropy of a cell is the ratio of its strongest coupling to its
+ * weakest. Lines are grown from the most anisotropic cells first. A line is extended from a cell
+ * to a neighbour across one of the two most strongly coupled faces of the cell if that face is
+ * also one of the two most strongly coupled faces of the neighbour, the neighbour is not yet in a
+ * line and both cells are anisotropic enough. Cells which cannot be put in a line with any other
+ * cell form lines of length one.
+ * \param anisotropy Minimum anisotropy of cells in lines of more than one cell
+ * \param[out] lineptr Start of each line in \p cells; one more entry than the number of lines
+ * \param[out] cells All cells, in order along each line
+ */
+void implicitLines(const UMesh2dh& m, const a_real anisotropy, std::vector<a_int>& lineptr,
+		std::vector<a_int>& cells);
+
+/// Lists the cells within a number of steps across interior faces from each cell
+/** Cells coupled only across periodic boundaries are not included.
+ * \param distance Maximum number of steps; the neighbourhood at distance 0 is the cell itself
+ * \param[out] ptr Start of the neighbourhood of each cell in \p cells; one more entry than the
+ *   number of cells
+ * \param[out] cells The neighbourhoods, each including the cell itself and in increasing order
+ */
+void cellNeighbourhoods(const UMesh2dh& m, const int distance, std::vector<a_int>& ptr,
+		std::vector<a_int>& cells);
+
+/// Colours the mesh cells so that cells of the same colour are more than a number of steps
+/// across interior faces apart
+/** The colouring is greedy, in the order of the cells. If the Jacobian row of a cell only
+ * couples it to cells within r steps, cells more than 2r steps apart are coupled to no common
+ * row; so a colouring at distance 2r lets the Jacobian be recovered column-block by
+ * column-block from one Jacobian-vector product per colour and variable.
+ * \param distance Cells of the same colour are more than this many steps apart
+ * \param[out] colourptr Start of each colour in \p cells; one more entry than the number of
+ *   colours
+ * \param[out] cells All cells, sorted by colour and in increasing order within each colour
+ */
+void distanceColouring(const UMesh2dh& m, const int distance, std::vector<a_int>& colourptr,
+		std::vector<a_int>& cells);
+
 }
 #endif
@@ -9,6 +9,8 @@
  * #defines work but get replaced
  */
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 #include "anumericalflux.hpp"
 
 namespace acfd {
@@ -17,6 +19,46 @@ InviscidFlux::InviscidFlux(const IdealGasPhysics *const phyctx)
 	: physics(phyctx), g{phyctx->g}
 { }
 
+void InviscidFlux::get_flux_batch(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	for(a_int i = 0; i < nfaces; i++)
+	{
+		a_real ul[NVARS], ur[NVARS], n[NDIM], flux[NVARS];
+		getBatchEntry<NVARS>(i, ulb, ul);
+		getBatchEntry<NVARS>(i, urb, ur);
+		getBatchEntry<NDIM>(i, nb, n);
+		get_flux(ul, ur, n, flux);
+		setBatchEntry<NVARS>(i, flux, fluxb);
+	}
+}
+
+void InviscidFlux::get_flux_batch_primitive(const a_int nfaces, 
+		const a_real *const wlb, const a_real *const wrb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	for(a_int i = 0; i < nfaces; i++)
+	{
+		a_real ul[NVARS], ur[NVARS], n[NDIM], flux[NVARS];
+		getBatchEntry<NVARS>(i, wlb, ul);
+		getBatchEntry<NVARS>(i, wrb, ur);
+		getBatchEntry<NDIM>(i, nb, n);
+		physics->getConservedFromPrimitive(ul, ul);
+		physics->getConservedFromPrimitive(ur, ur);
+		get_flux(ul, ur, n, flux);
+		setBatchEntry<NVARS>(i, flux, fluxb);
+	}
+}
+
+void InviscidFlux::get_flux_jacobian(const a_real *const ul, const a_real *const ur, 
+		const a_real *const n, 
+		a_real *const flux, a_real *const dfdl, a_real *const dfdr) const
+{
+	get_flux(ul, ur, n, flux);
+	get_jacobian(ul, ur, n, dfdl, dfdr);
+}
+
 /*void InviscidFlux::get_jacobian(const a_real *const uleft, const a_real *const uright, 
 		const a_real* const n, 
 		a_real *const dfdl, a_real *const dfdr)
@@ -29,28 +71,6 @@ LocalLaxFriedrichsFlux::LocalLaxFriedrichsFlux(const IdealGasPhysics *const anal
 	: InviscidFlux(analyticalflux)
 { }
 
-void LocalLaxFriedrichsFlux::get_flux(const a_real *const ul, 
-		const a_real *const ur, 
-		const a_real *const n, 
-		a_real *const __restrict flux) const
-{
-	a_real vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
-	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
-	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
-	ci = physics->getSoundSpeed(ul[0],pi);
-	cj = physics->getSoundSpeed(ur[0],pj);
-
-	const a_real eig = 
-		std::fabs(vni)+ci > std::fabs(vnj)+cj ? std::fabs(vni)+ci : std::fabs(vnj)+cj;
-	
-	physics->getDirectionalFluxFromConserved(ul,n,flux);
-	a_real fluxr[NVARS];
-	physics->getDirectionalFluxFromConserved(ur,n,fluxr);
-	for(int i = 0; i < NVARS; i++) {
-		flux[i] = 0.5*( flux[i] + fluxr[i] - eig*(ur[i]-ul[i]) );
-	}
-}
-
 /** Jacobian with frozen spectral radius
  */
 void LocalLaxFriedrichsFlux::get_jacobian(const a_real *const ul, const a_real *const ur,
@@ -95,6 +115,40 @@ void LocalLaxFriedrichsFlux::get_jacobian(const a_real *const ul, const a_real *
 		}
 }
 
+/** The flux and the Jacobian with frozen spectral radius share the flow variables and the
+ * spectral radius.
+ */
+void LocalLaxFriedrichsFlux::get_flux_jacobian(const a_real *const ul, const a_real *const ur,
+		const a_real* const n, a_real *const __restrict flux,
+		a_real *const __restrict dfdl, a_real *const __restrict dfdr) const
+{
+	a_real vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj;
+	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
+	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
+	const a_real ci = physics->getSoundSpeed(ul[0],pi);
+	const a_real cj = physics->getSoundSpeed(ur[0],pj);
+
+	const a_real eig = 
+		std::fabs(vni)+ci >= std::fabs(vnj)+cj ? std::fabs(vni)+ci : std::fabs(vnj)+cj;
+
+	a_real fluxr[NVARS];
+	physics->getDirectionalFlux(ul,n,vni,pi,flux);
+	physics->getDirectionalFlux(ur,n,vnj,pj,fluxr);
+	for(int i = 0; i < NVARS; i++)
+		flux[i] = 0.5*( flux[i] + fluxr[i] - eig*(ur[i]-ul[i]) );
+
+	physics->getJacobianDirectionalFluxWrtConserved(ul, n, dfdl);
+	physics->getJacobianDirectionalFluxWrtConserved(ur, n, dfdr);
+	for(int i = 0; i < NVARS; i++) {
+		dfdl[i*NVARS+i] += eig;
+		dfdr[i*NVARS+i] -= eig;
+	}
+	for(int i = 0; i < NVARS*NVARS; i++) {
+		dfdl[i] = -0.5*dfdl[i];
+		dfdr[i] =  0.5*dfdr[i];
+	}
+}
+
 // full linearization; no better than frozen version
 void LocalLaxFriedrichsFlux::get_jacobian_2(const a_real *const ul, 
 		const a_real *const ur,
@@ -186,55 +240,6 @@ VanLeerFlux::VanLeerFlux(const IdealGasPhysics *const analyticalflux)
 {
 }
 
-void VanLeerFlux::get_flux(const a_real *const ul, const a_real *const ur,
-		const a_real* const n, a_real *const __restrict flux) const
-{
-	a_real fiplus[NVARS], fjminus[NVARS];
-
-	a_real vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
-	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
-	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
-	ci = physics->getSoundSpeed(ul[0],pi);
-	cj = physics->getSoundSpeed(ur[0],pj);
-
-	//Normal mach numbers
-	const a_real Mni = vni/ci;
-	const a_real Mnj = vnj/cj;
-
-	//Calculate split fluxes
-	if(Mni < -1.0)
-		for(int i = 0; i < NVARS; i++)
-			fiplus[i] = 0;
-	else if(Mni > 1.0)
-		physics->getDirectionalFlux(ul,n,vni,pi,fiplus);
-	else
-	{
-		const a_real vmags = pow(ul[1]/ul[0], 2) + pow(ul[2]/ul[0], 2);
-		fiplus[0] = ul[0]*ci*pow(Mni+1, 2)/4.0;
-		fiplus[1] = fiplus[0] * (ul[1]/ul[0] + n[0]*(2.0*ci - vni)/g);
-		fiplus[2] = fiplus[0] * (ul[2]/ul[0] + n[1]*(2.0*ci - vni)/g);
-		fiplus[3] = fiplus[0] * ( (vmags - vni*vni)/2.0 + pow((g-1)*vni+2*ci, 2)/(2*(g*g-1)) );
-	}
-
-	if(Mnj > 1.0)
-		for(int i = 0; i < NVARS; i++)
-			fjminus[i] = 0;
-	else if(Mnj < -1.0)
-		physics->getDirectionalFlux(ur,n,vnj,pj,fjminus);
-	else
-	{
-		const a_real vmags = pow(ur[1]/ur[0], 2) + pow(ur[2]/ur[0], 2);
-		fjminus[0] = -ur[0]*cj*pow(Mnj-1, 2)/4.0;
-		fjminus[1] = fjminus[0] * (ur[1]/ur[0] + n[0]*(-2.0*cj - vnj)/g);
-		fjminus[2] = fjminus[0] * (ur[2]/ur[0] + n[1]*(-2.0*cj - vnj)/g);
-		fjminus[3] = fjminus[0] * ( (vmags - vnj*vnj)/2.0 + pow((g-1)*vnj-2*cj, 2)/(2*(g*g-1)) );
-	}
-
-	//Update the flux vector
-	for(int i = 0; i < NVARS; i++)
-		flux[i] = fiplus[i] + fjminus[i];
-}
-
 void VanLeerFlux::get_jacobian(const a_real *const ul, const a_real *const ur, 
 		const a_real* const n, a_real *const dfdl, a_real *const dfdr) const
 {
@@ -245,58 +250,6 @@ AUSMFlux::AUSMFlux(const IdealGasPhysics *const analyticalflux)
 	: InviscidFlux(analyticalflux)
 { }
 
-void AUSMFlux::get_flux(const a_real *const ul, const a_real *const ur,
-		const a_real* const n, a_real *const __restrict flux) const
-{
-	a_real ML, MR, pL, pR;
-	a_real vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
-	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
-	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
-	ci = physics->getSoundSpeed(ul[0],pi);
-	cj = physics->getSoundSpeed(ur[0],pj);
-
-	const a_real Mni = vni/ci, Mnj = vnj/cj;
-	
-	// split non-dimensional convection speeds (ie split Mach numbers) and split pressures
-	if(std::fabs(Mni) <= 1.0)
-	{
-		ML = 0.25*(Mni+1)*(Mni+1);
-		pL = ML*pi*(2.0-Mni);
-	}
-	else if(Mni < -1.0) {
-		ML = 0;
-		pL = 0;
-	}
-	else {
-		ML = Mni;
-		pL = pi;
-	}
-	
-	if(std::fabs(Mnj) <= 1.0) {
-		MR = -0.25*(Mnj-1)*(Mnj-1);
-		pR = -MR*pj*(2.0+Mnj);
-	}
-	else if(Mnj < -1.0) {
-		MR = Mnj;
-		pR = pj;
-	}
-	else {
-		MR = 0;
-		pR = 0;
-	}
-	
-	// Interface convection speed and pressure
-	const a_real Mhalf = ML+MR;
-	const a_real phalf = pL+pR;
-
-	// Fluxes
-	flux[0] = Mhalf/2.0*(ul[0]*ci+ur[0]*cj) -std::fabs(Mhalf)/2.0*(ur[0]*cj-ul[0]*ci);
-	for(int j = 1; j < NDIM+1; j++)
-		flux[j] = Mhalf/2.0*(ul[j]*ci+ur[j]*cj) -std::fabs(Mhalf)/2.0*(ur[j]*cj-ul[j]*ci) + phalf*n[j-1];
-	flux[3] = Mhalf/2.0*(ci*(ul[3]+pi)+cj*(ur[3]+pj)) 
-		-std::fabs(Mhalf)/2.0*(cj*(ur[3]+pj)-ci*(ul[3]+pi));
-}
-
 void AUSMFlux::get_jacobian(const a_real *const ul, const a_real *const ur, 
 		const a_real* const n, a_real *const dfdl, a_real *const dfdr) const
 {
@@ -457,81 +410,6 @@ AUSMPlusFlux::AUSMPlusFlux(const IdealGasPhysics *const analyticalflux)
 	: InviscidFlux(analyticalflux)
 { }
 
-void AUSMPlusFlux::get_flux(const a_real *const ul, const a_real *const ur,
-		const a_real* const n, a_real *const __restrict flux) const
-{
-	a_real ML, MR, pL, pR;
-	a_real vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
-	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
-	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
-	ci = physics->getSoundSpeed(ul[0],pi);
-	cj = physics->getSoundSpeed(ur[0],pj);
-	const a_real vmag2i = dimDotProduct(vi,vi);
-	const a_real vmag2j = dimDotProduct(vj,vj);
-
-	// Interface speed of sound
-	a_real csi = std::sqrt((ci*ci/(g-1.0)+0.5*vmag2i)*2.0*(g-1.0)/(g+1.0));
-	a_real csj = std::sqrt((cj*cj/(g-1.0)+0.5*vmag2j)*2.0*(g-1.0)/(g+1.0));
-	a_real corri, corrj;
-	if(csi > vni)
-		corri = csi;
-	else
-		corri = vni;
-	if(csj > -vnj)
-		corrj = csj;
-	else
-		corrj = -vnj;
-	csi = csi*csi/corri;
-	csj = csj*csj/corrj;
-	const a_real chalf = (csi < csj) ? csi : csj;
-	
-	const a_real Mni = vni/chalf, Mnj = vnj/chalf;
-	
-	// split non-dimensional convection speeds (ie split Mach numbers) and split pressures
-	if(std::fabs(Mni) <= 1.0)
-	{
-		ML = 0.25*(Mni+1)*(Mni+1) + 1.0/8.0*(Mni*Mni-1.0)*(Mni*Mni-1.0);
-		pL = pi*(0.25*(Mni+1)*(Mni+1)*(2.0-Mni) + 3.0/16*Mni*(Mni*Mni-1.0)*(Mni*Mni-1.0));
-	}
-	else if(Mni < -1.0) {
-		ML = 0;
-		pL = 0;
-	}
-	else {
-		ML = Mni;
-		pL = pi;
-	}
-	
-	if(std::fabs(Mnj) <= 1.0) {
-		MR = -0.25*(Mnj-1)*(Mnj-1) - 1.0/8.0*(Mnj*Mnj-1.0)*(Mnj*Mnj-1.0);
-		pR = pj*(0.25*(Mnj-1)*(Mnj-1)*(2.0+Mnj) - 3.0/16*Mnj*(Mnj*Mnj-1.0)*(Mnj*Mnj-1.0));
-	}
-	else if(Mnj < -1.0) {
-		MR = Mnj;
-		pR = pj;
-	}
-	else {
-		MR = 0;
-		pR = 0;
-	}
-	
-	// Interface convection speed and pressure
-	const a_real Mhalf = ML+MR;
-	const a_real phalf = pL+pR;
-
-	// Fluxes
-	flux[0] = chalf* (Mhalf/2.0*(ul[0]+ur[0]) -std::fabs(Mhalf)/2.0*(ur[0]-ul[0]));
-	for(int j = 1; j < NDIM+1; j++)
-		flux[j] = chalf* (Mhalf/2.0*(ul[j]+ur[j]) -std::fabs(Mhalf)/2.0*(ur[j]-ul[j])) + phalf*n[j-1];
-	flux[3] = chalf* (Mhalf/2.0*(ul[3]+pi+ur[3]+pj) -std::fabs(Mhalf)/2.0*((ur[3]+pj)-(ul[3]+pi)));
-	
-	/*const a_real mplus = 0.5*(Mhalf + std::fabs(Mhalf)), mminus = 0.5*(Mhalf - std::fabs(Mhalf));
-	flux[0] =  (mplus*ci*ul[0] + mminus*cj*ur[0]);
-	flux[1] =  (mplus*ci*ul[1] + mminus*cj*ur[1]) + phalf*n[0];
-	flux[2] =  (mplus*ci*ul[2] + mminus*cj*ur[2]) + phalf*n[1];
-	flux[3] =  (mplus*ci*(ul[3]+pi) + mminus*cj*(ur[3]+pj));*/
-}
-
 void AUSMPlusFlux::get_jacobian(const a_real *const ul, const a_real *const ur, 
 		const a_real* const n, a_real *const dfdl, a_real *const dfdr) const
 {
@@ -634,75 +512,25 @@ RoeFlux::RoeFlux(const IdealGasPhysics *const analyticalflux)
 	: RoeAverageBasedFlux(analyticalflux), fixeps{1.0e-4}
 { }
 
-void RoeFlux::get_flux(const a_real *const ul, const a_real *const ur,
-		const a_real* const n, a_real *const __restrict flux) const
-{
-	a_real vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj;
-	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
-	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
-
-	const a_real vxi = vi[0], vxj=vj[0], vyi=vi[1], vyj=vj[1];
-
-	// compute Roe-averages
-	a_real Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij;	
-	getRoeAverages(ul,ur,n,vxi,vyi,Hi,vxj,vyj,Hj, Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij);
-
-	// eigenvalues
-	a_real l[4];
-	l[0] = fabs(vnij-cij); l[1] = fabs(vnij); l[2] = l[1]; l[3] = fabs(vnij+cij);
-	
-	// Harten entropy fix
-	const a_real delta = fixeps*cij;
-	for(int ivar = 0; ivar < NVARS; ivar++)
-	{
-		if(l[ivar] < delta)
-			l[ivar] = (l[ivar]*l[ivar] + delta*delta)/(2.0*delta);
-	}
-
-	//> A_Roe * dU
-	
-	const a_real devn = vnj-vni, dep = pj-pi, derho = ur[0]-ul[0];
-	a_real adu[NVARS];
-	
-	// product of eigenvalues and wave strengths
-	a_real lalpha[NVARS];   
-	lalpha[0] = l[0]*(dep-rhoij*cij*devn)/(2.0*cij*cij);
-	lalpha[1] = l[1]*(derho - dep/(cij*cij));
-	lalpha[2] = l[1]*rhoij;
-	lalpha[3] = l[3]*(dep+rhoij*cij*devn)/(2.0*cij*cij);
-
-	// un-c:
-	adu[0] = lalpha[0];
-	adu[1] = lalpha[0]*(vxij-cij*n[0]);
-	adu[2] = lalpha[0]*(vyij-cij*n[1]);
-	adu[3] = lalpha[0]*(Hij-cij*vnij);
-
-	// un:
-	adu[0] += lalpha[1];
-	adu[1] += lalpha[1]*vxij +      lalpha[2]*(vxj-vxi - devn*n[0]); 
-	adu[2] += lalpha[1]*vyij +      lalpha[2]*(vyj-vyi - devn*n[1]);
-	adu[3] += lalpha[1]*vm2ij/2.0 + lalpha[2] *(vxij*(vxj-vxi) +vyij*(vyj-vyi) -vnij*devn);
-
-	// un+c:
-	adu[0] += lalpha[3];
-	adu[1] += lalpha[3]*(vxij+cij*n[0]);
-	adu[2] += lalpha[3]*(vyij+cij*n[1]);
-	adu[3] += lalpha[3]*(Hij+cij*vnij);
-
-	// get one-sided flux vectors
-	a_real fi[4], fj[4];
-	physics->getDirectionalFlux(ul,n,vni,pi,fi);
-	physics->getDirectionalFlux(ur,n,vnj,pj,fj);
-
-	// finally compute fluxes
-	for(int ivar = 0; ivar < NVARS; ivar++)
-		flux[ivar] = 0.5*(fi[ivar]+fj[ivar] - adu[ivar]);
-}
-
 /** \todo Works, but check correctness.
  */
 void RoeFlux::get_jacobian(const a_real *const ul, const a_real *const ur, 
 		const a_real* const n, a_real *const __restrict dfdl, a_real *const __restrict dfdr) const
+{
+	computeJacobian<false>(ul, ur, n, nullptr, dfdl, dfdr);
+}
+
+void RoeFlux::get_flux_jacobian(const a_real *const ul, const a_real *const ur, 
+		const a_real* const n, a_real *const __restrict flux,
+		a_real *const __restrict dfdl, a_real *const __restrict dfdr) const
+{
+	computeJacobian<true>(ul, ur, n, flux, dfdl, dfdr);
+}
+
+template <bool computeFlux>
+void RoeFlux::computeJacobian(const a_real *const ul, const a_real *const ur, 
+		const a_real* const n, a_real *const __restrict flux,
+		a_real *const __restrict dfdl, a_real *const __restrict dfdr) const
 {
 	a_real vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj;
 	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
@@ -909,17 +737,23 @@ void RoeFlux::get_jacobian(const a_real *const ul, const a_real *const ur,
 						+ lalpha[3]*(dHijj[k]+dcijj[k]*vnij+cij*dvnijj[k]);
 	}
 
+	if(computeFlux)
+	{
+		// the eigenvalues and wave strengths are the same as those used by get_flux
+		a_real fi[NVARS], fj[NVARS];
+		physics->getDirectionalFlux(ul,n,vni,pi,fi);
+		physics->getDirectionalFlux(ur,n,vnj,pj,fj);
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			flux[ivar] = 0.5*(fi[ivar]+fj[ivar] - adu[ivar]);
+	}
+
 	// get one-sided Jacobians
-	/*a_real fi[4], fj[4];
-	physics->getDirectionalFlux(ul,n,vni,pi,fi);
-	physics->getDirectionalFlux(ur,n,vnj,pj,fj);*/
 	physics->getJacobianDirectionalFluxWrtConserved(ul, n, dfdl);
 	physics->getJacobianDirectionalFluxWrtConserved(ur, n, dfdr);
 
-	// finally compute fluxes
+	// finally compute flux Jacobians
 	for(int ivar = 0; ivar < NVARS; ivar++)
 	{
-		//flux[ivar] = 0.5*(fi[ivar]+fj[ivar] - adu[ivar]);
 		for(int k = 0; k < NVARS; k++)
 		{
 			dfdl[ivar*NVARS+k] = - 0.5*(dfdl[ivar*NVARS+k] - dadui[ivar][k]);
@@ -933,440 +767,63 @@ HLLFlux::HLLFlux(const IdealGasPhysics *const analyticalflux)
 {
 }
 
-void HLLFlux::get_flux(const a_real *const __restrict__ ul, const a_real *const __restrict__ ur, 
-		const a_real* const __restrict__ n, a_real *const __restrict__ flux) const
-{
-	a_real vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
-	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
-	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
-	ci = physics->getSoundSpeed(ul[0], pi);
-	cj = physics->getSoundSpeed(ur[0], pj);
-
-	const a_real vxi = vi[0], vxj=vj[0], vyi=vi[1], vyj=vj[1];
-
-	//> compute Roe-averages
-	a_real Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij;	
-	getRoeAverages(ul,ur,n,vxi,vyi,Hi,vxj,vyj,Hj, Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij);
-
-	// Einfeldt estimate for signal speeds
-	a_real sl = vni - ci;
-	if (sl > vnij-cij)
-		sl = vnij-cij;
-	a_real sr = vnj+cj;
-	if(sr < vnij+cij)
-		sr = vnij+cij;
-	const a_real sr0 = sr > 0 ? 0 : sr;
-	const a_real sl0 = sl > 0 ? 0 : sl;
-
-	// flux
-	const a_real t1 = (sr0 - sl0)/(sr-sl); const a_real t2 = 1.0 - t1; 
-	const a_real t3 = 0.5*(sr*fabs(sl)-sl*fabs(sr))/(sr-sl);
-	flux[0] = t1*vnj*ur[0] + t2*vni*ul[0]                     - t3*(ur[0]-ul[0]);
-	flux[1] = t1*(vnj*ur[1]+pj*n[0]) + t2*(vni*ul[1]+pi*n[0]) - t3*(ur[1]-ul[1]);
-	flux[2] = t1*(vnj*ur[2]+pj*n[1]) + t2*(vni*ul[2]+pi*n[1]) - t3*(ur[2]-ul[2]);
-	flux[3] = t1*(vnj*ur[0]*Hj) + t2*(vni*ul[0]*Hi)           - t3*(ur[3]-ul[3]);
-}
-
-/** Automatically differentiated Jacobian w.r.t. left state, 
- * generated by Tapenade 3.12 (r6213) - 13 Oct 2016 10:54.
- * Modified to remove the runtime parameter nbdirs and the change in ul. 
- * Also changed the array shape of Jacobian.
+/** Differentiates \ref evaluateFlux with one dual-number evaluation per component of the left
+ * and right states.
  */
-void HLLFlux::getFluxJac_left(const a_real *const ul, 
-		                      const a_real *const ur, 
-		                      const a_real *const n, 
-		a_real *const __restrict flux, a_real *const __restrict fluxd) const
+void HLLFlux::get_jacobian_2(const a_real *const ul, const a_real *const ur, 
+		const a_real* const n, 
+		a_real *const __restrict dfdl, a_real *const __restrict dfdr) const
 {
-    a_real uld[NVARS][NVARS];
+	Dual dul[NVARS], dur[NVARS], dflux[NVARS];
 	for(int i = 0; i < NVARS; i++) {
-		for(int j = 0; j < NVARS; j++)
-			uld[i][j] = 0;
-		uld[i][i] = 1.0;
+		dul[i] = Dual(ul[i]);
+		dur[i] = Dual(ur[i]);
 	}
-	
-	const a_real g = 1.4;
-    a_real Hi, Hj, ci, cj, pi, pj, vxi, vxj, vyi, vyj, vmag2i, vmag2j, vni, vnj;
-    a_real Hid[NVARS], cid[NVARS], pid[NVARS], vxid[NVARS], vyid[NVARS], 
-		   vmag2id[NVARS], vnid[NVARS];
-    a_real fabs0;
-    a_real fabs0d[NVARS];
-    a_real fabs1;
-    a_real fabs1d[NVARS];
-    a_real arg1;
-    a_real arg1d[NVARS];
-    int nd;
- 	a_real sld[NVARS];
-    vxi = ul[1]/ul[0];
-    vyi = ul[2]/ul[0];
-    vmag2i = vxi*vxi + vyi*vyi;
-    pi = (g-1.0)*(ul[3]-0.5*ul[0]*vmag2i);
-    arg1 = g*pi/ul[0];
-    for (nd = 0; nd < NVARS; ++nd) {
-        vxid[nd] = (uld[1][nd]*ul[0]-ul[1]*uld[0][nd])/(ul[0]*ul[0]);
-        vyid[nd] = (uld[2][nd]*ul[0]-ul[2]*uld[0][nd])/(ul[0]*ul[0]);
-        vnid[nd] = n[0]*vxid[nd] + n[1]*vyid[nd];
-        vmag2id[nd] = vxid[nd]*vxi + vxi*vxid[nd] + vyid[nd]*vyi + vyi*vyid[nd];
-        // pressures
-        pid[nd] = (g-1.0)*(uld[3][nd]-0.5*(uld[0][nd]*vmag2i+ul[0]*vmag2id[nd]));
-        // speeds of sound
-        arg1d[nd] = (g*pid[nd]*ul[0]-g*pi*uld[0][nd])/(ul[0]*ul[0]);
-        cid[nd] = (arg1 == 0.0 ? 0.0 : arg1d[nd]/(2.0*sqrt(arg1)));
-        // enthalpies (E + p/rho = u(3)/u(0) + p/u(0) 
-		// (actually specific enthalpy := enthalpy per unit mass)
-        Hid[nd] = ((uld[3][nd]+pid[nd])*ul[0]-(ul[3]+pi)*uld[0][nd])/(ul[0]*ul[0]);
-        arg1d[nd] = -(ur[0]*uld[0][nd]/(ul[0]*ul[0]));
-        sld[nd] = vnid[nd] - cid[nd];
-    }
-    vxj = ur[1]/ur[0];
-    vyj = ur[2]/ur[0];
-    vni = vxi*n[0] + vyi*n[1];
-    vnj = vxj*n[0] + vyj*n[1];
-    vmag2j = vxj*vxj + vyj*vyj;
-    pj = (g-1.0)*(ur[3]-0.5*ur[0]*vmag2j);
-    ci = sqrt(arg1);
-    arg1 = g*pj/ur[0];
-    cj = sqrt(arg1);
-    Hi = (ul[3]+pi)/ul[0];
-    Hj = (ur[3]+pj)/ur[0];
-    // compute Roe-averages
-    a_real Rij, vxij, vyij, Hij, cij, vm2ij, vnij;
-    a_real Rijd[NVARS], vxijd[NVARS], vyijd[NVARS], Hijd[NVARS], cijd[NVARS], 
-		   vm2ijd[NVARS], vnijd[NVARS];
-    arg1 = ur[0]/ul[0];
-    Rij = sqrt(arg1);
-    vxij = (Rij*vxj+vxi)/(Rij+1.0);
-    vyij = (Rij*vyj+vyi)/(Rij+1.0);
-    for (nd = 0; nd < NVARS; ++nd) {
-        Rijd[nd] = (arg1 == 0.0 ? 0.0 : arg1d[nd]/(2.0*sqrt(arg1)));
-        vxijd[nd] = ((vxj*Rijd[nd]+vxid[nd])*(Rij+1.0)-(Rij*vxj+vxi)*Rijd[nd])
-			/((Rij+1.0)*(Rij+1.0));
-        vyijd[nd] = ((vyj*Rijd[nd]+vyid[nd])*(Rij+1.0)-(Rij*vyj+vyi)*Rijd[nd])
-			/((Rij+1.0)*(Rij+1.0));
-        Hijd[nd] = ((Hj*Rijd[nd]+Hid[nd])*(Rij+1.0)-(Rij*Hj+Hi)*Rijd[nd])/((Rij+1.0)*(Rij+1.0));
-        vm2ijd[nd] = vxijd[nd]*vxij + vxij*vxijd[nd] + vyijd[nd]*vyij + vyij*vyijd[nd];
-        vnijd[nd] = n[0]*vxijd[nd] + n[1]*vyijd[nd];
-        arg1d[nd] = (g-1.0)*(Hijd[nd]-0.5*vm2ijd[nd]);
-    }
-    Hij = (Rij*Hj+Hi)/(Rij+1.0);
-    vm2ij = vxij*vxij + vyij*vyij;
-    vnij = vxij*n[0] + vyij*n[1];
-    arg1 = (g-1.0)*(Hij-vm2ij*0.5);
-    for (nd = 0; nd < NVARS; ++nd)
-        cijd[nd] = (arg1 == 0.0 ? 0.0 : arg1d[nd]/(2.0*sqrt(arg1)));
-    cij = sqrt(arg1);
-    // Einfeldt estimate for signal speeds
-    a_real sr, sl, sr0, sl0;
-    a_real srd[NVARS], sr0d[NVARS], sl0d[NVARS];
-    sl = vni - ci;
-    if (sl > vnij - cij) {
-        for (nd = 0; nd < NVARS; ++nd)
-            sld[nd] = vnijd[nd] - cijd[nd];
-        sl = vnij - cij;
-    }
-    sr = vnj + cj;
-    if (sr < vnij + cij) {
-        for (nd = 0; nd < NVARS; ++nd)
-            srd[nd] = vnijd[nd] + cijd[nd];
-        sr = vnij + cij;
-    } else
-        for (nd = 0; nd < NVARS; ++nd)
-            srd[nd] = 0.0;
-    if (sr > 0) {
-        sr0 = 0;
-        for (nd = 0; nd < NVARS; ++nd)
-            sr0d[nd] = 0.0;
-    } else {
-        for (nd = 0; nd < NVARS; ++nd)
-            sr0d[nd] = srd[nd];
-        sr0 = sr;
-    }
-    if (sl > 0) {
-        sl0 = 0;
-        for (nd = 0; nd < NVARS; ++nd)
-            sl0d[nd] = 0.0;
-    } else {
-        for (nd = 0; nd < NVARS; ++nd)
-            sl0d[nd] = sld[nd];
-        sl0 = sl;
-    }
-    // flux
-    a_real t1, t2, t3;
-    a_real t1d[NVARS], t2d[NVARS], t3d[NVARS];
-    for (nd = 0; nd < NVARS; ++nd) {
-        t1d[nd] = ((sr0d[nd]-sl0d[nd])*(sr-sl)-(sr0-sl0)*(srd[nd]-sld[nd]))/((sr-sl)*(sr-sl));
-        t2d[nd] = -t1d[nd];
-    }
-    t1 = (sr0-sl0)/(sr-sl);
-    t2 = 1.0 - t1;
-    if (sl >= 0.0) {
-        for (nd = 0; nd < NVARS; ++nd)
-            fabs0d[nd] = sld[nd];
-        fabs0 = sl;
-    } else {
-        for (nd = 0; nd < NVARS; ++nd)
-            fabs0d[nd] = -sld[nd];
-        fabs0 = -sl;
-    }
-    if (sr >= 0.0) {
-        for (nd = 0; nd < NVARS; ++nd)
-            fabs1d[nd] = srd[nd];
-        fabs1 = sr;
-    } else {
-        for (nd = 0; nd < NVARS; ++nd)
-            fabs1d[nd] = -srd[nd];
-        fabs1 = -sr;
-    }
-    t3 = 0.5*(sr*fabs0-sl*fabs1)/(sr-sl);
-    for (nd = 0; nd < NVARS; ++nd) {
-        t3d[nd] = (0.5*(srd[nd]*fabs0+sr*fabs0d[nd]-sld[nd]*fabs1-sl*fabs1d[nd])*(sr-sl)
-				-0.5*(sr*fabs0-sl*fabs1)*(srd[nd]-sld[nd]))/((sr-sl)*(sr-sl));
-        fluxd[0*NVARS+nd] = vnj*ur[0]*t1d[nd] + (t2d[nd]*vni+t2*vnid[nd])*ul[0] 
-			+ t2*vni*uld[0][nd] - t3d[nd]*(ur[0]-ul[0]) + t3*uld[0][nd];
-    }
-    flux[0] = t1*vnj*ur[0] + t2*vni*ul[0] - t3*(ur[0]-ul[0]);
-    for (nd = 0; nd < NVARS; ++nd)
-        fluxd[1*NVARS+nd] = (vnj*ur[1]+pj*n[0])*t1d[nd] + t2d[nd]*(vni*ul[1]+pi*n[0]) 
-			+ t2*(vnid[nd]*ul[1]+vni*uld[1][nd]+n[0]*pid[nd]) - t3d[nd]*(ur[1]-ul[1]) 
-			+ t3*uld[1][nd];
-    flux[1] = t1*(vnj*ur[1]+pj*n[0]) + t2*(vni*ul[1]+pi*n[0]) - t3*(ur[1]-ul[1]);
-    for (nd = 0; nd < NVARS; ++nd)
-        fluxd[2*NVARS+nd] = (vnj*ur[2]+pj*n[1])*t1d[nd] + t2d[nd]*(vni*ul[2]+pi*n[1]) 
-			+ t2*(vnid[nd]*ul[2]+vni*uld[2][nd]+n[1]*pid[nd]) - t3d[nd]*(ur[2]-ul[2]) 
-			+ t3*uld[2][nd];
-    flux[2] = t1*(vnj*ur[2]+pj*n[1]) + t2*(vni*ul[2]+pi*n[1]) - t3*(ur[2]-ul[2]);
-    for (nd = 0; nd < NVARS; ++nd)
-        fluxd[3*NVARS+nd] = vnj*ur[0]*Hj*t1d[nd] + (t2d[nd]*vni+t2*vnid[nd])*ul[0]*Hi 
-			+ t2*vni*(uld[0][nd]*Hi+ul[0]*Hid[nd]) - t3d[nd]*(ur[3]-ul[3]) + t3*uld[3][nd];
-    flux[3] = t1*(vnj*ur[0]*Hj) + t2*(vni*ul[0]*Hi) - t3*(ur[3]-ul[3]);
-}
 
-/** Automatically differentiated Jacobian w.r.t. right state, 
- * generated by Tapenade 3.12 (r6213) - 13 Oct 2016 10:54.
- * Modified to remove the runtime parameter nbdirs and the differential of ul. 
- * Also changed the array shape of Jacobian.
- */
-void HLLFlux::getFluxJac_right(const a_real *const ul, const a_real *const ur, 
-		const a_real *const n, 
-		a_real *const __restrict flux, a_real *const __restrict fluxd) const
-{
-    a_real urd[NVARS][NVARS];
-	for(int i = 0; i < NVARS; i++) {
-		for(int j = 0; j < NVARS; j++)
-			urd[i][j] = 0;
-		urd[i][i] = 1.0;
-	}
+	for(int j = 0; j < NVARS; j++)
+	{
+		dul[j].der = 1.0;
+		evaluateFlux(dul, dur, n, dflux);
+		for(int i = 0; i < NVARS; i++)
+			dfdl[i*NVARS+j] = -dflux[i].der;
+		dul[j].der = 0;
 
-    a_real Hi, Hj, ci, cj, pi, pj, vxi, vxj, vyi, vyj, vmag2i, vmag2j, vni, vnj;
-    a_real Hjd[NVARS], cjd[NVARS], pjd[NVARS], vxjd[NVARS], vyjd[NVARS], 
-		   vmag2jd[NVARS], vnjd[NVARS];
-    a_real fabs0;
-    a_real fabs0d[NVARS];
-    a_real fabs1;
-    a_real fabs1d[NVARS];
-    a_real arg1;
-    a_real arg1d[NVARS];
-    int nd;
-    vxi = ul[1]/ul[0];
-    vyi = ul[2]/ul[0];
-    vxj = ur[1]/ur[0];
-    vyj = ur[2]/ur[0];
-    vmag2i = vxi*vxi + vyi*vyi;
-    vmag2j = vxj*vxj + vyj*vyj;
-    // pressures
-    pi = (g-1.0)*(ul[3]-0.5*ul[0]*vmag2i);
-    pj = (g-1.0)*(ur[3]-0.5*ur[0]*vmag2j);
-    // speeds of sound
-    arg1 = g*pi/ul[0];
-    ci = sqrt(arg1);
-    arg1 = g*pj/ur[0];
-    for (nd = 0; nd < NVARS; ++nd) {
-        vxjd[nd] = (urd[1][nd]*ur[0]-ur[1]*urd[0][nd])/(ur[0]*ur[0]);
-        vyjd[nd] = (urd[2][nd]*ur[0]-ur[2]*urd[0][nd])/(ur[0]*ur[0]);
-        vnjd[nd] = n[0]*vxjd[nd] + n[1]*vyjd[nd];
-        vmag2jd[nd] = vxjd[nd]*vxj + vxj*vxjd[nd] + vyjd[nd]*vyj + vyj*vyjd[nd];
-        pjd[nd] = (g-1.0)*(urd[3][nd]-0.5*(urd[0][nd]*vmag2j+ur[0]*vmag2jd[nd]));
-        arg1d[nd] = (g*pjd[nd]*ur[0]-g*pj*urd[0][nd])/(ur[0]*ur[0]);
-        cjd[nd] = (arg1 == 0.0 ? 0.0 : arg1d[nd]/(2.0*sqrt(arg1)));
-        Hjd[nd] = ((urd[3][nd]+pjd[nd])*ur[0]-(ur[3]+pj)*urd[0][nd])/(ur[0]*ur[0]);
-        arg1d[nd] = urd[0][nd]/ul[0];
-    }
-    vni = vxi*n[0] + vyi*n[1];
-    vnj = vxj*n[0] + vyj*n[1];
-    cj = sqrt(arg1);
-    // enthalpies (E + p/rho = u(3)/u(0) + p/u(0) 
-	// (actually specific enthalpy := enthalpy per unit mass)
-    Hi = (ul[3]+pi)/ul[0];
-    Hj = (ur[3]+pj)/ur[0];
-    // compute Roe-averages
-    a_real Rij, vxij, vyij, Hij, cij, vm2ij, vnij;
-    a_real Rijd[NVARS], vxijd[NVARS], vyijd[NVARS], Hijd[NVARS], cijd[NVARS], 
-		   vm2ijd[NVARS], vnijd[NVARS];
-    arg1 = ur[0]/ul[0];
-    Rij = sqrt(arg1);
-    vxij = (Rij*vxj+vxi)/(Rij+1.0);
-    vyij = (Rij*vyj+vyi)/(Rij+1.0);
-    for (nd = 0; nd < NVARS; ++nd) {
-        Rijd[nd] = (arg1 == 0.0 ? 0.0 : arg1d[nd]/(2.0*sqrt(arg1)));
-        vxijd[nd] = ((Rijd[nd]*vxj+Rij*vxjd[nd])*(Rij+1.0)-(Rij*vxj+vxi)*Rijd[nd])
-			/((Rij+1.0)*(Rij+1.0));
-        vyijd[nd] = ((Rijd[nd]*vyj+Rij*vyjd[nd])*(Rij+1.0)-(Rij*vyj+vyi)*Rijd[nd])
-			/((Rij+1.0)*(Rij+1.0));
-        Hijd[nd] = ((Rijd[nd]*Hj+Rij*Hjd[nd])*(Rij+1.0)-(Rij*Hj+Hi)*Rijd[nd])/((Rij+1.0)*(Rij+1.0));
-        vm2ijd[nd] = vxijd[nd]*vxij + vxij*vxijd[nd] + vyijd[nd]*vyij + vyij*vyijd[nd];
-        vnijd[nd] = n[0]*vxijd[nd] + n[1]*vyijd[nd];
-        arg1d[nd] = (g-1.0)*(Hijd[nd]-0.5*vm2ijd[nd]);
-    }
-    Hij = (Rij*Hj+Hi)/(Rij+1.0);
-    vm2ij = vxij*vxij + vyij*vyij;
-    vnij = vxij*n[0] + vyij*n[1];
-    arg1 = (g-1.0)*(Hij-vm2ij*0.5);
-    for (nd = 0; nd < NVARS; ++nd)
-        cijd[nd] = (arg1 == 0.0 ? 0.0 : arg1d[nd]/(2.0*sqrt(arg1)));
-    cij = sqrt(arg1);
-    // Einfeldt estimate for signal speeds
-    a_real sr, sl, sr0, sl0;
-    a_real srd[NVARS], sld[NVARS], sr0d[NVARS], sl0d[NVARS];
-    sl = vni - ci;
-    if (sl > vnij - cij) {
-        for (nd = 0; nd < NVARS; ++nd)
-            sld[nd] = vnijd[nd] - cijd[nd];
-        sl = vnij - cij;
-    } else
-        for (nd = 0; nd < NVARS; ++nd)
-            sld[nd] = 0.0;
-    for (nd = 0; nd < NVARS; ++nd)
-        srd[nd] = vnjd[nd] + cjd[nd];
-    sr = vnj + cj;
-    if (sr < vnij + cij) {
-        for (nd = 0; nd < NVARS; ++nd)
-            srd[nd] = vnijd[nd] + cijd[nd];
-        sr = vnij + cij;
-    }
-    if (sr > 0) {
-        sr0 = 0;
-        for (nd = 0; nd < NVARS; ++nd)
-            sr0d[nd] = 0.0;
-    } else {
-        for (nd = 0; nd < NVARS; ++nd)
-            sr0d[nd] = srd[nd];
-        sr0 = sr;
-    }
-    if (sl > 0) {
-        sl0 = 0;
-        for (nd = 0; nd < NVARS; ++nd)
-            sl0d[nd] = 0.0;
-    } else {
-        for (nd = 0; nd < NVARS; ++nd)
-            sl0d[nd] = sld[nd];
-        sl0 = sl;
-    }
-    // flux
-    a_real t1, t2, t3;
-    a_real t1d[NVARS], t2d[NVARS], t3d[NVARS];
-    for (nd = 0; nd < NVARS; ++nd) {
-        t1d[nd] = ((sr0d[nd]-sl0d[nd])*(sr-sl)-(sr0-sl0)*(srd[nd]-sld[nd]))/((sr-sl)*(sr-sl));
-        t2d[nd] = -t1d[nd];
-    }
-    t1 = (sr0-sl0)/(sr-sl);
-    t2 = 1.0 - t1;
-    if (sl >= 0.0) {
-        for (nd = 0; nd < NVARS; ++nd)
-            fabs0d[nd] = sld[nd];
-        fabs0 = sl;
-    } else {
-        for (nd = 0; nd < NVARS; ++nd)
-            fabs0d[nd] = -sld[nd];
-        fabs0 = -sl;
-    }
-    if (sr >= 0.0) {
-        for (nd = 0; nd < NVARS; ++nd)
-            fabs1d[nd] = srd[nd];
-        fabs1 = sr;
-    } else {
-        for (nd = 0; nd < NVARS; ++nd)
-            fabs1d[nd] = -srd[nd];
-        fabs1 = -sr;
-    }
-    t3 = 0.5*(sr*fabs0-sl*fabs1)/(sr-sl);
-    for (nd = 0; nd < NVARS; ++nd) {
-        t3d[nd] = (0.5*(srd[nd]*fabs0+sr*fabs0d[nd]-sld[nd]*fabs1-sl*fabs1d[nd])*(sr-sl)
-			-0.5*(sr*fabs0-sl*fabs1)*(srd[nd]-sld[nd]))/((sr-sl)*(sr-sl));
-        fluxd[0*NVARS+nd] = (t1d[nd]*vnj+t1*vnjd[nd])*ur[0] + t1*vnj*urd[0][nd] + vni*ul[0]*t2d[nd] 
-			- t3d[nd]*(ur[0]-ul[0]) - t3*urd[0][nd];
-    }
-    flux[0] = t1*vnj*ur[0] + t2*vni*ul[0] - t3*(ur[0]-ul[0]);
-    for (nd = 0; nd < NVARS; ++nd)
-        fluxd[1*NVARS+nd] = t1d[nd]*(vnj*ur[1]+pj*n[0]) 
-			+ t1*(vnjd[nd]*ur[1]+vnj*urd[1][nd]+n[0]*pjd[nd]) 
-			+ (vni*ul[1]+pi*n[0])*t2d[nd] - t3d[nd]*(ur[1]-ul[1]) - t3*urd[1][nd];
-    flux[1] = t1*(vnj*ur[1]+pj*n[0]) + t2*(vni*ul[1]+pi*n[0]) - t3*(ur[1]-ul[1]);
-    for (nd = 0; nd < NVARS; ++nd)
-        fluxd[2*NVARS+nd] = t1d[nd]*(vnj*ur[2]+pj*n[1]) 
-			+ t1*(vnjd[nd]*ur[2]+vnj*urd[2][nd]+n[1]*pjd[nd]) 
-			+ (vni*ul[2]+pi*n[1])*t2d[nd] - t3d[nd]*(ur[2]-ul[2]) - t3*urd[2][nd];
-    flux[2] = t1*(vnj*ur[2]+pj*n[1]) + t2*(vni*ul[2]+pi*n[1]) - t3*(ur[2]-ul[2]);
-    for (nd = 0; nd < NVARS; ++nd)
-        fluxd[3*NVARS+nd] = (t1d[nd]*vnj+t1*vnjd[nd])*ur[0]*Hj 
-			+ t1*vnj*(urd[0][nd]*Hj+ur[0]*Hjd[nd]) 
-			+ vni*ul[0]*Hi*t2d[nd] - t3d[nd]*(ur[3]-ul[3]) - t3*urd[3][nd];
-    flux[3] = t1*(vnj*ur[0]*Hj) + t2*(vni*ul[0]*Hi) - t3*(ur[3]-ul[3]);
+		dur[j].der = 1.0;
+		evaluateFlux(dul, dur, n, dflux);
+		for(int i = 0; i < NVARS; i++)
+			dfdr[i*NVARS+j] = dflux[i].der;
+		dur[j].der = 0;
+	}
 }
 
-void HLLFlux::get_jacobian_2(const a_real *const ul, const a_real *const ur, 
+/** The linearization assumes `locally frozen' signal speeds. 
+ * According to Batten, Lechziner and Goldberg, this should be fine.
+ */
+void HLLFlux::get_jacobian(const a_real *const ul, const a_real *const ur, 
 		const a_real* const n, 
 		a_real *const __restrict dfdl, a_real *const __restrict dfdr) const
 {
 	a_real flux[NVARS];
-	getFluxJac_left(ul, ur, n, flux, dfdl);
-	getFluxJac_right(ul, ur, n, flux, dfdr);
-	for(int i = 0; i < NVARS*NVARS; i++)
-		dfdl[i] *= -1.0;
+	computeJacobian(ul, ur, n, flux, dfdl, dfdr);
 }
 
+/** The Jacobians are the same as those of \ref get_jacobian, with frozen signal speeds.
+ */
 void HLLFlux::get_flux_jacobian(const a_real *const ul, const a_real *const ur, 
 		const a_real* const n, 
 		a_real *const __restrict flux, 
 		a_real *const __restrict dfdl, a_real *const __restrict dfdr) const
 {
-	getFluxJac_left(ul, ur, n, flux, dfdl);
-	getFluxJac_right(ul, ur, n, flux, dfdr);
-	for(int i = 0; i < NVARS*NVARS; i++)
-		dfdl[i] *= -1.0;
+	computeJacobian(ul, ur, n, flux, dfdl, dfdr);
 }
 
-/** The linearization assumes `locally frozen' signal speeds. 
- * According to Batten, Lechziner and Goldberg, this should be fine.
- */
-void HLLFlux::get_jacobian(const a_real *const ul, const a_real *const ur, 
-		const a_real* const n, 
+void HLLFlux::computeJacobian(const a_real *const ul, const a_real *const ur, 
+		const a_real* const n, a_real *const __restrict flux,
 		a_real *const __restrict dfdl, a_real *const __restrict dfdr) const
 {
-	a_real vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
-	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
-	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
-	ci = physics->getSoundSpeed(ul[0], pi);
-	cj = physics->getSoundSpeed(ur[0], pj);
-
-	const a_real vxi = vi[0], vxj=vj[0], vyi=vi[1], vyj=vj[1];
+	a_real t1, t2, t3;
+	evaluateFluxAndWeights(ul, ur, n, flux, t1, t2, t3);
 
-	// compute Roe-averages
-	a_real Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij;	
-	getRoeAverages(ul,ur,n,vxi,vyi,Hi,vxj,vyj,Hj, Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij);
-
-	// Einfeldt estimate for signal speeds
-	a_real sr, sl;
-	sl = vni - ci;
-	if (sl > vnij-cij)
-		sl = vnij-cij;
-	sr = vnj+cj;
-	if(sr < vnij+cij)
-		sr = vnij+cij;
-	const a_real sr0 = sr > 0 ? 0 : sr;
-	const a_real sl0 = sl > 0 ? 0 : sl;
-	const a_real t1 = (sr0 - sl0)/(sr-sl); 
-	const a_real t2 = 1.0 - t1; 
-	const a_real t3 = 0.5*(sr*fabs(sl)-sl*fabs(sr))/(sr-sl);
-	
 	// get flux jacobians
 	physics->getJacobianDirectionalFluxWrtConserved(ul, n, dfdl);
 	physics->getJacobianDirectionalFluxWrtConserved(ur, n, dfdr);
@@ -1391,19 +848,6 @@ HLLCFlux::HLLCFlux(const IdealGasPhysics *const analyticalflux)
 {
 }
 
-inline
-void HLLCFlux::getStarState(const a_real u[NVARS], const a_real n[NDIM],
-	const a_real vn, const a_real p, 
-	const a_real ss, const a_real sm,
-	a_real *const __restrict ustr) const
-{
-	const a_real pstar = u[0]*(vn-ss)*(vn-sm) + p;
-	ustr[0] = u[0] * (ss - vn)/(ss-sm);
-	ustr[1] = ( (ss-vn)*u[1] + (pstar-p)*n[0] )/(ss-sm);
-	ustr[2] = ( (ss-vn)*u[2] + (pstar-p)*n[1] )/(ss-sm);
-	ustr[3] = ( (ss-vn)*u[3] - p*vn + pstar*sm )/(ss-sm);
-}
-
 inline
 void HLLCFlux::getStarStateAndJacobian(const a_real u[NVARS], const a_real n[NDIM],
 	const a_real vn, const a_real p, 
@@ -1493,63 +937,6 @@ void HLLCFlux::getStarStateAndJacobian(const a_real u[NVARS], const a_real n[NDI
 		- ((ss-vn)*u[3]-p*vn+pstar*sm)*(dssj[3]-dsmj[3]) )/((ss-sm)*(ss-sm));
 }
 
-/** \todo See if the implementation can be tweaked to reduce round-off errors.
- */
-void HLLCFlux::get_flux(const a_real *const ul, const a_real *const ur, const a_real* const n, 
-		a_real *const __restrict flux) const
-{
-	a_real vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
-	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
-	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
-	ci = physics->getSoundSpeed(ul[0], pi);
-	cj = physics->getSoundSpeed(ur[0], pj);
-
-	const a_real vxi = vi[0], vxj=vj[0], vyi=vi[1], vyj=vj[1];
-
-	// compute Roe-averages
-	a_real Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij;	
-	getRoeAverages(ul,ur,n,vxi,vyi,Hi,vxj,vyj,Hj, Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij);
-
-	// estimate signal speeds
-	a_real sr, sl;
-	sl = vni - ci;
-	if (sl > vnij-cij)
-		sl = vnij-cij;
-	sr = vnj+cj;
-	if(sr < vnij+cij)
-		sr = vnij+cij;
-	const a_real sm = ( ur[0]*vnj*(sr-vnj) - ul[0]*vni*(sl-vni) + pi-pj ) 
-		/ ( ur[0]*(sr-vnj) - ul[0]*(sl-vni) );
-
-	// compute fluxes
-	
-	if(sl > 0)
-		physics->getDirectionalFlux(ul,n,vni,pi,flux);
-
-	else if(sl <= 0 && sm > 0)
-	{
-		physics->getDirectionalFlux(ul,n,vni,pi,flux);
-
-		a_real ulstr[NVARS];
-		getStarState(ul,n,vni,pi,sl,sm,ulstr);
-
-		for(int ivar = 0; ivar < NVARS; ivar++)
-			flux[ivar] += sl * ( ulstr[ivar] - ul[ivar]);
-	}
-	else if(sm <= 0 && sr >= 0)
-	{
-		physics->getDirectionalFlux(ur,n,vnj,pj,flux);
-
-		a_real urstr[NVARS];
-		getStarState(ur,n,vnj,pj,sr,sm,urstr);
-
-		for(int ivar = 0; ivar < NVARS; ivar++)
-			flux[ivar] += sr * ( urstr[ivar] - ur[ivar]);
-	}
-	else
-		physics->getDirectionalFlux(ur,n,vnj,pj,flux);
-}
-
 void HLLCFlux::get_jacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 		a_real *const __restrict dfdl, a_real *const __restrict dfdr) const
 {
@@ -1716,11 +1103,4 @@ void HLLCFlux::get_jacobian(const a_real *const ul, const a_real *const ur, cons
 		dfdl[i] *= -1.0;
 }
 
-void HLLCFlux::get_flux_jacobian(const a_real *const ul, const a_real *const ur, 
-		const a_real* const n, 
-		a_real *const __restrict flux, a_real *const __restrict dfdl, a_real *const __restrict dfdr) const
-{
-	std::cout << " !!!! Not available!!\n";
-}
-
 } // end namespace acfd
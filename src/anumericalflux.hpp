@@ -7,8 +7,10 @@
 #ifndef ANUMERICALFLUX_H
 #define ANUMERICALFLUX_H 1
 
+#include <cassert>
 #include "aconstants.hpp"
 #include "aphysics.hpp"
+#include "adual.hpp"
 
 namespace acfd {
 
@@ -32,6 +34,42 @@ public:
 			const a_real* const n, 
 			a_real *const flux) const = 0;
 
+	/// Computes flux across a face, along with its derivative in some direction
+	/** Same as the real-valued \ref get_flux, evaluated with states that carry the derivative
+	 * of the left and right states along the direction. The derivative of the flux in the
+	 * output is exact, up to the choice of branch at points where the flux is not smooth.
+	 */
+	virtual void get_flux(const Dual *const uleft, const Dual *const uright, 
+			const a_real* const n, 
+			Dual *const flux) const = 0;
+
+	/// Computes fluxes across a batch of faces
+	/** The states, normals and fluxes are stored in a structure-of-arrays layout: the ivar-th
+	 * component for the i-th face of the batch is at index ivar*FLUX_BATCH_SIZE + i. The
+	 * stride is a compile-time constant whatever the number of faces in the batch.
+	 * The default implementation calls \ref get_flux for each face; flux schemes override it
+	 * with a loop over faces that is vectorized with their flux inlined into it.
+	 * \param[in] nfaces Number of faces in the batch, at most FLUX_BATCH_SIZE
+	 * \param[in] uleft Left states of the faces, NVARS x FLUX_BATCH_SIZE
+	 * \param[in] uright Right states of the faces, NVARS x FLUX_BATCH_SIZE
+	 * \param[in] n Unit normals of the faces, NDIM x FLUX_BATCH_SIZE
+	 * \param[in,out] flux Computed fluxes, NVARS x FLUX_BATCH_SIZE
+	 */
+	virtual void get_flux_batch(const a_int nfaces, 
+			const a_real *const uleft, const a_real *const uright, const a_real *const n,
+			a_real *const flux) const;
+
+	/// Computes fluxes across a batch of faces from primitive variables
+	/** Same as \ref get_flux_batch, except that the left and right states are primitive
+	 * variables (density, velocities and pressure). This lets a second-order residual pass
+	 * reconstructed face values directly to the flux, without converting them to conserved
+	 * variables only to have the flux recompute pressure from them.
+	 * The default implementation converts each face's states and calls \ref get_flux.
+	 */
+	virtual void get_flux_batch_primitive(const a_int nfaces, 
+			const a_real *const wleft, const a_real *const wright, const a_real *const n,
+			a_real *const flux) const;
+
 	/// Computes the Jacobian of inviscid flux across a face w.r.t. both left and right states
 	/** dfdl is the `lower' block formed by the coupling between elements adjoining the face,
 	 * while dfdr is the `upper' block.
@@ -43,6 +81,16 @@ public:
 			const a_real* const n,
 			a_real *const dfdl, a_real *const dfdr) const = 0;
 
+	/// Computes the flux across a face and its Jacobians w.r.t. the left and right states
+	/** The outputs are the same as those of \ref get_flux and \ref get_jacobian. Flux schemes
+	 * override this to compute the quantities needed by both, such as averaged states and 
+	 * wave speeds, only once. The default implementation calls the two functions.
+	 * \warning The output is *assigned* to the arrays dfdl and dfdr - any prior contents are lost!
+	 */
+	virtual void get_flux_jacobian(const a_real *const uleft, const a_real *const uright, 
+			const a_real *const n,
+			a_real *const flux, a_real *const dfdl, a_real *const dfdr) const;
+
 	virtual ~InviscidFlux();
 
 protected:
@@ -50,7 +98,7 @@ protected:
 	const a_real g;                              ///< Adiabatic index
 };
 
-class LocalLaxFriedrichsFlux : public InviscidFlux
+class LocalLaxFriedrichsFlux final : public InviscidFlux
 {
 public:
 	LocalLaxFriedrichsFlux(const IdealGasPhysics *const analyticalflux);
@@ -59,6 +107,21 @@ public:
 	 */
 	void get_flux(const a_real *const uleft, const a_real *const uright, const a_real* const n, 
 			a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux
+	 */
+	void get_flux(const Dual *const uleft, const Dual *const uright, const a_real* const n, 
+			Dual *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch
+	 */
+	void get_flux_batch(const a_int nfaces, const a_real *const ul, const a_real *const ur,
+			const a_real *const n, a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch_primitive
+	 */
+	void get_flux_batch_primitive(const a_int nfaces, const a_real *const ul, 
+			const a_real *const ur, const a_real *const n, a_real *const flux) const;
 	
 	/** Currently computes an approximate Jacobian with frozen spectral radius.
 	 * This has been found to perform no worse than the exact Jacobian for inviscid flows.
@@ -68,15 +131,28 @@ public:
 	void get_jacobian(const a_real *const uleft, const a_real *const uright, const a_real* const n, 
 			a_real *const dfdl, a_real *const dfdr) const;
 
+	/** \sa InviscidFlux::get_flux_jacobian
+	 */
+	void get_flux_jacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
+			a_real *const flux, a_real *const dfdl, a_real *const dfdr) const;
+
 	/** Computes the exact Jacobian.
 	 * This has been done to make the frozen Jacobian default.
 	 */
 	void get_jacobian_2(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const dfdl, a_real *const dfdr) const;
+
+	/// Computes the flux across one face for either real or dual-number states
+	/** This is the kernel of \ref get_flux and of the batched fluxes. Its cases are selected
+	 * without branches, so that it can be vectorized across the faces of a batch.
+	 */
+	template <typename scalar>
+	void evaluateFlux(const scalar *const ul, const scalar *const ur, const a_real *const n,
+			scalar *const flux) const __attribute((always_inline));
 };
 
 /// Van-Leer flux-vector-splitting
-class VanLeerFlux : public InviscidFlux
+class VanLeerFlux final : public InviscidFlux
 {
 public:
 	VanLeerFlux(const IdealGasPhysics *const analyticalflux);
@@ -84,8 +160,29 @@ public:
 	 */
 	void get_flux(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux
+	 */
+	void get_flux(const Dual *const ul, const Dual *const ur, const a_real* const n, 
+			Dual *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch
+	 */
+	void get_flux_batch(const a_int nfaces, const a_real *const ul, const a_real *const ur,
+			const a_real *const n, a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch_primitive
+	 */
+	void get_flux_batch_primitive(const a_int nfaces, const a_real *const ul, 
+			const a_real *const ur, const a_real *const n, a_real *const flux) const;
 	void get_jacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const dfdl, a_real *const dfdr) const;
+
+	/// Computes the flux across one face for either real or dual-number states
+	/// \sa LocalLaxFriedrichsFlux::evaluateFlux
+	template <typename scalar>
+	void evaluateFlux(const scalar *const ul, const scalar *const ur, const a_real *const n,
+			scalar *const flux) const __attribute((always_inline));
 };
 
 /// Liou-Steffen AUSM flux-vector-splitting
@@ -94,7 +191,7 @@ public:
  * separately.
  * \warning The Jacobian does not work; use the LLF Jacobian instead.
  */
-class AUSMFlux : public InviscidFlux
+class AUSMFlux final : public InviscidFlux
 {
 public:
 	AUSMFlux(const IdealGasPhysics *const analyticalflux);
@@ -103,16 +200,37 @@ public:
 	 */
 	void get_flux(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux
+	 */
+	void get_flux(const Dual *const ul, const Dual *const ur, const a_real* const n, 
+			Dual *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch
+	 */
+	void get_flux_batch(const a_int nfaces, const a_real *const ul, const a_real *const ur,
+			const a_real *const n, a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch_primitive
+	 */
+	void get_flux_batch_primitive(const a_int nfaces, const a_real *const ul, 
+			const a_real *const ur, const a_real *const n, a_real *const flux) const;
 	
 	/** \sa InviscidFlux::get_jacobian
 	 * \warning The output is *assigned* to the arrays dfdl and dfdr - any prior contents are lost!
 	 */
 	void get_jacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const dfdl, a_real *const dfdr) const;
+
+	/// Computes the flux across one face for either real or dual-number states
+	/// \sa LocalLaxFriedrichsFlux::evaluateFlux
+	template <typename scalar>
+	void evaluateFlux(const scalar *const ul, const scalar *const ur, const a_real *const n,
+			scalar *const flux) const __attribute((always_inline));
 };
 
 /// Liou's AUSM+ flux
-class AUSMPlusFlux : public InviscidFlux
+class AUSMPlusFlux final : public InviscidFlux
 {
 public:
 	AUSMPlusFlux(const IdealGasPhysics *const analyticalflux);
@@ -120,9 +238,30 @@ public:
 	 */
 	void get_flux(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux
+	 */
+	void get_flux(const Dual *const ul, const Dual *const ur, const a_real* const n, 
+			Dual *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch
+	 */
+	void get_flux_batch(const a_int nfaces, const a_real *const ul, const a_real *const ur,
+			const a_real *const n, a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch_primitive
+	 */
+	void get_flux_batch_primitive(const a_int nfaces, const a_real *const ul, 
+			const a_real *const ur, const a_real *const n, a_real *const flux) const;
 	
 	void get_jacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const dfdl, a_real *const dfdr) const;
+
+	/// Computes the flux across one face for either real or dual-number states
+	/// \sa LocalLaxFriedrichsFlux::evaluateFlux
+	template <typename scalar>
+	void evaluateFlux(const scalar *const ul, const scalar *const ur, const a_real *const n,
+			scalar *const flux) const __attribute((always_inline));
 };
 
 /// Abstract class for fluxes which depend on Roe-averages
@@ -132,19 +271,22 @@ public:
 	RoeAverageBasedFlux(const IdealGasPhysics *const analyticalflux);
 	virtual void get_flux(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const flux) const = 0;
+	virtual void get_flux(const Dual *const ul, const Dual *const ur, const a_real* const n, 
+			Dual *const flux) const = 0;
 	virtual void get_jacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const dfdl, a_real *const dfdr) const = 0;
 
 protected:
 
 	/// Computes Roe-averaged quantities
-	void getRoeAverages(const a_real ul[NVARS], const a_real ur[NVARS], const a_real n[NDIM],
-		const a_real vxi, const a_real vyi, const a_real Hi,
-		const a_real vxj, const a_real vyj, const a_real Hj,
-		a_real& Rij, a_real& rhoij, a_real& vxij, a_real& vyij, a_real &vm2ij, a_real& vnij,
-		a_real& Hij, a_real& cij) const
+	template <typename scalar>
+	void getRoeAverages(const scalar ul[NVARS], const scalar ur[NVARS], const a_real n[NDIM],
+		const scalar vxi, const scalar vyi, const scalar Hi,
+		const scalar vxj, const scalar vyj, const scalar Hj,
+		scalar& Rij, scalar& rhoij, scalar& vxij, scalar& vyij, scalar &vm2ij, scalar& vnij,
+		scalar& Hij, scalar& cij) const
 	{
-		Rij = std::sqrt(ur[0]/ul[0]);
+		Rij = sqrt(ur[0]/ul[0]);
 		rhoij = Rij*ul[0];
 		vxij = (Rij*vxj + vxi)/(Rij + 1.0);
 		vyij = (Rij*vyj + vyi)/(Rij + 1.0);
@@ -172,7 +314,7 @@ protected:
 /// Roe-Pike flux-difference splitting
 /** From Blazek \cite{blazek}.
  */
-class RoeFlux : public RoeAverageBasedFlux
+class RoeFlux final : public RoeAverageBasedFlux
 {
 public:
 	RoeFlux(const IdealGasPhysics *const analyticalflux);
@@ -181,30 +323,54 @@ public:
 	 */
 	void get_flux(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux
+	 */
+	void get_flux(const Dual *const ul, const Dual *const ur, const a_real* const n, 
+			Dual *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch
+	 */
+	void get_flux_batch(const a_int nfaces, const a_real *const ul, const a_real *const ur,
+			const a_real *const n, a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch_primitive
+	 */
+	void get_flux_batch_primitive(const a_int nfaces, const a_real *const ul, 
+			const a_real *const ur, const a_real *const n, a_real *const flux) const;
 	
 	/** \sa InviscidFlux::get_jacobian
 	 * \warning The output is *assigned* to the arrays dfdl and dfdr - any prior contents are lost!
 	 */
 	void get_jacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const dfdl, a_real *const dfdr) const;
+
+	/** \sa InviscidFlux::get_flux_jacobian
+	 */
+	void get_flux_jacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
+			a_real *const flux, a_real *const dfdl, a_real *const dfdr) const;
+
+	/// Computes the flux across one face for either real or dual-number states
+	/// \sa LocalLaxFriedrichsFlux::evaluateFlux
+	template <typename scalar>
+	void evaluateFlux(const scalar *const ul, const scalar *const ur, const a_real *const n,
+			scalar *const flux) const __attribute((always_inline));
 protected:
 	/// Entropy fix parameter
 	const a_real fixeps;
+private:
+	/// Computes the flux Jacobians, and the flux itself if requested, from the same Roe averages
+	template <bool computeFlux>
+	void computeJacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
+			a_real *const flux, a_real *const dfdl, a_real *const dfdr) const;
 };
 
 /// Harten Lax Van-Leer numerical flux
 /** Decent for inviscid flows.
  * \cite invflux_batten
  */
-class HLLFlux : public RoeAverageBasedFlux
+class HLLFlux final : public RoeAverageBasedFlux
 {
-	/// Computes the Jacobian of the numerical flux w.r.t. left state
-	void getFluxJac_left(const a_real *const ul, const a_real *const ur, const a_real *const n, 
-			a_real *const flux, a_real *const fluxd) const;
-	/// Computes the Jacobian of the numerical flux w.r.t. right state
-	void getFluxJac_right(const a_real *const ul, const a_real *const ur, const a_real *const n, 
-			a_real *const flux, a_real *const fluxd) const;
-
 public:
 	HLLFlux(const IdealGasPhysics *const analyticalflux);
 	
@@ -212,6 +378,21 @@ public:
 	 */
 	void get_flux(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux
+	 */
+	void get_flux(const Dual *const ul, const Dual *const ur, const a_real* const n, 
+			Dual *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch
+	 */
+	void get_flux_batch(const a_int nfaces, const a_real *const ul, const a_real *const ur,
+			const a_real *const n, a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch_primitive
+	 */
+	void get_flux_batch_primitive(const a_int nfaces, const a_real *const ul, 
+			const a_real *const ur, const a_real *const n, a_real *const flux) const;
 	
 	/** \sa InviscidFlux::get_jacobian
 	 * \warning The output is *assigned* to the arrays dfdl and dfdr - any prior contents are lost!
@@ -219,20 +400,43 @@ public:
 	void get_jacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const dfdl, a_real *const dfdr) const;
 
-	/// Computes both the flux and the 2 flux Jacobians
+	/** \sa InviscidFlux::get_flux_jacobian
+	 */
 	void get_flux_jacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const flux, a_real *const dfdl, a_real *const dfdr) const;
 	
+	/// Computes the Jacobian without freezing the signal speeds
 	void get_jacobian_2(const a_real *const ul, const a_real *const ur, 
 			const a_real* const n, 
 			a_real *const dfdl, a_real *const dfdr) const;
+
+	/// Computes the flux across one face for either real or dual-number states
+	/// \sa LocalLaxFriedrichsFlux::evaluateFlux
+	template <typename scalar>
+	void evaluateFlux(const scalar *const ul, const scalar *const ur, const a_real *const n,
+			scalar *const flux) const __attribute((always_inline));
+
+private:
+	/// Computes the flux along with the weights of the left and right states in it
+	/** The flux is t1 f(ur) + t2 f(ul) - t3 (ur - ul), where f is the physical flux normal to
+	 * the face. This is the one place where the HLL flux is defined; \ref evaluateFlux and the
+	 * Jacobians are all computed from it.
+	 */
+	template <typename scalar>
+	void evaluateFluxAndWeights(const scalar *const ul, const scalar *const ur,
+			const a_real *const n, scalar *const flux, scalar& t1, scalar& t2, scalar& t3) const
+		__attribute((always_inline));
+
+	/// Computes the flux and the flux Jacobians with frozen signal speeds
+	void computeJacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
+			a_real *const flux, a_real *const dfdl, a_real *const dfdr) const;
 };
 
 /// Harten Lax Van-Leer numerical flux with contact restoration by Toro
 /** Implemented as described by Batten et al. \cite invflux_hllc_batten
  * Good for both inviscid and viscous flows.
  */
-class HLLCFlux : public RoeAverageBasedFlux
+class HLLCFlux final : public RoeAverageBasedFlux
 {
 public:
 	HLLCFlux(const IdealGasPhysics *const analyticalflux);
@@ -241,16 +445,27 @@ public:
 	 */
 	void get_flux(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux
+	 */
+	void get_flux(const Dual *const ul, const Dual *const ur, const a_real* const n, 
+			Dual *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch
+	 */
+	void get_flux_batch(const a_int nfaces, const a_real *const ul, const a_real *const ur,
+			const a_real *const n, a_real *const flux) const;
+
+	/** \sa InviscidFlux::get_flux_batch_primitive
+	 */
+	void get_flux_batch_primitive(const a_int nfaces, const a_real *const ul, 
+			const a_real *const ur, const a_real *const n, a_real *const flux) const;
 	
 	/** \sa InviscidFlux::get_jacobian
 	 * \warning The output is *assigned* to the arrays dfdl and dfdr - any prior contents are lost!
 	 */
 	void get_jacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
 			a_real *const dfdl, a_real *const dfdr) const;
-	
-	/// Computes both the flux and the 2 flux Jacobians
-	void get_flux_jacobian(const a_real *const ul, const a_real *const ur, const a_real* const n, 
-			a_real *const flux, a_real *const dfdl, a_real *const dfdr) const;
 
 protected:
 	/// Computes the averaged state between the waves in the Riemann fan
@@ -262,10 +477,11 @@ protected:
 	 * \param[in] sm Contact wave speed
 	 * \param[in|out] ustr The output average state
 	 */
-	void getStarState(const a_real u[NVARS], const a_real n[NDIM],
-		const a_real vn, const a_real p, 
-		const a_real ss, const a_real sm,
-		a_real *const __restrict ustr) const;
+	template <typename scalar>
+	void getStarState(const scalar u[NVARS], const a_real n[NDIM],
+		const scalar vn, const scalar p, 
+		const scalar ss, const scalar sm,
+		scalar *const __restrict ustr) const;
 
 	/// Computes the averaged state between the waves in the Riemann fan
 	/// and corresponding Jacobians
@@ -296,8 +512,580 @@ protected:
 		a_real ustr[NVARS],
 		a_real dustri[NVARS][NVARS], 
 		a_real dustrj[NVARS][NVARS]) const __attribute((always_inline));
+
+public:
+	/// Computes the flux across one face for either real or dual-number states
+	/// \sa LocalLaxFriedrichsFlux::evaluateFlux
+	template <typename scalar>
+	void evaluateFlux(const scalar *const ul, const scalar *const ur, const a_real *const n,
+			scalar *const flux) const __attribute((always_inline));
 };
 
+/* The per-face fluxes and the batched fluxes built on them are defined here, so that callers
+ * that know the type of the flux scheme, such as FlowFVStatic, can have them inlined.
+ */
+
+/// Copies the data of one face out of a batch stored in structure-of-arrays layout
+template <int ncomp>
+inline void getBatchEntry(const a_int iface, 
+		const a_real *const __restrict batch, a_real *const __restrict entry)
+{
+	for(int i = 0; i < ncomp; i++)
+		entry[i] = batch[i*FLUX_BATCH_SIZE + iface];
+}
+
+/// Copies the data of one face into a batch stored in structure-of-arrays layout
+template <int ncomp>
+inline void setBatchEntry(const a_int iface, 
+		const a_real *const __restrict entry, a_real *const __restrict batch)
+{
+	for(int i = 0; i < ncomp; i++)
+		batch[i*FLUX_BATCH_SIZE + iface] = entry[i];
+}
+
+/// Computes the numerical flux across one face of a batch with the per-face flux of a scheme
+/** The states are gathered into arrays local to this function rather than to the loop over
+ * faces, so that they can be kept in (vector) registers once this is inlined into the loop.
+ * \tparam primitiveInput Whether the states are primitive variables instead of conserved
+ */
+template <bool primitiveInput, typename Flux>
+inline void computeBatchEntry(const Flux& scheme, const IdealGasPhysics& physics,
+		const a_int iface, 
+		const a_real *const __restrict ulb, const a_real *const __restrict urb, 
+		const a_real *const __restrict nb, a_real *const __restrict fluxb)
+	__attribute((always_inline));
+
+template <bool primitiveInput, typename Flux>
+inline void computeBatchEntry(const Flux& scheme, const IdealGasPhysics& physics,
+		const a_int iface, 
+		const a_real *const __restrict ulb, const a_real *const __restrict urb, 
+		const a_real *const __restrict nb, a_real *const __restrict fluxb)
+{
+	a_real ul[NVARS], ur[NVARS], n[NDIM], flux[NVARS];
+	getBatchEntry<NVARS>(iface, ulb, ul);
+	getBatchEntry<NVARS>(iface, urb, ur);
+	getBatchEntry<NDIM>(iface, nb, n);
+	if(primitiveInput) {
+		physics.getConservedFromPrimitive(ul, ul);
+		physics.getConservedFromPrimitive(ur, ur);
+	}
+	scheme.evaluateFlux(ul, ur, n, flux);
+	setBatchEntry<NVARS>(iface, flux, fluxb);
+}
+
+/// Computes numerical fluxes across a batch of faces with the per-face flux of a scheme
+/** The stride of the batch is known at compile time, and the scheme's evaluateFlux is inlined
+ * into the loop over faces. The flux schemes select between their cases (upwind sides,
+ * regions of the Riemann fan, entropy fixes) without branches, so that the loop can be
+ * vectorized across faces.
+ * \tparam primitiveInput Whether the states are primitive variables instead of conserved
+ */
+template <bool primitiveInput, typename Flux>
+inline void computeFluxBatch(const Flux& scheme, const IdealGasPhysics& physics,
+		const a_int nfaces, 
+		const a_real *const __restrict ulb, const a_real *const __restrict urb, 
+		const a_real *const __restrict nb, a_real *const __restrict fluxb)
+{
+	assert(nfaces <= FLUX_BATCH_SIZE);
+
+#pragma omp simd
+	for(a_int iface = 0; iface < nfaces; iface++)
+		computeBatchEntry<primitiveInput>(scheme, physics, iface, ulb, urb, nb, fluxb);
+}
+
+template <typename scalar>
+inline void LocalLaxFriedrichsFlux::evaluateFlux(const scalar *const ul, 
+		const scalar *const ur, 
+		const a_real *const n, 
+		scalar *const __restrict flux) const
+{
+	scalar vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
+	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
+	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
+	ci = physics->getSoundSpeed(ul[0],pi);
+	cj = physics->getSoundSpeed(ur[0],pj);
+
+	const scalar eig = 
+		fabs(vni)+ci > fabs(vnj)+cj ? fabs(vni)+ci : fabs(vnj)+cj;
+	
+	physics->getDirectionalFlux(ul,n,vni,pi,flux);
+	scalar fluxr[NVARS];
+	physics->getDirectionalFlux(ur,n,vnj,pj,fluxr);
+	for(int i = 0; i < NVARS; i++) {
+		flux[i] = 0.5*( flux[i] + fluxr[i] - eig*(ur[i]-ul[i]) );
+	}
+}
+
+inline void LocalLaxFriedrichsFlux::get_flux(const a_real *const ul, const a_real *const ur,
+		const a_real* const n, a_real *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void LocalLaxFriedrichsFlux::get_flux(const Dual *const ul, const Dual *const ur,
+		const a_real* const n, Dual *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void LocalLaxFriedrichsFlux::get_flux_batch(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<false>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+inline void LocalLaxFriedrichsFlux::get_flux_batch_primitive(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<true>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+template <typename scalar>
+inline void VanLeerFlux::evaluateFlux(const scalar *const ul, const scalar *const ur,
+		const a_real* const n, scalar *const __restrict flux) const
+{
+	scalar fiplus[NVARS], fjminus[NVARS];
+
+	scalar vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
+	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
+	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
+	ci = physics->getSoundSpeed(ul[0],pi);
+	cj = physics->getSoundSpeed(ur[0],pj);
+
+	//Normal mach numbers
+	const scalar Mni = vni/ci;
+	const scalar Mnj = vnj/cj;
+
+	// Split fluxes for subsonic normal Mach numbers
+	const scalar vmagsi = (ul[1]/ul[0])*(ul[1]/ul[0]) + (ul[2]/ul[0])*(ul[2]/ul[0]);
+	fiplus[0] = ul[0]*ci*(Mni+1)*(Mni+1)/4.0;
+	fiplus[1] = fiplus[0] * (ul[1]/ul[0] + n[0]*(2.0*ci - vni)/g);
+	fiplus[2] = fiplus[0] * (ul[2]/ul[0] + n[1]*(2.0*ci - vni)/g);
+	fiplus[3] = fiplus[0] * ( (vmagsi - vni*vni)/2.0 
+			+ ((g-1)*vni+2*ci)*((g-1)*vni+2*ci)/(2*(g*g-1)) );
+
+	const scalar vmagsj = (ur[1]/ur[0])*(ur[1]/ur[0]) + (ur[2]/ur[0])*(ur[2]/ur[0]);
+	fjminus[0] = -ur[0]*cj*(Mnj-1)*(Mnj-1)/4.0;
+	fjminus[1] = fjminus[0] * (ur[1]/ur[0] + n[0]*(-2.0*cj - vnj)/g);
+	fjminus[2] = fjminus[0] * (ur[2]/ur[0] + n[1]*(-2.0*cj - vnj)/g);
+	fjminus[3] = fjminus[0] * ( (vmagsj - vnj*vnj)/2.0 
+			+ ((g-1)*vnj-2*cj)*((g-1)*vnj-2*cj)/(2*(g*g-1)) );
+
+	// Supersonic split fluxes are either the full flux or zero; select without branches
+	scalar fisup[NVARS], fjsup[NVARS];
+	physics->getDirectionalFlux(ul,n,vni,pi,fisup);
+	physics->getDirectionalFlux(ur,n,vnj,pj,fjsup);
+	const a_real supi = Mni > 1.0 ? 1.0 : 0.0, supj = Mnj < -1.0 ? 1.0 : 0.0;
+	const bool subi = fabs(Mni) <= 1.0, subj = fabs(Mnj) <= 1.0;
+
+	//Update the flux vector
+	for(int i = 0; i < NVARS; i++)
+		flux[i] = (subi ? fiplus[i] : supi*fisup[i]) + (subj ? fjminus[i] : supj*fjsup[i]);
+}
+
+inline void VanLeerFlux::get_flux(const a_real *const ul, const a_real *const ur,
+		const a_real* const n, a_real *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void VanLeerFlux::get_flux(const Dual *const ul, const Dual *const ur,
+		const a_real* const n, Dual *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void VanLeerFlux::get_flux_batch(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<false>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+inline void VanLeerFlux::get_flux_batch_primitive(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<true>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+template <typename scalar>
+inline void AUSMFlux::evaluateFlux(const scalar *const ul, const scalar *const ur,
+		const a_real* const n, scalar *const __restrict flux) const
+{
+	scalar vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
+	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
+	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
+	ci = physics->getSoundSpeed(ul[0],pi);
+	cj = physics->getSoundSpeed(ur[0],pj);
+
+	const scalar Mni = vni/ci, Mnj = vnj/cj;
+	
+	// split non-dimensional convection speeds (ie split Mach numbers) and split pressures,
+	// selected without branches
+	const scalar MLsub = 0.25*(Mni+1)*(Mni+1);
+	const scalar ML = fabs(Mni) <= 1.0 ? MLsub : (Mni < -1.0 ? scalar(0) : Mni);
+	const scalar pL = fabs(Mni) <= 1.0 ? MLsub*pi*(2.0-Mni) : (Mni < -1.0 ? scalar(0) : pi);
+	
+	const scalar MRsub = -0.25*(Mnj-1)*(Mnj-1);
+	const scalar MR = fabs(Mnj) <= 1.0 ? MRsub : (Mnj < -1.0 ? Mnj : scalar(0));
+	const scalar pR = fabs(Mnj) <= 1.0 ? -MRsub*pj*(2.0+Mnj) : (Mnj < -1.0 ? pj : scalar(0));
+	
+	// Interface convection speed and pressure
+	const scalar Mhalf = ML+MR;
+	const scalar phalf = pL+pR;
+
+	// Fluxes
+	flux[0] = Mhalf/2.0*(ul[0]*ci+ur[0]*cj) -fabs(Mhalf)/2.0*(ur[0]*cj-ul[0]*ci);
+	for(int j = 1; j < NDIM+1; j++)
+		flux[j] = Mhalf/2.0*(ul[j]*ci+ur[j]*cj) -fabs(Mhalf)/2.0*(ur[j]*cj-ul[j]*ci) + phalf*n[j-1];
+	flux[3] = Mhalf/2.0*(ci*(ul[3]+pi)+cj*(ur[3]+pj)) 
+		-fabs(Mhalf)/2.0*(cj*(ur[3]+pj)-ci*(ul[3]+pi));
+}
+
+inline void AUSMFlux::get_flux(const a_real *const ul, const a_real *const ur,
+		const a_real* const n, a_real *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void AUSMFlux::get_flux(const Dual *const ul, const Dual *const ur,
+		const a_real* const n, Dual *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void AUSMFlux::get_flux_batch(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<false>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+inline void AUSMFlux::get_flux_batch_primitive(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<true>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+template <typename scalar>
+inline void AUSMPlusFlux::evaluateFlux(const scalar *const ul, const scalar *const ur,
+		const a_real* const n, scalar *const __restrict flux) const
+{
+	scalar vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
+	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
+	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
+	ci = physics->getSoundSpeed(ul[0],pi);
+	cj = physics->getSoundSpeed(ur[0],pj);
+	const scalar vmag2i = dimDotProduct(vi,vi);
+	const scalar vmag2j = dimDotProduct(vj,vj);
+
+	// Interface speed of sound
+	scalar csi = sqrt((ci*ci/(g-1.0)+0.5*vmag2i)*2.0*(g-1.0)/(g+1.0));
+	scalar csj = sqrt((cj*cj/(g-1.0)+0.5*vmag2j)*2.0*(g-1.0)/(g+1.0));
+	const scalar corri = csi > vni ? csi : vni;
+	const scalar corrj = csj > -vnj ? csj : -vnj;
+	csi = csi*csi/corri;
+	csj = csj*csj/corrj;
+	const scalar chalf = (csi < csj) ? csi : csj;
+	
+	const scalar Mni = vni/chalf, Mnj = vnj/chalf;
+	
+	// split non-dimensional convection speeds (ie split Mach numbers) and split pressures,
+	// selected without branches
+	const scalar MLsub = 0.25*(Mni+1)*(Mni+1) + 1.0/8.0*(Mni*Mni-1.0)*(Mni*Mni-1.0);
+	const scalar pLsub = 
+		pi*(0.25*(Mni+1)*(Mni+1)*(2.0-Mni) + 3.0/16*Mni*(Mni*Mni-1.0)*(Mni*Mni-1.0));
+	const scalar ML = fabs(Mni) <= 1.0 ? MLsub : (Mni < -1.0 ? scalar(0) : Mni);
+	const scalar pL = fabs(Mni) <= 1.0 ? pLsub : (Mni < -1.0 ? scalar(0) : pi);
+	
+	const scalar MRsub = -0.25*(Mnj-1)*(Mnj-1) - 1.0/8.0*(Mnj*Mnj-1.0)*(Mnj*Mnj-1.0);
+	const scalar pRsub = 
+		pj*(0.25*(Mnj-1)*(Mnj-1)*(2.0+Mnj) - 3.0/16*Mnj*(Mnj*Mnj-1.0)*(Mnj*Mnj-1.0));
+	const scalar MR = fabs(Mnj) <= 1.0 ? MRsub : (Mnj < -1.0 ? Mnj : scalar(0));
+	const scalar pR = fabs(Mnj) <= 1.0 ? pRsub : (Mnj < -1.0 ? pj : scalar(0));
+	
+	// Interface convection speed and pressure
+	const scalar Mhalf = ML+MR;
+	const scalar phalf = pL+pR;
+
+	// Fluxes
+	flux[0] = chalf* (Mhalf/2.0*(ul[0]+ur[0]) -fabs(Mhalf)/2.0*(ur[0]-ul[0]));
+	for(int j = 1; j < NDIM+1; j++)
+		flux[j] = chalf* (Mhalf/2.0*(ul[j]+ur[j]) -fabs(Mhalf)/2.0*(ur[j]-ul[j])) + phalf*n[j-1];
+	flux[3] = chalf* (Mhalf/2.0*(ul[3]+pi+ur[3]+pj) -fabs(Mhalf)/2.0*((ur[3]+pj)-(ul[3]+pi)));
+	
+	/*const scalar mplus = 0.5*(Mhalf + fabs(Mhalf)), mminus = 0.5*(Mhalf - fabs(Mhalf));
+	flux[0] =  (mplus*ci*ul[0] + mminus*cj*ur[0]);
+	flux[1] =  (mplus*ci*ul[1] + mminus*cj*ur[1]) + phalf*n[0];
+	flux[2] =  (mplus*ci*ul[2] + mminus*cj*ur[2]) + phalf*n[1];
+	flux[3] =  (mplus*ci*(ul[3]+pi) + mminus*cj*(ur[3]+pj));*/
+}
+
+inline void AUSMPlusFlux::get_flux(const a_real *const ul, const a_real *const ur,
+		const a_real* const n, a_real *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void AUSMPlusFlux::get_flux(const Dual *const ul, const Dual *const ur,
+		const a_real* const n, Dual *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void AUSMPlusFlux::get_flux_batch(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<false>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+inline void AUSMPlusFlux::get_flux_batch_primitive(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<true>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+template <typename scalar>
+inline void RoeFlux::evaluateFlux(const scalar *const ul, const scalar *const ur,
+		const a_real* const n, scalar *const __restrict flux) const
+{
+	scalar vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj;
+	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
+	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
+
+	const scalar vxi = vi[0], vxj=vj[0], vyi=vi[1], vyj=vj[1];
+
+	// compute Roe-averages
+	scalar Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij;	
+	getRoeAverages(ul,ur,n,vxi,vyi,Hi,vxj,vyj,Hj, Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij);
+
+	// eigenvalues
+	scalar l[4];
+	l[0] = fabs(vnij-cij); l[1] = fabs(vnij); l[2] = l[1]; l[3] = fabs(vnij+cij);
+	
+	// Harten entropy fix
+	const scalar delta = fixeps*cij;
+	for(int ivar = 0; ivar < NVARS; ivar++)
+		l[ivar] = l[ivar] < delta ? (l[ivar]*l[ivar] + delta*delta)/(2.0*delta) : l[ivar];
+
+	//> A_Roe * dU
+	
+	const scalar devn = vnj-vni, dep = pj-pi, derho = ur[0]-ul[0];
+	scalar adu[NVARS];
+	
+	// product of eigenvalues and wave strengths
+	scalar lalpha[NVARS];   
+	lalpha[0] = l[0]*(dep-rhoij*cij*devn)/(2.0*cij*cij);
+	lalpha[1] = l[1]*(derho - dep/(cij*cij));
+	lalpha[2] = l[1]*rhoij;
+	lalpha[3] = l[3]*(dep+rhoij*cij*devn)/(2.0*cij*cij);
+
+	// un-c:
+	adu[0] = lalpha[0];
+	adu[1] = lalpha[0]*(vxij-cij*n[0]);
+	adu[2] = lalpha[0]*(vyij-cij*n[1]);
+	adu[3] = lalpha[0]*(Hij-cij*vnij);
+
+	// un:
+	adu[0] += lalpha[1];
+	adu[1] += lalpha[1]*vxij +      lalpha[2]*(vxj-vxi - devn*n[0]); 
+	adu[2] += lalpha[1]*vyij +      lalpha[2]*(vyj-vyi - devn*n[1]);
+	adu[3] += lalpha[1]*vm2ij/2.0 + lalpha[2] *(vxij*(vxj-vxi) +vyij*(vyj-vyi) -vnij*devn);
+
+	// un+c:
+	adu[0] += lalpha[3];
+	adu[1] += lalpha[3]*(vxij+cij*n[0]);
+	adu[2] += lalpha[3]*(vyij+cij*n[1]);
+	adu[3] += lalpha[3]*(Hij+cij*vnij);
+
+	// get one-sided flux vectors
+	scalar fi[4], fj[4];
+	physics->getDirectionalFlux(ul,n,vni,pi,fi);
+	physics->getDirectionalFlux(ur,n,vnj,pj,fj);
+
+	// finally compute fluxes
+	for(int ivar = 0; ivar < NVARS; ivar++)
+		flux[ivar] = 0.5*(fi[ivar]+fj[ivar] - adu[ivar]);
+}
+
+inline void RoeFlux::get_flux(const a_real *const ul, const a_real *const ur,
+		const a_real* const n, a_real *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void RoeFlux::get_flux(const Dual *const ul, const Dual *const ur,
+		const a_real* const n, Dual *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void RoeFlux::get_flux_batch(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<false>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+inline void RoeFlux::get_flux_batch_primitive(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<true>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+template <typename scalar>
+inline void HLLFlux::evaluateFlux(const scalar *const __restrict__ ul, const scalar *const __restrict__ ur, 
+		const a_real* const __restrict__ n, scalar *const __restrict__ flux) const
+{
+	scalar t1, t2, t3;
+	evaluateFluxAndWeights(ul, ur, n, flux, t1, t2, t3);
+}
+
+template <typename scalar>
+inline void HLLFlux::evaluateFluxAndWeights(const scalar *const __restrict__ ul,
+		const scalar *const __restrict__ ur, const a_real* const __restrict__ n,
+		scalar *const __restrict__ flux, scalar& t1, scalar& t2, scalar& t3) const
+{
+	scalar vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
+	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
+	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
+	ci = physics->getSoundSpeed(ul[0], pi);
+	cj = physics->getSoundSpeed(ur[0], pj);
+
+	const scalar vxi = vi[0], vxj=vj[0], vyi=vi[1], vyj=vj[1];
+
+	//> compute Roe-averages
+	scalar Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij;	
+	getRoeAverages(ul,ur,n,vxi,vyi,Hi,vxj,vyj,Hj, Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij);
+
+	// Einfeldt estimate for signal speeds
+	const scalar sl = vni - ci > vnij-cij ? vnij-cij : vni - ci;
+	const scalar sr = vnj + cj < vnij+cij ? vnij+cij : vnj + cj;
+	const scalar sr0 = sr > 0 ? scalar(0) : sr;
+	const scalar sl0 = sl > 0 ? scalar(0) : sl;
+
+	// flux
+	t1 = (sr0 - sl0)/(sr-sl); t2 = 1.0 - t1; 
+	t3 = 0.5*(sr*fabs(sl)-sl*fabs(sr))/(sr-sl);
+	flux[0] = t1*vnj*ur[0] + t2*vni*ul[0]                     - t3*(ur[0]-ul[0]);
+	flux[1] = t1*(vnj*ur[1]+pj*n[0]) + t2*(vni*ul[1]+pi*n[0]) - t3*(ur[1]-ul[1]);
+	flux[2] = t1*(vnj*ur[2]+pj*n[1]) + t2*(vni*ul[2]+pi*n[1]) - t3*(ur[2]-ul[2]);
+	flux[3] = t1*(vnj*ur[0]*Hj) + t2*(vni*ul[0]*Hi)           - t3*(ur[3]-ul[3]);
+}
+
+inline void HLLFlux::get_flux(const a_real *const ul, const a_real *const ur,
+		const a_real* const n, a_real *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void HLLFlux::get_flux(const Dual *const ul, const Dual *const ur,
+		const a_real* const n, Dual *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void HLLFlux::get_flux_batch(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<false>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+inline void HLLFlux::get_flux_batch_primitive(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<true>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+template <typename scalar>
+inline void HLLCFlux::getStarState(const scalar u[NVARS], const a_real n[NDIM],
+	const scalar vn, const scalar p, 
+	const scalar ss, const scalar sm,
+	scalar *const __restrict ustr) const
+{
+	const scalar pstar = u[0]*(vn-ss)*(vn-sm) + p;
+	ustr[0] = u[0] * (ss - vn)/(ss-sm);
+	ustr[1] = ( (ss-vn)*u[1] + (pstar-p)*n[0] )/(ss-sm);
+	ustr[2] = ( (ss-vn)*u[2] + (pstar-p)*n[1] )/(ss-sm);
+	ustr[3] = ( (ss-vn)*u[3] - p*vn + pstar*sm )/(ss-sm);
+}
+
+/** \todo See if the implementation can be tweaked to reduce round-off errors.
+ */
+template <typename scalar>
+inline void HLLCFlux::evaluateFlux(const scalar *const ul, const scalar *const ur, const a_real* const n, 
+		scalar *const __restrict flux) const
+{
+	scalar vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj, ci, cj;
+	physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
+	physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
+	ci = physics->getSoundSpeed(ul[0], pi);
+	cj = physics->getSoundSpeed(ur[0], pj);
+
+	const scalar vxi = vi[0], vxj=vj[0], vyi=vi[1], vyj=vj[1];
+
+	// compute Roe-averages
+	scalar Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij;	
+	getRoeAverages(ul,ur,n,vxi,vyi,Hi,vxj,vyj,Hj, Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij);
+
+	// estimate signal speeds
+	const scalar sl = vni - ci > vnij-cij ? vnij-cij : vni - ci;
+	const scalar sr = vnj + cj < vnij+cij ? vnij+cij : vnj + cj;
+	const scalar sm = ( ur[0]*vnj*(sr-vnj) - ul[0]*vni*(sl-vni) + pi-pj ) 
+		/ ( ur[0]*(sr-vnj) - ul[0]*(sl-vni) );
+
+	/* The fluxes in all four regions of the Riemann fan are computed and the one containing
+	 * the face is selected, so that there are no branches.
+	 */
+	scalar fl[NVARS], fr[NVARS], ulstr[NVARS], urstr[NVARS];
+	physics->getDirectionalFlux(ul,n,vni,pi,fl);
+	physics->getDirectionalFlux(ur,n,vnj,pj,fr);
+	getStarState(ul,n,vni,pi,sl,sm,ulstr);
+	getStarState(ur,n,vnj,pj,sr,sm,urstr);
+
+	for(int ivar = 0; ivar < NVARS; ivar++)
+	{
+		const scalar flstr = fl[ivar] + sl * ( ulstr[ivar] - ul[ivar]);
+		const scalar frstr = fr[ivar] + sr * ( urstr[ivar] - ur[ivar]);
+		flux[ivar] = sl > 0 ? fl[ivar] : (sm > 0 ? flstr : (sr >= 0 ? frstr : fr[ivar]));
+	}
+}
+
+inline void HLLCFlux::get_flux(const a_real *const ul, const a_real *const ur,
+		const a_real* const n, a_real *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void HLLCFlux::get_flux(const Dual *const ul, const Dual *const ur,
+		const a_real* const n, Dual *const __restrict flux) const
+{
+	evaluateFlux(ul, ur, n, flux);
+}
+
+inline void HLLCFlux::get_flux_batch(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<false>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
+inline void HLLCFlux::get_flux_batch_primitive(const a_int nfaces, 
+		const a_real *const ulb, const a_real *const urb, const a_real *const nb,
+		a_real *const fluxb) const
+{
+	computeFluxBatch<true>(*this, *physics, nfaces, ulb, urb, nb, fluxb);
+}
+
 } // end namespace acfd
 
 #endif
@@ -22,6 +22,7 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <limits>
 #include <sys/time.h>
 #include <ctime>
 
@@ -29,11 +30,14 @@
 #include <omp.h>
 #endif
 
+#include <Eigen/LU>
+#include <Eigen/Cholesky>
 #include <petscksp.h>
 #include <petsctime.h>
 
 #include "aodesolver.hpp"
 #include "alinalg.hpp"
+#include "afactory.hpp"
 
 namespace acfd {
 
@@ -65,7 +69,8 @@ static Matrix<a_real,Dynamic,Dynamic> initialize_TVDRK_Coeffs(const int _order)
 template <int nvars>
 SteadySolver<nvars>::SteadySolver(const Spatial<nvars> *const spatial, const SteadySolverConfig& conf)
 	: space{spatial}, config{conf}, 
-	  tdata{spatial->mesh()->gnelem(), 1, 0.0, 0.0, 0.0, 0.0, 0, 0, 0, false}
+	  tdata{spatial->mesh()->gnelem(), 1, 0.0, 0.0, 0.0, 0.0, 0, 0, 0, false, 0, 0, 0.0, 0.0, {}, {}, {},
+	         {}, {}}
 { }
 
 template <int nvars>
@@ -73,13 +78,171 @@ TimingData SteadySolver<nvars>::getTimingData() const {
 	return tdata;
 }
 
+template <int nvars>
+a_real SteadySolver<nvars>::linearRamp(const a_real cstart, const a_real cend, 
+		const int itstart, const int itend, const int itcur) const
+{
+	a_real curCFL;
+	if(itcur < itstart) {
+		curCFL = cstart;
+	}
+	else if(itcur < itend) {
+		if(itend-itstart <= 0) {
+			curCFL = cend;
+		}
+		else {
+			const a_real slopec = (cend-cstart)/(itend-itstart);
+			curCFL = cstart + slopec*(itcur-itstart);
+		}
+	}
+	else {
+		curCFL = cend;
+	}
+	return curCFL;
+}
+
+AndersonAccelerator::AndersonAccelerator(const MPI_Comm communicator, const a_int size,
+		const int depth, const a_real restart_ratio)
+	: comm{communicator}, n{size}, mdepth{depth}, restartratio{restart_ratio},
+	  df(static_cast<size_t>(depth)*size), dg(static_cast<size_t>(depth)*size),
+	  fold(size), gold(size), gram(depth,depth),
+	  nstored{0}, newest{-1}, havelast{false}, lastresnorm{0}, nrestarts{0}
+{ }
+
+void AndersonAccelerator::restart()
+{
+	nstored = 0;
+	newest = -1;
+	havelast = false;
+	nrestarts++;
+}
+
+StatusCode AndersonAccelerator::update(a_real *const u, const a_real *const f,
+		const a_real localresnorm)
+{
+	StatusCode ierr = 0;
+	a_real resnorm = localresnorm*localresnorm;
+	ierr = MPI_Allreduce(MPI_IN_PLACE, &resnorm, 1, MPI_DOUBLE, MPI_SUM, comm); CHKERRQ(ierr);
+	resnorm = std::sqrt(resnorm);
+
+	// safeguard: a growing residual means the history no longer describes the iteration well
+	if(havelast && resnorm > restartratio*lastresnorm)
+		restart();
+	lastresnorm = resnorm;
+
+	const bool newdiff = havelast;
+	if(newdiff) {
+		newest = (newest+1) % mdepth;
+		nstored = std::min(nstored+1, mdepth);
+	}
+
+	/* Form the newest differences and replace the previous update and fixed-point value,
+	 * and compute the inner products of the newest update difference with the stored ones
+	 * (including itself) and of the stored update differences with the current update.
+	 */
+	Matrix<a_real,Dynamic,1> dots = Matrix<a_real,Dynamic,1>::Zero(2*nstored);
+	a_real *const dfnew = newdiff ? &df[static_cast<size_t>(newest)*n] : nullptr;
+	a_real *const dgnew = newdiff ? &dg[static_cast<size_t>(newest)*n] : nullptr;
+
+#pragma omp parallel default(shared)
+	{
+		Matrix<a_real,Dynamic,1> ldots = Matrix<a_real,Dynamic,1>::Zero(2*nstored);
+
+#pragma omp for
+		for(a_int i = 0; i < n; i++)
+		{
+			const a_real g = u[i] + f[i];
+			if(newdiff) {
+				dfnew[i] = f[i] - fold[i];
+				dgnew[i] = g - gold[i];
+				for(int j = 0; j < nstored; j++) {
+					const a_real dfj = df[static_cast<size_t>(j)*n+i];
+					ldots(j) += dfnew[i]*dfj;
+					ldots(nstored+j) += dfj*f[i];
+				}
+			}
+			fold[i] = f[i];
+			gold[i] = g;
+		}
+
+#pragma omp critical
+		{
+			dots += ldots;
+		}
+	}
+	havelast = true;
+
+	if(nstored > 0) {
+		ierr = MPI_Allreduce(MPI_IN_PLACE, dots.data(), 2*nstored, MPI_DOUBLE, MPI_SUM, comm);
+		CHKERRQ(ierr);
+	}
+
+	Matrix<a_real,Dynamic,1> gamma;
+	if(nstored > 0)
+	{
+		for(int j = 0; j < nstored; j++) {
+			gram(newest,j) = dots(j);
+			gram(j,newest) = dots(j);
+		}
+
+		// a little regularization keeps nearly dependent differences from blowing up the weights
+		Matrix<a_real,Dynamic,Dynamic> H = gram.topLeftCorner(nstored,nstored);
+		H.diagonal().array() += 1e-12*H.trace()/nstored;
+		Eigen::LDLT<Matrix<a_real,Dynamic,Dynamic>> ldlt(H);
+		gamma = ldlt.solve(dots.tail(nstored));
+
+		if(ldlt.info() != Eigen::Success || !gamma.allFinite()) {
+			restart();
+			havelast = true;
+		}
+	}
+
+	if(nstored == 0) {
+#pragma omp parallel for simd default(shared)
+		for(a_int i = 0; i < n; i++)
+			u[i] = gold[i];
+		return ierr;
+	}
+
+#pragma omp parallel for default(shared)
+	for(a_int i = 0; i < n; i++)
+	{
+		a_real unew = gold[i];
+		for(int j = 0; j < nstored; j++)
+			unew -= gamma(j)*dg[static_cast<size_t>(j)*n+i];
+		u[i] = unew;
+	}
+	return ierr;
+}
+
+/// Reads the Anderson acceleration options and creates the accelerator if it is requested
+/** \param[in] size Length of the state vector
+ * \param[out] anderson The accelerator, or nullptr if the depth is zero
+ */
+static StatusCode createAndersonAccelerator(const a_int size, AndersonAccelerator **const anderson)
+{
+	StatusCode ierr = 0;
+	PetscInt depth = 0;
+	PetscReal restartratio = 1.0;
+	PetscBool set = PETSC_FALSE;
+	ierr = PetscOptionsGetInt(NULL, NULL, "-anderson_depth", &depth, &set); CHKERRQ(ierr);
+	ierr = PetscOptionsGetReal(NULL, NULL, "-anderson_restart_ratio", &restartratio, &set);
+	CHKERRQ(ierr);
+	if(depth < 0)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONG, "The Anderson depth cannot be negative");
+
+	*anderson = depth > 0 ?
+		new AndersonAccelerator(PETSC_COMM_WORLD, size, depth, restartratio) : nullptr;
+	return ierr;
+}
+
 
 template<int nvars>
 SteadyForwardEulerSolver<nvars>::SteadyForwardEulerSolver(
 		const Spatial<nvars> *const spatial, const Vec uvec,
 		const SteadySolverConfig& conf)
 
-	: SteadySolver<nvars>(spatial, conf)
+	: SteadySolver<nvars>(spatial, conf), anderson{nullptr}
 {
 	const UMesh2dh *const m = space->mesh();
 	dtm.resize(m->gnelem(), 0);
@@ -89,6 +252,15 @@ SteadyForwardEulerSolver<nvars>::SteadyForwardEulerSolver(
 		std::cout << "! SteadyForwardEulerSolver: Could not create residual vector!\n";
 		std::abort();
 	}
+
+	ierr = createAndersonAccelerator(m->gnelem()*nvars, &anderson);
+	if(ierr) {
+		std::cout << "! SteadyForwardEulerSolver: Could not set up Anderson acceleration!\n";
+		std::abort();
+	}
+	if(anderson)
+		std::cout << " SteadyForwardEulerSolver: Anderson acceleration with depth "
+			<< anderson->depth() << "." << std::endl;
 }
 
 template<int nvars>
@@ -97,6 +269,7 @@ SteadyForwardEulerSolver<nvars>::~SteadyForwardEulerSolver()
 	int ierr = VecDestroy(&rvec);
 	if(ierr)
 		std::cout << "! SteadyForwardEulerSolver: Could not destroy residual vector!\n";
+	delete anderson;
 }
 
 template<int nvars>
@@ -155,24 +328,32 @@ StatusCode SteadyForwardEulerSolver<nvars>::solve(Vec uvec)
 
 #pragma omp parallel default(shared)
 		{
-#pragma omp for simd
+#pragma omp for simd reduction(+:errmass)
 			for(a_int iel = 0; iel < m->gnelem(); iel++)
 			{
-				for(int i = 0; i < nvars; i++)
-				{
-					u(iel,i) += config.cflinit*dtm[iel] * 1.0/m->garea(iel)*residual(iel,i);
-				}
+				errmass += residual(iel,nvars-1)*residual(iel,nvars-1)*m->garea(iel);
 			}
 
-#pragma omp for simd reduction(+:errmass)
+			// with acceleration, the residual is replaced by the update
+#pragma omp for simd
 			for(a_int iel = 0; iel < m->gnelem(); iel++)
 			{
-				errmass += residual(iel,nvars-1)*residual(iel,nvars-1)*m->garea(iel);
+				for(int i = 0; i < nvars; i++)
+				{
+					if(anderson)
+						residual(iel,i) *= config.cflinit*dtm[iel] * 1.0/m->garea(iel);
+					else
+						u(iel,i) += config.cflinit*dtm[iel] * 1.0/m->garea(iel)*residual(iel,i);
+				}
 			}
 		} // end parallel region
 
 		resi = sqrt(errmass);
 
+		if(anderson) {
+			ierr = anderson->update(uarr, rarr, resi); CHKERRQ(ierr);
+		}
+
 		if(step == 0)
 			initres = resi;
 
@@ -195,6 +376,7 @@ StatusCode SteadyForwardEulerSolver<nvars>::solve(Vec uvec)
 	double finalwtime = (double)time2.tv_sec + (double)time2.tv_usec * 1.0e-6;
 	double finalctime = (double)clock() / (double)CLOCKS_PER_SEC;
 	tdata.ode_walltime += (finalwtime-initialwtime); tdata.ode_cputime += (finalctime-initialctime);
+	tdata.num_timesteps = step;
 
 	tdata.converged = true;
 	if(step == config.maxiter) {
@@ -204,6 +386,9 @@ StatusCode SteadyForwardEulerSolver<nvars>::solve(Vec uvec)
 	}
 	if(mpirank == 0) {
 		std::cout << " SteadyForwardEulerSolver: solve(): Done, steps = " << step << "\n\n";
+		if(anderson)
+			std::cout << " SteadyForwardEulerSolver: solve(): Anderson history discarded "
+				<< anderson->numRestarts() << " times\n\n";
 		std::cout << " SteadyForwardEulerSolver: solve(): Time taken by ODE solver:\n";
 		std::cout << "                                   Wall time = " << tdata.ode_walltime 
 			<< ", CPU time = " << tdata.ode_cputime << std::endl << std::endl;
@@ -227,15 +412,112 @@ SteadyBackwardEulerSolver<nvars>::SteadyBackwardEulerSolver(
 		const SteadySolverConfig& conf,	
 		KSP ksp)
 
-	: SteadySolver<nvars>(spatial, conf), solver{ksp}
+	: SteadySolver<nvars>(spatial, conf), solver{ksp},
+	  nativemat{nullptr}, nativemfop{nullptr}, nativeprec{nullptr}, nativesolver{nullptr}, incrementalprec{false},
+	  jaclag{1}, jaclagresratio{1.0}, jaclagmaxlinits{std::numeric_limits<int>::max()},
+	  ewchoice{0}, eweta0{0.3}, ewetamax{0.9}, ewgamma{0.9}, ewalpha{2.0}, anderson{nullptr}
 {
 	const UMesh2dh *const m = space->mesh();
 	dtm.resize(m->gnelem(), 0);
-	Mat M; int ierr;
-	ierr = KSPGetOperators(solver, NULL, &M);
+	mdiag.resize(m->gnelem(), 0);
+	Mat M, A; int ierr;
+	ierr = KSPGetOperators(solver, &A, &M);
 	ierr = MatCreateVecs(M, &duvec, &rvec);
 	if(ierr)
 		throw "! SteadyBackwardEulerSolver: Could not create residual or update vector!";
+
+	char backend[PETSCOPTION_STR_LEN];
+	PetscBool set = PETSC_FALSE;
+	ierr = PetscOptionsGetString(NULL, NULL, "-linear_solver_backend", backend, 
+			PETSCOPTION_STR_LEN, &set);
+	if(ierr)
+		throw "! SteadyBackwardEulerSolver: Could not get the linear solver backend!";
+
+	if(set && std::string(backend) == "NATIVE")
+	{
+		const JacobianBlockLocations *blocks;
+		ierr = getJacobianBlockLocations(M, &blocks);
+		if(ierr || !blocks)
+			throw "! SteadyBackwardEulerSolver: Native solvers need a stored BAIJ preconditioning"
+				" matrix!";
+
+		BlockSolverConfig bconf;
+		ierr = getBlockSolverConfig(solver, &bconf);
+		if(ierr)
+			throw "! SteadyBackwardEulerSolver: Could not get native solver settings!";
+
+		nativemat = new BSRMatrix<nvars>(m);
+		nativeprec = create_blockpreconditioner<nvars>(bconf.precond, m,
+				bconf.nbuildsweeps, bconf.napplysweeps, bconf.refreshtol,
+				bconf.lineanisotropy, bconf.singleprec);
+		incrementalprec = bconf.refreshtol > 0;
+		nativesolver = create_blocksolver<nvars>(bconf, m->gnelem());
+		if(!nativeprec || !nativesolver)
+			throw "! SteadyBackwardEulerSolver: Could not create native solver!";
+
+		// a matrix-free Jacobian is applied through PETSc; the preconditioner still comes from M
+		if(isMatrixFree(A)) {
+			nativemfop = new PetscBlockOperator<nvars>(A);
+			nativesolver->setOperators(nativemfop, nativeprec);
+		}
+		else
+			nativesolver->setOperators(nativemat, nativeprec);
+	}
+	else if(set && std::string(backend) != "PETSC")
+		throw "! SteadyBackwardEulerSolver: Unknown linear solver backend!";
+
+	PetscInt lag = jaclag, maxlinits = jaclagmaxlinits;
+	PetscReal lagresratio = jaclagresratio;
+	ierr = PetscOptionsGetInt(NULL, NULL, "-jacobian_lag", &lag, &set);
+	ierr = ierr || PetscOptionsGetReal(NULL, NULL, "-jacobian_lag_residual_ratio", &lagresratio, &set);
+	ierr = ierr || PetscOptionsGetInt(NULL, NULL, "-jacobian_lag_max_linear_iters", &maxlinits, &set);
+	if(ierr)
+		throw "! SteadyBackwardEulerSolver: Could not get Jacobian lagging options!";
+	if(lag < 1)
+		throw "! SteadyBackwardEulerSolver: The Jacobian lag must be at least 1!";
+	jaclag = lag;
+	jaclagresratio = lagresratio;
+	jaclagmaxlinits = maxlinits;
+	if(jaclag > 1)
+		std::cout << " SteadyBackwardEulerSolver: Lagging the Jacobian for up to " << jaclag
+			<< " time steps." << std::endl;
+
+	char forcing[PETSCOPTION_STR_LEN];
+	set = PETSC_FALSE;
+	ierr = PetscOptionsGetString(NULL, NULL, "-linear_forcing_term", forcing,
+			PETSCOPTION_STR_LEN, &set);
+	if(ierr)
+		throw "! SteadyBackwardEulerSolver: Could not get the linear forcing term!";
+	if(set && std::string(forcing) == "EW1") {
+		ewchoice = 1;
+		ewalpha = (1.0+std::sqrt(5.0))/2.0;
+	}
+	else if(set && std::string(forcing) == "EW2")
+		ewchoice = 2;
+	else if(set && std::string(forcing) != "NONE")
+		throw "! SteadyBackwardEulerSolver: Unknown linear forcing term!";
+
+	PetscReal eta0 = eweta0, etamax = ewetamax, gamma = ewgamma, alpha = ewalpha;
+	ierr = PetscOptionsGetReal(NULL, NULL, "-linear_forcing_eta0", &eta0, &set);
+	ierr = ierr || PetscOptionsGetReal(NULL, NULL, "-linear_forcing_etamax", &etamax, &set);
+	ierr = ierr || PetscOptionsGetReal(NULL, NULL, "-linear_forcing_gamma", &gamma, &set);
+	ierr = ierr || PetscOptionsGetReal(NULL, NULL, "-linear_forcing_alpha", &alpha, &set);
+	if(ierr)
+		throw "! SteadyBackwardEulerSolver: Could not get linear forcing term options!";
+	eweta0 = eta0;
+	ewetamax = etamax;
+	ewgamma = gamma;
+	ewalpha = alpha;
+	if(ewchoice > 0)
+		std::cout << " SteadyBackwardEulerSolver: Setting the linear tolerance by Eisenstat-Walker"
+			<< " choice " << ewchoice << "." << std::endl;
+
+	ierr = createAndersonAccelerator(m->gnelem()*nvars, &anderson);
+	if(ierr)
+		throw "! SteadyBackwardEulerSolver: Could not set up Anderson acceleration!";
+	if(anderson)
+		std::cout << " SteadyBackwardEulerSolver: Anderson acceleration with depth "
+			<< anderson->depth() << "." << std::endl;
 }
 
 template <int nvars>
@@ -247,29 +529,76 @@ SteadyBackwardEulerSolver<nvars>::~SteadyBackwardEulerSolver()
 	ierr = VecDestroy(&duvec);
 	if(ierr)
 		std::cout << "! SteadyBackwardEulerSolver: Could not destroy update vector!\n";
+	delete nativesolver;
+	delete nativeprec;
+	delete nativemfop;
+	delete nativemat;
+	delete anderson;
 }
 	
 template <int nvars>
-a_real SteadyBackwardEulerSolver<nvars>::linearRamp(const a_real cstart, const a_real cend, 
-		const int itstart, const int itend, const int itcur) const
+StatusCode SteadyBackwardEulerSolver<nvars>::addToDiagonal(Mat M, const std::vector<a_real>& d)
+	const
 {
-	a_real curCFL;
-	if(itcur < itstart) {
-		curCFL = cstart;
-	}
-	else if(itcur < itend) {
-		if(itend-itstart <= 0) {
-			curCFL = cend;
+	StatusCode ierr = 0;
+	const UMesh2dh *const m = space->mesh();
+	const JacobianBlockLocations *blocks;
+	ierr = getJacobianBlockLocations(M, &blocks); CHKERRQ(ierr);
+	if(blocks)
+	{
+		// each cell owns its diagonal block
+		PetscScalar *vals;
+		ierr = getJacobianBlockValues(M, &vals); CHKERRQ(ierr);
+#pragma omp parallel for default(shared)
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			for(int i = 0; i < nvars; i++)
+				vals[blocks->diag[iel]*nvars*nvars + i*nvars+i] += d[iel];
 		}
-		else {
-			const a_real slopec = (cend-cstart)/(itend-itstart);
-			curCFL = cstart + slopec*(itcur-itstart);
+		ierr = restoreJacobianBlockValues(M, &vals); CHKERRQ(ierr);
+	}
+	else
+	{
+#pragma omp parallel for default(shared)
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			Matrix<a_real,nvars,nvars,RowMajor> db 
+				= Matrix<a_real,nvars,nvars,RowMajor>::Zero();
+
+			for(int i = 0; i < nvars; i++)
+				db(i,i) = d[iel];
+
+#pragma omp critical
+			{
+				MatSetValuesBlocked(M, 1, &iel, 1, &iel, db.data(), ADD_VALUES);
+			}
 		}
 	}
+
+	ierr = MatAssemblyBegin(M, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+	ierr = MatAssemblyEnd(M, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+	return ierr;
+}
+
+template <int nvars>
+a_real SteadyBackwardEulerSolver<nvars>::forcingTerm(const a_real fnorm, const a_real fnormold,
+		const a_real linresnorm, const a_real etaold, const a_real relres) const
+{
+	a_real eta, safeguard;
+	if(ewchoice == 1) {
+		eta = std::fabs(fnorm - linresnorm)/fnormold;
+		safeguard = std::pow(etaold, ewalpha);
+	}
 	else {
-		curCFL = cend;
+		eta = ewgamma*std::pow(fnorm/fnormold, ewalpha);
+		safeguard = ewgamma*std::pow(etaold, ewalpha);
 	}
-	return curCFL;
+	if(safeguard > 0.1)
+		eta = std::max(eta, safeguard);
+
+	// near convergence, oversolving cannot reduce the residual below the nonlinear tolerance
+	eta = std::max(eta, 0.5*config.tol/relres);
+	return std::min(eta, ewetamax);
 }
 
 template <int nvars>
@@ -342,6 +671,24 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 	
 	double linwtime = 0, linctime = 0;
 		
+	// state of the Jacobian lagging
+	int stepssincebuild = 0;
+	int lastlinsteps = 0;
+	a_real matcfl = 0;
+
+	// state of the forcing term
+	PetscReal kspdefrtol, kspatol, kspdtol;
+	PetscInt kspmaxits;
+	ierr = KSPGetTolerances(solver, &kspdefrtol, &kspatol, &kspdtol, &kspmaxits); CHKERRQ(ierr);
+	a_real linrtol = kspdefrtol;
+	a_real fnorm = 1.0, fnormold = 1.0, linresnorm = 0;
+	// choice 1 needs the unpreconditioned linear residual, which the KSP may not monitor
+	Vec linres = NULL, linwork = NULL;
+	if(ewchoice == 1 && !nativesolver) {
+		ierr = VecDuplicate(rvec, &linres); CHKERRQ(ierr);
+		ierr = VecDuplicate(rvec, &linwork); CHKERRQ(ierr);
+	}
+		
 	while(resi/initres > config.tol && step < config.maxiter)
 	{
 #pragma omp parallel for default(shared)
@@ -351,42 +698,101 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 				residual(iel,i) = 0;
 			}
 		}
-		
-		// update residual and local time steps
-		ierr = space->compute_residual(uvec, rvec, true, dtm); CHKERRQ(ierr);
 
-		ierr = MatZeroEntries(M); CHKERRQ(ierr);
-		ierr = space->compute_jacobian(uvec, M); CHKERRQ(ierr);
-		
 		curCFL = linearRamp(config.cflinit, config.cflfin, config.rampstart, config.rampend, step);
-		(void)resiold;
 		//curCFL = expResidualRamp(config.cflinit, config.cflfin, curCFL, resiold/resi, 0.25, 0.25);
 
-		// add pseudo-time terms to diagonal blocks; also, after the following loop,
-		// dtm is the diagonal vector of the mass matrix but having only one entry for each cell.
+		// decide whether to assemble the Jacobian
+		JacobianUpdateType jacupdate = JACOBIAN_REUSED;
+		if(step == 0 || stepssincebuild >= jaclag)
+			jacupdate = JACOBIAN_REBUILT;
+		else if(step > 1 && resi > jaclagresratio*resiold)
+			jacupdate = JACOBIAN_REBUILT_RESIDUAL;
+		else if(lastlinsteps > jaclagmaxlinits)
+			jacupdate = JACOBIAN_REBUILT_LINITERS;
+		else if(curCFL != matcfl)
+			jacupdate = JACOBIAN_DIAGONAL_UPDATED;
+		const bool rebuild = jacupdate == JACOBIAN_REBUILT || jacupdate == JACOBIAN_REBUILT_RESIDUAL
+			|| jacupdate == JACOBIAN_REBUILT_LINITERS;
+		tdata.jacobian_updates.push_back(jacupdate);
+
+		PetscLogDouble thisasmwtime;
+		PetscTime(&thisasmwtime);
+		
+		// update residual, local time steps and, if needed, the Jacobian
+		if(rebuild) {
+			ierr = MatZeroEntries(M); CHKERRQ(ierr);
+			ierr = space->compute_residual_and_jacobian(uvec, rvec, true, dtm, M); CHKERRQ(ierr);
+		}
+		else {
+			ierr = space->compute_residual(uvec, rvec, true, dtm); CHKERRQ(ierr);
+		}
+		if(mfA) {
+			ierr = mfA->update_state(); CHKERRQ(ierr);
+		}
 
-#pragma omp parallel for default(shared)
+		// after the following loop, dtm is the diagonal vector of the mass matrix 
+		// but having only one entry for each cell.
+#pragma omp parallel for simd default(shared)
 		for(a_int iel = 0; iel < m->gnelem(); iel++)
-		{
 			dtm[iel] = m->garea(iel) / (curCFL*dtm[iel]);
 
-			Matrix<a_real,nvars,nvars,RowMajor> db 
-				= Matrix<a_real,nvars,nvars,RowMajor>::Zero();
-
-			for(int i = 0; i < nvars; i++)
-				db(i,i) = dtm[iel];
+		// add pseudo-time terms to diagonal blocks
+		if(rebuild)
+		{
+			ierr = addToDiagonal(M, dtm); CHKERRQ(ierr);
+			std::copy(dtm.begin(), dtm.end(), mdiag.begin());
 	
-#pragma omp critical
-			{
-				MatSetValuesBlocked(M, 1, &iel, 1, &iel, db.data(), ADD_VALUES);
-			}
+			/// Freezes the non-zero structure for efficiency in subsequent time steps.
+			ierr = MatSetOption(M, MAT_NEW_NONZERO_LOCATIONS, PETSC_FALSE); CHKERRQ(ierr);
+
+			matcfl = curCFL;
+			stepssincebuild = 0;
+			tdata.num_jacobian_evals++;
+		}
+		else if(jacupdate == JACOBIAN_DIAGONAL_UPDATED)
+		{
+			// replace the old pseudo-time term by the new one
+#pragma omp parallel for simd default(shared)
+			for(a_int iel = 0; iel < m->gnelem(); iel++)
+				mdiag[iel] = dtm[iel] - mdiag[iel];
+			ierr = addToDiagonal(M, mdiag); CHKERRQ(ierr);
+			std::copy(dtm.begin(), dtm.end(), mdiag.begin());
+
+			matcfl = curCFL;
+			tdata.num_diagonal_updates++;
 		}
+		stepssincebuild++;
 
-		MatAssemblyBegin(M, MAT_FINAL_ASSEMBLY);
-		MatAssemblyEnd(M, MAT_FINAL_ASSEMBLY);
-	
-		/// Freezes the non-zero structure for efficiency in subsequent time steps.
-		ierr = MatSetOption(M, MAT_NEW_NONZERO_LOCATIONS, PETSC_FALSE); CHKERRQ(ierr);
+		// relative tolerance of the linear solve
+		if(ewchoice > 0)
+		{
+			// the L2 norm of the residual, to compare with the linear residual, and the norm
+			// used for the nonlinear tolerance, for the lower bound
+			a_real fnorm2 = 0, resnorm2 = 0;
+#pragma omp parallel for default(shared) reduction(+:fnorm2,resnorm2)
+			for(a_int iel = 0; iel < m->gnelem(); iel++) {
+				for(int i = 0; i < nvars; i++)
+					fnorm2 += residual(iel,i)*residual(iel,i);
+				resnorm2 += residual(iel,nvars-1)*residual(iel,nvars-1)*m->garea(iel);
+			}
+			fnormold = fnorm;
+			fnorm = std::sqrt(fnorm2);
+
+			if(step == 0)
+				linrtol = eweta0;
+			else
+				linrtol = forcingTerm(fnorm, fnormold, linresnorm, linrtol,
+						std::sqrt(resnorm2)/initres);
+
+			if(nativesolver)
+				nativesolver->setRelativeTolerance(linrtol);
+			else {
+				ierr = KSPSetTolerances(solver, linrtol, PETSC_DEFAULT, PETSC_DEFAULT, PETSC_DEFAULT);
+				CHKERRQ(ierr);
+			}
+		}
+		tdata.lin_rtols.push_back(linrtol);
 
 		// setup and solve linear system for the update du
 	
@@ -394,35 +800,72 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 		PetscTime(&thislinwtime);
 		double thislinctime = (double)clock() / (double)CLOCKS_PER_SEC;
 
-		ierr = KSPSolve(solver, rvec, duvec); CHKERRQ(ierr);
+		// the preconditioner is only set up again if the matrix has changed
+		PetscLogDouble thissetupwtime;
+		int linstepsneeded;
+		if(nativesolver) {
+			if(jacupdate != JACOBIAN_REUSED) {
+				ierr = nativemat->copyFrom(M); CHKERRQ(ierr);
+				ierr = nativeprec->compute(*nativemat); CHKERRQ(ierr);
+				tdata.prec_refresh_fractions.push_back(nativeprec->refreshedFraction());
+			}
+			PetscTime(&thissetupwtime);
+			linstepsneeded = nativesolver->solve(rarr, duarr);
+			linresnorm = nativesolver->residualNorm();
+		}
+		else {
+			ierr = KSPSetUp(solver); CHKERRQ(ierr);
+			PetscTime(&thissetupwtime);
+			ierr = KSPSolve(solver, rvec, duvec); CHKERRQ(ierr);
+			ierr = KSPGetIterationNumber(solver, &linstepsneeded); CHKERRQ(ierr);
+			if(ewchoice == 1) {
+				Vec rlin;
+				ierr = KSPBuildResidual(solver, linwork, linres, &rlin); CHKERRQ(ierr);
+				ierr = VecNorm(rlin, NORM_2, &linresnorm); CHKERRQ(ierr);
+			}
+		}
 
 		PetscLogDouble thisfinwtime; PetscTime(&thisfinwtime);
 		double thisfinctime = (double)clock() / (double)CLOCKS_PER_SEC;
 		linwtime += (thisfinwtime-thislinwtime); 
 		linctime += (thisfinctime-thislinctime);
+		tdata.lin_walltimes.push_back(thisfinwtime-thislinwtime);
+
+		// time to compute the residual and (maybe) the Jacobian and to set up the preconditioner
+		const double thisjacwtime = thissetupwtime - thisasmwtime;
+		if(rebuild)
+			tdata.jac_walltime += thisjacwtime;
+		else
+			tdata.lag_saved_walltime += tdata.jac_walltime/tdata.num_jacobian_evals - thisjacwtime;
+		lastlinsteps = linstepsneeded;
 
-		int linstepsneeded;
-		ierr = KSPGetIterationNumber(solver, &linstepsneeded); CHKERRQ(ierr);
 		tdata.total_lin_iters += linstepsneeded;
+		tdata.lin_iters.push_back(linstepsneeded);
 		
 		a_real resnorm2 = 0;
 
 #pragma omp parallel default(shared)
 		{
-#pragma omp for
-			for(a_int iel = 0; iel < m->gnelem(); iel++) {
-				u.row(iel) += du.row(iel);
-			}
 #pragma omp for simd reduction(+:resnorm2)
 			for(a_int iel = 0; iel < m->gnelem(); iel++)
 			{
 				resnorm2 += residual(iel,nvars-1)*residual(iel,nvars-1)*m->garea(iel);
 			}
+			if(!anderson) {
+#pragma omp for
+				for(a_int iel = 0; iel < m->gnelem(); iel++) {
+					u.row(iel) += du.row(iel);
+				}
+			}
 		}
 
 		resiold = resi;
 		resi = sqrt(resnorm2);
 
+		if(anderson) {
+			ierr = anderson->update(uarr, duarr, resi); CHKERRQ(ierr);
+		}
+
 		if(step == 0)
 			initres = resi;
 
@@ -432,15 +875,35 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 				std::cout << "  SteadyBackwardEulerSolver: solve(): Step " << step 
 					<< ", rel res " << resi/initres << ", abs res = " << resi << std::endl;
 				std::cout << "      CFL = " << curCFL 
-					<< ", iters used = " << linstepsneeded << std::endl;
+					<< ", iters used = " << linstepsneeded;
+				if(ewchoice > 0)
+					std::cout << ", linear rtol = " << linrtol;
+				if(incrementalprec && jacupdate != JACOBIAN_REUSED)
+					std::cout << ", preconditioner rows refreshed = " 
+						<< tdata.prec_refresh_fractions.back();
+				std::cout << std::endl;
 			}
 		}
 
 		step++;
 			
 		if(config.lognres)
-			if(mpirank == 0)
-				convout << step << " " << std::setw(10)  << resi/initres << '\n';
+			if(mpirank == 0) {
+				convout << step << " " << std::setw(10)  << resi/initres;
+				if(ewchoice > 0)
+					convout << " " << std::setw(10) << linrtol << " " << std::setw(5) << linstepsneeded;
+				convout << '\n';
+			}
+	}
+
+	// leave the KSP as it was given
+	if(ewchoice > 0 && !nativesolver) {
+		ierr = KSPSetTolerances(solver, kspdefrtol, PETSC_DEFAULT, PETSC_DEFAULT, PETSC_DEFAULT);
+		CHKERRQ(ierr);
+	}
+	if(linres) {
+		ierr = VecDestroy(&linres); CHKERRQ(ierr);
+		ierr = VecDestroy(&linwork); CHKERRQ(ierr);
 	}
 
 	/*gettimeofday(&time2, NULL);
@@ -478,6 +941,31 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 			<< tdata.ode_cputime << "\n";
 		std::cout << " SteadyBackwardEulerSolver: solve(): Time taken by linear solver:\n";
 		std::cout << " \t\tWall time = " << linwtime << ", CPU time = " << linctime << std::endl;
+		if(tdata.lin_walltimes.size() > 0)
+			std::cout << " \t\tWall time per step: first = " << tdata.lin_walltimes.front()
+				<< ", average = " << linwtime/tdata.lin_walltimes.size()
+				<< ", last = " << tdata.lin_walltimes.back() << std::endl;
+		if(jaclag > 1) {
+			std::cout << " SteadyBackwardEulerSolver: solve(): Jacobian assembled in "
+				<< tdata.num_jacobian_evals << " time steps, pseudo-time term updated in "
+				<< tdata.num_diagonal_updates << "\n";
+			std::cout << " \t\tEstimated wall time saved by lagging = " << tdata.lag_saved_walltime
+				<< std::endl;
+		}
+		if(anderson)
+			std::cout << " SteadyBackwardEulerSolver: solve(): Anderson history discarded "
+				<< anderson->numRestarts() << " times" << std::endl;
+		if(nativeprec)
+			std::cout << " SteadyBackwardEulerSolver: solve(): Native preconditioner storage = "
+				<< nativeprec->storageBytes()/1048576.0 << " MiB" << std::endl;
+		if(incrementalprec && tdata.prec_refresh_fractions.size() > 0) {
+			a_real avgfrac = 0;
+			for(a_real frac : tdata.prec_refresh_fractions)
+				avgfrac += frac;
+			avgfrac /= tdata.prec_refresh_fractions.size();
+			std::cout << " SteadyBackwardEulerSolver: solve(): Average fraction of preconditioner rows"
+				<< " refreshed = " << avgfrac << std::endl;
+		}
 	}
 
 #ifdef _OPENMP
@@ -513,6 +1001,342 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 	return ierr;
 }
 
+template <int nvars>
+SteadyMultigridSolver<nvars>::SteadyMultigridSolver(const Spatial<nvars> *const spatial,
+		const Vec x, const SteadySolverConfig& conf, const int periodicmarker)
+	: SteadySolver<nvars>(spatial, conf), ncycle{1}, implicitsmoother{true},
+	  npresmooth{1}, npostsmooth{1}, ncoarsesmooth{2}, uvec{NULL}, curCFL{0},
+	  recordnorm{false}, resnorm{0}, nfineresiduals{0}
+{
+	PetscInt nlevels = 3, npre = npresmooth, npost = npostsmooth, ncoarse = ncoarsesmooth;
+	char cycletype[PETSCOPTION_STR_LEN] = "V";
+	char smoother[PETSCOPTION_STR_LEN] = "IMPLICIT";
+	PetscBool set = PETSC_FALSE;
+	int ierr = PetscOptionsGetInt(NULL, NULL, "-mg_levels", &nlevels, &set);
+	ierr = ierr || PetscOptionsGetInt(NULL, NULL, "-mg_pre_smooth", &npre, &set);
+	ierr = ierr || PetscOptionsGetInt(NULL, NULL, "-mg_post_smooth", &npost, &set);
+	ierr = ierr || PetscOptionsGetInt(NULL, NULL, "-mg_coarse_smooth", &ncoarse, &set);
+	ierr = ierr || PetscOptionsGetString(NULL, NULL, "-mg_cycle", cycletype,
+			PETSCOPTION_STR_LEN, &set);
+	ierr = ierr || PetscOptionsGetString(NULL, NULL, "-mg_smoother", smoother,
+			PETSCOPTION_STR_LEN, &set);
+	if(ierr)
+		throw "! SteadyMultigridSolver: Could not get multigrid options!";
+	if(nlevels < 1 || npre < 0 || npost < 0 || ncoarse < 1)
+		throw "! SteadyMultigridSolver: Invalid number of levels or smoothing steps!";
+
+	if(std::string(cycletype) == "W")
+		ncycle = 2;
+	else if(std::string(cycletype) != "V")
+		throw "! SteadyMultigridSolver: Unknown multigrid cycle!";
+	if(std::string(smoother) == "EXPLICIT")
+		implicitsmoother = false;
+	else if(std::string(smoother) != "IMPLICIT")
+		throw "! SteadyMultigridSolver: Unknown multigrid smoother!";
+	npresmooth = npre; npostsmooth = npost; ncoarsesmooth = ncoarse;
+
+	levels.push_back(new AgglomeratedMesh(space->mesh(), periodicmarker));
+	std::cout << " SteadyMultigridSolver: Level 0 has " << levels[0]->gnelem() << " cells";
+	for(int ilevel = 1; ilevel < nlevels; ilevel++)
+	{
+		AgglomeratedMesh *const coarse = new AgglomeratedMesh(levels.back());
+		// stop if the mesh cannot be coarsened any more
+		if(coarse->gnelem() >= levels.back()->gnelem()) {
+			delete coarse;
+			break;
+		}
+		levels.push_back(coarse);
+		std::cout << ", level " << ilevel << " has " << coarse->gnelem();
+	}
+	std::cout << ".\n SteadyMultigridSolver: " << (ncycle == 1 ? "V" : "W") << " cycles with "
+		<< (implicitsmoother ? "point-implicit" : "explicit") << " smoothing." << std::endl;
+
+	const int nlev = static_cast<int>(levels.size());
+	state.resize(nlev); restricted.resize(nlev); residual.resize(nlev);
+	forcing.resize(nlev); dtm.resize(nlev); diag.resize(nlev);
+	for(int ilevel = 0; ilevel < nlev; ilevel++)
+	{
+		const a_int nelem = levels[ilevel]->gnelem();
+		state[ilevel].resize(nelem*nvars);
+		residual[ilevel].resize(nelem*nvars);
+		dtm[ilevel].resize(nelem);
+		if(implicitsmoother)
+			diag[ilevel].resize(nelem*nvars*nvars);
+		if(ilevel > 0) {
+			restricted[ilevel].resize(nelem*nvars);
+			forcing[ilevel].resize(nelem*nvars);
+		}
+	}
+
+	ierr = VecDuplicate(x, &rvec);
+	if(ierr)
+		throw "! SteadyMultigridSolver: Could not create residual vector!";
+}
+
+template <int nvars>
+SteadyMultigridSolver<nvars>::~SteadyMultigridSolver()
+{
+	int ierr = VecDestroy(&rvec);
+	if(ierr)
+		std::cout << "! SteadyMultigridSolver: Could not destroy residual vector!\n";
+	for(AgglomeratedMesh *const level : levels)
+		delete level;
+}
+
+template <int nvars>
+StatusCode SteadyMultigridSolver<nvars>::computeResidual(const int level, const bool needdiag)
+{
+	StatusCode ierr = 0;
+	const AgglomeratedMesh& am = *levels[level];
+	std::vector<a_real>& res = residual[level];
+
+	if(level == 0)
+	{
+		// the finest level uses the full discretization
+		PetscScalar *arr;
+		ierr = VecGetArray(uvec, &arr); CHKERRQ(ierr);
+		std::copy(state[0].begin(), state[0].end(), arr);
+		ierr = VecRestoreArray(uvec, &arr); CHKERRQ(ierr);
+
+		ierr = VecSet(rvec, 0.0); CHKERRQ(ierr);
+		ierr = space->compute_residual(uvec, rvec, true, dtm[0]); CHKERRQ(ierr);
+
+		ierr = VecGetArray(rvec, &arr); CHKERRQ(ierr);
+		std::copy(arr, arr+res.size(), res.begin());
+		ierr = VecRestoreArray(rvec, &arr); CHKERRQ(ierr);
+
+		if(needdiag) {
+			ierr = space->compute_agglomerated_residual(am, &state[0][0], nullptr, false, nullptr,
+					&diag[0][0]);
+			CHKERRQ(ierr);
+		}
+
+		nfineresiduals++;
+		if(recordnorm)
+		{
+			a_real resnorm2 = 0;
+#pragma omp parallel for simd default(shared) reduction(+:resnorm2)
+			for(a_int iel = 0; iel < am.gnelem(); iel++)
+				resnorm2 += res[iel*nvars+nvars-1]*res[iel*nvars+nvars-1]*am.garea(iel);
+			resnorm = sqrt(resnorm2);
+			recordnorm = false;
+		}
+	}
+	else
+	{
+		std::copy(forcing[level].begin(), forcing[level].end(), res.begin());
+		ierr = space->compute_agglomerated_residual(am, &state[level][0], &res[0], true,
+				&dtm[level][0], needdiag ? &diag[level][0] : nullptr);
+		CHKERRQ(ierr);
+	}
+
+	return ierr;
+}
+
+template <int nvars>
+StatusCode SteadyMultigridSolver<nvars>::smooth(const int level, const int nsteps)
+{
+	StatusCode ierr = 0;
+	const AgglomeratedMesh& am = *levels[level];
+	std::vector<a_real>& u = state[level];
+	const std::vector<a_real>& res = residual[level];
+	const std::vector<a_real>& dt = dtm[level];
+
+	for(int istep = 0; istep < nsteps; istep++)
+	{
+		ierr = computeResidual(level, implicitsmoother); CHKERRQ(ierr);
+
+		if(implicitsmoother)
+		{
+			// solve (area/(CFL dt) I + D) du = residual, cell by cell
+#pragma omp parallel for default(shared)
+			for(a_int iel = 0; iel < am.gnelem(); iel++)
+			{
+				Matrix<a_real,nvars,nvars,RowMajor> A
+					= Eigen::Map<const Matrix<a_real,nvars,nvars,RowMajor>>
+						(&diag[level][iel*nvars*nvars]);
+				for(int i = 0; i < nvars; i++)
+					A(i,i) += am.garea(iel)/(curCFL*dt[iel]);
+				Eigen::Map<Matrix<a_real,nvars,1>>(&u[iel*nvars])
+					+= A.inverse()*Eigen::Map<const Matrix<a_real,nvars,1>>(&res[iel*nvars]);
+			}
+		}
+		else
+		{
+#pragma omp parallel for simd default(shared)
+			for(a_int iel = 0; iel < am.gnelem(); iel++)
+				for(int i = 0; i < nvars; i++)
+					u[iel*nvars+i] += curCFL*dt[iel]/am.garea(iel)*res[iel*nvars+i];
+		}
+	}
+
+	return ierr;
+}
+
+template <int nvars>
+StatusCode SteadyMultigridSolver<nvars>::cycle(const int level)
+{
+	StatusCode ierr = 0;
+	if(level == static_cast<int>(levels.size())-1) {
+		ierr = smooth(level, ncoarsesmooth); CHKERRQ(ierr);
+		return ierr;
+	}
+
+	ierr = smooth(level, npresmooth); CHKERRQ(ierr);
+	ierr = computeResidual(level, false); CHKERRQ(ierr);
+
+	// restrict the state by area-weighted averaging and the residual by summation
+	const AgglomeratedMesh& fine = *levels[level];
+	const AgglomeratedMesh& coarse = *levels[level+1];
+	std::vector<a_real>& uc = state[level+1];
+	std::vector<a_real>& fc = forcing[level+1];
+	// each coarse cell gathers from its own fine cells, so no two threads write to the same entry
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < coarse.gnelem(); iel++)
+	{
+		a_real usum[nvars], fsum[nvars];
+		for(int i = 0; i < nvars; i++) {
+			usum[i] = 0;
+			fsum[i] = 0;
+		}
+		for(a_int j = coarse.gfinecell_p(iel); j < coarse.gfinecell_p(iel+1); j++)
+		{
+			const a_int ifine = coarse.gfinecell(j);
+			for(int i = 0; i < nvars; i++) {
+				usum[i] += fine.garea(ifine)*state[level][ifine*nvars+i];
+				fsum[i] += residual[level][ifine*nvars+i];
+			}
+		}
+		for(int i = 0; i < nvars; i++) {
+			uc[iel*nvars+i] = usum[i]/coarse.garea(iel);
+			restricted[level+1][iel*nvars+i] = uc[iel*nvars+i];
+			fc[iel*nvars+i] = fsum[i];
+		}
+	}
+
+	// the forcing term is the restricted residual minus the coarse residual at the restricted state
+	std::vector<a_real>& rc = residual[level+1];
+	std::fill(rc.begin(), rc.end(), 0.0);
+	ierr = space->compute_agglomerated_residual(coarse, &uc[0], &rc[0], false, nullptr, nullptr);
+	CHKERRQ(ierr);
+#pragma omp parallel for simd default(shared)
+	for(size_t i = 0; i < fc.size(); i++)
+		fc[i] -= rc[i];
+
+	for(int icycle = 0; icycle < ncycle; icycle++) {
+		ierr = cycle(level+1); CHKERRQ(ierr);
+	}
+
+	// prolong the correction by injection
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < fine.gnelem(); iel++)
+	{
+		const a_int icoarse = coarse.gcoarsecell(iel);
+		for(int i = 0; i < nvars; i++)
+			state[level][iel*nvars+i] += uc[icoarse*nvars+i] - restricted[level+1][icoarse*nvars+i];
+	}
+
+	ierr = smooth(level, npostsmooth); CHKERRQ(ierr);
+	return ierr;
+}
+
+template <int nvars>
+StatusCode SteadyMultigridSolver<nvars>::solve(Vec u)
+{
+	if(config.maxiter <= 0) {
+		std::cout << " SteadyMultigridSolver: solve(): No iterations to be done.\n";
+		return 0;
+	}
+
+	StatusCode ierr = 0;
+	int mpirank;
+	MPI_Comm_rank(PETSC_COMM_WORLD, &mpirank);
+
+	uvec = u;
+	PetscScalar *uarr;
+	ierr = VecGetArray(uvec, &uarr); CHKERRQ(ierr);
+	std::copy(uarr, uarr+state[0].size(), state[0].begin());
+	ierr = VecRestoreArray(uvec, &uarr); CHKERRQ(ierr);
+
+	std::ofstream convout;
+	if(config.lognres)
+		if(mpirank == 0)
+			convout.open(config.logfile+".conv", std::ofstream::app);
+
+	double initialctime = (double)clock() / (double)CLOCKS_PER_SEC;
+	PetscLogDouble initialwtime;
+	PetscTime(&initialwtime);
+
+	int step = 0;
+	a_real resi = 1.0, initres = 1.0;
+	nfineresiduals = 0;
+
+	while(resi/initres > config.tol && step < config.maxiter)
+	{
+		curCFL = linearRamp(config.cflinit, config.cflfin, config.rampstart, config.rampend, step);
+
+		recordnorm = true;
+		ierr = cycle(0); CHKERRQ(ierr);
+		resi = resnorm;
+
+		if(step == 0)
+			initres = resi;
+
+		if(step % 10 == 0)
+			if(mpirank == 0) {
+				std::cout << "  SteadyMultigridSolver: solve(): Step " << step
+					<< ", rel res " << resi/initres << ", abs res = " << resi << std::endl;
+				std::cout << "      CFL = " << curCFL << std::endl;
+			}
+
+		step++;
+		if(config.lognres)
+			if(mpirank == 0)
+				convout << step << " " << std::setw(10)  << resi/initres << '\n';
+	}
+
+	// the finest state is the solution
+	ierr = VecGetArray(uvec, &uarr); CHKERRQ(ierr);
+	std::copy(state[0].begin(), state[0].end(), uarr);
+	ierr = VecRestoreArray(uvec, &uarr); CHKERRQ(ierr);
+
+	PetscLogDouble finalwtime;
+	PetscTime(&finalwtime);
+	double finalctime = (double)clock() / (double)CLOCKS_PER_SEC;
+	tdata.ode_walltime += (finalwtime-initialwtime);
+	tdata.ode_cputime += (finalctime-initialctime);
+	tdata.num_timesteps = step;
+
+	if(config.lognres)
+		if(mpirank == 0)
+			convout.close();
+
+	tdata.converged = true;
+	if(step == config.maxiter) {
+		tdata.converged = false;
+		if(mpirank == 0)
+			std::cout << "! SteadyMultigridSolver: solve(): Exceeded max iterations!\n";
+	}
+
+	if(mpirank == 0) {
+		std::cout << " SteadyMultigridSolver: solve(): Done, cycles = " << step
+			<< ", rel residual " << resi/initres << std::endl;
+		// the last residual is that before the last cycle
+		if(step > 1)
+			std::cout << "\t\tAverage residual reduction factor per cycle = "
+				<< std::pow(resi/initres, 1.0/(step-1)) << std::endl;
+		std::cout << "\t\tResidual evaluations on the finest level = " << nfineresiduals << std::endl;
+		std::cout << " SteadyMultigridSolver: solve(): Time taken by ODE solver:\n";
+		std::cout << " \t\tWall time = " << tdata.ode_walltime << ", CPU time = "
+			<< tdata.ode_cputime << std::endl;
+	}
+
+#ifdef _OPENMP
+	tdata.num_threads = omp_get_max_threads();
+#endif
+	return ierr;
+}
+
 template <int nvars>
 UnsteadySolver<nvars>::UnsteadySolver(const Spatial<nvars> *const spatial, Vec soln,
 		const int temporal_order, const std::string log_file)
@@ -652,6 +1476,8 @@ template class SteadyForwardEulerSolver<NVARS>;
 template class SteadyBackwardEulerSolver<NVARS>;
 template class SteadyForwardEulerSolver<1>;
 template class SteadyBackwardEulerSolver<1>;
+template class SteadyMultigridSolver<NVARS>;
+template class SteadyMultigridSolver<1>;
 
 template class TVDRKSolver<NVARS>;
 
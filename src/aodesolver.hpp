@@ -10,6 +10,7 @@
 #include <tuple>
 #include <petscksp.h>
 #include "aspatial.hpp"
+#include "akrylov.hpp"
 
 namespace acfd {
 
@@ -27,6 +28,15 @@ struct SteadySolverConfig {
 	int linmaxiterend;           ///< Max number of solver iterations after step \ref rampend
 };
 
+/// What implicit pseudo-time stepping did with the Jacobian matrix in a time step
+enum JacobianUpdateType {
+	JACOBIAN_REBUILT = 0,         ///< Assembled, because it was due or it was the first step
+	JACOBIAN_REBUILT_RESIDUAL,    ///< Assembled, because the nonlinear residual did not drop enough
+	JACOBIAN_REBUILT_LINITERS,    ///< Assembled, because the last linear solve needed too many iters
+	JACOBIAN_DIAGONAL_UPDATED,    ///< Lagged, but the pseudo-time term was updated for a new CFL
+	JACOBIAN_REUSED               ///< Lagged and unchanged, so the preconditioner is reused too
+};
+
 /// A collection of variables used for benchmarking purposes
 struct TimingData {
 	a_int nelem;                 ///< Size of the problem - the number of cells
@@ -39,6 +49,92 @@ struct TimingData {
 	int avg_lin_iters;           ///< Average number of linear iters needed per time step
 	int num_timesteps;           ///< Number of time steps needed for the ODE solve
 	bool converged;              ///< Did the nonlinear solver converge?
+	int num_jacobian_evals;      ///< Number of time steps in which the Jacobian was assembled
+	int num_diagonal_updates;    ///< Number of time steps in which only the pseudo-time term changed
+	/// Wall time taken by residual and Jacobian computation and preconditioner set-up in time steps
+	/// in which the Jacobian was assembled
+	double jac_walltime;
+	/// Estimate of the wall time saved by lagging the Jacobian, compared to assembling it (and
+	/// setting up the preconditioner) in every time step
+	double lag_saved_walltime;
+	/// What was done with the Jacobian in each time step
+	std::vector<JacobianUpdateType> jacobian_updates;
+	/// Fraction of the rows of the native preconditioner computed, each time it was set up
+	std::vector<a_real> prec_refresh_fractions;
+	/// Relative tolerance of the linear solver in each time step
+	std::vector<a_real> lin_rtols;
+	/// Number of linear iterations in each time step
+	std::vector<int> lin_iters;
+	/// Wall-clock time taken by the linear solve (including preconditioner set-up) in each time step
+	std::vector<double> lin_walltimes;
+};
+
+/// Anderson mixing of a fixed-point iteration \f$ u_{k+1} = g(u_k) = u_k + f(u_k) \f$
+/** In pseudo-time iterations, f is the update computed in each time step. Instead of taking
+ * \f$ g(u_k) \f$ as the next iterate, the differences of the last few updates f and
+ * fixed-point values g are kept, and the next iterate is
+ * \f$ u_{k+1} = g_k - \Delta G \gamma \f$, where \f$ \gamma \f$ minimizes
+ * \f$ \|f_k - \Delta F \gamma\|_2 \f$ (type-II Anderson acceleration, as in Walker and Ni).
+ *
+ * The small least-squares problem is solved through its normal equations. Only the inner
+ * products involving the newest difference and the newest update are computed in each step,
+ * in the same pass over the data that forms the differences.
+ *
+ * As a safeguard, the history is discarded whenever the residual norm passed to \ref update
+ * exceeds the previous one by more than a given factor, or when the least-squares problem
+ * cannot be solved. The iteration then continues from the plain fixed-point iterate.
+ *
+ * Each process holds its part of the vectors. The inner products and the residual norm are
+ * summed over the processes, so that all of them solve the same least-squares problem and
+ * take the same safeguarding decisions.
+ */
+class AndersonAccelerator
+{
+public:
+	/** \param comm The communicator over which the vectors are distributed
+	 * \param size Length of this process's part of the state vector
+	 * \param depth Maximum number of differences kept, ie., the window depth
+	 * \param restartratio The history is discarded when the ratio of the current residual norm
+	 *   to the previous one exceeds this
+	 */
+	AndersonAccelerator(const MPI_Comm comm, const a_int size, const int depth,
+			const a_real restartratio);
+
+	/// Discards the history, so that the next step is a plain fixed-point step
+	void restart();
+
+	/// Replaces the current iterate by the accelerated next iterate
+	/** \param[in,out] u The current iterate on input, the next one on output
+	 * \param[in] f The update computed at the current iterate
+	 * \param[in] resnorm Norm of this process's part of the nonlinear residual at the current
+	 *   iterate, used for safeguarding
+	 */
+	StatusCode update(a_real *const u, const a_real *const f, const a_real resnorm);
+
+	/// Number of times the history has been discarded
+	int numRestarts() const { return nrestarts; }
+
+	/// The window depth
+	int depth() const { return mdepth; }
+
+protected:
+	const MPI_Comm comm;                   ///< Communicator of the distributed vectors
+	const a_int n;                         ///< Length of the local parts of the vectors
+	const int mdepth;                      ///< Maximum number of differences stored
+	const a_real restartratio;             ///< Residual ratio above which the history is dropped
+
+	std::vector<a_real> df;                ///< Differences of updates, one vector of size n per slot
+	std::vector<a_real> dg;                ///< Differences of fixed-point values, likewise
+	std::vector<a_real> fold;              ///< The update of the previous step
+	std::vector<a_real> gold;              ///< The fixed-point value of the previous step
+	/// Inner products of the stored update differences, indexed by slot
+	Matrix<a_real,Dynamic,Dynamic> gram;
+
+	int nstored;                           ///< Number of differences stored
+	int newest;                            ///< Slot of the most recent difference
+	bool havelast;                         ///< Whether fold and gold hold the previous step
+	a_real lastresnorm;                    ///< Residual norm passed in the previous step
+	int nrestarts;                         ///< Number of times the history was discarded
 };
 
 /// Base class for steady-state simulations in pseudo-time
@@ -68,6 +164,10 @@ protected:
 	const SteadySolverConfig& config;
 	Vec rvec;
 	TimingData tdata;
+
+	/// Linear CFL ramping 
+	a_real linearRamp(const a_real cstart, const a_real cend, const int itstart, const int itend,
+			const int itcur) const;
 };
 	
 /// A driver class for explicit time-stepping to steady state using forward Euler integration
@@ -77,6 +177,10 @@ protected:
  * Optionally runs a `starter' time stepping loop to generate an initial solution
  * before starting the `main' loop.
  * The starter can perhaps use a first-order discretization.
+ *
+ * If the option -anderson_depth is a positive number m, the time steps are accelerated by
+ * \ref AndersonAccelerator using the last m steps. The history is discarded when the ratio of
+ * the residual norm to that of the previous step exceeds -anderson_restart_ratio (default 1).
  */
 template <int nvars>
 class SteadyForwardEulerSolver : public SteadySolver<nvars>
@@ -105,9 +209,35 @@ private:
 	using SteadySolver<nvars>::tdata;
 
 	std::vector<a_real> dtm;				///< Stores allowable local time step for each cell
+	AndersonAccelerator *anderson;		///< Acceleration of the time steps, or nullptr
 };
 
 /// Implicit pseudo-time iteration to steady state
+/** The linear system in each time step is solved by the PETSc KSP by default. If the option
+ * -linear_solver_backend NATIVE is passed, it is solved instead by a thread-parallel
+ * [native solver](\ref BlockKrylovSolver) configured by \ref getBlockSolverConfig,
+ * using a copy of the Jacobian in block sparse storage. This requires a stored Jacobian in a
+ * BAIJ matrix.
+ *
+ * The (stored) Jacobian can be lagged, ie., re-used over several time steps along with its
+ * preconditioner. It is re-assembled
+ *  - every N time steps, where N is given by the option -jacobian_lag (default 1, no lagging),
+ *  - when the ratio of the current nonlinear residual norm to the previous one exceeds
+ *    -jacobian_lag_residual_ratio (default 1), or
+ *  - when the previous linear solve needed more than -jacobian_lag_max_linear_iters iterations
+ *    (by default, there is no such limit).
+ * In between, only the pseudo-time term on the diagonal is updated, and only if the CFL number
+ * has changed. The decision in each time step is recorded in the \ref TimingData.
+ *
+ * By default, the relative tolerance of the linear solver is the one set in the KSP. If the option
+ * -linear_forcing_term is EW1 or EW2, it is instead set in each time step by choice 1 or choice 2
+ * of Eisenstat and Walker's forcing terms for inexact Newton methods, see \ref forcingTerm.
+ * The tolerance and the number of linear iterations of each time step are recorded in the
+ * \ref TimingData, and also written to the convergence history file in that case.
+ *
+ * The nonlinear updates can be accelerated by \ref AndersonAccelerator as in
+ * \ref SteadyForwardEulerSolver, with the options -anderson_depth and -anderson_restart_ratio.
+ */
 template <int nvars>
 class SteadyBackwardEulerSolver : public SteadySolver<nvars>
 {
@@ -139,21 +269,142 @@ protected:
 	using SteadySolver<nvars>::config;
 	using SteadySolver<nvars>::tdata;
 	using SteadySolver<nvars>::rvec;       ///< Residual vector
+	using SteadySolver<nvars>::linearRamp;
 
 	Vec duvec;                             ///< Nonlinear update vector
 	std::vector<a_real> dtm;               ///< Stores allowable local time step for each cell
 
 	KSP solver;                            ///< The solver context
 
-	/// Linear CFL ramping 
-	a_real linearRamp(const a_real cstart, const a_real cend, const int itstart, const int itend,
-			const int itcur) const;
+	/// The Jacobian in block sparse storage for the native solver, or nullptr if it is not used
+	BSRMatrix<nvars> *nativemat;
+	/// The matrix-free Jacobian seen by the native solver, or nullptr if the Jacobian is stored
+	PetscBlockOperator<nvars> *nativemfop;
+	BlockPreconditioner<nvars> *nativeprec;    ///< Preconditioner for the native solver
+	BlockKrylovSolver<nvars> *nativesolver;    ///< Native solver, or nullptr if PETSc is used
+	bool incrementalprec;                      ///< Whether nativeprec is refreshed incrementally
+
+	int jaclag;                            ///< Maximum number of time steps between Jacobian assemblies
+	a_real jaclagresratio;                 ///< Residual ratio above which the Jacobian is assembled
+	int jaclagmaxlinits;                   ///< Linear iterations above which it is assembled
+	/// The pseudo-time term currently in the diagonal of the Jacobian, for each cell
+	std::vector<a_real> mdiag;
+
+	/// Eisenstat-Walker forcing term - 1 or 2, or 0 for the fixed relative tolerance of the KSP
+	int ewchoice;
+	a_real eweta0;                         ///< Relative linear tolerance in the first time step
+	a_real ewetamax;                       ///< Upper bound of the relative linear tolerance
+	a_real ewgamma;                        ///< Multiplier in choice 2 and in its safeguard
+	a_real ewalpha;                        ///< Exponent in the forcing terms and safeguards
+
+	AndersonAccelerator *anderson;         ///< Acceleration of the nonlinear updates, or nullptr
+
+	/// Adds a multiple of the identity to each diagonal block of a matrix and assembles it
+	/** \param d The multiple of the identity to add, for each cell
+	 */
+	StatusCode addToDiagonal(Mat M, const std::vector<a_real>& d) const;
+
+	/// Computes the relative tolerance of the linear solver from the nonlinear residual history
+	/** Choice 1 is \f$ \eta_k = |\|F_k\| - \|F_{k-1}+J_{k-1}s_{k-1}\|| / \|F_{k-1}\| \f$,
+	 * with the safeguard \f$ \eta_{k-1}^\alpha \f$. Choice 2 is
+	 * \f$ \eta_k = \gamma (\|F_k\|/\|F_{k-1}\|)^\alpha \f$, with the safeguard
+	 * \f$ \gamma \eta_{k-1}^\alpha \f$. A safeguard is a lower bound applied when it
+	 * exceeds 0.1, so that the tolerance does not drop suddenly. The result is bounded above by
+	 * \ref ewetamax, and is not lower than needed to reduce the residual to the nonlinear tolerance.
+	 * \param fnorm L2 norm of the current residual
+	 * \param fnormold L2 norm of the residual in the previous time step
+	 * \param linresnorm L2 norm of the unpreconditioned linear residual at the end of the
+	 *   previous linear solve
+	 * \param etaold Relative linear tolerance in the previous time step
+	 * \param relres The current residual relative to the initial one, in the norm that the
+	 *   nonlinear tolerance applies to
+	 */
+	a_real forcingTerm(const a_real fnorm, const a_real fnormold, const a_real linresnorm,
+			const a_real etaold, const a_real relres) const;
 
 	/// A kind of exponential ramping, designed to be dependent on the residual ratio as base
 	a_real expResidualRamp(const a_real cflmin, const a_real cflmax, const a_real prevcfl,
 			const a_real resratio, const a_real paramup, const a_real paramdown);
 };
 
+/// Pseudo-time iteration to steady state accelerated by agglomeration multigrid
+/** Uses the full approximation scheme (FAS). The coarse levels are \ref AgglomeratedMesh es
+ * built from the mesh, on which the first-order inviscid residual of
+ * \ref Spatial::compute_agglomerated_residual is used, so only inviscid flows are supported.
+ * The coarse equations are forced so that their residual at the restricted state is the sum of
+ * the finer residuals in each agglomerate.
+ * States are restricted by area-weighted averaging and corrections are prolonged by injection.
+ *
+ * Each level is smoothed by local time-stepping, either explicitly by forward Euler, or
+ * point-implicitly by backward Euler with only the diagonal blocks of the first-order
+ * Jacobian, so that no linear solver is needed. The CFL number is ramped as in
+ * \ref SteadyBackwardEulerSolver, and is the same on all levels. One time step is one cycle.
+ *
+ * The following options are read:
+ *  - -mg_levels Number of levels including the finest one (default 3)
+ *  - -mg_cycle V (default) or W
+ *  - -mg_smoother IMPLICIT (default) or EXPLICIT
+ *  - -mg_pre_smooth, -mg_post_smooth Number of smoothing steps before restriction and
+ *    after prolongation (default 1 each)
+ *  - -mg_coarse_smooth Number of smoothing steps on the coarsest level (default 2)
+ */
+template <int nvars>
+class SteadyMultigridSolver : public SteadySolver<nvars>
+{
+public:
+	/// Builds the agglomerated levels and reads multigrid options
+	/** \param spatial The spatial discretization, which is used as is on the finest level
+	 * \param x A PETSc Vec from which the residual vector is duplicated
+	 * \param conf Settings of the pseudo-time iteration
+	 * \param periodicmarker Boundary marker of periodic boundaries, or -1
+	 */
+	SteadyMultigridSolver(const Spatial<nvars> *const spatial, const Vec x,
+			const SteadySolverConfig& conf, const int periodicmarker);
+
+	~SteadyMultigridSolver();
+
+	/// Runs multigrid cycles until the residual drops below the tolerance
+	StatusCode solve(Vec u);
+
+protected:
+	using SteadySolver<nvars>::space;
+	using SteadySolver<nvars>::config;
+	using SteadySolver<nvars>::rvec;
+	using SteadySolver<nvars>::tdata;
+	using SteadySolver<nvars>::linearRamp;
+
+	/// The levels - the first one is the mesh itself, each of the others agglomerates the previous
+	std::vector<AgglomeratedMesh*> levels;
+	int ncycle;                            ///< Number of coarse cycles per cycle - 1 for V, 2 for W
+	bool implicitsmoother;                 ///< Whether smoothing is point-implicit
+	int npresmooth;                        ///< Smoothing steps before restriction
+	int npostsmooth;                       ///< Smoothing steps after prolongation
+	int ncoarsesmooth;                     ///< Smoothing steps on the coarsest level
+
+	Vec uvec;                              ///< The solution vector passed to \ref solve
+	a_real curCFL;                         ///< CFL number of the current cycle
+	/// Whether the norm of the next residual computed on the finest level is to be stored
+	bool recordnorm;
+	a_real resnorm;                        ///< Norm of the first finest residual of the current cycle
+	int nfineresiduals;                    ///< Number of residual computations on the finest level
+
+	std::vector<std::vector<a_real>> state;      ///< State on each level
+	std::vector<std::vector<a_real>> restricted; ///< Restricted state, before coarse smoothing
+	std::vector<std::vector<a_real>> residual;   ///< Forced residual on each level
+	std::vector<std::vector<a_real>> forcing;    ///< FAS forcing term on each level
+	std::vector<std::vector<a_real>> dtm;        ///< Local time steps on each level
+	std::vector<std::vector<a_real>> diag;       ///< Jacobian diagonal blocks on each level
+
+	/// Computes the forced residual, local time steps and, if needed, diagonal blocks on a level
+	StatusCode computeResidual(const int level, const bool needdiag);
+
+	/// Carries out pseudo-time steps on a level
+	StatusCode smooth(const int level, const int nsteps);
+
+	/// Carries out one multigrid cycle starting at a level
+	StatusCode cycle(const int level);
+};
+
 /// Base class for unsteady simulations
 /** Note that the unknowns u and residuals R correspond to the following ODE:
  * \f$ \frac{du}{dt} + R(u) = 0 \f$. Note that the residual is on the LHS.
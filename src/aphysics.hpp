@@ -16,9 +16,12 @@
 namespace acfd {
 
 /// Returns a dot product computed between the first NDIM components of the two vectors.
-inline a_real dimDotProduct(const a_real *const u, const a_real *const v)
+/** The two vectors may have different scalar types, eg. a state of dual numbers and a normal.
+ */
+template <typename scalar1, typename scalar2>
+inline auto dimDotProduct(const scalar1 *const u, const scalar2 *const v) -> decltype(u[0]*v[0])
 {
-	a_real dot = 0;
+	decltype(u[0]*v[0]) dot = 0;
 	for(int i = 0; i < NDIM; i++)
 		dot += u[i]*v[i];
 	return dot;
@@ -82,8 +85,9 @@ public:
 	 * \param[in|out] flux Output vector for the flux; note that any pre-existing contents
 	 *   will be replaced!
 	 */
-	void getDirectionalFlux(const a_real *const uc, const a_real *const n,
-			const a_real vn, const a_real p, a_real *const __restrict flux) const
+	template <typename scalar>
+	void getDirectionalFlux(const scalar *const uc, const a_real *const n,
+			const scalar vn, const scalar p, scalar *const __restrict flux) const
 		__attribute__((always_inline));
 
 	/// Computes the analytical convective flux across a face oriented in some direction
@@ -111,10 +115,11 @@ public:
 	 * \param[out] p Pressure
 	 * \param[out] H Specific enthalpy
 	 */
-	void getVarsFromConserved(const a_real *const uc, const a_real *const n,
-			a_real *const v,
-			a_real& vn,
-			a_real& p, a_real& H ) const
+	template <typename scalar>
+	void getVarsFromConserved(const scalar *const uc, const a_real *const n,
+			scalar *const v,
+			scalar& vn,
+			scalar& p, scalar& H ) const
 		__attribute((always_inline));
 
 	/// Computes derivatives of variables computed in getVarsFromConserved
@@ -131,10 +136,12 @@ public:
 	a_real getFreestreamPressure() const;
 	
 	/// Computes pressure from internal energy - here it's the ideal gas relation	
-	a_real getPressure(const a_real internalenergy) const;
+	template <typename scalar>
+	scalar getPressure(const scalar internalenergy) const;
 
 	/// Computes pressure from conserved variables
-	a_real getPressureFromConserved(const a_real *const uc) const;
+	template <typename scalar>
+	scalar getPressureFromConserved(const scalar *const uc) const;
 
 	/// Computes pressure gradient from conserved variables and their gradients
 	a_real getGradPressureFromConservedAndGradConserved(const a_real *const uc,
@@ -152,7 +159,8 @@ public:
 			a_real *const __restrict dp) const;
 
 	/// Computes temperature from density and pressure - depends on non-dimensionalization.
-	a_real getTemperature(const a_real rho, const a_real p) const;
+	template <typename scalar>
+	scalar getTemperature(const scalar rho, const scalar p) const;
 
 	/// Computes derivatives of temperature w.r.t. either conserved, primitive or primitive2
 	/** \note Derivatives can be computed w.r.t. any variable-set that 
@@ -164,7 +172,8 @@ public:
 			a_real *const __restrict dT) const;
 	
 	/// Computes speed of sound from density and pressure
-	a_real getSoundSpeed(const a_real rho, const a_real p) const;
+	template <typename scalar>
+	scalar getSoundSpeed(const scalar rho, const scalar p) const;
 
 	/// Derivative of sound speed
 	/** The variable-set w.r.t. which the differentiation happens is the same as that w.r.t.
@@ -176,7 +185,8 @@ public:
 			a_real *const __restrict dc) const;
 
 	/// Computes speed of sound from conserved variables
-	a_real getSoundSpeedFromConserved(const a_real *const uc) const;
+	template <typename scalar>
+	scalar getSoundSpeedFromConserved(const scalar *const uc) const;
 
 	/// Derivative of sound speed w.r.t. conserved variables
 	void getJacobianSoundSpeedWrtConserved(const a_real *const uc,
@@ -191,10 +201,12 @@ public:
 	a_real getEntropyFromConserved(const a_real *const uc) const;
 
 	/// Compute energy from pressure, density and square of magnitude of velocity
-	a_real getEnergyFromPressure(const a_real p, const a_real d, const a_real vmag2) const;
+	template <typename scalar>
+	scalar getEnergyFromPressure(const scalar p, const scalar d, const scalar vmag2) const;
 	
 	/// Compute energy from temperature, density and square of magnitude of velocity
-	a_real getEnergyFromTemperature(const a_real T, const a_real d, const a_real vmag2) const;
+	template <typename scalar>
+	scalar getEnergyFromTemperature(const scalar T, const scalar d, const scalar vmag2) const;
 	
 	/// Computes derivatives of total energy from derivatives of temperature and |v|^2
 	/** Can compute the derivatives w.r.t. any variable-set as long as
@@ -208,21 +220,25 @@ public:
 		a_real *const drhoE) const;
 
 	/// Computes total energy from primitive variabes
-	a_real getEnergyFromPrimitive(const a_real *const up) const;
+	template <typename scalar>
+	scalar getEnergyFromPrimitive(const scalar *const up) const;
 
 	/// Computes total energy from a vector of density, velocities and temperature
 	/** All quantities are non-dimensional.
 	 */
-	a_real getEnergyFromPrimitive2(const a_real *const upt) const;
+	template <typename scalar>
+	scalar getEnergyFromPrimitive2(const scalar *const upt) const;
 
 	/// Convert conserved variables to primitive variables (density, velocities, pressure)
 	/** The input pointers are not assumed restricted, so the two parameters can point to
 	 * the same storage.
 	 */
-	void getPrimitiveFromConserved(const a_real *const uc, a_real *const up) const;
+	template <typename scalar>
+	void getPrimitiveFromConserved(const scalar *const uc, scalar *const up) const;
 	
 	/// Convert conserved variables to primitive-2 variables; depends on non-dimensionalization
-	void getPrimitive2FromConserved(const a_real *const uc, a_real *const up) const;
+	template <typename scalar>
+	void getPrimitive2FromConserved(const scalar *const uc, scalar *const up) const;
 	
 	/// Computes the Jacobian matrix of the conserved-to-primitive-2 transformation
 	/** \f$ \partial \mathbf{u}_{prim2} / \partial \mathbf{u}_{cons} \f$. 
@@ -238,11 +254,13 @@ public:
 	/** The input pointers are not assumed restricted, so the two parameters can point to
 	 * the same storage.
 	 */
-	void getConservedFromPrimitive(const a_real *const up, a_real *const uc) const;
+	template <typename scalar>
+	void getConservedFromPrimitive(const scalar *const up, scalar *const uc) const;
 
 	/// Computes density from pressure and temperature using ideal gas relation;
 	/// All quantities are non-dimensional
-	a_real getDensityFromPressureTemperature(const a_real pressure, const a_real temperature) const;
+	template <typename scalar>
+	scalar getDensityFromPressureTemperature(const scalar pressure, const scalar temperature) const;
 
 	/// Computes derivatives of density from derivatives of pressure and temperature
 	void getJacobianDensityFromJacobiansPressureTemperature(
@@ -252,7 +270,8 @@ public:
 	/// Computes non-dimensional temperature from non-dimensional conserved variables
 	/** \sa IdealGasPhysics
 	 */
-	a_real getTemperatureFromConserved(const a_real *const uc) const;
+	template <typename scalar>
+	scalar getTemperatureFromConserved(const scalar *const uc) const;
 	
 	/// Computes derivatives of temperature w.r.t. conserved variables
 	/** \param[in|out] dT The derivatives are added to dT, which is not zeroed initially.
@@ -261,11 +280,13 @@ public:
 			a_real *const __restrict dT) const;
 
 	/// Computes non-dimensional temperature from non-dimensional primitive variables
-	a_real getTemperatureFromPrimitive(const a_real *const up) const;
+	template <typename scalar>
+	scalar getTemperatureFromPrimitive(const scalar *const up) const;
 
 	/// Computes non-dim temperature gradient from non-dim density, pressure and their gradients
-	a_real getGradTemperature(const a_real rho, const a_real gradrho, 
-		const a_real p, const a_real gradp) const;
+	template <typename scalar>
+	scalar getGradTemperature(const scalar rho, const scalar gradrho, 
+		const scalar p, const scalar gradp) const;
 
 	/// Compute non-dim temperature spatial derivative 
 	/// from non-dim conserved variables and their spatial derivatives
@@ -287,7 +308,8 @@ public:
 	/** By viscosity coefficient, we mean dynamic viscosity divided by 
 	 * the free-stream Reynolds number.
 	 */
-	a_real getViscosityCoeffFromTemperature(const a_real T) const;
+	template <typename scalar>
+	scalar getViscosityCoeffFromTemperature(const scalar T) const;
 
 	/// Computes non-dimensional viscosity coeff using Sutherland's law from conserved variables
 	/** This is the dynamic viscosity divided by the Reynolds number
@@ -305,7 +327,8 @@ public:
 	a_real getConstantViscosityCoeff() const;
 
 	/// Computes non-dimensional conductivity from non-dimensional dynamic viscosity coeff
-	a_real getThermalConductivityFromViscosity(const a_real muhat) const;
+	template <typename scalar>
+	scalar getThermalConductivityFromViscosity(const scalar muhat) const;
 
 	/** \brief Computes derivatives of non-dim thermal conductivity w.r.t. conserved variables
 	 * given derivatives of the non-dim viscosity coeff w.r.t. conserved variables.
@@ -320,8 +343,9 @@ public:
 	 * \param[in] grad Gradients of primitve variables
 	 * \param[in,out] stress Components of the stress tensor on output
 	 */
-	void getStressTensor(const a_real mu, const a_real grad[NDIM][NVARS], 
-			a_real stress[NDIM][NDIM]) const __attribute((always_inline));
+	template <typename scalar>
+	void getStressTensor(const scalar mu, const scalar grad[NDIM][NVARS], 
+			scalar stress[NDIM][NDIM]) const __attribute((always_inline));
 
 	/// Computes Jacobian of stress tensor using Jacobian of gradients of primitive variables
 	/** Assigns the computed Jacobian to the output array components so prior contents are lost.
@@ -344,9 +368,10 @@ public:
 	const a_real sC;
 };
 
+template <typename scalar>
 inline
-void IdealGasPhysics::getDirectionalFlux(const a_real *const uc, const a_real *const n,
-		const a_real vn, const a_real p, a_real *const __restrict flux) const
+void IdealGasPhysics::getDirectionalFlux(const scalar *const uc, const a_real *const n,
+		const scalar vn, const scalar p, scalar *const __restrict flux) const
 {
 	flux[0] = vn*uc[0];
 	for(int i = 1; i < NDIM+1; i++)
@@ -354,16 +379,17 @@ void IdealGasPhysics::getDirectionalFlux(const a_real *const uc, const a_real *c
 	flux[NVARS-1] = vn*(uc[NVARS-1] + p);
 }
 
+template <typename scalar>
 inline
-void IdealGasPhysics::getVarsFromConserved(const a_real *const uc, const a_real *const n,
-		a_real *const __restrict v,
-		a_real& vn,
-		a_real& p, a_real& H ) const
+void IdealGasPhysics::getVarsFromConserved(const scalar *const uc, const a_real *const n,
+		scalar *const __restrict v,
+		scalar& vn,
+		scalar& p, scalar& H ) const
 {
 	for(int j = 0; j < NDIM; j++)
 		v[j] = uc[j+1]/uc[0]; 
 	vn = dimDotProduct(v,n);
-	const a_real vmag2 = dimDotProduct(v,v);
+	const scalar vmag2 = dimDotProduct(v,v);
 	p = (g-1.0)*(uc[3] - 0.5*uc[0]*vmag2);
 	H = (uc[3]+p)/uc[0];
 }
@@ -378,14 +404,16 @@ void IdealGasPhysics::getJacobianVmag2WrtConserved(const a_real *const uc,
 		dvmag2[i] += 2.0*uc[i]/(uc[0]*uc[0]);
 }
 
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getPressure(const a_real internalenergy) const {
+scalar IdealGasPhysics::getPressure(const scalar internalenergy) const {
 	return (g-1.0)*internalenergy;
 }
 
 // not restricted to ideal gases
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getPressureFromConserved(const a_real *const uc) const
+scalar IdealGasPhysics::getPressureFromConserved(const scalar *const uc) const
 {
 	return getPressure(uc[NDIM+1] - 0.5*dimDotProduct(&uc[1],&uc[1])/uc[0]);
 }
@@ -420,8 +448,9 @@ void IdealGasPhysics::getJacobianPressureWrtConserved(const a_real *const uc,
 	dp[NDIM+1] += (g-1.0);
 }
 
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getTemperature(const a_real rho, const a_real p) const
+scalar IdealGasPhysics::getTemperature(const scalar rho, const scalar p) const
 {
   return p/rho * g*Minf*Minf;
 }
@@ -437,10 +466,11 @@ void IdealGasPhysics::getJacobianTemperature(const a_real rho,
 		dT[i] += coef/rho * dp[i];
 }
 
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getSoundSpeed(const a_real rho, const a_real p) const
+scalar IdealGasPhysics::getSoundSpeed(const scalar rho, const scalar p) const
 {
-	return std::sqrt(g * p/rho);
+	return sqrt(g * p/rho);
 }
 
 inline
@@ -455,8 +485,9 @@ void IdealGasPhysics::getJacobianSoundSpeed(const a_real rho,
 
 // independent of non-dimensionalization
 // not restricted to ideal gases
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getSoundSpeedFromConserved(const a_real *const uc) const
+scalar IdealGasPhysics::getSoundSpeedFromConserved(const scalar *const uc) const
 {
   return getSoundSpeed(uc[0],getPressureFromConserved(uc));
 }
@@ -501,16 +532,18 @@ a_real IdealGasPhysics::getEntropyFromConserved(const a_real *const uc) const
 	return getPressureFromConserved(uc)/std::pow(uc[0],g);
 }
 
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getEnergyFromPressure(const a_real p, const a_real d, const a_real vmag2) 
+scalar IdealGasPhysics::getEnergyFromPressure(const scalar p, const scalar d, const scalar vmag2) 
 	const 
 {
 	return p/(g-1.0) + 0.5*d*vmag2;
 }
 
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getEnergyFromTemperature(const a_real T, const a_real d, 
-		const a_real vmag2) const
+scalar IdealGasPhysics::getEnergyFromTemperature(const scalar T, const scalar d, 
+		const scalar vmag2) const
 {
 	return d * (T/(g*(g-1.0)*Minf*Minf) + 0.5*vmag2);
 }
@@ -528,14 +561,16 @@ void IdealGasPhysics::getJacobianEnergyFromJacobiansTemperatureVmag2(
 }
 
 // independent of non-dimensionalization
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getEnergyFromPrimitive(const a_real *const up) const
+scalar IdealGasPhysics::getEnergyFromPrimitive(const scalar *const up) const
 {
 	return getEnergyFromPressure(up[NVARS-1], up[0], dimDotProduct(&up[1],&up[1]));
 }
 
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getEnergyFromPrimitive2(const a_real *const upt) const
+scalar IdealGasPhysics::getEnergyFromPrimitive2(const scalar *const upt) const
 {
 	/*const a_real p = upt[0]*upt[NDIM+1]/(g*Minf*Minf);
 	return p/(g-1.0) + 0.5*upt[0]*dimDotProduct(&upt[1],&upt[1]);*/
@@ -544,11 +579,12 @@ a_real IdealGasPhysics::getEnergyFromPrimitive2(const a_real *const upt) const
 
 // independent of non-dimensionalization
 // not restricted to ideal gases
+template <typename scalar>
 inline
-void IdealGasPhysics::getPrimitiveFromConserved(const a_real *const uc, a_real *const up) const
+void IdealGasPhysics::getPrimitiveFromConserved(const scalar *const uc, scalar *const up) const
 {
 	up[0] = uc[0];
-	const a_real p = getPressureFromConserved(uc);
+	const scalar p = getPressureFromConserved(uc);
 	for(int idim = 1; idim < NDIM+1; idim++) {
 		up[idim] = uc[idim]/uc[0];
 	}
@@ -557,11 +593,12 @@ void IdealGasPhysics::getPrimitiveFromConserved(const a_real *const uc, a_real *
 
 // independent of non-dimensionalization
 // not restricted to ideal gases
+template <typename scalar>
 inline
-void IdealGasPhysics::getPrimitive2FromConserved(const a_real *const uc, a_real *const up) const
+void IdealGasPhysics::getPrimitive2FromConserved(const scalar *const uc, scalar *const up) const
 {
 	up[0] = uc[0];
-	const a_real p = getPressureFromConserved(uc);
+	const scalar p = getPressureFromConserved(uc);
 	for(int idim = 1; idim < NDIM+1; idim++) {
 		up[idim] = uc[idim]/uc[0];
 	}
@@ -570,20 +607,22 @@ void IdealGasPhysics::getPrimitive2FromConserved(const a_real *const uc, a_real
 
 // independent of non-dimensionalization
 // not restricted to ideal gases
+template <typename scalar>
 inline
-void IdealGasPhysics::getConservedFromPrimitive(const a_real *const up, a_real *const uc) const
+void IdealGasPhysics::getConservedFromPrimitive(const scalar *const up, scalar *const uc) const
 {
 	uc[0] = up[0];
-	const a_real rhoE = getEnergyFromPrimitive(up);
+	const scalar rhoE = getEnergyFromPrimitive(up);
 	for(int idim = 1; idim < NDIM+1; idim++) {
 		uc[idim] = up[0]*up[idim];
 	}
 	uc[NDIM+1] = rhoE;
 }
 
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getDensityFromPressureTemperature(const a_real pressure, 
-		const a_real temperature) const
+scalar IdealGasPhysics::getDensityFromPressureTemperature(const scalar pressure, 
+		const scalar temperature) const
 {
 	return g*Minf*Minf*pressure/temperature;
 }
@@ -599,8 +638,9 @@ void IdealGasPhysics::getJacobianDensityFromJacobiansPressureTemperature(
 
 // independent of non-dimensionalization
 // not restricted to ideal gases
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getTemperatureFromConserved(const a_real *const uc) const
+scalar IdealGasPhysics::getTemperatureFromConserved(const scalar *const uc) const
 {
 	return getTemperature(uc[0], getPressureFromConserved(uc));
 }
@@ -618,15 +658,17 @@ void IdealGasPhysics::getJacobianTemperatureWrtConserved(const a_real *const uc,
 }
 
 // independent of non-dimensionalization
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getTemperatureFromPrimitive(const a_real *const up) const
+scalar IdealGasPhysics::getTemperatureFromPrimitive(const scalar *const up) const
 {
 	return getTemperature(up[0], up[NVARS-1]);
 }
 
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getGradTemperature(const a_real rho, const a_real gradrho, 
-		const a_real p, const a_real gradp) const
+scalar IdealGasPhysics::getGradTemperature(const scalar rho, const scalar gradrho, 
+		const scalar p, const scalar gradp) const
 {
 	return (gradp*rho - p*gradrho) / (rho*rho) * g*Minf*Minf;
 }
@@ -681,10 +723,11 @@ void IdealGasPhysics::getGradPrimitive2FromConservedAndGradConserved(
 	gup[NVARS-1] = getGradTemperature(uc[0],gup[0], p, dp);
 }
 
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getViscosityCoeffFromTemperature(const a_real T) const
+scalar IdealGasPhysics::getViscosityCoeffFromTemperature(const scalar T) const
 {
-	return (1.0+sC/Tinf)/(T+sC/Tinf) * std::pow(T,1.5) / Reinf;
+	return (1.0+sC/Tinf)/(T+sC/Tinf) * pow(T,1.5) / Reinf;
 }
 
 inline
@@ -715,8 +758,9 @@ a_real IdealGasPhysics::getConstantViscosityCoeff() const {
 	return 1.0/Reinf;
 }
 
+template <typename scalar>
 inline
-a_real IdealGasPhysics::getThermalConductivityFromViscosity(const a_real muhat) const {
+scalar IdealGasPhysics::getThermalConductivityFromViscosity(const scalar muhat) const {
 	return muhat / (Minf*Minf*(g-1.0)*Pr);
 }
 
@@ -733,12 +777,13 @@ a_real IdealGasPhysics::getFreestreamPressure() const {
 	return 1.0/(g*Minf*Minf);
 }
 
+template <typename scalar>
 inline
-void IdealGasPhysics::getStressTensor(const a_real mu, const a_real grad[NDIM][NVARS], 
-		a_real stress[NDIM][NDIM]) const
+void IdealGasPhysics::getStressTensor(const scalar mu, const scalar grad[NDIM][NVARS], 
+		scalar stress[NDIM][NDIM]) const
 {
 	// divergence of velocity times second viscosity
-	a_real ldiv = 0;
+	scalar ldiv = 0;
 	for(int j = 0; j < NDIM; j++)
 		ldiv += grad[j][j+1];
 	ldiv *= 2.0/3.0*mu;
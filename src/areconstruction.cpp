@@ -8,22 +8,6 @@
 
 namespace acfd {
 
-/// Reconstructs a face value
-static inline a_real linearExtrapolate(
-		const a_real ucell,             ///< Relevant cell centred value
-		const FArray<NDIM,NVARS>& grad, ///< Gradients
-		const int ivar,                 ///< Index of physical variable to be reconstructed
-		const a_real lim,               ///< Limiter value
-		const a_real *const gp,         ///< Quadrature point coords
-		const a_real *const rc          ///< Cell centre coords
-	)
-{
-	a_real uface = ucell;
-	for(int idim = 0; idim < NDIM; idim++)
-		uface += lim*grad(idim,ivar)*(gp[idim] - rc[idim]);
-	return uface;
-}
-
 SolutionReconstruction::SolutionReconstruction (const UMesh2dh *const mesh, 
 		const amat::Array2d<a_real>& c_centres, 
 		const amat::Array2d<a_real>* gauss_r)
@@ -33,11 +17,48 @@ SolutionReconstruction::SolutionReconstruction (const UMesh2dh *const mesh,
 SolutionReconstruction::~SolutionReconstruction()
 { }
 
+bool SolutionReconstruction::has_cell_limiters() const
+{
+	return false;
+}
+
+int SolutionReconstruction::stencil_radius() const
+{
+	return 1;
+}
+
+void SolutionReconstruction::compute_limiters(const MVector& u, 
+		const amat::Array2d<a_real>& ug,
+		const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
+		amat::Array2d<a_real>& phi) const
+{
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			phi(iel,ivar) = 1.0;
+}
+
+void SolutionReconstruction::compute_limiters(const amat::Array2d<Dual>& u, 
+		const amat::Array2d<Dual>& ug,
+		const amat::Array2d<Dual>& grads,
+		amat::Array2d<Dual>& phi) const
+{
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			phi(iel,ivar) = 1.0;
+}
+
 LinearUnlimitedReconstruction::LinearUnlimitedReconstruction(const UMesh2dh *const mesh,
 		const amat::Array2d<a_real>& c_centres, const amat::Array2d<a_real>* gauss_r)
 	: SolutionReconstruction(mesh, c_centres, gauss_r)
 { }
 
+bool LinearUnlimitedReconstruction::has_cell_limiters() const
+{
+	return true;
+}
+
 void LinearUnlimitedReconstruction::compute_face_values(
 		const MVector& u, 
 		const amat::Array2d<a_real>& ug,
@@ -156,6 +177,11 @@ void WENOReconstruction::compute_face_values(const MVector& u,
 	}
 }
 
+int WENOReconstruction::stencil_radius() const
+{
+	return 2;
+}
+
 MUSCLReconstruction::MUSCLReconstruction(const UMesh2dh *const mesh,
 		const amat::Array2d<a_real>& r_centres, const amat::Array2d<a_real>* gauss_r)
 	: SolutionReconstruction(mesh, r_centres, gauss_r), eps{1e-8}, k{1.0/3.0}
@@ -270,35 +296,7 @@ void BarthJespersenLimiter::compute_face_values(const MVector& u,
 	{
 		for(int ivar = 0; ivar < NVARS; ivar++)
 		{
-			a_real duimin=0, duimax=0;
-			for(int j = 0; j < m->gnfael(iel); j++)
-			{
-				const a_int jel = m->gesuel(iel,j);
-				const a_real dui = u(jel,ivar)-u(iel,ivar);
-				if(dui > duimax) duimax = dui;
-				if(dui < duimin) duimin = dui;
-			}
-			
-			a_real lim = 1.0;
-			for(int j = 0; j < m->gnfael(iel); j++)
-			{
-				const a_int face = m->gelemface(iel,j);
-				
-				const a_real uface = linearExtrapolate(u(iel,ivar), grads[iel], ivar, 1.0,
-						&gr[face](0,0), &ri(iel,0));
-				
-				a_real phiik;
-				const a_real diff = uface - u(iel,ivar);
-				if(diff>0)
-					phiik = 1 < duimax/diff ? 1 : duimax/diff;
-				else if(diff < 0)
-					phiik = 1 < duimin/diff ? 1 : duimin/diff;
-				else
-					phiik = 1;
-
-				if(phiik < lim)
-					lim = phiik;
-			}
+			const a_real lim = computeLimiter(iel, ivar, u, ug, grads);
 			
 			for(int j = 0; j < m->gnfael(iel); j++)
 			{
@@ -317,6 +315,22 @@ void BarthJespersenLimiter::compute_face_values(const MVector& u,
 	}
 }
 
+bool BarthJespersenLimiter::has_cell_limiters() const
+{
+	return true;
+}
+
+void BarthJespersenLimiter::compute_limiters(const amat::Array2d<Dual>& u, 
+		const amat::Array2d<Dual>& ug,
+		const amat::Array2d<Dual>& grads,
+		amat::Array2d<Dual>& phi) const
+{
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			phi(iel,ivar) = computeLimiter(iel, ivar, u, ug, grads);
+}
+
 VenkatakrishnanLimiter::VenkatakrishnanLimiter(const UMesh2dh *const mesh, 
 		const amat::Array2d<a_real>& r_centres, const amat::Array2d<a_real>* gauss_r,
 		a_real k_param=2.0)
@@ -350,36 +364,9 @@ void VenkatakrishnanLimiter::compute_face_values(const MVector& u,
 #pragma omp parallel for default(shared)
 	for(a_int iel = 0; iel < m->gnelem(); iel++)
 	{
-		const a_real eps2 = std::pow(K*clength[iel], 3);
-
 		for(int ivar = 0; ivar < NVARS; ivar++)
 		{
-			a_real duimin=0, duimax=0;
-			for(int j = 0; j < m->gnfael(iel); j++)
-			{
-				const a_int jel = m->gesuel(iel,j);
-				const a_real dui = u(jel,ivar)-u(iel,ivar);
-				if(dui > duimax) duimax = dui;
-				if(dui < duimin) duimin = dui;
-			}
-			
-			a_real lim = 1.0;
-			for(int j = 0; j < m->gnfael(iel); j++)
-			{
-				const a_int face = m->gelemface(iel,j);
-				
-				const a_real uface = linearExtrapolate(u(iel,ivar), grads[iel], ivar, 1.0,
-						&gr[face](0,0), &ri(iel,0));
-				
-				const a_real dm = uface - u(iel,ivar);
-
-				// Venkatakrishnan modification
-				const a_real dp = dm < 0 ? duimin : duimax;
-				const a_real phiik = (dp*dp + 2*dp*dm + eps2)/(dp*dp + dp*dm + 2*dm*dm + eps2);
-
-				if(phiik < lim)
-					lim = phiik;
-			}
+			const a_real lim = computeLimiter(iel, ivar, u, ug, grads);
 			
 			for(int j = 0; j < m->gnfael(iel); j++)
 			{
@@ -398,5 +385,21 @@ void VenkatakrishnanLimiter::compute_face_values(const MVector& u,
 	}
 }
 
+bool VenkatakrishnanLimiter::has_cell_limiters() const
+{
+	return true;
+}
+
+void VenkatakrishnanLimiter::compute_limiters(const amat::Array2d<Dual>& u, 
+		const amat::Array2d<Dual>& ug,
+		const amat::Array2d<Dual>& grads,
+		amat::Array2d<Dual>& phi) const
+{
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			phi(iel,ivar) = computeLimiter(iel, ivar, u, ug, grads);
+}
+
 } // end namespace
 
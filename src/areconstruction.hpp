@@ -6,9 +6,11 @@
 #ifndef ARECONSTRUCTION_H
 #define ARECONSTRUCTION_H
 
+#include <cmath>
 #include "aconstants.hpp"
 #include "aarray2d.hpp"
 #include "amesh2dh.hpp"
+#include "adual.hpp"
 
 namespace acfd {
 
@@ -34,6 +36,46 @@ public:
 			const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
 			amat::Array2d<a_real>& uface_left, amat::Array2d<a_real>& uface_right) const = 0;
 
+	/// Whether the face values are linear extrapolations limited by one factor per cell
+	/** If so, the face value of variable k on the side of cell i is
+	 * \f$ u_{i,k} + \phi_{i,k} \nabla u_{i,k} \cdot (\mathbf{r}_f - \mathbf{r}_i) \f$,
+	 * where the limiter factors \f$ \phi \f$ are given by \ref compute_limiters.
+	 * Face values can then be computed when needed instead of being stored.
+	 * The default is false.
+	 */
+	virtual bool has_cell_limiters() const;
+
+	/// Number of steps across faces within which the cells are that the face values on the side
+	/// of a cell depend on
+	/** Gradients couple a cell to its face neighbours, so this is at least 1, the default.
+	 */
+	virtual int stencil_radius() const;
+
+	/// Computes the limiter factor for each variable in each cell
+	/** Only valid if \ref has_cell_limiters returns true. The default sets all factors to 1.
+	 * \param[in] unknowns Cell-centred values
+	 * \param[in] unknow_ghost Ghost cell values
+	 * \param[in] grads Cell-centred gradients
+	 * \param[out] phi Limiter factors, nelem x NVARS
+	 */
+	virtual void compute_limiters(const MVector& unknowns, 
+			const amat::Array2d<a_real>& unknow_ghost,
+			const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
+			amat::Array2d<a_real>& phi) const;
+
+	/// Computes the limiter factors and their derivatives in some direction
+	/** Same as the real-valued \ref compute_limiters, for states carrying a direction.
+	 * \param[in] unknowns Cell-centred values
+	 * \param[in] unknow_ghost Ghost cell values
+	 * \param[in] grads Cell-centred gradients; the derivative w.r.t. coordinate idim of
+	 *   variable ivar is in column idim*NVARS+ivar
+	 * \param[out] phi Limiter factors, nelem x NVARS
+	 */
+	virtual void compute_limiters(const amat::Array2d<Dual>& unknowns, 
+			const amat::Array2d<Dual>& unknow_ghost,
+			const amat::Array2d<Dual>& grads,
+			amat::Array2d<Dual>& phi) const;
+
 	virtual ~SolutionReconstruction();
 };
 
@@ -41,7 +83,7 @@ public:
 /// based on computed derivatives but without limiter.
 /** ug (cell centered flow variables at ghost cells) are not used for this
  */
-class LinearUnlimitedReconstruction : public SolutionReconstruction
+class LinearUnlimitedReconstruction final : public SolutionReconstruction
 {
 public:
 	/// Constructor. \sa SolutionReconstruction::SolutionReconstruction.
@@ -53,6 +95,9 @@ public:
 			const amat::Array2d<a_real>& unknow_ghost, 
 			const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
 			amat::Array2d<a_real>& uface_left, amat::Array2d<a_real>& uface_right) const;
+
+	/// Returns true; the limiter factors are all 1
+	bool has_cell_limiters() const;
 };
 
 /// Computes state at left and right sides of each face based on WENO-limited derivatives 
@@ -62,7 +107,7 @@ public:
  * Note that we do not take the 'oscillation indicator' as the square of the magnitude of 
  * the gradient, like (it seems) in Dumbser & Kaeser, but unlike in Xia et. al.
  */
-class WENOReconstruction : public SolutionReconstruction
+class WENOReconstruction final : public SolutionReconstruction
 {
 	const a_real gamma;
 	const a_real lambda;
@@ -76,6 +121,10 @@ public:
 			const amat::Array2d<a_real>& unknow_ghost, 
 			const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
 			amat::Array2d<a_real>& uface_left, amat::Array2d<a_real>& uface_right) const;
+
+	/// Returns 2, as the limited derivatives of a cell are computed from the gradients of its
+	/// face neighbours
+	int stencil_radius() const;
 };
 
 /// Provides common functionality for computing face values using MUSCL reconstruciton
@@ -127,7 +176,7 @@ protected:
 };
 
 /// Computes face values using MUSCL reconstruciton with Van-Albada limiter
-class MUSCLVanAlbada : public MUSCLReconstruction
+class MUSCLVanAlbada final : public MUSCLReconstruction
 {
 public:
     MUSCLVanAlbada(const UMesh2dh *const mesh,
@@ -141,7 +190,7 @@ public:
 };
 
 /// Non-differentiable multidimensional slope limiter for linear reconstruction
-class BarthJespersenLimiter : public SolutionReconstruction
+class BarthJespersenLimiter final : public SolutionReconstruction
 {
 public:
     BarthJespersenLimiter(const UMesh2dh *const mesh, 
@@ -152,10 +201,31 @@ public:
 			const amat::Array2d<a_real>& unknow_ghost, 
 			const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
 			amat::Array2d<a_real>& uface_left, amat::Array2d<a_real>& uface_right) const;
+
+	bool has_cell_limiters() const;
+
+	void compute_limiters(const MVector& unknowns, 
+			const amat::Array2d<a_real>& unknow_ghost,
+			const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
+			amat::Array2d<a_real>& phi) const;
+
+	void compute_limiters(const amat::Array2d<Dual>& unknowns, 
+			const amat::Array2d<Dual>& unknow_ghost,
+			const amat::Array2d<Dual>& grads,
+			amat::Array2d<Dual>& phi) const;
+
+protected:
+	/// Computes the limiter factor of one variable in one cell
+	/** The cell values are either an MVector or an array of dual numbers, with gradients
+	 * stored correspondingly (see \ref compute_limiters).
+	 */
+	template <typename scalar, typename CellValues, typename Gradients>
+	scalar computeLimiter(const a_int iel, const int ivar, const CellValues& u, 
+			const amat::Array2d<scalar>& ug, const Gradients& grads) const;
 };
 
 /// Differentiable modification of Barth-Jespersen limiter
-class VenkatakrishnanLimiter: public SolutionReconstruction
+class VenkatakrishnanLimiter final : public SolutionReconstruction
 {
 	/// Parameter for adjusting limiting vs convergence
 	const a_real K;
@@ -176,7 +246,177 @@ public:
 			const amat::Array2d<a_real>& unknow_ghost, 
 			const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
 			amat::Array2d<a_real>& uface_left, amat::Array2d<a_real>& uface_right) const;
+
+	bool has_cell_limiters() const;
+
+	void compute_limiters(const MVector& unknowns, 
+			const amat::Array2d<a_real>& unknow_ghost,
+			const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
+			amat::Array2d<a_real>& phi) const;
+
+	void compute_limiters(const amat::Array2d<Dual>& unknowns, 
+			const amat::Array2d<Dual>& unknow_ghost,
+			const amat::Array2d<Dual>& grads,
+			amat::Array2d<Dual>& phi) const;
+
+protected:
+	/// Computes the limiter factor of one variable in one cell
+	/** The cell values are either an MVector or an array of dual numbers, with gradients
+	 * stored correspondingly (see \ref compute_limiters).
+	 */
+	template <typename scalar, typename CellValues, typename Gradients>
+	scalar computeLimiter(const a_int iel, const int ivar, const CellValues& u, 
+			const amat::Array2d<scalar>& ug, const Gradients& grads) const;
 };
 
+/* The limiter kernels are defined here, so that callers that know the type of the limiter,
+ * such as FlowFVStatic, can have them inlined.
+ */
+
+/// Reconstructs a face value
+inline a_real linearExtrapolate(
+		const a_real ucell,             ///< Relevant cell centred value
+		const FArray<NDIM,NVARS>& grad, ///< Gradients
+		const int ivar,                 ///< Index of physical variable to be reconstructed
+		const a_real lim,               ///< Limiter value
+		const a_real *const gp,         ///< Quadrature point coords
+		const a_real *const rc          ///< Cell centre coords
+	)
+{
+	a_real uface = ucell;
+	for(int idim = 0; idim < NDIM; idim++)
+		uface += lim*grad(idim,ivar)*(gp[idim] - rc[idim]);
+	return uface;
+}
+
+/// Reconstructs a face value from gradients of dual numbers
+/** \param grad The gradients of one cell, stored as for SolutionReconstruction::compute_limiters
+ */
+inline Dual linearExtrapolate(const Dual ucell, const Dual *const grad, const int ivar,
+		const Dual lim, const a_real *const gp, const a_real *const rc)
+{
+	Dual uface = ucell;
+	for(int idim = 0; idim < NDIM; idim++)
+		uface += lim*grad[idim*NVARS+ivar]*(gp[idim] - rc[idim]);
+	return uface;
+}
+
+/// Returns the gradients of one cell in the form linearExtrapolate needs
+inline const FArray<NDIM,NVARS>& getCellGradient(
+		const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
+		const a_int iel)
+{
+	return grads[iel];
+}
+
+inline const Dual* getCellGradient(const amat::Array2d<Dual>& grads, const a_int iel)
+{
+	return grads.const_row_pointer(iel);
+}
+
+/// Returns the cell-centred value of a variable in a real or ghost cell
+/** \param[in] u Values in real cells
+ * \param[in] ug Values in ghost cells; the ghost cell across boundary face ied has index nelem+ied
+ */
+template <typename CellValues, typename scalar>
+inline scalar getCellValue(const UMesh2dh *const m, const CellValues& u, 
+		const amat::Array2d<scalar>& ug, const a_int iel, const int ivar)
+{
+	return iel < m->gnelem() ? u(iel,ivar) : ug(iel-m->gnelem(),ivar);
+}
+
+template <typename scalar, typename CellValues, typename Gradients>
+inline scalar BarthJespersenLimiter::computeLimiter(const a_int iel, const int ivar, const CellValues& u,
+		const amat::Array2d<scalar>& ug, const Gradients& grads) const
+{
+	scalar duimin=0, duimax=0;
+	for(int j = 0; j < m->gnfael(iel); j++)
+	{
+		const a_int jel = m->gesuel(iel,j);
+		const scalar dui = getCellValue(m,u,ug,jel,ivar)-u(iel,ivar);
+		if(dui > duimax) duimax = dui;
+		if(dui < duimin) duimin = dui;
+	}
+	
+	scalar lim = 1.0;
+	for(int j = 0; j < m->gnfael(iel); j++)
+	{
+		const a_int face = m->gelemface(iel,j);
+		
+		const scalar uface = linearExtrapolate(u(iel,ivar), getCellGradient(grads,iel), ivar, 1.0,
+				&gr[face](0,0), &ri(iel,0));
+		
+		scalar phiik;
+		const scalar diff = uface - u(iel,ivar);
+		if(diff>0)
+			phiik = 1 < duimax/diff ? 1 : duimax/diff;
+		else if(diff < 0)
+			phiik = 1 < duimin/diff ? 1 : duimin/diff;
+		else
+			phiik = 1;
+
+		if(phiik < lim)
+			lim = phiik;
+	}
+	return lim;
+}
+
+inline void BarthJespersenLimiter::compute_limiters(const MVector& u, 
+		const amat::Array2d<a_real>& ug,
+		const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
+		amat::Array2d<a_real>& phi) const
+{
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			phi(iel,ivar) = computeLimiter(iel, ivar, u, ug, grads);
+}
+
+template <typename scalar, typename CellValues, typename Gradients>
+inline scalar VenkatakrishnanLimiter::computeLimiter(const a_int iel, const int ivar, const CellValues& u,
+		const amat::Array2d<scalar>& ug, const Gradients& grads) const
+{
+	const a_real eps2 = std::pow(K*clength[iel], 3);
+
+	scalar duimin=0, duimax=0;
+	for(int j = 0; j < m->gnfael(iel); j++)
+	{
+		const a_int jel = m->gesuel(iel,j);
+		const scalar dui = getCellValue(m,u,ug,jel,ivar)-u(iel,ivar);
+		if(dui > duimax) duimax = dui;
+		if(dui < duimin) duimin = dui;
+	}
+	
+	scalar lim = 1.0;
+	for(int j = 0; j < m->gnfael(iel); j++)
+	{
+		const a_int face = m->gelemface(iel,j);
+		
+		const scalar uface = linearExtrapolate(u(iel,ivar), getCellGradient(grads,iel), ivar, 1.0,
+				&gr[face](0,0), &ri(iel,0));
+		
+		const scalar dm = uface - u(iel,ivar);
+
+		// Venkatakrishnan modification
+		const scalar dp = dm < 0 ? duimin : duimax;
+		const scalar phiik = (dp*dp + 2*dp*dm + eps2)/(dp*dp + dp*dm + 2*dm*dm + eps2);
+
+		if(phiik < lim)
+			lim = phiik;
+	}
+	return lim;
+}
+
+inline void VenkatakrishnanLimiter::compute_limiters(const MVector& u, 
+		const amat::Array2d<a_real>& ug,
+		const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
+		amat::Array2d<a_real>& phi) const
+{
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			phi(iel,ivar) = computeLimiter(iel, ivar, u, ug, grads);
+}
+
 } // end namespace
 #endif
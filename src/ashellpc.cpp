@@ -0,0 +1,182 @@
+/** @file ashellpc.cpp
+ * @brief Implementation of native block preconditioners as PETSc shell preconditioners
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <ctime>
+#include <petsctime.h>
+#include "ashellpc.hpp"
+#include "afactory.hpp"
+
+namespace acfd {
+
+template <int bs>
+NativeShellPreconditioner<bs>::NativeShellPreconditioner(const UMesh2dh *const mesh,
+		const BlockSolverConfig& conf)
+	: factorwalltime{0}, applywalltime{0}, factorcputime{0}, applycputime{0},
+	  m{mesh}, config(conf), mat{nullptr}, prec{nullptr}
+{ }
+
+template <int bs>
+NativeShellPreconditioner<bs>::~NativeShellPreconditioner()
+{
+	delete prec;
+	delete mat;
+}
+
+template <int bs>
+StatusCode NativeShellPreconditioner<bs>::attach(KSP ksp)
+{
+	StatusCode ierr = 0;
+	PC pc;
+	ierr = KSPGetPC(ksp, &pc); CHKERRQ(ierr);
+	PetscBool isbjacobi, isasm, isshell, isksp;
+	ierr = PetscObjectTypeCompare((PetscObject)pc,PCBJACOBI,&isbjacobi); CHKERRQ(ierr);
+	ierr = PetscObjectTypeCompare((PetscObject)pc,PCASM,&isasm); CHKERRQ(ierr);
+	ierr = PetscObjectTypeCompare((PetscObject)pc,PCSHELL,&isshell); CHKERRQ(ierr);
+	ierr = PetscObjectTypeCompare((PetscObject)pc,PCKSP,&isksp); CHKERRQ(ierr);
+
+	if(isbjacobi || isasm)
+	{
+		PetscInt nlocalblocks, firstlocalblock;
+		ierr = KSPSetUp(ksp); CHKERRQ(ierr);
+		ierr = PCSetUp(pc); CHKERRQ(ierr);
+		KSP *subksp;
+		if(isbjacobi) {
+			ierr = PCBJacobiGetSubKSP(pc, &nlocalblocks, &firstlocalblock, &subksp); CHKERRQ(ierr);
+		}
+		else {
+			ierr = PCASMGetSubKSP(pc, &nlocalblocks, &firstlocalblock, &subksp); CHKERRQ(ierr);
+		}
+		if(nlocalblocks != 1)
+			SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONGSTATE,
+					"Only one subdomain per rank is supported.");
+		ierr = attach(subksp[0]); CHKERRQ(ierr);
+	}
+	else if(isksp) {
+		ierr = KSPSetUp(ksp); CHKERRQ(ierr);
+		ierr = PCSetUp(pc); CHKERRQ(ierr);
+		KSP subksp;
+		ierr = PCKSPGetKSP(pc, &subksp); CHKERRQ(ierr);
+		ierr = attach(subksp); CHKERRQ(ierr);
+	}
+	else if(isshell) {
+		ierr = setShell(pc); CHKERRQ(ierr);
+	}
+
+	return ierr;
+}
+
+template <int bs>
+StatusCode NativeShellPreconditioner<bs>::setShell(PC pc)
+{
+	StatusCode ierr = 0;
+	if(!prec) {
+		prec = create_blockpreconditioner<bs>(config.precond, m,
+				config.nbuildsweeps, config.napplysweeps, config.refreshtol,
+				config.lineanisotropy, config.singleprec);
+		if(!prec)
+			SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONG, "Unknown native preconditioner!");
+		mat = new BSRMatrix<bs>(m);
+	}
+
+	ierr = PCShellSetContext(pc, (void*)this); CHKERRQ(ierr);
+	ierr = PCShellSetSetUp(pc, &shell_setup); CHKERRQ(ierr);
+	ierr = PCShellSetApply(pc, &shell_apply); CHKERRQ(ierr);
+	ierr = PCShellSetName(pc, "FVENS native block preconditioner"); CHKERRQ(ierr);
+	std::cout << " NativeShellPreconditioner: Set up " << config.precond
+		<< " as a shell preconditioner." << std::endl;
+	return ierr;
+}
+
+template <int bs>
+PetscErrorCode NativeShellPreconditioner<bs>::shell_setup(PC pc)
+{
+	PetscErrorCode ierr = 0;
+	void *ctx;
+	ierr = PCShellGetContext(pc, &ctx); CHKERRQ(ierr);
+	NativeShellPreconditioner<bs> *const npc = reinterpret_cast<NativeShellPreconditioner<bs>*>(ctx);
+
+	PetscLogDouble initwtime, finwtime;
+	ierr = PetscTime(&initwtime); CHKERRQ(ierr);
+	const double initctime = (double)clock() / (double)CLOCKS_PER_SEC;
+
+	Mat P;
+	ierr = PCGetOperators(pc, NULL, &P); CHKERRQ(ierr);
+	ierr = npc->mat->copyFrom(P); CHKERRQ(ierr);
+	ierr = npc->prec->compute(*npc->mat); CHKERRQ(ierr);
+
+	ierr = PetscTime(&finwtime); CHKERRQ(ierr);
+	const double finctime = (double)clock() / (double)CLOCKS_PER_SEC;
+	npc->factorwalltime += finwtime - initwtime;
+	npc->factorcputime += finctime - initctime;
+	return ierr;
+}
+
+template <int bs>
+PetscErrorCode NativeShellPreconditioner<bs>::shell_apply(PC pc, Vec r, Vec z)
+{
+	PetscErrorCode ierr = 0;
+	void *ctx;
+	ierr = PCShellGetContext(pc, &ctx); CHKERRQ(ierr);
+	NativeShellPreconditioner<bs> *const npc = reinterpret_cast<NativeShellPreconditioner<bs>*>(ctx);
+
+	PetscLogDouble initwtime, finwtime;
+	ierr = PetscTime(&initwtime); CHKERRQ(ierr);
+	const double initctime = (double)clock() / (double)CLOCKS_PER_SEC;
+
+	const PetscScalar *rarr;
+	PetscScalar *zarr;
+	ierr = VecGetArrayRead(r, &rarr); CHKERRQ(ierr);
+	ierr = VecGetArray(z, &zarr); CHKERRQ(ierr);
+	npc->prec->apply(rarr, zarr);
+	ierr = VecRestoreArrayRead(r, &rarr); CHKERRQ(ierr);
+	ierr = VecRestoreArray(z, &zarr); CHKERRQ(ierr);
+
+	ierr = PetscTime(&finwtime); CHKERRQ(ierr);
+	const double finctime = (double)clock() / (double)CLOCKS_PER_SEC;
+	npc->applywalltime += finwtime - initwtime;
+	npc->applycputime += finctime - initctime;
+	return ierr;
+}
+
+template <int nvars>
+StatusCode setup_native_shellpc(KSP ksp, Vec u, const Spatial<nvars> *const startprob,
+		NativeShellPreconditioner<nvars>& npc)
+{
+	StatusCode ierr = 0;
+	Mat M, A;
+	ierr = KSPGetOperators(ksp, &A, &M); CHKERRQ(ierr);
+
+	// first assemble the matrix once for proper setup
+	ierr = startprob->compute_jacobian(u, M); CHKERRQ(ierr);
+	ierr = MatAssemblyBegin(M, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+	ierr = MatAssemblyEnd(M, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+
+	ierr = npc.attach(ksp); CHKERRQ(ierr);
+	return ierr;
+}
+
+template class NativeShellPreconditioner<NVARS>;
+template class NativeShellPreconditioner<1>;
+template StatusCode setup_native_shellpc(KSP ksp, Vec u, const Spatial<NVARS> *const startprob,
+		NativeShellPreconditioner<NVARS>& npc);
+template StatusCode setup_native_shellpc(KSP ksp, Vec u, const Spatial<1> *const startprob,
+		NativeShellPreconditioner<1>& npc);
+
+}
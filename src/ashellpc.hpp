@@ -0,0 +1,90 @@
+/** @file ashellpc.hpp
+ * @brief Use of the native block preconditioners through PETSc shell preconditioners
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASHELLPC_H
+#define ASHELLPC_H
+
+#include <petscksp.h>
+#include "akrylov.hpp"
+
+namespace acfd {
+
+/// A native block preconditioner which is used by PETSc solvers as a shell preconditioner (PCSHELL)
+/** The preconditioning matrix of the PETSc solver must have \ref JacobianBlockLocations.
+ * It is copied into a \ref BSRMatrix, and the preconditioner is computed from that, whenever
+ * PETSc sets up the shell preconditioner. The time taken by the preconditioner is accumulated;
+ * the timing data is analogous to that of the BLASTed library.
+ */
+template <int bs>
+class NativeShellPreconditioner
+{
+public:
+	/// Sets the mesh and the settings, but does not allocate anything
+	/** \param conf Settings; only the preconditioner type and the sweeps are used
+	 */
+	NativeShellPreconditioner(const UMesh2dh *const mesh, const BlockSolverConfig& conf);
+
+	~NativeShellPreconditioner();
+
+	/// Makes the shell preconditioners of a solver use this native preconditioner
+	/** The shell preconditioner may be that of the solver itself, or that of the only sub-domain
+	 * of a block Jacobi or additive Schwarz preconditioner, or that of the solver of a PCKSP
+	 * preconditioner. If the outer preconditioner needs to be set up for this, the preconditioning
+	 * matrix must be already assembled. Nothing is done if there is no shell preconditioner.
+	 * This object must outlive the solver.
+	 */
+	StatusCode attach(KSP ksp);
+
+	/// Number of bytes taken by the blocks stored by the native preconditioner, once it is set up
+	size_t storageBytes() const { return prec ? prec->storageBytes() : 0; }
+
+	double factorwalltime;          ///< Wall time taken to compute the preconditioner
+	double applywalltime;           ///< Wall time taken to apply the preconditioner
+	double factorcputime;           ///< CPU time taken to compute the preconditioner
+	double applycputime;            ///< CPU time taken to apply the preconditioner
+
+protected:
+	const UMesh2dh *const m;
+	const BlockSolverConfig config;
+	BSRMatrix<bs> *mat;             ///< Copy of the preconditioning matrix
+	BlockPreconditioner<bs> *prec;  ///< The native preconditioner
+
+	/// Sets the shell preconditioner of a solver to use the native preconditioner
+	StatusCode setShell(PC pc);
+
+	/// Set-up routine for the PETSc shell preconditioner
+	static PetscErrorCode shell_setup(PC pc);
+
+	/// Application routine for the PETSc shell preconditioner
+	static PetscErrorCode shell_apply(PC pc, Vec r, Vec z);
+};
+
+/// Sets up native shell preconditioners, in the way \ref setup_blasted sets up BLASTed ones
+/** \param ksp The top-level KSP
+ * \param u A solution vector used to assemble the Jacobian matrix once, needed for initialization
+ *   of some PETSc preconditioners - the actual values don't matter.
+ * \param startprob A spatial discretization context to compute the Jacobian with
+ * \param npc The native preconditioner to use in the shell preconditioners
+ */
+template <int nvars>
+StatusCode setup_native_shellpc(KSP ksp, Vec u, const Spatial<nvars> *const startprob,
+		NativeShellPreconditioner<nvars>& npc);
+
+}
+#endif
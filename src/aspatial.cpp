@@ -20,8 +20,12 @@
 
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <type_traits>
 #include "afactory.hpp"
 #include "aspatial.hpp"
+#include "alinalg.hpp"
+#include "ameshutils.hpp"
 
 namespace acfd {
 
@@ -86,6 +90,52 @@ Spatial<nvars>::~Spatial()
 	delete [] gr;
 }
 
+template<int nvars>
+StatusCode Spatial<nvars>::compute_residual_and_jacobian(const Vec u, Vec residual, 
+		const bool gettimesteps, std::vector<a_real>& dtm, Mat A) const
+{
+	StatusCode ierr = compute_residual(u, residual, gettimesteps, dtm); CHKERRQ(ierr);
+	ierr = compute_jacobian(u, A); CHKERRQ(ierr);
+	return ierr;
+}
+
+template<int nvars>
+StatusCode Spatial<nvars>::compute_agglomerated_residual(const AgglomeratedMesh& am,
+		const a_real *const u, a_real *const residual,
+		const bool gettimesteps, a_real *const dtm, a_real *const diag) const
+{
+	SETERRQ(PETSC_COMM_SELF, PETSC_ERR_SUP,
+			"This spatial discretization cannot be used on agglomerated meshes!");
+}
+
+template<int nvars>
+StatusCode Spatial<nvars>::compute_jacobian_vector_product(const Vec u, const Vec x, Vec jx) const
+{
+	SETERRQ(PETSC_COMM_SELF, PETSC_ERR_SUP,
+			"This spatial discretization cannot compute exact Jacobian-vector products!");
+}
+
+template<int nvars>
+StatusCode Spatial<nvars>::freeze_reconstruction(const Vec u, FrozenReconstruction **const fr) const
+{
+	SETERRQ(PETSC_COMM_SELF, PETSC_ERR_SUP,
+			"This spatial discretization cannot freeze its reconstruction!");
+}
+
+template<int nvars>
+StatusCode Spatial<nvars>::compute_frozen_residual(const Vec u, 
+		const FrozenReconstruction *const fr, Vec residual) const
+{
+	SETERRQ(PETSC_COMM_SELF, PETSC_ERR_SUP,
+			"This spatial discretization cannot freeze its reconstruction!");
+}
+
+template<int nvars>
+int Spatial<nvars>::jacobian_stencil_radius() const
+{
+	return 1;
+}
+
 template<int nvars>
 void Spatial<nvars>::compute_ghost_cell_coords_about_midpoint(amat::Array2d<a_real>& rchg)
 {
@@ -153,9 +203,10 @@ void Spatial<nvars>::compute_ghost_cell_coords_about_face(amat::Array2d<a_real>&
 }
 
 template <int nvars>
+template <typename scalar>
 void Spatial<nvars>::getFaceGradient_modifiedAverage(const a_int iface,
-		const a_real *const ucl, const a_real *const ucr,
-		const a_real gradl[NDIM][nvars], const a_real gradr[NDIM][nvars], a_real grad[NDIM][nvars])
+		const scalar *const ucl, const scalar *const ucr,
+		const scalar gradl[NDIM][nvars], const scalar gradr[NDIM][nvars], scalar grad[NDIM][nvars])
 	const
 {
 	a_real dr[NDIM], dist=0;
@@ -173,14 +224,14 @@ void Spatial<nvars>::getFaceGradient_modifiedAverage(const a_int iface,
 
 	for(int i = 0; i < nvars; i++) 
 	{
-		a_real davg[NDIM];
+		scalar davg[NDIM];
 		
 		for(int j = 0; j < NDIM; j++)
 			davg[j] = 0.5*(gradl[j][i] + gradr[j][i]);
 
-		const a_real corr = (ucr[i]-ucl[i])/dist;
+		const scalar corr = (ucr[i]-ucl[i])/dist;
 		
-		const a_real ddr = dimDotProduct(davg,dr);
+		const scalar ddr = dimDotProduct(davg,dr);
 
 		for(int j = 0; j < NDIM; j++)
 		{
@@ -242,7 +293,19 @@ FlowFV<secondOrderRequested,constVisc>::FlowFV(const UMesh2dh *const mesh,
 	gradcomp {create_const_gradientscheme<NVARS>(nconfig.gradientscheme, m, rc)},
 
 	// the last argument in the next line is the Venkatakrishnan parameter
-	lim {create_const_reconstruction(nconfig.reconstruction, m, rc, gr, 6.0)}
+	lim {create_const_reconstruction(nconfig.reconstruction, m, rc, gr, 6.0)},
+
+	usecellgather {nconfig.residual_engine == "CELLGATHER"},
+
+	fusedreconstruction {secondOrderRequested && lim->has_cell_limiters()},
+
+	jacobianfluxsameasresidual {nconfig.conv_numflux == nconfig.conv_numflux_jac},
+
+	exactjacobian {nconfig.jacobian_assembly == "EXACT"},
+
+	differencejacobian {nconfig.jacobian_assembly == "DIFFERENCE"},
+
+	colouredjacobian {exactjacobian || differencejacobian}
 
 {
 	std::cout << " FlowFV: Boundary markers:\n";
@@ -258,6 +321,24 @@ FlowFV<secondOrderRequested,constVisc>::FlowFV(const UMesh2dh *const mesh,
 		<< pconfig.adiabaticwall_vel << '\n';
 	if(constVisc)
 		std::cout << " FLowFV: Using constant viscosity.\n";
+	if(usecellgather)
+		std::cout << " FlowFV: Assembling the residual by gathering face fluxes into cells.\n";
+	if(fusedreconstruction)
+		std::cout << " FlowFV: Reconstructing face values during flux computation.\n";
+	if(exactjacobian)
+		std::cout << " FlowFV: Assembling the exact Jacobian.\n";
+	if(differencejacobian)
+		std::cout << " FlowFV: Assembling the Jacobian by finite differences.\n";
+	if(colouredjacobian) {
+		distanceColouring(*m, 2*jacobian_stencil_radius(), jaccolourptr, jaccolourcells);
+		cellNeighbourhoods(*m, jacobian_stencil_radius(), jacnbhdptr, jacnbhd);
+		std::cout << "  " << jaccolourptr.size()-1 << " colours of cells.\n";
+	}
+
+	// one workspace is enough for the usual case of a single caller
+	workspaces.push_back(new ResidualWorkspace(m, secondOrderRequested, fusedreconstruction));
+	freeworkspaces.reserve(1);
+	freeworkspaces.push_back(workspaces[0]);
 }
 
 template<bool secondOrderRequested, bool constVisc>
@@ -267,6 +348,88 @@ FlowFV<secondOrderRequested,constVisc>::~FlowFV()
 	delete inviflux;
 	delete jflux;
 	delete lim;
+	for(ResidualWorkspace *ws : workspaces)
+		delete ws;
+}
+
+template<bool secondOrderRequested, bool constVisc>
+FlowFV<secondOrderRequested,constVisc>::ResidualWorkspace::ResidualWorkspace(
+		const UMesh2dh *const mesh, const bool secondorder, const bool fused)
+	: integ(mesh->gnelem(), 1), ug(mesh->gnbface(), NVARS), 
+	uleft(fused || !secondorder ? mesh->gnbface() : mesh->gnaface(), NVARS), 
+	uright(fused || !secondorder ? mesh->gnbface() : mesh->gnaface(), NVARS), limiters(&phi),
+	up(mesh->gnelem(), NVARS), cellderived(mesh->gnelem(), NCELLDERIVED), dual(NULL)
+{
+	if(secondorder)
+		grads.resize(mesh->gnelem());
+	if(fused)
+		phi.resize(mesh->gnelem(), NVARS);
+}
+
+template<bool secondOrderRequested, bool constVisc>
+FlowFV<secondOrderRequested,constVisc>::ResidualWorkspace::~ResidualWorkspace()
+{
+	delete dual;
+}
+
+template<bool secondOrderRequested, bool constVisc>
+FlowFV<secondOrderRequested,constVisc>::FrozenFlowReconstruction::FrozenFlowReconstruction(
+		const UMesh2dh *const mesh, const bool secondorder)
+	: ucell(mesh->gnbface(), NVARS), uleft(mesh->gnbface(), NVARS), 
+	uright(mesh->gnbface(), NVARS), duright(mesh->gnbface(), NVARS*NVARS)
+{
+	if(secondorder) {
+		phi.resize(mesh->gnelem(), NVARS);
+		ug.resize(mesh->gnbface(), NVARS);
+		dug.resize(mesh->gnbface(), NVARS*NVARS);
+	}
+}
+
+template<bool secondOrderRequested, bool constVisc>
+FlowFV<secondOrderRequested,constVisc>::DualStates::DualStates(const UMesh2dh *const mesh,
+		const bool secondorder)
+	: up(mesh->gnelem(), NVARS), uleft(mesh->gnbface(), NVARS), uright(mesh->gnbface(), NVARS)
+{
+	if(secondorder) {
+		ug.resize(mesh->gnbface(), NVARS);
+		grads.resize(mesh->gnelem(), NDIM*NVARS);
+		phi.resize(mesh->gnelem(), NVARS);
+		upval.resize(mesh->gnelem(), NVARS);
+		upder.resize(mesh->gnelem(), NVARS);
+		ugval.resize(mesh->gnbface(), NVARS);
+		ugder.resize(mesh->gnbface(), NVARS);
+		gradval.resize(mesh->gnelem());
+		gradder.resize(mesh->gnelem());
+	}
+}
+
+template<bool secondOrderRequested, bool constVisc>
+typename FlowFV<secondOrderRequested,constVisc>::ResidualWorkspace* 
+FlowFV<secondOrderRequested,constVisc>::acquireWorkspace() const
+{
+	ResidualWorkspace *ws = nullptr;
+#pragma omp critical (flowfv_workspaces)
+	{
+		if(freeworkspaces.empty()) {
+			// Another caller is computing a residual at the same time.
+			// Reserve space so that releasing workspaces never allocates.
+			ws = new ResidualWorkspace(m, secondOrderRequested, fusedreconstruction);
+			workspaces.push_back(ws);
+			freeworkspaces.reserve(workspaces.size());
+		}
+		else {
+			ws = freeworkspaces.back();
+			freeworkspaces.pop_back();
+		}
+	}
+	return ws;
+}
+
+template<bool secondOrderRequested, bool constVisc>
+void FlowFV<secondOrderRequested,constVisc>::releaseWorkspace(ResidualWorkspace *const ws) const
+{
+#pragma omp critical (flowfv_workspaces)
+	freeworkspaces.push_back(ws);
 }
 
 template<bool secondOrderRequested, bool constVisc>
@@ -294,9 +457,10 @@ StatusCode FlowFV<secondOrderRequested,constVisc>::initializeUnknowns(Vec u) con
 }
 
 template<bool secondOrderRequested, bool constVisc>
+template <typename scalar>
 void FlowFV<secondOrderRequested,constVisc>::compute_boundary_states(
-		const amat::Array2d<a_real>& ins, 
-		       amat::Array2d<a_real>& bs ) const
+		const amat::Array2d<scalar>& ins, 
+		       amat::Array2d<scalar>& bs ) const
 {
 #pragma omp parallel for default(shared)
 	for(a_int ied = 0; ied < m->gnbface(); ied++)
@@ -315,12 +479,73 @@ template<bool secondOrderRequested, bool constVisc>
 void FlowFV<secondOrderRequested,constVisc>::compute_boundary_state(const int ied, 
 		const a_real *const ins, 
 		a_real *const gs        ) const
+{
+	evaluateBoundaryState(ied, ins, gs);
+}
+
+template<bool secondOrderRequested, bool constVisc>
+void FlowFV<secondOrderRequested,constVisc>::compute_boundary_state(const int ied, 
+		const Dual *const ins, 
+		Dual *const gs        ) const
+{
+	evaluateBoundaryState(ied, ins, gs);
+}
+
+template<bool secondOrderRequested, bool constVisc>
+void FlowFV<secondOrderRequested,constVisc>::compute_boundary_states_and_jacobians(
+		const amat::Array2d<a_real>& instates, 
+		amat::Array2d<a_real>& bounstates, amat::Array2d<a_real>& dbounstates) const
+{
+	// one direction at a time, each a column of the Jacobian
+#pragma omp parallel for default(shared)
+	for(a_int ied = 0; ied < m->gnbface(); ied++)
+	{
+		for(int j = 0; j < NVARS; j++)
+		{
+			Dual ins[NVARS], gs[NVARS];
+			for(int i = 0; i < NVARS; i++)
+				ins[i] = Dual(instates(ied,i), i == j ? 1.0 : 0.0);
+			compute_boundary_state(ied, ins, gs);
+
+			for(int i = 0; i < NVARS; i++) {
+				bounstates(ied,i) = gs[i].val;
+				dbounstates(ied,i*NVARS+j) = gs[i].der;
+			}
+		}
+	}
+}
+
+template<bool secondOrderRequested, bool constVisc>
+template <typename scalar>
+void FlowFV<secondOrderRequested,constVisc>::compute_linearised_boundary_states(
+		const amat::Array2d<a_real>& instates0,
+		const amat::Array2d<a_real>& bounstates0, const amat::Array2d<a_real>& dbounstates0,
+		const amat::Array2d<scalar>& instates, amat::Array2d<scalar>& bounstates) const
+{
+#pragma omp parallel for default(shared)
+	for(a_int ied = 0; ied < m->gnbface(); ied++)
+	{
+		for(int i = 0; i < NVARS; i++)
+		{
+			bounstates(ied,i) = bounstates0(ied,i);
+			for(int j = 0; j < NVARS; j++)
+				bounstates(ied,i) += dbounstates0(ied,i*NVARS+j)
+					*(instates(ied,j)-instates0(ied,j));
+		}
+	}
+}
+
+template<bool secondOrderRequested, bool constVisc>
+template <typename scalar>
+void FlowFV<secondOrderRequested,constVisc>::evaluateBoundaryState(const int ied, 
+		const scalar *const ins, 
+		scalar *const gs        ) const
 {
 	const a_real nx = m->gfacemetric(ied,0);
 	const a_real ny = m->gfacemetric(ied,1);
 	const a_real n[NDIM] = {m->gfacemetric(ied,0), m->gfacemetric(ied,1)};
 
-	const a_real vni = dimDotProduct(&ins[1],n)/ins[0];
+	const scalar vni = dimDotProduct(&ins[1],n)/ins[0];
 
 	if(m->gintfacbtags(ied,0) == pconfig.slipwall_id)
 	{
@@ -360,9 +585,9 @@ void FlowFV<secondOrderRequested,constVisc>::compute_boundary_state(const int ie
 	 */
 	else if(m->gintfacbtags(ied,0) == pconfig.inflowoutflow_id)
 	{
-		const a_real ci = physics.getSoundSpeedFromConserved(ins);
-		const a_real Mni = vni/ci;
-		const a_real pinf = physics.getFreestreamPressure();
+		const scalar ci = physics.getSoundSpeedFromConserved(ins);
+		const scalar Mni = vni/ci;
+		const scalar pinf = physics.getFreestreamPressure();
 
 		/* At inflow, ghost cell state is determined by farfield state; the Riemann solver
 		 * takes care of signal propagation at the boundary.
@@ -398,7 +623,7 @@ void FlowFV<secondOrderRequested,constVisc>::compute_boundary_state(const int ie
 	{
 		if(m->gintfacbtags(ied,0) == pconfig.adiabaticwall_id)
 		{
-			const a_real tangMomentum = pconfig.adiabaticwall_vel * ins[0];
+			const scalar tangMomentum = pconfig.adiabaticwall_vel * ins[0];
 			gs[0] = ins[0];
 			gs[1] =  2.0*tangMomentum*ny - ins[1];
 			gs[2] = -2.0*tangMomentum*nx - ins[2];
@@ -411,32 +636,32 @@ void FlowFV<secondOrderRequested,constVisc>::compute_boundary_state(const int ie
 		else if(m->gintfacbtags(ied,0) == pconfig.isothermalwall_id)
 		{
 			// pressure in the interior cell
-			const a_real p = physics.getPressureFromConserved(ins);
+			const scalar p = physics.getPressureFromConserved(ins);
 			
 			// temperature in the ghost cell
-			const a_real gtemp = 2.0*pconfig.isothermalwall_temp - physics.getTemperature(ins[0],p);
+			const scalar gtemp = 2.0*pconfig.isothermalwall_temp - physics.getTemperature(ins[0],p);
 
 			//gs[0] = physics.getDensityFromPressureTemperature(p, gtemp);
 			gs[0] = ins[0];
 			gs[1] = gs[0]*( 2.0*pconfig.isothermalwall_vel*ny - ins[1]/ins[0]);
 			gs[2] = gs[0]*(-2.0*pconfig.isothermalwall_vel*nx - ins[2]/ins[0]);
-			const a_real vmag2 = dimDotProduct(&gs[1],&gs[1])/(gs[0]*gs[0]);
+			const scalar vmag2 = dimDotProduct(&gs[1],&gs[1])/(gs[0]*gs[0]);
 			gs[3] = physics.getEnergyFromTemperature(gtemp, gs[0], vmag2);
 		}
 
 		else if(m->gintfacbtags(ied,0) == pconfig.isothermalbaricwall_id)
 		{
 			// pressure in the ghost cell
-			const a_real gp = physics.getFreestreamPressure();
+			const scalar gp = physics.getFreestreamPressure();
 			
 			// temperature in the ghost cell
-			const a_real gtemp= 2.0*pconfig.isothermalbaricwall_temp 
+			const scalar gtemp= 2.0*pconfig.isothermalbaricwall_temp 
 				- physics.getTemperature(ins[0],gp);
 
 			gs[0] = physics.getDensityFromPressureTemperature(gp, gtemp);
 			gs[1] = gs[0]*( 2.0*pconfig.isothermalbaricwall_vel*ny - ins[1]/ins[0]);
 			gs[2] = gs[0]*(-2.0*pconfig.isothermalbaricwall_vel*nx - ins[2]/ins[0]);
-			const a_real vmag2 = dimDotProduct(&gs[1],&gs[1])/(gs[0]*gs[0]);
+			const scalar vmag2 = dimDotProduct(&gs[1],&gs[1])/(gs[0]*gs[0]);
 			gs[3] = physics.getEnergyFromTemperature(gtemp, gs[0], vmag2);
 		}
 	}
@@ -626,16 +851,15 @@ void FlowFV<secondOrderRequested,constVisc>::compute_boundary_Jacobian(const int
 
 template<bool secondOrderRequested, bool constVisc>
 void FlowFV<secondOrderRequested,constVisc>::computeViscousFlux(const a_int iface, 
-		const a_real *const ucell_l, const a_real *const ucell_r, const amat::Array2d<a_real>& ug,
-		const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
-		const amat::Array2d<a_real>& ul, const amat::Array2d<a_real>& ur,
+		const ResidualWorkspace& ws, const a_real *const ul, const a_real *const ur,
 		a_real *const __restrict vflux) const
 {
 	const a_int lelem = m->gintfac(iface,0);
 	const a_int relem = m->gintfac(iface,1);
 
-	/* Get proper state variables and grads at cell centres
-	 * we start with all conserved variables and either conservative or primitive gradients
+	/* Get primitive-2 variables and their gradients at cell centres.
+	 * Primitive variables and temperatures of real cells are available in the workspace;
+	 * gradients, if any, are those of primitive variables.
 	 */
 
 	// cell-centred left and right states
@@ -645,7 +869,7 @@ void FlowFV<secondOrderRequested,constVisc>::computeViscousFlux(const a_int ifac
 	
 	for(int i = 0; i < NVARS; i++) 
 	{
-		ucl[i] = ucell_l[i];
+		ucl[i] = ws.up(lelem,i);
 		
 		for(int j = 0; j < NDIM; j++) {
 			gradl[j][i] = 0; 
@@ -660,22 +884,16 @@ void FlowFV<secondOrderRequested,constVisc>::computeViscousFlux(const a_int ifac
 		if(secondOrderRequested)
 		{
 			for(int i = 0; i < NVARS; i++) {
-				ucr[i] = ug(iface,i);
+				ucr[i] = ws.ug(iface,i);
 			}
 	
 			// note: these copies are necessary because we need row-major raw C arrays for
 			// the physics operations later in the function
 			for(int j = 0; j < NDIM; j++)
 				for(int i = 0; i < NVARS; i++) {
-					gradl[j][i] = grads[lelem](j,i);
+					gradl[j][i] = ws.grads[lelem](j,i);
 				}
 
-			// If gradients are those of primitive variables,
-			// convert cell-centred variables to primitive; we need primitive variables
-			// to compute temperature gradient from primitive gradients.
-			// ug was already primitive, so don't convert ucr.
-			physics.getPrimitiveFromConserved(ucl, ucl);
-			
 			// get one-sided temperature gradients from one-sided primitive gradients
 			// and discard grad p in favor of grad T.
 			for(int j = 0; j < NDIM; j++)
@@ -694,26 +912,26 @@ void FlowFV<secondOrderRequested,constVisc>::computeViscousFlux(const a_int ifac
 		{
 			// if second order was not requested, boundary values are stored in ur, not ug
 			for(int i = 0; i < NVARS; i++) {
-				ucr[i] = ur(iface,i);
+				ucr[i] = ur[i];
 			}
 		}
+
+		// the ghost cell's temperature is not cached
+		ucr[NVARS-1] = physics.getTemperature(ucr[0], ucr[NVARS-1]);
 	}
 	else {
 		for(int i = 0; i < NVARS; i++) {
-			ucr[i] = ucell_r[i];
+			ucr[i] = ws.up(relem,i);
 		}
 
 		if(secondOrderRequested)
 		{
 			for(int j = 0; j < NDIM; j++)
 				for(int i = 0; i < NVARS; i++) {
-					gradl[j][i] = grads[lelem](j,i);
-					gradr[j][i] = grads[relem](j,i);
+					gradl[j][i] = ws.grads[lelem](j,i);
+					gradr[j][i] = ws.grads[relem](j,i);
 				}
 
-			physics.getPrimitiveFromConserved(ucl, ucl);
-			physics.getPrimitiveFromConserved(ucr, ucr);
-			
 			/* get one-sided temperature gradients from one-sided primitive gradients
 			 * and discard grad p in favor of grad T.
 			 */
@@ -724,42 +942,53 @@ void FlowFV<secondOrderRequested,constVisc>::computeViscousFlux(const a_int ifac
 							ucr[NVARS-1], gradr[j][NVARS-1]);
 			}
 		}
-	}
 
-	// convert cell-centred variables to primitive-2
-	if(secondOrderRequested)
-	{
-		ucl[NVARS-1] = physics.getTemperature(ucl[0], ucl[NVARS-1]);
-		ucr[NVARS-1] = physics.getTemperature(ucr[0], ucr[NVARS-1]);
+		ucr[NVARS-1] = ws.cellderived(relem,CELL_TEMPERATURE);
 	}
+
+	// replace pressure by temperature to get primitive-2 variables
+	ucl[NVARS-1] = ws.cellderived(lelem,CELL_TEMPERATURE);
+
+	// Non-dimensional dynamic viscosity divided by free-stream Reynolds number
+	// For the first-order scheme, face states are cell-centred states, whose viscosities 
+	// are cached.
+	a_real muRe;
+	if(constVisc)
+		muRe = physics.getConstantViscosityCoeff();
+	else if(secondOrderRequested)
+		muRe = 0.5*( physics.getViscosityCoeffFromTemperature(physics.getTemperatureFromPrimitive(ul))
+			+ physics.getViscosityCoeffFromTemperature(physics.getTemperatureFromPrimitive(ur)) );
 	else
-	{
-		physics.getPrimitive2FromConserved(ucl, ucl);
-		physics.getPrimitive2FromConserved(ucr, ucr);
-	}
+		muRe = 0.5*( ws.cellderived(lelem,CELL_VISCOSITY)
+			+ (iface < m->gnbface() ? physics.getViscosityCoeffFromTemperature(ucr[NVARS-1])
+			                        : ws.cellderived(relem,CELL_VISCOSITY)) );
+
+	computeViscousFlux(iface, ucl, ucr, gradl, gradr, muRe, ul, ur, vflux);
+}
 
+template<bool secondOrderRequested, bool constVisc>
+template <typename scalar>
+void FlowFV<secondOrderRequested,constVisc>::computeViscousFlux(const a_int iface, 
+		const scalar *const ucl, const scalar *const ucr,
+		const scalar gradl[NDIM][NVARS], const scalar gradr[NDIM][NVARS], const scalar muRe,
+		const scalar *const ul, const scalar *const ur,
+		scalar *const __restrict vflux) const
+{
 	/* Compute modified averages of primitive-2 variables and their gradients.
 	 * This is the only finite-volume part of this function, rest is physics and chain rule.
 	 */
 	
-	a_real grad[NDIM][NVARS];
+	scalar grad[NDIM][NVARS];
 	getFaceGradient_modifiedAverage(iface, ucl, ucr, gradl, gradr, grad);
 
 	/* Finally, compute viscous fluxes from primitive-2 cell-centred variables, 
-	 * primitive-2 face gradients and conserved face variables.
+	 * primitive-2 face gradients and primitive face variables.
 	 */
 	
-	// Non-dimensional dynamic viscosity divided by free-stream Reynolds number
-	const a_real muRe = constVisc ? 
-			physics.getConstantViscosityCoeff() 
-		:
-			0.5*( physics.getViscosityCoeffFromConserved(&ul(iface,0))
-			+ physics.getViscosityCoeffFromConserved(&ur(iface,0)) );
-	
 	// Non-dimensional thermal conductivity
-	const a_real kdiff = physics.getThermalConductivityFromViscosity(muRe); 
+	const scalar kdiff = physics.getThermalConductivityFromViscosity(muRe); 
 
-	a_real stress[NDIM][NDIM];
+	scalar stress[NDIM][NDIM];
 	for(int i = 0; i < NDIM; i++)
 		for(int j = 0; j < NDIM; j++)
 			stress[i][j] = 0;
@@ -776,14 +1005,14 @@ void FlowFV<secondOrderRequested,constVisc>::computeViscousFlux(const a_int ifac
 	}
 
 	// for the energy dissipation, compute avg velocities first
-	a_real vavg[NDIM];
+	scalar vavg[NDIM];
 	for(int j = 0; j < NDIM; j++)
-		vavg[j] = 0.5*( ul(iface,j+1)/ul(iface,0) + ur(iface,j+1)/ur(iface,0) );
+		vavg[j] = 0.5*( ul[j+1] + ur[j+1] );
 
 	vflux[NVARS-1] = 0;
 	for(int i = 0; i < NDIM; i++)
 	{
-		a_real comp = 0;
+		scalar comp = 0;
 		
 		for(int j = 0; j < NDIM; j++)
 			comp += stress[i][j]*vavg[j];       // dissipation by momentum flux (friction etc)
@@ -984,229 +1213,1049 @@ void FlowFV<secondOrder,constVisc>::computeViscousFluxApproximateJacobian(const
 }
 
 template<bool secondOrderRequested, bool constVisc>
-StatusCode FlowFV<secondOrderRequested,constVisc>::compute_residual(const Vec uvec, 
-		Vec __restrict rvec, 
-		const bool gettimesteps, std::vector<a_real>& dtm) const
+template<typename Flux>
+inline void FlowFV<secondOrderRequested,constVisc>::computeBoundaryInviscidFlux(const a_int ied,
+		const ResidualWorkspace& ws, a_real *const flux) const
 {
-	StatusCode ierr = 0;
-	amat::Array2d<a_real> integ, ug, uleft, uright;	
-	integ.resize(m->gnelem(), 1);
-	ug.resize(m->gnbface(),NVARS);
-	uleft.resize(m->gnaface(), NVARS);
-	uright.resize(m->gnaface(), NVARS);
-	std::vector<FArray<NDIM,NVARS>, aligned_allocator<FArray<NDIM,NVARS>> > grads;
+	const a_real n[NDIM] = {m->gfacemetric(ied,0), m->gfacemetric(ied,1)};
+	static_cast<const Flux*>(inviflux)->get_flux(&ws.uleft(ied,0), &ws.uright(ied,0), n, flux);
+}
 
-	PetscInt locnelem; const PetscScalar *uarr; PetscScalar *rarr;
-	ierr = VecGetLocalSize(uvec, &locnelem); CHKERRQ(ierr);
-	assert(locnelem % NVARS == 0);
-	locnelem /= NVARS;
-	assert(locnelem == m->gnelem());
-	//ierr = VecGetLocalSize(dtmvec, &dtsz); CHKERRQ(ierr);
-	//assert(locnelem == dtsz);
+template<bool secondOrderRequested, bool constVisc>
+template<typename Flux>
+inline void FlowFV<secondOrderRequested,constVisc>::computeInviscidFluxBatch(
+		const a_int nfaces, const a_int *const faces, const ResidualWorkspace& ws,
+		const a_real (*const ul)[NVARS], const a_real (*const ur)[NVARS],
+		a_real (*const fluxes)[NVARS]) const
+{
+	a_real ulb[NVARS*FLUX_BATCH_SIZE], urb[NVARS*FLUX_BATCH_SIZE], nb[NDIM*FLUX_BATCH_SIZE],
+	       fluxb[NVARS*FLUX_BATCH_SIZE];
 
-	ierr = VecGetArrayRead(uvec, &uarr); CHKERRQ(ierr);
-	Eigen::Map<const MVector> u(uarr, locnelem, NVARS);
-	ierr = VecGetArray(rvec, &rarr); CHKERRQ(ierr);
-	Eigen::Map<MVector> residual(rarr, locnelem, NVARS);
-	//ierr = VecGetArray(dtmvec, &dtm); CHKERRQ(ierr);
+	// interior faces of the batch, packed together
+	a_int ibatch[FLUX_BATCH_SIZE];
+	a_int nint = 0;
 
-#pragma omp parallel default(shared)
+	for(a_int i = 0; i < nfaces; i++)
 	{
-#pragma omp for simd
-		for(a_int iel = 0; iel < m->gnelem(); iel++)
-		{
-			integ(iel) = 0.0;
+		if(faces[i] < m->gnbface()) {
+			computeBoundaryInviscidFlux<Flux>(faces[i], ws, fluxes[i]);
+			continue;
 		}
 
-		// first, set cell-centered values of boundary cells as left-side values of boundary faces
-#pragma omp for
-		for(a_int ied = 0; ied < m->gnbface(); ied++)
-		{
-			a_int ielem = m->gintfac(ied,0);
-			for(int ivar = 0; ivar < NVARS; ivar++)
-				uleft(ied,ivar) = u(ielem,ivar);
+		for(int ivar = 0; ivar < NVARS; ivar++) {
+			ulb[ivar*FLUX_BATCH_SIZE+nint] = ul[i][ivar];
+			urb[ivar*FLUX_BATCH_SIZE+nint] = ur[i][ivar];
 		}
+		for(int idim = 0; idim < NDIM; idim++)
+			nb[idim*FLUX_BATCH_SIZE+nint] = m->gfacemetric(faces[i],idim);
+		ibatch[nint++] = i;
 	}
 
-	if(secondOrderRequested)
-	{
-		// for storing cell-centred gradients at interior cells and ghost cells
-		/*dudx.resize(m->gnelem()+m->gnbface(), NVARS);
-		dudy.resize(m->gnelem()+m->gnbface(), NVARS);*/
-		grads.resize(m->gnelem());
+	if(nint == 0)
+		return;
 
-		// get cell average values at ghost cells using BCs
-		compute_boundary_states(uleft, ug);
+	static_cast<const Flux*>(inviflux)->get_flux_batch_primitive(nint, ulb, urb, nb, fluxb);
 
-		MVector up(m->gnelem(), NVARS);
+	for(a_int j = 0; j < nint; j++)
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			fluxes[ibatch[j]][ivar] = fluxb[ivar*FLUX_BATCH_SIZE+j];
+}
 
-		// convert everything to primitive variables
-#pragma omp parallel default(shared)
-		{
-#pragma omp for
-			for(a_int iface = 0; iface < m->gnbface(); iface++)
-			{
-				physics.getPrimitiveFromConserved(&ug(iface,0), &ug(iface,0));
-			}
+template<bool secondOrderRequested, bool constVisc>
+inline void FlowFV<secondOrderRequested,constVisc>::integrateFaceFlux(const a_int ied, 
+		const ResidualWorkspace& ws, const a_real *const ul, const a_real *const ur,
+		a_real *const fluxes) const
+{
+	const a_real len = m->gfacemetric(ied,2);
 
-#pragma omp for
-			for(a_int iel = 0; iel < m->gnelem(); iel++)
-				physics.getPrimitiveFromConserved(&uarr[iel*NVARS], &up(iel,0));
+	for(int ivar = 0; ivar < NVARS; ivar++)
+		fluxes[ivar] *= len;
+
+	if(pconfig.viscous_sim) 
+	{
+		// get viscous fluxes
+		a_real vflux[NVARS];
+		computeViscousFlux(ied, ws, ul, ur, vflux);
+
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			fluxes[ivar] += vflux[ivar]*len;
+	}
+}
+
+template<bool secondOrderRequested, bool constVisc>
+inline void FlowFV<secondOrderRequested,constVisc>::getFaceStates(const a_int ied, 
+		const ResidualWorkspace& ws, a_real *const ul, a_real *const ur) const
+{
+	const a_int lelem = m->gintfac(ied,0);
+	const a_int relem = m->gintfac(ied,1);
+
+	if(!secondOrderRequested && ied >= m->gnbface())
+	{
+		for(int ivar = 0; ivar < NVARS; ivar++) {
+			ul[ivar] = ws.up(lelem,ivar);
+			ur[ivar] = ws.up(relem,ivar);
 		}
+		return;
+	}
 
-		// reconstruct
-		gradcomp->compute_gradients(up, ug, grads);
-		lim->compute_face_values(up, ug, grads, uleft, uright);
+	if(!fusedreconstruction || ied < m->gnbface())
+	{
+		for(int ivar = 0; ivar < NVARS; ivar++) {
+			ul[ivar] = ws.uleft(ied,ivar);
+			ur[ivar] = ws.uright(ied,ivar);
+		}
 
-		// Convert face values back to conserved variables - gradients stay primitive.
-#pragma omp parallel default(shared)
-		{
-#pragma omp for
-			for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
-			{
-				physics.getConservedFromPrimitive(&uleft(iface,0), &uleft(iface,0));
-				physics.getConservedFromPrimitive(&uright(iface,0), &uright(iface,0));
-			}
-#pragma omp for
-			for(a_int iface = 0; iface < m->gnbface(); iface++) 
-			{
-				physics.getConservedFromPrimitive(&uleft(iface,0), &uleft(iface,0));
-			}
+		// boundary conditions work with conserved variables
+		if(ied < m->gnbface()) {
+			physics.getPrimitiveFromConserved(ul, ul);
+			physics.getPrimitiveFromConserved(ur, ur);
 		}
+		return;
 	}
-	else
+	const a_real *const gp = &gr[ied](0,0);
+
+	// linear extrapolation of primitive variables, as in SolutionReconstruction
+	const amat::Array2d<a_real>& phi = *ws.limiters;
+	for(int ivar = 0; ivar < NVARS; ivar++)
 	{
-		// if order is 1, set the face data same as cell-centred data for all faces
-		
-		// set both left and right states for all interior faces
-#pragma omp parallel for default(shared)
-		for(a_int ied = m->gnbface(); ied < m->gnaface(); ied++)
-		{
-			a_int ielem = m->gintfac(ied,0);
-			a_int jelem = m->gintfac(ied,1);
-			for(int ivar = 0; ivar < NVARS; ivar++)
-			{
-				uleft(ied,ivar) = u(ielem,ivar);
-				uright(ied,ivar) = u(jelem,ivar);
-			}
+		ul[ivar] = ws.up(lelem,ivar);
+		ur[ivar] = ws.up(relem,ivar);
+		for(int idim = 0; idim < NDIM; idim++) {
+			ul[ivar] += phi(lelem,ivar)*ws.grads[lelem](idim,ivar)*(gp[idim]-rc(lelem,idim));
+			ur[ivar] += phi(relem,ivar)*ws.grads[relem](idim,ivar)*(gp[idim]-rc(relem,idim));
 		}
 	}
+}
 
-	// set right (ghost) state for boundary faces
-	compute_boundary_states(uleft,uright);
+template<bool secondOrderRequested, bool constVisc>
+a_real FlowFV<secondOrderRequested,constVisc>::computeFaceSpectralRadius(const a_int ied,
+		const ResidualWorkspace& ws, const a_real *const uface, const a_int ielem) const
+{
+	const a_real len = m->gfacemetric(ied,2);
+	const a_real c = secondOrderRequested ? physics.getSoundSpeed(uface[0], uface[NVARS-1])
+		: ws.cellderived(ielem,CELL_SOUNDSPEED);
+	const a_real vn = uface[1]*m->gfacemetric(ied,0) + uface[2]*m->gfacemetric(ied,1);
 
-	/** Compute fluxes.
-	 * The integral of the maximum magnitude of eigenvalue over each face is also computed:
-	 * \f[
-	 * \int_{f_i} (|v_n| + c) \mathrm{d}l
-	 * \f]
-	 * so that time steps can be calculated for explicit time stepping.
+	a_real specrad = (fabs(vn)+c)*len;
+
+	if(pconfig.viscous_sim) 
+	{
+		const a_real mu = constVisc ? physics.getConstantViscosityCoeff()
+			: secondOrderRequested ?
+				physics.getViscosityCoeffFromTemperature(physics.getTemperatureFromPrimitive(uface))
+			: ws.cellderived(ielem,CELL_VISCOSITY);
+		const a_real co = std::max(4.0/(3*uface[0]), physics.g/uface[0]);
+		specrad += co*mu/physics.Pr * len*len/m->garea(ielem);
+	}
+
+	return specrad;
+}
+
+template<bool secondOrderRequested, bool constVisc>
+template<typename Flux>
+void FlowFV<secondOrderRequested,constVisc>::assembleResidual_faceColoured(
+		ResidualWorkspace& ws,
+		const bool gettimesteps, Eigen::Map<MVector>& residual,
+		const JacobianAssembly *const jac) const
+{
+	/* Faces are processed one colour at a time, so that no two threads write to the same cell.
+	 * Within a colour, inviscid fluxes are computed in batches of faces.
+	 * When the first-order flux is computed at the same states as its Jacobian, interior faces
+	 * get both from one call instead.
 	 */
+	const bool fluxwithjacobian = jac && !secondOrderRequested && jacobianfluxsameasresidual;
+	// then the Jacobian flux is of the same type as the residual flux
+	assert(!fluxwithjacobian || dynamic_cast<const Flux*>(jflux));
 
 #pragma omp parallel default(shared)
 	{
-#pragma omp for
-		for(a_int ied = 0; ied < m->gnaface(); ied++)
+		for(int icolour = 0; icolour < m->gnfacecolours(); icolour++)
 		{
-			a_real n[NDIM];
-			n[0] = m->gfacemetric(ied,0);
-			n[1] = m->gfacemetric(ied,1);
-			a_real len = m->gfacemetric(ied,2);
-			const int lelem = m->gintfac(ied,0);
-			const int relem = m->gintfac(ied,1);
-			a_real fluxes[NVARS];
-
-			inviflux->get_flux(&uleft(ied,0), &uright(ied,0), n, fluxes);
-
-			// integrate over the face
-			for(int ivar = 0; ivar < NVARS; ivar++)
-					fluxes[ivar] *= len;
+			const a_int colstart = m->gfacecolour_p(icolour);
+			const a_int colend = m->gfacecolour_p(icolour+1);
+			const a_int nbatches = (colend-colstart + FLUX_BATCH_SIZE-1)/FLUX_BATCH_SIZE;
 
-			if(pconfig.viscous_sim) 
+#pragma omp for
+			for(a_int ibatch = 0; ibatch < nbatches; ibatch++)
 			{
-				// get viscous fluxes
-				a_real vflux[NVARS];
-				const a_real *const urt = (ied < m->gnbface()) ? nullptr : &uarr[relem*NVARS];
-				computeViscousFlux(ied, &uarr[lelem*NVARS], urt, ug, grads, uleft, uright, 
-						vflux);
-
-				for(int ivar = 0; ivar < NVARS; ivar++)
-					fluxes[ivar] += vflux[ivar]*len;
-			}
+				const a_int batchstart = colstart + ibatch*FLUX_BATCH_SIZE;
+				const a_int nbf = std::min(FLUX_BATCH_SIZE, colend-batchstart);
 
-			/// We assemble the negative of the residual ( M du/dt + r(u) = 0).
-			for(int ivar = 0; ivar < NVARS; ivar++) {
-#pragma omp atomic
-				residual(lelem,ivar) -= fluxes[ivar];
-			}
-			if(relem < m->gnelem()) {
-				for(int ivar = 0; ivar < NVARS; ivar++) {
-#pragma omp atomic
-					residual(relem,ivar) += fluxes[ivar];
+				a_int faces[FLUX_BATCH_SIZE];
+				a_real ufl[FLUX_BATCH_SIZE][NVARS], ufr[FLUX_BATCH_SIZE][NVARS],
+				       fluxb[FLUX_BATCH_SIZE][NVARS];
+				for(a_int i = 0; i < nbf; i++)
+				{
+					faces[i] = m->gfacecolour(batchstart+i);
+					getFaceStates(faces[i], ws, ufl[i], ufr[i]);
 				}
-			}
-			
-			// compute max allowable time steps
-			if(gettimesteps) 
-			{
-				//calculate speeds of sound
-				const a_real ci = physics.getSoundSpeedFromConserved(&uleft(ied,0));
-				const a_real cj = physics.getSoundSpeedFromConserved(&uright(ied,0));
-				//calculate normal velocities
-				const a_real vni = (uleft(ied,1)*n[0] +uleft(ied,2)*n[1])/uleft(ied,0);
-				const a_real vnj = (uright(ied,1)*n[0] + uright(ied,2)*n[1])/uright(ied,0);
 
-				a_real specradi = (fabs(vni)+ci)*len, specradj = (fabs(vnj)+cj)*len;
+				if(!fluxwithjacobian)
+					computeInviscidFluxBatch<Flux>(nbf, faces, ws, ufl, ufr, fluxb);
 
-				if(pconfig.viscous_sim) 
+				for(a_int i = 0; i < nbf; i++)
 				{
-					a_real mui, muj;
-					if(constVisc) {
-						mui = physics.getConstantViscosityCoeff();
-						muj = physics.getConstantViscosityCoeff();
+					const a_int ied = faces[i];
+					const a_int lelem = m->gintfac(ied,0);
+					const a_int relem = m->gintfac(ied,1);
+					a_real *const fluxes = fluxb[i];
+					a_real L[NVARS*NVARS], U[NVARS*NVARS];
+
+					if(fluxwithjacobian)
+					{
+						if(ied < m->gnbface())
+							computeBoundaryInviscidFlux<Flux>(ied, ws, fluxes);
+						else
+							computeInteriorFaceJacobian<Flux>(ied, jac->u, L, U, fluxes);
 					}
-					else {
-						mui = physics.getViscosityCoeffFromConserved(&uleft(ied,0));
-						muj = physics.getViscosityCoeffFromConserved(&uright(ied,0));
+
+					integrateFaceFlux(ied, ws, ufl[i], ufr[i], fluxes);
+
+					/// We assemble the negative of the residual ( M du/dt + r(u) = 0).
+					for(int ivar = 0; ivar < NVARS; ivar++) {
+						residual(lelem,ivar) -= fluxes[ivar];
+					}
+					if(relem < m->gnelem()) {
+						for(int ivar = 0; ivar < NVARS; ivar++) {
+							residual(relem,ivar) += fluxes[ivar];
+						}
 					}
-					a_real coi = std::max(4.0/(3*uleft(ied,0)), physics.g/uleft(ied,0));
-					a_real coj = std::max(4.0/(3*uright(ied,0)), physics.g/uright(ied,0));
 					
-					specradi += coi*mui/physics.Pr * len*len/m->garea(lelem);
-					if(relem < m->gnelem())
-						specradj += coj*muj/physics.Pr * len*len/m->garea(relem);
-				}
+					// compute max allowable time steps
+					if(gettimesteps) 
+					{
+						ws.integ(lelem) += computeFaceSpectralRadius(ied, ws, ufl[i], lelem);
+						if(relem < m->gnelem())
+							ws.integ(relem) += computeFaceSpectralRadius(ied, ws, ufr[i], relem);
+					}
 
-#pragma omp atomic
-				integ(lelem) += specradi;
-				
-				if(relem < m->gnelem()) {
-#pragma omp atomic
-					integ(relem) += specradj;
+					if(jac)
+					{
+						if(ied < m->gnbface())
+							computeBoundaryFaceJacobian(ied, jac->u, L);
+						else if(!fluxwithjacobian)
+							computeInteriorFaceJacobian(ied, jac->u, L, U);
+						addFaceJacobian(*jac, ied, L, U);
+					}
 				}
 			}
 		}
+	}
+}
 
-#pragma omp barrier
+template<bool secondOrderRequested, bool constVisc>
+template<typename Flux>
+void FlowFV<secondOrderRequested,constVisc>::assembleResidual_cellGather(
+		ResidualWorkspace& ws,
+		const bool gettimesteps, Eigen::Map<MVector>& residual) const
+{
+	const a_int nblocks = (m->gnelem() + FLUX_BATCH_SIZE-1)/FLUX_BATCH_SIZE;
 
-		if(gettimesteps)
-#pragma omp for simd
+#pragma omp parallel for default(shared)
+	for(a_int iblock = 0; iblock < nblocks; iblock++)
+	{
+		const a_int cellstart = iblock*FLUX_BATCH_SIZE;
+		const a_int cellend = std::min(cellstart+FLUX_BATCH_SIZE, m->gnelem());
+		const a_int icfend = m->gcellface_p(cellend);
+		a_int iel = cellstart;
+
+		for(a_int batchstart = m->gcellface_p(cellstart); batchstart < icfend; 
+				batchstart += FLUX_BATCH_SIZE)
+		{
+			const a_int nbf = std::min(FLUX_BATCH_SIZE, icfend-batchstart);
+			a_int faces[FLUX_BATCH_SIZE];
+			a_real ufl[FLUX_BATCH_SIZE][NVARS], ufr[FLUX_BATCH_SIZE][NVARS],
+			       fluxb[FLUX_BATCH_SIZE][NVARS];
+
+			for(a_int i = 0; i < nbf; i++)
+			{
+				faces[i] = m->gcellface(batchstart+i);
+				getFaceStates(faces[i], ws, ufl[i], ufr[i]);
+			}
+
+			computeInviscidFluxBatch<Flux>(nbf, faces, ws, ufl, ufr, fluxb);
+
+			for(a_int i = 0; i < nbf; i++)
+			{
+				const a_int icf = batchstart+i;
+				while(icf >= m->gcellface_p(iel+1))
+					iel++;
+
+				const a_int ied = faces[i];
+				const int sign = m->gcellfacesign(icf);
+				a_real *const fluxes = fluxb[i];
+				integrateFaceFlux(ied, ws, ufl[i], ufr[i], fluxes);
+
+				// the face flux is from the left cell into the right cell
+				for(int ivar = 0; ivar < NVARS; ivar++)
+					residual(iel,ivar) -= sign*fluxes[ivar];
+
+				if(gettimesteps)
+					ws.integ(iel) += computeFaceSpectralRadius(ied, ws, sign > 0 ? ufl[i] : ufr[i],
+							iel);
+			}
+		}
+	}
+}
+
+template<bool secondOrderRequested, bool constVisc>
+StatusCode FlowFV<secondOrderRequested,constVisc>::compute_residual(const Vec uvec, 
+		Vec __restrict rvec, 
+		const bool gettimesteps, std::vector<a_real>& dtm) const
+{
+	return computeResidualWith<a_real,InviscidFlux,GradientScheme<NVARS>,SolutionReconstruction>
+		(uvec, NULL, rvec, gettimesteps, dtm, NULL, NULL);
+}
+
+template<bool secondOrderRequested, bool constVisc>
+StatusCode FlowFV<secondOrderRequested,constVisc>::compute_residual_and_jacobian(const Vec uvec, 
+		Vec __restrict rvec, 
+		const bool gettimesteps, std::vector<a_real>& dtm, Mat A) const
+{
+	return computeResidualWith<a_real,InviscidFlux,GradientScheme<NVARS>,SolutionReconstruction>
+		(uvec, NULL, rvec, gettimesteps, dtm, A, NULL);
+}
+
+template<bool secondOrderRequested, bool constVisc>
+StatusCode FlowFV<secondOrderRequested,constVisc>::freeze_reconstruction(const Vec uvec,
+		FrozenReconstruction **const fr) const
+{
+	StatusCode ierr = 0;
+	if(secondOrderRequested && !fusedreconstruction)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_SUP,
+				"Freezing the reconstruction needs a reconstruction with cell limiters!");
+
+	if(!*fr)
+		*fr = new FrozenFlowReconstruction(m, secondOrderRequested);
+	FrozenFlowReconstruction *const frozen = dynamic_cast<FrozenFlowReconstruction*>(*fr);
+	if(!frozen)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONG, 
+				"The reconstruction was frozen by a different kind of discretization!");
+
+	const PetscScalar *uarr;
+	ierr = VecGetArrayRead(uvec, &uarr); CHKERRQ(ierr);
+
+#pragma omp parallel for default(shared)
+	for(a_int ied = 0; ied < m->gnbface(); ied++)
+	{
+		const a_int ielem = m->gintfac(ied,0);
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			frozen->ucell(ied,ivar) = uarr[ielem*NVARS+ivar];
+	}
+
+	if(secondOrderRequested)
+	{
+		// the limiter factors and boundary face states, computed as in the residual
+		const WorkspaceGuard ws(*this);
+
+#pragma omp parallel for simd default(shared)
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+			physics.getPrimitiveFromConserved(&uarr[iel*NVARS], &ws->up(iel,0));
+
+		compute_boundary_states_and_jacobians(frozen->ucell, frozen->ug, frozen->dug);
+
+#pragma omp parallel for default(shared)
+		for(a_int iface = 0; iface < m->gnbface(); iface++)
+			physics.getPrimitiveFromConserved(&frozen->ug(iface,0), &ws->ug(iface,0));
+
+		gradcomp->compute_gradients(ws->up, ws->ug, ws->grads);
+		lim->compute_limiters(ws->up, ws->ug, ws->grads, frozen->phi);
+
+#pragma omp parallel for default(shared)
+		for(a_int iface = 0; iface < m->gnbface(); iface++) 
+		{
+			const a_int lelem = m->gintfac(iface,0);
+			for(int ivar = 0; ivar < NVARS; ivar++) {
+				frozen->uleft(iface,ivar) = ws->up(lelem,ivar);
+				for(int idim = 0; idim < NDIM; idim++)
+					frozen->uleft(iface,ivar) += frozen->phi(lelem,ivar)*ws->grads[lelem](idim,ivar)
+						*(gr[iface](0,idim)-rc(lelem,idim));
+			}
+			physics.getConservedFromPrimitive(&frozen->uleft(iface,0), &frozen->uleft(iface,0));
+		}
+	}
+	else
+	{
+#pragma omp parallel for default(shared)
+		for(a_int ied = 0; ied < m->gnbface(); ied++)
+			for(int ivar = 0; ivar < NVARS; ivar++)
+				frozen->uleft(ied,ivar) = frozen->ucell(ied,ivar);
+	}
+
+	compute_boundary_states_and_jacobians(frozen->uleft, frozen->uright, frozen->duright);
+
+	ierr = VecRestoreArrayRead(uvec, &uarr); CHKERRQ(ierr);
+	return ierr;
+}
+
+template<bool secondOrderRequested, bool constVisc>
+StatusCode FlowFV<secondOrderRequested,constVisc>::compute_frozen_residual(const Vec uvec, 
+		const FrozenReconstruction *const fr, Vec __restrict rvec) const
+{
+	const FrozenFlowReconstruction *const frozen = getFrozenData(fr);
+	if(!frozen)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONG, 
+				"The reconstruction was not frozen by this kind of discretization!");
+	std::vector<a_real> dummy;
+	return computeResidualWith<a_real,InviscidFlux,GradientScheme<NVARS>,SolutionReconstruction>
+		(uvec, NULL, rvec, false, dummy, NULL, frozen);
+}
+
+/** The fluxes, spectral radii and Jacobian blocks of all faces are computed first, and are
+ * then gathered by each cell, so that no synchronization is needed.
+ */
+template<bool secondOrderRequested, bool constVisc>
+StatusCode FlowFV<secondOrderRequested,constVisc>::compute_agglomerated_residual(
+		const AgglomeratedMesh& am, const a_real *const u, a_real *const residual,
+		const bool gettimesteps, a_real *const dtm, a_real *const diag) const
+{
+	if(pconfig.viscous_sim)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_SUP,
+				"Agglomerated meshes can only be used for inviscid flows!");
+	if(diag && !jflux)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONGSTATE,
+				"The Jacobian flux is needed for the diagonal blocks!");
+
+	typedef Matrix<a_real,NVARS,NVARS,RowMajor> FaceBlock;
+	const a_int naface = am.gnaface();
+	std::vector<a_real> fluxes(residual ? naface*NVARS : 0);
+	std::vector<a_real> specrad(gettimesteps ? 2*naface : 0);
+	std::vector<a_real> faceblocks(diag ? 2*naface*NVARS*NVARS : 0);
+
+#pragma omp parallel for default(shared)
+	for(a_int iface = 0; iface < naface; iface++)
+	{
+		const a_int lelem = am.gintfac(iface,0);
+		const a_real n[NDIM] = {am.gfacemetric(iface,0), am.gfacemetric(iface,1)};
+		const a_real len = am.gfacemetric(iface,2);
+		const a_real *const ul = &u[lelem*NVARS];
+		a_real ur[NVARS];
+		FaceBlock drdl;
+
+		if(iface < am.gnbface()) {
+			if(diag)
+				compute_boundary_Jacobian(am.gmeshface(iface), ul, ur, &drdl(0,0));
+			else
+				compute_boundary_state(am.gmeshface(iface), ul, ur);
+		}
+		else
+			for(int ivar = 0; ivar < NVARS; ivar++)
+				ur[ivar] = u[am.gintfac(iface,1)*NVARS+ivar];
+
+		if(residual) {
+			inviflux->get_flux(ul, ur, n, &fluxes[iface*NVARS]);
+			for(int ivar = 0; ivar < NVARS; ivar++)
+				fluxes[iface*NVARS+ivar] *= len;
+		}
+
+		if(gettimesteps) {
+			specrad[2*iface] = (std::fabs(ul[1]*n[0]+ul[2]*n[1])/ul[0]
+					+ physics.getSoundSpeedFromConserved(ul))*len;
+			specrad[2*iface+1] = (std::fabs(ur[1]*n[0]+ur[2]*n[1])/ur[0]
+					+ physics.getSoundSpeedFromConserved(ur))*len;
+		}
+
+		if(diag)
+		{
+			FaceBlock left, right;
+			jflux->get_jacobian(ul, ur, n, &left(0,0), &right(0,0));
+			Eigen::Map<FaceBlock> lblock(&faceblocks[2*iface*NVARS*NVARS]);
+			Eigen::Map<FaceBlock> rblock(&faceblocks[(2*iface+1)*NVARS*NVARS]);
+			// as in computeBoundaryFaceJacobian and addFaceJacobian
+			if(iface < am.gnbface())
+				lblock = -len*(left - right*drdl);
+			else {
+				lblock = -len*left;
+				rblock = -len*right;
+			}
+		}
+	}
+
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < am.gnelem(); iel++)
+	{
+		a_real integ = 0;
+		if(diag)
+			for(int i = 0; i < NVARS*NVARS; i++)
+				diag[iel*NVARS*NVARS+i] = 0;
+
+		for(a_int j = am.gcellface_p(iel); j < am.gcellface_p(iel+1); j++)
+		{
+			const a_int iface = am.gcellface(j);
+			const int sign = am.gcellfacesign(j);
+			const int side = sign > 0 ? 0 : 1;
+
+			// the flux is from the left cell into the right cell
+			if(residual)
+				for(int ivar = 0; ivar < NVARS; ivar++)
+					residual[iel*NVARS+ivar] -= sign*fluxes[iface*NVARS+ivar];
+			if(gettimesteps)
+				integ += specrad[2*iface+side];
+			if(diag)
+				for(int i = 0; i < NVARS*NVARS; i++)
+					diag[iel*NVARS*NVARS+i] += faceblocks[(2*iface+side)*NVARS*NVARS+i];
+		}
+
+		if(gettimesteps)
+			dtm[iel] = am.garea(iel)/integ;
+	}
+
+	return 0;
+}
+
+template<bool secondOrderRequested, bool constVisc>
+typename FlowFV<secondOrderRequested,constVisc>::DualStates& 
+FlowFV<secondOrderRequested,constVisc>::getStates(ResidualWorkspace& ws, Dual) const
+{
+	if(!ws.dual)
+		ws.dual = new DualStates(m, secondOrderRequested);
+	return *ws.dual;
+}
+
+template<bool secondOrderRequested, bool constVisc>
+void FlowFV<secondOrderRequested,constVisc>::setCellStates(const a_real *const uarr, 
+		const a_real *const, ResidualWorkspace& ws) const
+{
+	amat::Array2d<a_real>& integ = ws.integ;
+	MVector& up = ws.up;
+	amat::Array2d<a_real>& cellderived = ws.cellderived;
+
+#pragma omp parallel default(shared)
+	{
+#pragma omp for simd
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			integ(iel) = 0.0;
+		}
+
+		/* Convert cell-centred variables to primitive variables, and compute the quantities
+		 * that faces need from them, once per cell.
+		 */
+#pragma omp for simd
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			physics.getPrimitiveFromConserved(&uarr[iel*NVARS], &up(iel,0));
+			cellderived(iel,CELL_SOUNDSPEED) = physics.getSoundSpeed(up(iel,0), up(iel,NVARS-1));
+		}
+
+		if(pconfig.viscous_sim)
+		{
+#pragma omp for simd
 			for(a_int iel = 0; iel < m->gnelem(); iel++)
 			{
-				dtm[iel] = m->garea(iel)/integ(iel);
+				cellderived(iel,CELL_TEMPERATURE) = physics.getTemperature(up(iel,0),up(iel,NVARS-1));
+				cellderived(iel,CELL_VISCOSITY) = constVisc ? physics.getConstantViscosityCoeff()
+					: physics.getViscosityCoeffFromTemperature(cellderived(iel,CELL_TEMPERATURE));
+			}
+		}
+
+		// first, set cell-centered values of boundary cells as left-side values of boundary faces
+#pragma omp for
+		for(a_int ied = 0; ied < m->gnbface(); ied++)
+		{
+			a_int ielem = m->gintfac(ied,0);
+			for(int ivar = 0; ivar < NVARS; ivar++)
+				ws.uleft(ied,ivar) = uarr[ielem*NVARS+ivar];
+		}
+	}
+}
+
+template<bool secondOrderRequested, bool constVisc>
+void FlowFV<secondOrderRequested,constVisc>::setCellStates(const a_real *const uarr, 
+		const a_real *const xarr, DualStates& ds) const
+{
+#pragma omp parallel default(shared)
+	{
+#pragma omp for
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			Dual uc[NVARS];
+			for(int ivar = 0; ivar < NVARS; ivar++)
+				uc[ivar] = Dual(uarr[iel*NVARS+ivar], xarr[iel*NVARS+ivar]);
+			physics.getPrimitiveFromConserved(uc, &ds.up(iel,0));
+		}
+
+#pragma omp for
+		for(a_int ied = 0; ied < m->gnbface(); ied++)
+		{
+			const a_int ielem = m->gintfac(ied,0);
+			for(int ivar = 0; ivar < NVARS; ivar++)
+				ds.uleft(ied,ivar) = Dual(uarr[ielem*NVARS+ivar], xarr[ielem*NVARS+ivar]);
+		}
+	}
+}
+
+template<bool secondOrderRequested, bool constVisc>
+template<typename Gradient>
+void FlowFV<secondOrderRequested,constVisc>::computeGradients(ResidualWorkspace& ws) const
+{
+	static_cast<const Gradient*>(gradcomp)->compute_gradients(ws.up, ws.ug, ws.grads);
+}
+
+/** The gradient schemes are linear, so the gradients of the derivative part of the
+ * states are the derivatives of the gradients.
+ */
+template<bool secondOrderRequested, bool constVisc>
+template<typename Gradient>
+void FlowFV<secondOrderRequested,constVisc>::computeGradients(DualStates& ds) const
+{
+#pragma omp parallel default(shared)
+	{
+#pragma omp for
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+			for(int ivar = 0; ivar < NVARS; ivar++) {
+				ds.upval(iel,ivar) = ds.up(iel,ivar).val;
+				ds.upder(iel,ivar) = ds.up(iel,ivar).der;
+			}
+#pragma omp for
+		for(a_int iface = 0; iface < m->gnbface(); iface++)
+			for(int ivar = 0; ivar < NVARS; ivar++) {
+				ds.ugval(iface,ivar) = ds.ug(iface,ivar).val;
+				ds.ugder(iface,ivar) = ds.ug(iface,ivar).der;
+			}
+	}
+
+	static_cast<const Gradient*>(gradcomp)->compute_gradients(ds.upval, ds.ugval, ds.gradval);
+	static_cast<const Gradient*>(gradcomp)->compute_gradients(ds.upder, ds.ugder, ds.gradder);
+
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		for(int idim = 0; idim < NDIM; idim++)
+			for(int ivar = 0; ivar < NVARS; ivar++)
+				ds.grads(iel,idim*NVARS+ivar) = Dual(ds.gradval[iel](idim,ivar), 
+						ds.gradder[iel](idim,ivar));
+}
+
+template<bool secondOrderRequested, bool constVisc>
+template<typename Limiter>
+void FlowFV<secondOrderRequested,constVisc>::reconstructFaceValues(ResidualWorkspace& ws,
+		const FrozenFlowReconstruction *const fr) const
+{
+	if(fusedreconstruction)
+	{
+		/* Only the boundary faces' left states are stored, as they are needed by the 
+		 * boundary conditions; interior face states are reconstructed during flux assembly.
+		 */
+		if(fr)
+			ws.limiters = &fr->phi;
+		else {
+			static_cast<const Limiter*>(lim)->compute_limiters(ws.up, ws.ug, ws.grads, ws.phi);
+			ws.limiters = &ws.phi;
+		}
+
+		extrapolateToBoundaryFaces(*ws.limiters, ws);
+	}
+	else
+	{
+		static_cast<const Limiter*>(lim)->compute_face_values(ws.up, ws.ug, ws.grads, 
+				ws.uleft, ws.uright);
+
+		/* Interior face values stay primitive, as the fluxes accept primitive variables.
+		 * Boundary faces' left states are converted for the boundary conditions.
+		 */
+#pragma omp parallel for default(shared)
+		for(a_int iface = 0; iface < m->gnbface(); iface++) 
+		{
+			physics.getConservedFromPrimitive(&ws.uleft(iface,0), &ws.uleft(iface,0));
+		}
+	}
+}
+
+template<bool secondOrderRequested, bool constVisc>
+template<typename Limiter>
+void FlowFV<secondOrderRequested,constVisc>::reconstructFaceValues(DualStates& ds,
+		const FrozenFlowReconstruction *const fr) const
+{
+	assert(!fr);
+	static_cast<const Limiter*>(lim)->compute_limiters(ds.up, ds.ug, ds.grads, ds.phi);
+	extrapolateToBoundaryFaces(ds.phi, ds);
+}
+
+template<bool secondOrderRequested, bool constVisc>
+template<typename scalar, typename States>
+void FlowFV<secondOrderRequested,constVisc>::extrapolateToBoundaryFaces(
+		const amat::Array2d<scalar>& phi, States& st) const
+{
+#pragma omp parallel for default(shared)
+	for(a_int iface = 0; iface < m->gnbface(); iface++) 
+	{
+		const a_int lelem = m->gintfac(iface,0);
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			st.uleft(iface,ivar) = linearExtrapolate(st.up(lelem,ivar), 
+					getCellGradient(st.grads,lelem), ivar, phi(lelem,ivar),
+					&gr[iface](0,0), &rc(lelem,0));
+		physics.getConservedFromPrimitive(&st.uleft(iface,0), &st.uleft(iface,0));
+	}
+}
+
+template<bool secondOrderRequested, bool constVisc>
+template<typename Flux>
+void FlowFV<secondOrderRequested,constVisc>::assembleResidual(ResidualWorkspace& ws,
+		const bool gettimesteps, Eigen::Map<MVector>& residual,
+		const JacobianAssembly *const jac) const
+{
+	if(usecellgather) {
+		assert(!jac);
+		assembleResidual_cellGather<Flux>(ws, gettimesteps, residual);
+	}
+	else
+		assembleResidual_faceColoured<Flux>(ws, gettimesteps, residual, jac);
+}
+
+template<bool secondOrderRequested, bool constVisc>
+template<typename Flux>
+void FlowFV<secondOrderRequested,constVisc>::assembleResidual(DualStates& ds,
+		const bool gettimesteps, Eigen::Map<MVector>& residual,
+		const JacobianAssembly *const jac) const
+{
+	assert(!gettimesteps);
+	assert(!jac);
+
+	// faces of one colour at a time, so that no two threads write to the same cell
+#pragma omp parallel default(shared)
+	for(int icolour = 0; icolour < m->gnfacecolours(); icolour++)
+	{
+#pragma omp for
+		for(a_int ifc = m->gfacecolour_p(icolour); ifc < m->gfacecolour_p(icolour+1); ifc++)
+		{
+			const a_int ied = m->gfacecolour(ifc);
+			const a_int lelem = m->gintfac(ied,0);
+			const a_int relem = m->gintfac(ied,1);
+			const a_real n[NDIM] = {m->gfacemetric(ied,0), m->gfacemetric(ied,1)};
+			const a_real len = m->gfacemetric(ied,2);
+
+			Dual ul[NVARS], ur[NVARS], ulc[NVARS], urc[NVARS], fluxes[NVARS];
+			getFaceStates(ied, ds, ul, ur);
+			physics.getConservedFromPrimitive(ul, ulc);
+			physics.getConservedFromPrimitive(ur, urc);
+			static_cast<const Flux*>(inviflux)->get_flux(ulc, urc, n, fluxes);
+
+			if(pconfig.viscous_sim)
+			{
+				Dual vflux[NVARS];
+				computeViscousFlux(ied, ds, ul, ur, vflux);
+				for(int ivar = 0; ivar < NVARS; ivar++)
+					fluxes[ivar] += vflux[ivar];
+			}
+
+			// the residual r(u) gains the flux out of the left cell and into the right cell
+			for(int ivar = 0; ivar < NVARS; ivar++) {
+				residual(lelem,ivar) += fluxes[ivar].der*len;
+			}
+			if(relem < m->gnelem()) {
+				for(int ivar = 0; ivar < NVARS; ivar++) {
+					residual(relem,ivar) -= fluxes[ivar].der*len;
+				}
+			}
+		}
+	}
+}
+
+template<bool secondOrderRequested, bool constVisc>
+template<typename scalar, typename Flux, typename Gradient, typename Limiter>
+StatusCode FlowFV<secondOrderRequested,constVisc>::computeResidualWith(const Vec uvec, 
+		const Vec xvec, Vec __restrict rvec, 
+		const bool gettimesteps, std::vector<a_real>& dtm, Mat A, 
+		const FrozenFlowReconstruction *const fr) const
+{
+	StatusCode ierr = 0;
+
+	// the Jacobian is assembled along with the residual if its blocks can be written directly
+	const JacobianBlockLocations *blocks = NULL;
+	if(A) {
+		ierr = getJacobianBlockLocations(A, &blocks); CHKERRQ(ierr);
+	}
+	const bool fusedjacobian = blocks && !usecellgather && !colouredjacobian;
+
+	/* Otherwise the Jacobian is assembled first, so that a coloured assembly, which computes
+	 * residuals itself, does not need a second workspace while this one is held.
+	 */
+	if(A && !fusedjacobian) {
+		ierr = compute_jacobian(uvec, A); CHKERRQ(ierr);
+	}
+
+	PetscInt locnelem; const PetscScalar *uarr, *xarr = NULL; PetscScalar *rarr;
+	ierr = VecGetLocalSize(uvec, &locnelem); CHKERRQ(ierr);
+	assert(locnelem % NVARS == 0);
+	locnelem /= NVARS;
+	assert(locnelem == m->gnelem());
+	//ierr = VecGetLocalSize(dtmvec, &dtsz); CHKERRQ(ierr);
+	//assert(locnelem == dtsz);
+
+	ierr = VecGetArrayRead(uvec, &uarr); CHKERRQ(ierr);
+	if(xvec) {
+		ierr = VecGetArrayRead(xvec, &xarr); CHKERRQ(ierr);
+	}
+	ierr = VecGetArray(rvec, &rarr); CHKERRQ(ierr);
+	Eigen::Map<MVector> residual(rarr, locnelem, NVARS);
+	//ierr = VecGetArray(dtmvec, &dtm); CHKERRQ(ierr);
+
+	const WorkspaceGuard ws(*this);
+	auto& st = getStates(*ws, scalar());
+
+	setCellStates(uarr, xarr, st);
+
+	if(secondOrderRequested)
+	{
+		// get cell average values at ghost cells using BCs
+		if(fr)
+			compute_linearised_boundary_states(fr->ucell, fr->ug, fr->dug, st.uleft, st.ug);
+		else
+			compute_boundary_states(st.uleft, st.ug);
+
+		// convert ghost states to primitive variables
+#pragma omp parallel for default(shared)
+		for(a_int iface = 0; iface < m->gnbface(); iface++)
+		{
+			physics.getPrimitiveFromConserved(&st.ug(iface,0), &st.ug(iface,0));
+		}
+
+		// reconstruct
+		computeGradients<Gradient>(st);
+		reconstructFaceValues<Limiter>(st, fr);
+	}
+
+	// set right (ghost) state for boundary faces
+	if(fr)
+		compute_linearised_boundary_states(fr->uleft, fr->uright, fr->duright, st.uleft, st.uright);
+	else
+		compute_boundary_states(st.uleft, st.uright);
+
+	/** Compute fluxes.
+	 * The integral of the maximum magnitude of eigenvalue over each face is also computed:
+	 * \f[
+	 * \int_{f_i} (|v_n| + c) \mathrm{d}l
+	 * \f]
+	 * so that time steps can be calculated for explicit time stepping.
+	 */
+
+	if(fusedjacobian)
+	{
+		JacobianAssembly jac {uarr, blocks, NULL};
+		ierr = getJacobianBlockValues(A, &jac.vals); CHKERRQ(ierr);
+		assembleResidual<Flux>(st, gettimesteps, residual, &jac);
+		ierr = restoreJacobianBlockValues(A, &jac.vals); CHKERRQ(ierr);
+	}
+	else
+		assembleResidual<Flux>(st, gettimesteps, residual, NULL);
+
+	if(gettimesteps)
+#pragma omp parallel for simd default(shared)
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			dtm[iel] = m->garea(iel)/ws->integ(iel);
+		}
+	
+	VecRestoreArrayRead(uvec, &uarr);
+	if(xvec)
+		VecRestoreArrayRead(xvec, &xarr);
+	VecRestoreArray(rvec, &rarr);
+	//VecRestoreArray(dtmvec, &dtm);
+
+	return ierr;
+}
+
+template<bool secondOrderRequested, bool constVisc>
+void FlowFV<secondOrderRequested,constVisc>::getFaceStates(const a_int ied, 
+		const DualStates& ds, Dual *const ul, Dual *const ur) const
+{
+	const a_int lelem = m->gintfac(ied,0);
+	const a_int relem = m->gintfac(ied,1);
+
+	if(ied < m->gnbface())
+	{
+		physics.getPrimitiveFromConserved(&ds.uleft(ied,0), ul);
+		physics.getPrimitiveFromConserved(&ds.uright(ied,0), ur);
+		return;
+	}
+
+	for(int ivar = 0; ivar < NVARS; ivar++) {
+		ul[ivar] = ds.up(lelem,ivar);
+		ur[ivar] = ds.up(relem,ivar);
+	}
+
+	if(secondOrderRequested)
+	{
+		const a_real *const gp = &gr[ied](0,0);
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			for(int idim = 0; idim < NDIM; idim++) {
+				ul[ivar] += ds.phi(lelem,ivar)*ds.grads(lelem,idim*NVARS+ivar)
+					*(gp[idim]-rc(lelem,idim));
+				ur[ivar] += ds.phi(relem,ivar)*ds.grads(relem,idim*NVARS+ivar)
+					*(gp[idim]-rc(relem,idim));
 			}
-	} // end parallel region
+	}
+}
+
+template<bool secondOrderRequested, bool constVisc>
+void FlowFV<secondOrderRequested,constVisc>::computeViscousFlux(const a_int iface, 
+		const DualStates& ds, const Dual *const ul, const Dual *const ur,
+		Dual *const __restrict vflux) const
+{
+	const a_int lelem = m->gintfac(iface,0);
+	const a_int relem = m->gintfac(iface,1);
+
+	// cell-centred primitive-2 variables and their gradients, as in the workspace version
+	Dual ucl[NVARS], ucr[NVARS];
+	Dual gradl[NDIM][NVARS], gradr[NDIM][NVARS];
 	
-	VecRestoreArrayRead(uvec, &uarr);
-	VecRestoreArray(rvec, &rarr);
-	//VecRestoreArray(dtmvec, &dtm);
-	return ierr;
+	for(int i = 0; i < NVARS; i++) 
+	{
+		ucl[i] = ds.up(lelem,i);
+		if(iface < m->gnbface())
+			ucr[i] = secondOrderRequested ? ds.ug(iface,i) : ur[i];
+		else
+			ucr[i] = ds.up(relem,i);
+		
+		for(int j = 0; j < NDIM; j++) {
+			gradl[j][i] = secondOrderRequested ? ds.grads(lelem,j*NVARS+i) : Dual(0);
+			gradr[j][i] = secondOrderRequested && iface >= m->gnbface() ? 
+				ds.grads(relem,j*NVARS+i) : Dual(0);
+		}
+	}
+
+	/* Discard grad p in favor of grad T, then replace pressure by temperature.
+	 * Boundary faces use the one-sided gradient on both sides.
+	 */
+	if(secondOrderRequested)
+		for(int j = 0; j < NDIM; j++) {
+			gradl[j][NVARS-1] = physics.getGradTemperature(ucl[0], gradl[j][0],
+						ucl[NVARS-1], gradl[j][NVARS-1]);
+			if(iface < m->gnbface())
+				for(int i = 0; i < NVARS; i++)
+					gradr[j][i] = gradl[j][i];
+			else
+				gradr[j][NVARS-1] = physics.getGradTemperature(ucr[0], gradr[j][0],
+							ucr[NVARS-1], gradr[j][NVARS-1]);
+		}
+	ucl[NVARS-1] = physics.getTemperature(ucl[0], ucl[NVARS-1]);
+	ucr[NVARS-1] = physics.getTemperature(ucr[0], ucr[NVARS-1]);
+
+	Dual muRe;
+	if(constVisc)
+		muRe = physics.getConstantViscosityCoeff();
+	else if(secondOrderRequested)
+		muRe = 0.5*( physics.getViscosityCoeffFromTemperature(physics.getTemperatureFromPrimitive(ul))
+			+ physics.getViscosityCoeffFromTemperature(physics.getTemperatureFromPrimitive(ur)) );
+	else
+		muRe = 0.5*( physics.getViscosityCoeffFromTemperature(ucl[NVARS-1])
+			+ physics.getViscosityCoeffFromTemperature(ucr[NVARS-1]) );
+
+	computeViscousFlux(iface, ucl, ucr, gradl, gradr, muRe, ul, ur, vflux);
+}
+
+template<bool secondOrderRequested, bool constVisc>
+StatusCode FlowFV<secondOrderRequested,constVisc>::compute_jacobian_vector_product(
+		const Vec uvec, const Vec xvec, Vec jvec) const
+{
+	StatusCode ierr = 0;
+	if(secondOrderRequested && !lim->has_cell_limiters())
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_SUP,
+				"Exact Jacobian-vector products need a reconstruction with cell limiters!");
+
+	ierr = VecSet(jvec, 0.0); CHKERRQ(ierr);
+	std::vector<a_real> dummy;
+	return computeResidualWith<Dual,InviscidFlux,GradientScheme<NVARS>,SolutionReconstruction>
+		(uvec, xvec, jvec, false, dummy, NULL, NULL);
+}
+
+template<bool order2, bool constVisc>
+void FlowFV<order2,constVisc>::computeBoundaryFaceJacobian(const a_int iface, 
+		const a_real *const uarr, a_real *const __restrict dblock) const
+{
+	const a_int lelem = m->gintfac(iface,0);
+	a_real n[NDIM];
+	n[0] = m->gfacemetric(iface,0);
+	n[1] = m->gfacemetric(iface,1);
+	const a_real len = m->gfacemetric(iface,2);
+	
+	a_real uface[NVARS];
+	Matrix<a_real,NVARS,NVARS,RowMajor> drdl;
+	Matrix<a_real,NVARS,NVARS,RowMajor> left;
+	Matrix<a_real,NVARS,NVARS,RowMajor> right;
+	
+	compute_boundary_Jacobian(iface, &uarr[lelem*NVARS], uface, &drdl(0,0));	
+	
+	jflux->get_jacobian(&uarr[lelem*NVARS], uface, n, &left(0,0), &right(0,0));
+
+	if(pconfig.viscous_sim) {
+		//computeViscousFluxApproximateJacobian(iface, &uarr[lelem*NVARS], uface, 
+		//		&left(0,0), &right(0,0));
+		computeViscousFluxJacobian(iface,&uarr[lelem*NVARS],uface, &left(0,0), &right(0,0));
+	}
+	
+	/* The actual derivative is  dF/dl  +  dF/dr * dr/dl.
+	 * We actually need to subtract dF/dr from dF/dl because the inviscid numerical flux
+	 * computation returns the negative of dF/dl but positive dF/dr. The latter was done to
+	 * get correct signs for lower and upper off-diagonal blocks.
+	 *
+	 * Integrate the results over the face and negate, as -ve of L is added to D
+	 */
+	Eigen::Map<Matrix<a_real,NVARS,NVARS,RowMajor>> block(dblock);
+	block = -len*(left - right*drdl);
+}
+
+template<bool order2, bool constVisc>
+template<typename Flux>
+void FlowFV<order2,constVisc>::computeInteriorFaceJacobian(const a_int iface, 
+		const a_real *const uarr, a_real *const __restrict L, a_real *const __restrict U,
+		a_real *const __restrict flux) const
+{
+	const Flux *const fluxscheme = static_cast<const Flux*>(jflux);
+	const a_int lelem = m->gintfac(iface,0);
+	const a_int relem = m->gintfac(iface,1);
+	a_real n[NDIM];
+	n[0] = m->gfacemetric(iface,0);
+	n[1] = m->gfacemetric(iface,1);
+	const a_real len = m->gfacemetric(iface,2);
+
+	// NOTE: the values of L and U get REPLACED here, not added to
+	if(flux)
+		fluxscheme->get_flux_jacobian(&uarr[lelem*NVARS], &uarr[relem*NVARS], n, flux, L, U);
+	else
+		fluxscheme->get_jacobian(&uarr[lelem*NVARS], &uarr[relem*NVARS], n, L, U);
+
+	if(pconfig.viscous_sim) {
+		//computeViscousFluxApproximateJacobian(iface, &uarr[lelem*NVARS], &uarr[relem*NVARS], 
+		//		L, U);
+		computeViscousFluxJacobian(iface, &uarr[lelem*NVARS], &uarr[relem*NVARS], L, U);
+	}
+
+	for(int i = 0; i < NVARS*NVARS; i++) {
+		L[i] *= len;
+		U[i] *= len;
+	}
+}
+
+template<bool order2, bool constVisc>
+void FlowFV<order2,constVisc>::addFaceJacobian(const JacobianAssembly& jac, const a_int iface,
+		const a_real *const L, const a_real *const U) const
+{
+	typedef Eigen::Map<const Matrix<a_real,NVARS,NVARS,RowMajor>> FaceBlock;
+	typedef Eigen::Map<Matrix<a_real,NVARS,NVARS,ColMajor>> BlockMap;
+	const a_int lelem = m->gintfac(iface,0);
+
+	if(iface < m->gnbface()) {
+		BlockMap(&jac.vals[jac.locs->diag[lelem]*NVARS*NVARS]) += FaceBlock(L);
+		return;
+	}
+
+	const a_int relem = m->gintfac(iface,1);
+	BlockMap(&jac.vals[jac.locs->lower[iface]*NVARS*NVARS]) += FaceBlock(L);
+	BlockMap(&jac.vals[jac.locs->upper[iface]*NVARS*NVARS]) += FaceBlock(U);
+	// negative L and U contribute to diagonal blocks
+	BlockMap(&jac.vals[jac.locs->diag[lelem]*NVARS*NVARS]) -= FaceBlock(L);
+	BlockMap(&jac.vals[jac.locs->diag[relem]*NVARS*NVARS]) -= FaceBlock(U);
 }
 
 template<bool order2, bool constVisc>
 StatusCode FlowFV<order2,constVisc>::compute_jacobian(const Vec uvec, Mat A) const
 {
 	StatusCode ierr = 0;
+	if(colouredjacobian) {
+		ierr = assembleColouredJacobian(uvec, A); CHKERRQ(ierr);
+		return ierr;
+	}
 
 	PetscInt locnelem; const PetscScalar *uarr;
 	ierr = VecGetLocalSize(uvec, &locnelem); CHKERRQ(ierr);
@@ -1217,38 +2266,45 @@ StatusCode FlowFV<order2,constVisc>::compute_jacobian(const Vec uvec, Mat A) con
 	ierr = VecGetArrayRead(uvec, &uarr); CHKERRQ(ierr);
 	//Eigen::Map<const MVector> u(uarr, m->gnelem(), NVARS);
 
+	const JacobianBlockLocations *blocks;
+	ierr = getJacobianBlockLocations(A, &blocks); CHKERRQ(ierr);
+
+	if(blocks)
+	{
+		/* Add the blocks directly to the matrix storage. Faces of one colour do not share cells,
+		 * so they can add to diagonal blocks concurrently; each face owns its off-diagonal blocks.
+		 */
+		JacobianAssembly jac {uarr, blocks, NULL};
+		ierr = getJacobianBlockValues(A, &jac.vals); CHKERRQ(ierr);
+
+#pragma omp parallel default(shared)
+		for(int icolour = 0; icolour < m->gnfacecolours(); icolour++)
+		{
+#pragma omp for
+			for(a_int ifc = m->gfacecolour_p(icolour); ifc < m->gfacecolour_p(icolour+1); ifc++)
+			{
+				const a_int iface = m->gfacecolour(ifc);
+				a_real L[NVARS*NVARS], U[NVARS*NVARS];
+
+				if(iface < m->gnbface())
+					computeBoundaryFaceJacobian(iface, uarr, L);
+				else
+					computeInteriorFaceJacobian(iface, uarr, L, U);
+				addFaceJacobian(jac, iface, L, U);
+			}
+		}
+
+		ierr = restoreJacobianBlockValues(A, &jac.vals); CHKERRQ(ierr);
+		ierr = VecRestoreArrayRead(uvec, &uarr); CHKERRQ(ierr);
+		return ierr;
+	}
+
 #pragma omp parallel for default(shared)
 	for(a_int iface = 0; iface < m->gnbface(); iface++)
 	{
 		const a_int lelem = m->gintfac(iface,0);
-		a_real n[NDIM];
-		n[0] = m->gfacemetric(iface,0);
-		n[1] = m->gfacemetric(iface,1);
-		const a_real len = m->gfacemetric(iface,2);
-		
-		a_real uface[NVARS];
-		Matrix<a_real,NVARS,NVARS,RowMajor> drdl;
 		Matrix<a_real,NVARS,NVARS,RowMajor> left;
-		Matrix<a_real,NVARS,NVARS,RowMajor> right;
-		
-		compute_boundary_Jacobian(iface, &uarr[lelem*NVARS], uface, &drdl(0,0));	
-		
-		jflux->get_jacobian(&uarr[lelem*NVARS], uface, n, &left(0,0), &right(0,0));
-
-		if(pconfig.viscous_sim) {
-			//computeViscousFluxApproximateJacobian(iface, &uarr[lelem*NVARS], uface, 
-			//		&left(0,0), &right(0,0));
-			computeViscousFluxJacobian(iface,&uarr[lelem*NVARS],uface, &left(0,0), &right(0,0));
-		}
-		
-		/* The actual derivative is  dF/dl  +  dF/dr * dr/dl.
-		 * We actually need to subtract dF/dr from dF/dl because the inviscid numerical flux
-		 * computation returns the negative of dF/dl but positive dF/dr. The latter was done to
-		 * get correct signs for lower and upper off-diagonal blocks.
-		 *
-		 * Integrate the results over the face and negate, as -ve of L is added to D
-		 */
-		left = -len*(left - right*drdl);
+		computeBoundaryFaceJacobian(iface, uarr, left.data());
 
 #pragma omp critical
 		{
@@ -1259,27 +2315,12 @@ StatusCode FlowFV<order2,constVisc>::compute_jacobian(const Vec uvec, Mat A) con
 #pragma omp parallel for default(shared)
 	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
 	{
-		//const a_int intface = iface-m->gnbface();
 		const a_int lelem = m->gintfac(iface,0);
 		const a_int relem = m->gintfac(iface,1);
-		a_real n[NDIM];
-		n[0] = m->gfacemetric(iface,0);
-		n[1] = m->gfacemetric(iface,1);
-		const a_real len = m->gfacemetric(iface,2);
 		Matrix<a_real,NVARS,NVARS,RowMajor> L;
 		Matrix<a_real,NVARS,NVARS,RowMajor> U;
-	
-		// NOTE: the values of L and U get REPLACED here, not added to
-		jflux->get_jacobian(&uarr[lelem*NVARS], &uarr[relem*NVARS], n, &L(0,0), &U(0,0));
-
-		if(pconfig.viscous_sim) {
-			//computeViscousFluxApproximateJacobian(iface, &uarr[lelem*NVARS], &uarr[relem*NVARS], 
-			//		&L(0,0), &U(0,0));
-			computeViscousFluxJacobian(iface, &uarr[lelem*NVARS], &uarr[relem*NVARS], 
-					&L(0,0), &U(0,0));
-		}
+		computeInteriorFaceJacobian(iface, uarr, L.data(), U.data());
 
-		L *= len; U *= len;
 #pragma omp critical
 		{
 			ierr = MatSetValuesBlocked(A, 1, &relem, 1, &lelem, L.data(), ADD_VALUES);
@@ -1306,6 +2347,153 @@ StatusCode FlowFV<order2,constVisc>::compute_jacobian(const Vec uvec, Mat A) con
 	return ierr;
 }
 
+template<bool order2, bool constVisc>
+int FlowFV<order2,constVisc>::jacobian_stencil_radius() const
+{
+	return colouredjacobian && order2 ? 1 + lim->stencil_radius() : 1;
+}
+
+template<bool order2, bool constVisc>
+StatusCode FlowFV<order2,constVisc>::assembleColouredJacobian(const Vec uvec, Mat A) const
+{
+	StatusCode ierr = 0;
+	for(a_int iface = 0; iface < m->gnbface(); iface++)
+		if(m->gintfacbtags(iface,0) == pconfig.periodic_id)
+			SETERRQ(PETSC_COMM_SELF, PETSC_ERR_SUP,
+					"Coloured Jacobians are not supported with periodic boundaries!");
+
+	/* Finite difference step for a state; relative to its magnitude, but not smaller than for a
+	 * state of magnitude 1, so that zero velocities are perturbed too.
+	 */
+	const a_real relstep = 1e-7;
+	auto differenceStep = [relstep](const a_real u) {
+		return relstep*std::max(std::fabs(u), 1.0);
+	};
+
+	// seeds or perturbed states, and the column of the Jacobian for each variable
+	Vec x, jx[NVARS];
+	ierr = VecDuplicate(uvec, &x); CHKERRQ(ierr);
+	for(int ivar = 0; ivar < NVARS; ivar++) {
+		ierr = VecDuplicate(uvec, &jx[ivar]); CHKERRQ(ierr);
+	}
+
+	// residual at the state, for finite differences
+	Vec r = NULL;
+	std::vector<a_real> dummy;
+	if(differencejacobian) {
+		ierr = VecDuplicate(uvec, &r); CHKERRQ(ierr);
+		ierr = VecSet(r, 0.0); CHKERRQ(ierr);
+		ierr = compute_residual(uvec, r, false, dummy); CHKERRQ(ierr);
+	}
+
+	// the blocks are written directly if the matrix was preallocated for this stencil
+	const JacobianBlockLocations *blocks;
+	ierr = getJacobianBlockLocations(A, &blocks); CHKERRQ(ierr);
+	if(blocks && blocks->stencilradius != jacobian_stencil_radius())
+		blocks = NULL;
+	PetscScalar *vals = NULL;
+	if(blocks) {
+		ierr = getJacobianBlockValues(A, &vals); CHKERRQ(ierr);
+	}
+
+	for(size_t icolour = 0; icolour+1 < jaccolourptr.size(); icolour++)
+	{
+		for(int ivar = 0; ivar < NVARS; ivar++)
+		{
+			PetscScalar *xarr;
+			if(exactjacobian) {
+				ierr = VecSet(x, 0.0); CHKERRQ(ierr);
+			} else {
+				ierr = VecCopy(uvec, x); CHKERRQ(ierr);
+			}
+			ierr = VecGetArray(x, &xarr); CHKERRQ(ierr);
+			for(a_int k = jaccolourptr[icolour]; k < jaccolourptr[icolour+1]; k++) {
+				const a_int i = jaccolourcells[k]*NVARS+ivar;
+				xarr[i] = exactjacobian ? 1.0 : xarr[i] + differenceStep(xarr[i]);
+			}
+			ierr = VecRestoreArray(x, &xarr); CHKERRQ(ierr);
+
+			if(exactjacobian) {
+				ierr = compute_jacobian_vector_product(uvec, x, jx[ivar]); CHKERRQ(ierr);
+			}
+			else {
+				// compute_residual gives -r(u), so this is r(u+h) - r(u)
+				ierr = VecSet(jx[ivar], 0.0); CHKERRQ(ierr);
+				ierr = compute_residual(x, jx[ivar], false, dummy); CHKERRQ(ierr);
+				ierr = VecAYPX(jx[ivar], -1.0, r); CHKERRQ(ierr);
+			}
+		}
+
+		const PetscScalar *uarr, *jxarr[NVARS];
+		ierr = VecGetArrayRead(uvec, &uarr); CHKERRQ(ierr);
+		for(int ivar = 0; ivar < NVARS; ivar++) {
+			ierr = VecGetArrayRead(jx[ivar], &jxarr[ivar]); CHKERRQ(ierr);
+		}
+
+		// Scaled column block of the Jacobian, coupling cell icell to cell jcell
+		auto columnBlock = [&](const a_int icell, const a_int jcell,
+				Matrix<a_real,NVARS,NVARS,RowMajor>& block)
+		{
+			for(int j = 0; j < NVARS; j++) {
+				const a_real colscale
+					= exactjacobian ? 1.0 : 1.0/differenceStep(uarr[jcell*NVARS+j]);
+				for(int i = 0; i < NVARS; i++)
+					block(i,j) = jxarr[j][icell*NVARS+i]*colscale;
+			}
+		};
+
+		/* Neighbourhoods are symmetric, so the rows coupled to a cell are its neighbourhood.
+		 * Each block is in the column of exactly one cell, so the cells of a colour can write
+		 * their blocks concurrently.
+		 */
+		if(blocks)
+		{
+			typedef Eigen::Map<Matrix<a_real,NVARS,NVARS,ColMajor>> BlockMap;
+#pragma omp parallel for default(shared)
+			for(a_int k = jaccolourptr[icolour]; k < jaccolourptr[icolour+1]; k++)
+			{
+				const a_int jcell = jaccolourcells[k];
+				for(a_int l = jacnbhdptr[jcell]; l < jacnbhdptr[jcell+1]; l++)
+				{
+					Matrix<a_real,NVARS,NVARS,RowMajor> block;
+					columnBlock(jacnbhd[l], jcell, block);
+					BlockMap(&vals[blocks->nbhdcolumn[l]*NVARS*NVARS]) += block;
+				}
+			}
+		}
+		else
+			for(a_int k = jaccolourptr[icolour]; k < jaccolourptr[icolour+1]; k++)
+			{
+				const a_int jcell = jaccolourcells[k];
+				for(a_int l = jacnbhdptr[jcell]; l < jacnbhdptr[jcell+1]; l++)
+				{
+					const a_int icell = jacnbhd[l];
+					Matrix<a_real,NVARS,NVARS,RowMajor> block;
+					columnBlock(icell, jcell, block);
+					ierr = MatSetValuesBlocked(A, 1, &icell, 1, &jcell, block.data(), ADD_VALUES);
+					CHKERRQ(ierr);
+				}
+			}
+
+		ierr = VecRestoreArrayRead(uvec, &uarr); CHKERRQ(ierr);
+		for(int ivar = 0; ivar < NVARS; ivar++) {
+			ierr = VecRestoreArrayRead(jx[ivar], &jxarr[ivar]); CHKERRQ(ierr);
+		}
+	}
+
+	if(blocks) {
+		ierr = restoreJacobianBlockValues(A, &vals); CHKERRQ(ierr);
+	}
+	if(differencejacobian) {
+		ierr = VecDestroy(&r); CHKERRQ(ierr);
+	}
+	ierr = VecDestroy(&x); CHKERRQ(ierr);
+	for(int ivar = 0; ivar < NVARS; ivar++) {
+		ierr = VecDestroy(&jx[ivar]); CHKERRQ(ierr);
+	}
+	return ierr;
+}
+
 #if 0
 
 /** Computes the Jacobian in a block diagonal, lower and upper format.
@@ -1530,6 +2718,145 @@ template class FlowFV<false,true>;
 template class FlowFV<true,false>;
 template class FlowFV<false,false>;
 
+template<bool secondOrderRequested, bool constVisc, 
+	typename Flux, typename Gradient, typename Limiter>
+FlowFVStatic<secondOrderRequested,constVisc,Flux,Gradient,Limiter>::FlowFVStatic(
+		const UMesh2dh *const mesh,
+		const FlowPhysicsConfig& pconf, 
+		const FlowNumericsConfig& nconf)
+	: FlowFV<secondOrderRequested,constVisc>(mesh, pconf, nconf)
+{
+	assert(dynamic_cast<const Flux*>(this->inviflux));
+	assert(dynamic_cast<const Gradient*>(this->gradcomp));
+	assert(dynamic_cast<const Limiter*>(this->lim));
+}
+
+template<bool secondOrderRequested, bool constVisc, 
+	typename Flux, typename Gradient, typename Limiter>
+StatusCode FlowFVStatic<secondOrderRequested,constVisc,Flux,Gradient,Limiter>::compute_residual(
+		const Vec u, Vec residual, 
+		const bool gettimesteps, std::vector<a_real>& dtm) const
+{
+	return this->template computeResidualWith<a_real,Flux,Gradient,Limiter>(u, NULL, residual,
+			gettimesteps, dtm, NULL, NULL);
+}
+
+template<bool secondOrderRequested, bool constVisc, 
+	typename Flux, typename Gradient, typename Limiter>
+StatusCode FlowFVStatic<secondOrderRequested,constVisc,Flux,Gradient,Limiter>::
+compute_residual_and_jacobian(const Vec u, Vec residual, 
+		const bool gettimesteps, std::vector<a_real>& dtm, Mat A) const
+{
+	return this->template computeResidualWith<a_real,Flux,Gradient,Limiter>(u, NULL, residual,
+			gettimesteps, dtm, A, NULL);
+}
+
+template<bool secondOrderRequested, bool constVisc, 
+	typename Flux, typename Gradient, typename Limiter>
+StatusCode FlowFVStatic<secondOrderRequested,constVisc,Flux,Gradient,Limiter>::
+compute_frozen_residual(const Vec u, const Spatial<NVARS>::FrozenReconstruction *const fr,
+		Vec residual) const
+{
+	const auto *const frozen = this->getFrozenData(fr);
+	if(!frozen)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONG, 
+				"The reconstruction was not frozen by this kind of discretization!");
+	std::vector<a_real> dummy;
+	return this->template computeResidualWith<a_real,Flux,Gradient,Limiter>(u, NULL, residual,
+			false, dummy, NULL, frozen);
+}
+
+/* Schemes for which devirtualised residuals are compiled, as X(name, type) where name is
+ * the string selecting the scheme in the control file. Every combination of a flux,
+ * a gradient scheme and a limiter in these lists is compiled, so the lists are kept short
+ * unless all combinations are requested at build time.
+ */
+#ifndef STATIC_DISPATCH_LEVEL
+#define STATIC_DISPATCH_LEVEL 1
+#endif
+
+#if STATIC_DISPATCH_LEVEL >= 2
+#define STATIC_FLUXES(X) X("LLF", LocalLaxFriedrichsFlux) X("VANLEER", VanLeerFlux) \
+	X("AUSM", AUSMFlux) X("AUSMPLUS", AUSMPlusFlux) X("ROE", RoeFlux) X("HLL", HLLFlux) \
+	X("HLLC", HLLCFlux)
+#define STATIC_GRADIENTS(X) X("LEASTSQUARES", WeightedLeastSquaresGradients<NVARS>) \
+	X("GREENGAUSS", GreenGaussGradients<NVARS>)
+#define STATIC_LIMITERS(X) X("NONE", LinearUnlimitedReconstruction) \
+	X("WENO", WENOReconstruction) X("VANALBADA", MUSCLVanAlbada) \
+	X("BARTHJESPERSEN", BarthJespersenLimiter) X("VENKATAKRISHNAN", VenkatakrishnanLimiter)
+#elif STATIC_DISPATCH_LEVEL == 1
+#define STATIC_FLUXES(X) X("ROE", RoeFlux) X("HLL", HLLFlux) X("HLLC", HLLCFlux)
+#define STATIC_GRADIENTS(X) X("LEASTSQUARES", WeightedLeastSquaresGradients<NVARS>) \
+	X("GREENGAUSS", GreenGaussGradients<NVARS>)
+#define STATIC_LIMITERS(X) X("NONE", LinearUnlimitedReconstruction) \
+	X("WENO", WENOReconstruction) X("VENKATAKRISHNAN", VenkatakrishnanLimiter)
+#else
+#define STATIC_FLUXES(X)
+#define STATIC_GRADIENTS(X)
+#define STATIC_LIMITERS(X)
+#endif
+
+namespace {
+
+template <bool constVisc, typename Flux, typename Gradient>
+Spatial<NVARS>* create_static_flowfv_limiter(const UMesh2dh *const m,
+	const FlowPhysicsConfig& pconf, const FlowNumericsConfig& nconf)
+{
+#define STATIC_LIMITER_CASE(name, type) \
+	if(nconf.reconstruction == name) \
+		return new FlowFVStatic<true,constVisc,Flux,Gradient,type>(m, pconf, nconf);
+	STATIC_LIMITERS(STATIC_LIMITER_CASE)
+#undef STATIC_LIMITER_CASE
+	return nullptr;
+}
+
+/// Second-order: the gradient scheme and limiter are chosen next
+template <bool constVisc, typename Flux>
+Spatial<NVARS>* create_static_flowfv_reconstruction(std::true_type, const UMesh2dh *const m,
+	const FlowPhysicsConfig& pconf, const FlowNumericsConfig& nconf)
+{
+#define STATIC_GRADIENT_CASE(name, type) \
+	if(nconf.gradientscheme == name) \
+		return create_static_flowfv_limiter<constVisc,Flux,type>(m, pconf, nconf);
+	STATIC_GRADIENTS(STATIC_GRADIENT_CASE)
+#undef STATIC_GRADIENT_CASE
+	return nullptr;
+}
+
+/// First-order: the gradient scheme and limiter are never called
+template <bool constVisc, typename Flux>
+Spatial<NVARS>* create_static_flowfv_reconstruction(std::false_type, const UMesh2dh *const m,
+	const FlowPhysicsConfig& pconf, const FlowNumericsConfig& nconf)
+{
+	return new FlowFVStatic<false,constVisc,Flux,GradientScheme<NVARS>,SolutionReconstruction>
+		(m, pconf, nconf);
+}
+
+}
+
+template <bool secondOrderRequested, bool constVisc>
+Spatial<NVARS>* create_static_flowfv(const UMesh2dh *const m,
+	const FlowPhysicsConfig& pconf,
+	const FlowNumericsConfig& nconf)
+{
+#define STATIC_FLUX_CASE(name, type) \
+	if(nconf.conv_numflux == name) \
+		return create_static_flowfv_reconstruction<constVisc,type>( \
+				std::integral_constant<bool,secondOrderRequested>(), m, pconf, nconf);
+	STATIC_FLUXES(STATIC_FLUX_CASE)
+#undef STATIC_FLUX_CASE
+	return nullptr;
+}
+
+template Spatial<NVARS>* create_static_flowfv<true,true>(const UMesh2dh *const m,
+	const FlowPhysicsConfig& pconf, const FlowNumericsConfig& nconf);
+template Spatial<NVARS>* create_static_flowfv<false,true>(const UMesh2dh *const m,
+	const FlowPhysicsConfig& pconf, const FlowNumericsConfig& nconf);
+template Spatial<NVARS>* create_static_flowfv<true,false>(const UMesh2dh *const m,
+	const FlowPhysicsConfig& pconf, const FlowNumericsConfig& nconf);
+template Spatial<NVARS>* create_static_flowfv<false,false>(const UMesh2dh *const m,
+	const FlowPhysicsConfig& pconf, const FlowNumericsConfig& nconf);
+
 
 template<int nvars>
 Diffusion<nvars>::Diffusion(const UMesh2dh *const mesh, const a_real diffcoeff, const a_real bvalue,
@@ -1668,69 +2995,44 @@ StatusCode DiffusionMA<nvars>::compute_residual(const Vec uvec,
 	compute_boundary_states(uleft, ug);
 	gradcomp->compute_gradients(u, ug, grads);
 
-#pragma omp parallel for default(shared)
-	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
+	// faces of one colour do not share any cell, so they can be processed concurrently
+#pragma omp parallel default(shared)
+	for(int icolour = 0; icolour < m->gnfacecolours(); icolour++)
 	{
-		const a_int lelem = m->gintfac(iface,0);
-		const a_int relem = m->gintfac(iface,1);
-		const a_real len = m->gfacemetric(iface,2);
-		
-		a_real gradl[NDIM][nvars], gradr[NDIM][nvars];
-		for(int ivar = 0; ivar < nvars; ivar++) {
-			for(int idim = 0; idim < NDIM; idim++) {
-				gradl[idim][ivar] = grads[lelem](idim,ivar);
-				gradr[idim][ivar] = grads[relem](idim,ivar);
-			}
-		}
-	
-		a_real gradf[NDIM][nvars];
-		getFaceGradient_modifiedAverage(iface, &uarr[lelem*nvars], &uarr[relem*nvars], gradl, gradr, 
-				gradf);
-
-		for(int ivar = 0; ivar < nvars; ivar++)
+#pragma omp for
+		for(a_int ifc = m->gfacecolour_p(icolour); ifc < m->gfacecolour_p(icolour+1); ifc++)
 		{
-			// compute nu*(-grad u . n) * l
-			a_real flux = 0;
-			for(int idim = 0; idim < NDIM; idim++)
-				flux += gradf[idim][ivar]*m->gfacemetric(iface,idim);
-			flux *= (-diffusivity*len);
-
-			/// NOTE: we assemble the negative of the residual r in 'M du/dt + r(u) = 0'
-#pragma omp atomic
-			residual(lelem,ivar) -= flux;
-#pragma omp atomic
-			residual(relem,ivar) += flux;
-		}
-	}
-	
-#pragma omp parallel for default(shared)
-	for(int iface = 0; iface < m->gnbface(); iface++)
-	{
-		const a_int lelem = m->gintfac(iface,0);
-		const a_real len = m->gfacemetric(iface,2);
-		
-		a_real gradl[NDIM][nvars], gradr[NDIM][nvars];
-		for(int ivar = 0; ivar < nvars; ivar++) {
-			for(int idim = 0; idim < NDIM; idim++) {
-				gradl[idim][ivar] = grads[lelem](idim,ivar);
-				gradr[idim][ivar] = grads[lelem](idim,ivar);
+			const a_int iface = m->gfacecolour(ifc);
+			const bool isboundary = iface < m->gnbface();
+			const a_int lelem = m->gintfac(iface,0);
+			const a_int relem = isboundary ? lelem : m->gintfac(iface,1);
+			const a_real len = m->gfacemetric(iface,2);
+			const a_real *const ur = isboundary ? &ug(iface,0) : &uarr[relem*nvars];
+			
+			a_real gradl[NDIM][nvars], gradr[NDIM][nvars];
+			for(int ivar = 0; ivar < nvars; ivar++) {
+				for(int idim = 0; idim < NDIM; idim++) {
+					gradl[idim][ivar] = grads[lelem](idim,ivar);
+					gradr[idim][ivar] = grads[relem](idim,ivar);
+				}
 			}
-		}
-
-		a_real gradf[NDIM][nvars];
-		getFaceGradient_modifiedAverage(iface, &uarr[lelem*nvars], &ug(iface,0), gradl, gradr, gradf);
-
-		for(int ivar = 0; ivar < nvars; ivar++)
-		{
-			// compute nu*(-grad u . n) * l
-			a_real flux = 0;
-			for(int idim = 0; idim < NDIM; idim++)
-				flux += gradf[idim][ivar]*m->gfacemetric(iface,idim);
-			flux *= (-diffusivity*len);
+		
+			a_real gradf[NDIM][nvars];
+			getFaceGradient_modifiedAverage(iface, &uarr[lelem*nvars], ur, gradl, gradr, gradf);
 
-			/// NOTE: we assemble the negative of the residual r in 'M du/dt + r(u) = 0'
-#pragma omp atomic
-			residual(lelem,ivar) -= flux;
+			for(int ivar = 0; ivar < nvars; ivar++)
+			{
+				// compute nu*(-grad u . n) * l
+				a_real flux = 0;
+				for(int idim = 0; idim < NDIM; idim++)
+					flux += gradf[idim][ivar]*m->gfacemetric(iface,idim);
+				flux *= (-diffusivity*len);
+
+				/// NOTE: we assemble the negative of the residual r in 'M du/dt + r(u) = 0'
+				residual(lelem,ivar) -= flux;
+				if(!isboundary)
+					residual(relem,ivar) += flux;
+			}
 		}
 	}
 
@@ -28,6 +28,7 @@
 #include "aarray2d.hpp"
 
 #include "amesh2dh.hpp"
+#include "aagglomeration.hpp"
 #include "anumericalflux.hpp"
 #include "agradientschemes.hpp"
 #include "areconstruction.hpp"
@@ -36,6 +37,9 @@
 
 namespace acfd {
 
+// defined in alinalg.hpp
+struct JacobianBlockLocations;
+
 /// Base class for finite volume spatial discretization
 template<int nvars>
 class Spatial
@@ -66,6 +70,78 @@ public:
 	 */
 	virtual StatusCode compute_jacobian(const Vec u, Mat A) const = 0;
 
+	/// Computes the residual, local time steps and the Jacobian matrix of the residual
+	/** The arguments are those of \ref compute_residual and \ref compute_jacobian.
+	 * Discretizations can override this to compute both in one pass over the mesh;
+	 * the default implementation calls the two functions one after the other.
+	 */
+	virtual StatusCode compute_residual_and_jacobian(const Vec u, Vec residual, 
+			const bool gettimesteps, std::vector<a_real>& dtm, Mat A) const;
+
+	/// Computes a first-order residual on an agglomerated mesh, for multigrid
+	/** The sign convention is that of \ref compute_residual. Discretizations which can be used
+	 * with multigrid override this; the default implementation returns an error.
+	 * \param[in] am The agglomerated mesh, whose boundary faces are faces of \ref m
+	 * \param[in] u The state in each cell of the agglomerated mesh, nvars values per cell
+	 * \param[in,out] residual The residual is added to this, unless it is null
+	 * \param[in] gettimesteps Whether local time steps are needed
+	 * \param[out] dtm Local time steps, one for each cell
+	 * \param[out] diag If not null, the diagonal blocks of the Jacobian of r(u) are stored here,
+	 *   nvars x nvars row-major values per cell
+	 */
+	virtual StatusCode compute_agglomerated_residual(const AgglomeratedMesh& am,
+			const a_real *const u, a_real *const residual,
+			const bool gettimesteps, a_real *const dtm, a_real *const diag) const;
+
+	/// Computes the product of the Jacobian of r(u) with a vector exactly
+	/** The sign convention is that of \ref compute_jacobian, ie, the output is (dr/du) x.
+	 * Discretizations can override this to differentiate their residual in the direction x
+	 * exactly, without assembling the Jacobian; the default implementation returns an error.
+	 * \param[in] u The state at which the Jacobian is needed
+	 * \param[in] x The vector to multiply
+	 * \param[out] jx The product, which is assigned to
+	 */
+	virtual StatusCode compute_jacobian_vector_product(const Vec u, const Vec x, Vec jx) const;
+
+	/// Data captured by \ref freeze_reconstruction at a state
+	/** Discretizations that can freeze their reconstruction store their data in a class
+	 * derived from this. The data belongs to the caller, not to the discretization.
+	 */
+	class FrozenReconstruction
+	{
+	public:
+		virtual ~FrozenReconstruction() { }
+	};
+
+	/// Captures the nonlinear parts of the reconstruction at a state
+	/** Discretizations can override this to store whatever \ref compute_frozen_residual needs;
+	 * the default implementation returns an error.
+	 * \param[in] u The state about which later residuals are frozen
+	 * \param[in,out] fr If null, it is set to new data, which the caller must delete;
+	 *   otherwise, data created by an earlier call to this discretization, which is overwritten
+	 */
+	virtual StatusCode freeze_reconstruction(const Vec u, FrozenReconstruction **const fr) const;
+
+	/// Computes the residual with the reconstruction frozen by \ref freeze_reconstruction
+	/** The sign convention is that of \ref compute_residual, and at the frozen state the result 
+	 * is the same as that of \ref compute_residual. Elsewhere, limiters are not recomputed
+	 * and boundary states are linearised about the frozen state, so that finite differences of
+	 * this residual are cheaper and smoother than those of the full residual.
+	 * The default implementation returns an error.
+	 * \param[in] u The state at which the residual is to be computed
+	 * \param[in] fr The data captured at the frozen state
+	 * \param[in,out] residual The residual is added to this
+	 */
+	virtual StatusCode compute_frozen_residual(const Vec u, const FrozenReconstruction *const fr,
+			Vec residual) const;
+
+	/// Number of steps across faces within which \ref compute_jacobian couples cells
+	/** Matrices passed to \ref compute_jacobian must be preallocated for this stencil radius;
+	 * see \ref setJacobianPreallocation. The default is 1, for Jacobians coupling each cell to
+	 * its face neighbours only.
+	 */
+	virtual int jacobian_stencil_radius() const;
+
 	/// Computes gradients of field variables and stores them in the argument
 	virtual void getGradients(const MVector& u,
 		std::vector<FArray<NDIM,nvars>,aligned_allocator<FArray<NDIM,nvars>>>& grads) const = 0;
@@ -115,9 +191,10 @@ protected:
 	 * \param gradr Right cell-centred gradients
 	 * \param[out] grad Face gradients
 	 */
+	template <typename scalar>
 	void getFaceGradient_modifiedAverage(const a_int iface,
-		const a_real *const ucl, const a_real *const ucr,
-		const a_real gradl[NDIM][nvars], const a_real gradr[NDIM][nvars], a_real grad[NDIM][nvars])
+		const scalar *const ucl, const scalar *const ucr,
+		const scalar gradl[NDIM][nvars], const scalar gradr[NDIM][nvars], scalar grad[NDIM][nvars])
 		const;
 
 	/// Computes the thin-layer face gradient and its Jacobian w.r.t. the left and right states
@@ -173,6 +250,14 @@ struct FlowNumericsConfig
 	std::string gradientscheme;       ///< Method to use to compute gradients
 	std::string reconstruction;       ///< Method to use to reconstruct the solution
 	bool order2;                      ///< Whether to compute a second-order solution
+	/// How fluxes are assembled into the residual: FACECOLOURING (the default, if empty)
+	/// loops over faces one colour at a time, CELLGATHER loops over cells and gathers fluxes
+	std::string residual_engine;
+	/// How the Jacobian matrix is computed: APPROXIMATE (the default, if empty) differentiates
+	/// a first-order residual with the Jacobian flux, EXACT assembles the exact Jacobian of the
+	/// residual from Jacobian-vector products and DIFFERENCE assembles it from finite
+	/// differences of the residual
+	std::string jacobian_assembly;
 };
 
 /// Computes the integrated fluxes and their Jacobians for compressible flow
@@ -215,8 +300,67 @@ public:
 
 	/// Computes the residual Jacobian as a PETSc martrix
 	/** Computes the Jacobian of r(u), where the 
+	 *
+	 * If the matrix has \ref JacobianBlockLocations, the blocks are added directly to its
+	 * storage by faces of one colour at a time, without synchronization; otherwise, they are
+	 * inserted one at a time through PETSc.
+	 *
+	 * If the exact or finite-difference Jacobian is requested, it is assembled instead by 
+	 * \ref assembleColouredJacobian.
 	 */
 	StatusCode compute_jacobian(const Vec u, Mat A) const;
+
+	/// Computes the residual and its Jacobian in one loop over faces
+	/** If the matrix has \ref JacobianBlockLocations and the residual is assembled over
+	 * coloured faces, the Jacobian blocks of each face are added right after its flux. 
+	 * For the first-order scheme, if the Jacobian uses the same flux scheme as the residual,
+	 * the flux at interior faces is computed together with its Jacobian
+	 * (see \ref InviscidFlux::get_flux_jacobian). Otherwise, the residual and the Jacobian are
+	 * computed one after the other.
+	 */
+	StatusCode compute_residual_and_jacobian(const Vec u, Vec residual, 
+			const bool gettimesteps, std::vector<a_real>& dtm, Mat A) const;
+
+	/// Computes the first-order inviscid residual on an agglomerated mesh
+	/** Agglomerated meshes have no cell centres, so the gradients needed by viscous fluxes
+	 * cannot be computed on them; an error is returned if the flow is viscous. The diagonal
+	 * blocks are computed with the Jacobian flux \ref jflux.
+	 */
+	StatusCode compute_agglomerated_residual(const AgglomeratedMesh& am,
+			const a_real *const u, a_real *const residual,
+			const bool gettimesteps, a_real *const dtm, a_real *const diag) const;
+
+	/// Computes the product of the residual Jacobian with a vector using dual numbers
+	/** The residual is evaluated once by \ref computeResidualWith with states \ref Dual
+	 * numbers u + e x, so through the same boundary conditions, reconstruction, inviscid and
+	 * viscous fluxes as \ref compute_residual, and the derivative part is the exact product
+	 * (dr/du) x. Gradients are linear in the states, so the gradients of the derivative part
+	 * are computed by the gradient scheme separately from those of the value part.
+	 * The dual states are kept in the residual workspaces, so products do not allocate memory
+	 * after the first one.
+	 *
+	 * For the second-order scheme, the reconstruction must be limited by one factor per cell
+	 * (\ref SolutionReconstruction::has_cell_limiters); otherwise an error is returned.
+	 */
+	StatusCode compute_jacobian_vector_product(const Vec u, const Vec x, Vec jx) const;
+
+	/// Stores the limiter factors, and linearisations of the boundary states, at a state
+	/** Gradient schemes are linear and keep their own stencil weights, so gradients are not
+	 * frozen. For the second-order scheme, the reconstruction must be limited by one factor
+	 * per cell (\ref SolutionReconstruction::has_cell_limiters); otherwise an error is returned.
+	 */
+	StatusCode freeze_reconstruction(const Vec u, FrozenReconstruction **const fr) const;
+
+	/// Computes the residual using the limiter factors and boundary state linearisations stored
+	/// by \ref freeze_reconstruction
+	StatusCode compute_frozen_residual(const Vec u, const FrozenReconstruction *const fr,
+			Vec residual) const;
+
+	/// For Jacobians assembled from products, one more than the stencil radius of the
+	/// reconstruction for the second-order scheme; otherwise 1
+	/** The residual of a cell depends on the face values on the sides of its face neighbours.
+	 */
+	int jacobian_stencil_radius() const;
 	
 	/// Computes gradients of converved variables
 	void getGradients(const MVector& u,
@@ -265,6 +409,196 @@ protected:
 	/// Reconstruction context
 	const SolutionReconstruction *const lim;
 
+	/// Whether the residual is assembled by a loop over cells instead of coloured faces
+	const bool usecellgather;
+
+	/// Whether face values at interior faces are reconstructed when their fluxes are computed
+	/** This is possible for second-order schemes if the reconstruction is limited by one factor
+	 * per cell (\ref SolutionReconstruction::has_cell_limiters). Face values at interior faces
+	 * are then never stored.
+	 */
+	const bool fusedreconstruction;
+
+	/// Whether the Jacobian uses the same inviscid flux scheme as the residual
+	const bool jacobianfluxsameasresidual;
+
+	/// Whether the exact Jacobian is assembled, see \ref assembleColouredJacobian
+	const bool exactjacobian;
+
+	/// Whether the Jacobian is assembled from finite differences of the residual,
+	/// see \ref assembleColouredJacobian
+	const bool differencejacobian;
+
+	/// Whether the Jacobian is assembled by \ref assembleColouredJacobian
+	const bool colouredjacobian;
+
+	/// Colouring of the cells for assembling the Jacobian from products, 
+	/// see \ref distanceColouring
+	std::vector<a_int> jaccolourptr, jaccolourcells;
+
+	/// The cells coupled to each cell by the Jacobian, see \ref cellNeighbourhoods
+	std::vector<a_int> jacnbhdptr, jacnbhd;
+
+	/// Assembles the Jacobian one column-block at a time from Jacobian-vector products
+	/** The products are taken with the states of all cells of one colour of 
+	 * \ref jaccolourcells perturbed in one variable. Cells of a colour are far enough apart
+	 * that each row of the product only sees one of them. For the exact Jacobian, the products
+	 * are computed by \ref compute_jacobian_vector_product. Otherwise, they are forward
+	 * differences of \ref compute_residual, with a step relative to the magnitude of each
+	 * perturbed state; this needs one residual per colour and variable, but works with any 
+	 * reconstruction. The blocks are added to the matrix, which must be preallocated for
+	 * \ref jacobian_stencil_radius. Periodic boundaries are not supported.
+	 */
+	StatusCode assembleColouredJacobian(const Vec u, Mat A) const;
+
+	/// Matrix storage that a Jacobian is assembled into directly, see \ref JacobianBlockLocations
+	struct JacobianAssembly
+	{
+		/// Cell-centred conserved variables that the Jacobian is computed at
+		const a_real *u;
+		/// Locations of the blocks in the array of values of the matrix
+		const JacobianBlockLocations *locs;
+		/// Array of values of the matrix
+		PetscScalar *vals;
+	};
+
+	struct DualStates;
+
+	/// Temporary storage needed for computing the residual
+	/** This is sized once from the mesh and reused, so that residual evaluations
+	 * do not allocate memory.
+	 */
+	struct ResidualWorkspace
+	{
+		/** \param fused Whether face values are only stored for boundary faces,
+		 *   see \ref fusedreconstruction
+		 */
+		ResidualWorkspace(const UMesh2dh *const mesh, const bool secondorder, const bool fused);
+		~ResidualWorkspace();
+
+		ResidualWorkspace(const ResidualWorkspace&) = delete;
+		ResidualWorkspace& operator=(const ResidualWorkspace&) = delete;
+
+		/// Integral of the spectral radius over the boundary of each cell
+		amat::Array2d<a_real> integ;
+		/// Ghost cell states, used for reconstruction
+		amat::Array2d<a_real> ug;
+		/// Left and right states at each face, or only at boundary faces for the first-order
+		/// scheme and for fused reconstruction
+		amat::Array2d<a_real> uleft, uright;
+		/// Limiter factors of each cell (only for fused reconstruction)
+		amat::Array2d<a_real> phi;
+		/// The limiter factors used by the current residual computation, either \ref phi or
+		/// those of a frozen reconstruction
+		const amat::Array2d<a_real> *limiters;
+		/// Cell-centred gradients of primitive variables (only for second order)
+		std::vector<FArray<NDIM,NVARS>, aligned_allocator<FArray<NDIM,NVARS>>> grads;
+		/// Cell-centred primitive variables
+		MVector up;
+		/// Quantities derived from the cell-centred variables, indexed by \ref CellDerivedVar
+		/** They are computed once per residual evaluation, so that faces need not recompute
+		 * them from the states of their neighbouring cells.
+		 */
+		amat::Array2d<a_real> cellderived;
+		/// States carrying a direction, created the first time the workspace is used to
+		/// compute a Jacobian-vector product
+		DualStates *dual;
+	};
+
+	/// Cell and boundary states carrying a direction, for \ref compute_jacobian_vector_product
+	/** The members have the same names as those of \ref ResidualWorkspace, so that the
+	 * computation of the states can be written once for both.
+	 */
+	struct DualStates
+	{
+		DualStates(const UMesh2dh *const mesh, const bool secondorder);
+
+		/// Cell-centred primitive variables
+		amat::Array2d<Dual> up;
+		/// Conserved variables on the left and right of boundary faces
+		amat::Array2d<Dual> uleft, uright;
+		/// Primitive variables in ghost cells (only for second order)
+		amat::Array2d<Dual> ug;
+		/// Cell-centred gradients of primitive variables (only for second order);
+		/// the derivative w.r.t. coordinate idim of variable ivar is in column idim*NVARS+ivar
+		amat::Array2d<Dual> grads;
+		/// Limiter factors of each cell (only for second order)
+		amat::Array2d<Dual> phi;
+		/// Value and derivative parts of the cell-centred and ghost primitive variables and
+		/// of their gradients, which the gradient schemes compute separately
+		/// (only for second order)
+		MVector upval, upder;
+		amat::Array2d<a_real> ugval, ugder;
+		std::vector<FArray<NDIM,NVARS>, aligned_allocator<FArray<NDIM,NVARS>>> gradval, gradder;
+	};
+
+	/// Data captured at a state by \ref freeze_reconstruction
+	/** The Jacobians are NVARS x NVARS row-major arrays, one row of the array per boundary face.
+	 */
+	struct FrozenFlowReconstruction : public FrozenReconstruction
+	{
+		FrozenFlowReconstruction(const UMesh2dh *const mesh, const bool secondorder);
+
+		/// Limiter factors of each cell (only for second order)
+		amat::Array2d<a_real> phi;
+		/// Conserved variables of the cells adjoining boundary faces
+		amat::Array2d<a_real> ucell;
+		/// Ghost cell states (conserved) and their Jacobians w.r.t. \ref ucell
+		/// (only for second order)
+		amat::Array2d<a_real> ug, dug;
+		/// Left (interior) conserved states at boundary faces
+		amat::Array2d<a_real> uleft;
+		/// Right (ghost) conserved states at boundary faces and their Jacobians w.r.t. \ref uleft
+		amat::Array2d<a_real> uright, duright;
+	};
+
+	/// Gets the flow data of a frozen reconstruction, or null if it was not created by
+	/// a discretization of this type
+	static const FrozenFlowReconstruction* getFrozenData(const FrozenReconstruction *const fr) {
+		return dynamic_cast<const FrozenFlowReconstruction*>(fr);
+	}
+
+	/// Columns of \ref ResidualWorkspace::cellderived
+	/** Pressure is not stored separately, it is the last primitive variable.
+	 * Temperature and viscosity are only computed for viscous flows.
+	 */
+	enum CellDerivedVar { CELL_SOUNDSPEED = 0, CELL_TEMPERATURE, CELL_VISCOSITY, NCELLDERIVED };
+
+	/// All residual workspaces created so far
+	/** There is one workspace for each caller that has computed the residual concurrently
+	 * with other callers.
+	 */
+	mutable std::vector<ResidualWorkspace*> workspaces;
+
+	/// Residual workspaces not currently in use
+	mutable std::vector<ResidualWorkspace*> freeworkspaces;
+
+	/// Gets a residual workspace that no other caller is using, creating one if needed
+	ResidualWorkspace* acquireWorkspace() const;
+
+	/// Returns a workspace obtained from \ref acquireWorkspace so that it can be reused
+	void releaseWorkspace(ResidualWorkspace *const ws) const;
+
+	/// Holds a workspace obtained from \ref acquireWorkspace for as long as it is in scope
+	/** The workspace is returned to the pool on every return path, including error returns.
+	 */
+	class WorkspaceGuard
+	{
+	public:
+		WorkspaceGuard(const FlowFV& flowfv) : fv(flowfv), ws(flowfv.acquireWorkspace()) { }
+		~WorkspaceGuard() { fv.releaseWorkspace(ws); }
+
+		WorkspaceGuard(const WorkspaceGuard&) = delete;
+		WorkspaceGuard& operator=(const WorkspaceGuard&) = delete;
+
+		ResidualWorkspace& operator*() const { return *ws; }
+		ResidualWorkspace* operator->() const { return ws; }
+
+	private:
+		const FlowFV& fv;
+		ResidualWorkspace *const ws;
+	};
+
 	/// Computes flow variables at all boundaries (either Gauss points or ghost cell centers) 
 	/// using the interior state provided
 	/** \param[in] instates provides the left (interior state) for each boundary face
@@ -273,8 +607,9 @@ protected:
 	 * Currently does not use characteristic BCs.
 	 * \todo Implement and test characteristic BCs
 	 */
-	void compute_boundary_states(const amat::Array2d<a_real>& instates, 
-			amat::Array2d<a_real>& bounstates) const;
+	template <typename scalar>
+	void compute_boundary_states(const amat::Array2d<scalar>& instates, 
+			amat::Array2d<scalar>& bounstates) const;
 
 	/// Computes ghost cell state across one face
 	/** \param[in] ied Face id in face data structure intfac
@@ -283,6 +618,33 @@ protected:
 	 */
 	void compute_boundary_state(const int ied, const a_real *const ins, a_real *const gs) const;
 
+	/// Computes ghost cell state across one face, along with its derivative in some direction
+	void compute_boundary_state(const int ied, const Dual *const ins, Dual *const gs) const;
+
+	/// Computes boundary states and their Jacobians w.r.t. the interior states
+	/** \param[in] instates Interior conserved state at each boundary face
+	 * \param[out] bounstates Ghost conserved state at each boundary face
+	 * \param[out] dbounstates Jacobian of each ghost state, NVARS x NVARS row-major per face
+	 */
+	void compute_boundary_states_and_jacobians(const amat::Array2d<a_real>& instates,
+			amat::Array2d<a_real>& bounstates, amat::Array2d<a_real>& dbounstates) const;
+
+	/// Computes boundary states from their linearisations about some interior states
+	/** \param[in] instates0 Interior states about which the boundary states are linearised
+	 * \param[in] bounstates0 Boundary states at instates0
+	 * \param[in] dbounstates0 Jacobians of the boundary states at instates0
+	 * \param[in] instates Interior states at which the boundary states are needed
+	 * \param[out] bounstates The linearised boundary states
+	 */
+	template <typename scalar>
+	void compute_linearised_boundary_states(const amat::Array2d<a_real>& instates0,
+			const amat::Array2d<a_real>& bounstates0, const amat::Array2d<a_real>& dbounstates0,
+			const amat::Array2d<scalar>& instates, amat::Array2d<scalar>& bounstates) const;
+
+	/// Computes ghost cell state across one face for either real or dual-number states
+	template <typename scalar>
+	void evaluateBoundaryState(const int ied, const scalar *const ins, scalar *const gs) const;
+
 	/// Computes the Jacobian of the ghost state w.r.t. the interior state
 	/** The output array dgs is zeroed first, so any previous content will be lost. 
 	 * \param[in] ied Face id in face data structure intfac
@@ -297,26 +659,278 @@ protected:
 	/// Computes viscous flux across a face
 	/** The output vflux still needs to be integrated on the face.
 	 * \param[in] iface Face index
-	 * \param[in] ucell_l Cell-centred conserved variables on left side of the face
-	 * \param[in] ucell_r Cell-centred conserved variables on right side of the face
-	 *             Note that for boundary faces, this can be NULL because ug is used instead.
-	 * \param[in] ug Ghost cell-centred conserved variables
-	 * \param[in] dudx Cell-centred gradients ("optional")
-	 * \param[in] dudy Cell-centred gradients ("optional", see below)
-	 * \param[in] ul Left state of faces (conserved variables)
-	 * \param[in] ul Right state of faces (conserved variables)
+	 * \param[in] ws The workspace of the current residual computation, from which the
+	 *   cell-centred primitive variables, derived quantities, ghost states and (for the
+	 *   second-order scheme) gradients are used
+	 * \param[in] ul Left state at the face (primitive variables; see \ref getFaceStates)
+	 * \param[in] ur Right state at the face (primitive variables)
 	 * \param[in,out] vflux On output, contains the viscous flux across the face
-	 *
-	 * Note that dudx and dudy can be unallocated if only first-order fluxes are being computed,
-	 * but ul and ur are always used.
-	 */
-	void computeViscousFlux(
-			const a_int iface, const a_real *const ucell_l, const a_real *const ucell_r,
-			const amat::Array2d<a_real>& ug,
-			const std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>>& grads,
-			const amat::Array2d<a_real>& ul, const amat::Array2d<a_real>& ur,
+	 */
+	void computeViscousFlux(const a_int iface, const ResidualWorkspace& ws,
+			const a_real *const ul, const a_real *const ur,
 			a_real *const vflux) const;
 
+	/// Computes viscous flux across a face for states carrying a direction
+	/** Same as the workspace version, with the cell-centred data taken from dual states.
+	 */
+	void computeViscousFlux(const a_int iface, const DualStates& ds,
+			const Dual *const ul, const Dual *const ur,
+			Dual *const vflux) const;
+
+	/// Computes viscous flux across a face from cell-centred primitive-2 variables
+	/** \param[in] iface Face index
+	 * \param[in] ucl Left cell-centred density, velocities and temperature
+	 * \param[in] ucr Right (possibly ghost) cell-centred density, velocities and temperature
+	 * \param[in] gradl Left cell-centred gradients of density, velocities and temperature;
+	 *   zero for the first-order scheme
+	 * \param[in] gradr Right cell-centred gradients
+	 * \param[in] muRe Viscosity coefficient at the face
+	 * \param[in] ul Left state at the face (primitive variables)
+	 * \param[in] ur Right state at the face (primitive variables)
+	 * \param[in,out] vflux On output, contains the viscous flux across the face
+	 */
+	template <typename scalar>
+	void computeViscousFlux(const a_int iface, const scalar *const ucl, const scalar *const ucr,
+			const scalar gradl[NDIM][NVARS], const scalar gradr[NDIM][NVARS], const scalar muRe,
+			const scalar *const ul, const scalar *const ur,
+			scalar *const vflux) const;
+
+	/// Computes the inviscid flux across a boundary face from the conserved states in a workspace
+	/** The boundary conditions give conserved states, so the flux is computed from them
+	 * rather than from the primitive states of \ref getFaceStates, which would only be
+	 * converted back.
+	 * \param[in] iface Boundary face index
+	 * \param[in] ws The workspace of the current residual computation
+	 * \param[out] flux The inviscid flux across the face, per unit length
+	 */
+	template <typename Flux>
+	void computeBoundaryInviscidFlux(const a_int iface, const ResidualWorkspace& ws,
+			a_real *const flux) const;
+
+	/// Computes the inviscid fluxes across a batch of faces through the batched flux kernel
+	/** The states of interior faces are packed into the structure-of-arrays layout of
+	 * \ref InviscidFlux::get_flux_batch_primitive, and their fluxes are unpacked from it.
+	 * Boundary faces are computed by \ref computeBoundaryInviscidFlux.
+	 * \param[in] nfaces Number of faces in the batch, at most FLUX_BATCH_SIZE
+	 * \param[in] faces Indices of the faces in the batch
+	 * \param[in] ws The workspace of the current residual computation
+	 * \param[in] ul Left states at the faces, as given by \ref getFaceStates
+	 * \param[in] ur Right states at the faces
+	 * \param[out] fluxes The inviscid flux across each face, per unit length
+	 *
+	 * The template parameter is the type of \ref inviflux; see \ref computeResidualWith.
+	 */
+	template <typename Flux>
+	void computeInviscidFluxBatch(const a_int nfaces, const a_int *const faces,
+			const ResidualWorkspace& ws,
+			const a_real (*const ul)[NVARS], const a_real (*const ur)[NVARS],
+			a_real (*const fluxes)[NVARS]) const;
+
+	/// Integrates the flux across a face over the face and adds the viscous flux, if any
+	/** The arguments are the same as those of \ref computeViscousFlux, except
+	 * \param[in,out] fluxes On input, the inviscid flux per unit length; on output, the total
+	 *   integrated flux from the left cell into the right cell
+	 */
+	void integrateFaceFlux(const a_int iface, const ResidualWorkspace& ws,
+			const a_real *const ul, const a_real *const ur,
+			a_real *const fluxes) const;
+
+	/// Gets the states on both sides of a face
+	/** With \ref fusedreconstruction, states at interior faces are reconstructed from the 
+	 * cell-centred primitive variables, gradients and limiter factors in the workspace;
+	 * otherwise, they are copied from the face values stored in the workspace.
+	 *
+	 * For the first-order scheme, interior face states are the cell-centred primitive
+	 * variables.
+	 *
+	 * The states are primitive variables - they are never converted to conserved variables,
+	 * except at boundary faces for the boundary conditions. The fluxes, viscous fluxes and
+	 * spectral radii then use them directly. At boundary faces, the conserved states are
+	 * converted here once, for the viscous flux and spectral radius; the inviscid flux uses
+	 * the conserved states, see \ref computeBoundaryInviscidFlux.
+	 * \param[in] iface Face index
+	 * \param[in] ws The workspace of the current residual computation
+	 * \param[out] ul Left state
+	 * \param[out] ur Right state
+	 */
+	void getFaceStates(const a_int iface, const ResidualWorkspace& ws,
+			a_real *const ul, a_real *const ur) const;
+
+	/// Gets the primitive states on both sides of a face from dual states
+	/** Face values are always reconstructed from the cell-centred data, see
+	 * \ref reconstructFaceValues.
+	 */
+	void getFaceStates(const a_int iface, const DualStates& ds,
+			Dual *const ul, Dual *const ur) const;
+
+	/// Computes the contribution of a face to the spectral radius of a cell adjacent to it
+	/** The maximum eigenvalue magnitude is integrated over the face; for viscous flows,
+	 * an estimate of the viscous eigenvalue is added.
+	 * \param[in] iface Face index
+	 * \param[in] ws The workspace of the current residual computation; for the first-order
+	 *   scheme, the face state is the cell's own, so its derived quantities are used
+	 * \param[in] uface State at the face on the side of the cell, as given by \ref getFaceStates
+	 * \param[in] ielem The (real, not ghost) cell for which the contribution is needed
+	 */
+	a_real computeFaceSpectralRadius(const a_int iface, const ResidualWorkspace& ws,
+			const a_real *const uface, const a_int ielem) const;
+
+	/// Assembles face fluxes into the residual by looping over faces one colour at a time
+	/** Inviscid fluxes of the faces of a colour are computed in batches, 
+	 * see \ref InviscidFlux::get_flux_batch_primitive.
+	 * \param[in,out] ws The workspace containing face values, or the data needed to
+	 *   reconstruct them (see \ref getFaceStates). If gettimesteps is true, the integral of
+	 *   the spectral radius over the boundary of each cell is added to ws.integ.
+	 * \param[in,out] residual The residual to add the fluxes to
+	 * \param[in] jac If not null, the Jacobian blocks of each face are also added to this
+	 */
+	template <typename Flux>
+	void assembleResidual_faceColoured(ResidualWorkspace& ws,
+			const bool gettimesteps, Eigen::Map<MVector>& residual,
+			const JacobianAssembly *const jac) const;
+
+	/// Assembles face fluxes into the residual by looping over cells and gathering from faces
+	/** Each interior face flux is computed twice, but each thread only writes to its own cells.
+	 * The faces of a block of consecutive cells are contiguous in the cell-to-face list, so
+	 * their inviscid fluxes are computed in batches as in \ref assembleResidual_faceColoured.
+	 * The arguments are the same as those of \ref assembleResidual_faceColoured.
+	 */
+	template <typename Flux>
+	void assembleResidual_cellGather(ResidualWorkspace& ws,
+			const bool gettimesteps, Eigen::Map<MVector>& residual) const;
+
+	/// Returns the workspace itself, as the states of a real-valued residual
+	ResidualWorkspace& getStates(ResidualWorkspace& ws, a_real) const { return ws; }
+
+	/// Returns the dual states of a workspace, creating them the first time
+	DualStates& getStates(ResidualWorkspace& ws, Dual) const;
+
+	/// Sets the cell-centred primitive variables, and the left states of boundary faces
+	/** The integrals of spectral radii are zeroed, and the derived quantities of each cell
+	 * are computed, as well.
+	 * \param[in] u Cell-centred conserved variables
+	 * \param[in] x Not used
+	 * \param[in,out] ws The workspace of the current residual computation
+	 */
+	void setCellStates(const a_real *const u, const a_real *const x, ResidualWorkspace& ws) const;
+
+	/// Sets the cell-centred primitive states u + e x, and the left states of boundary faces
+	void setCellStates(const a_real *const u, const a_real *const x, DualStates& ds) const;
+
+	/// Computes the cell-centred gradients of the primitive variables
+	template <typename Gradient>
+	void computeGradients(ResidualWorkspace& ws) const;
+
+	/// Computes the gradients of dual states from their value and derivative parts separately
+	template <typename Gradient>
+	void computeGradients(DualStates& ds) const;
+
+	/// Computes the limiter factors or face values, and the left states of boundary faces
+	/** With \ref fusedreconstruction, only the limiter factors are computed, from which
+	 * face values at interior faces are computed by \ref getFaceStates. Otherwise, face values
+	 * are computed at all faces. Boundary faces' left states are then converted to conserved
+	 * variables for the boundary conditions.
+	 * \param[in,out] ws The workspace, containing the cell-centred and ghost primitive
+	 *   variables and the gradients
+	 * \param[in] fr If not null, the limiter factors of this are used instead of being
+	 *   computed, see \ref ResidualWorkspace::limiters
+	 */
+	template <typename Limiter>
+	void reconstructFaceValues(ResidualWorkspace& ws,
+			const FrozenFlowReconstruction *const fr) const;
+
+	/// Computes the limiter factors of dual states and the left states of boundary faces
+	/** Interior face values of dual states are always computed by \ref getFaceStates.
+	 */
+	template <typename Limiter>
+	void reconstructFaceValues(DualStates& ds,
+			const FrozenFlowReconstruction *const fr) const;
+
+	/// Extrapolates the left states of boundary faces from their cells using limiter factors
+	/** The states are converted to conserved variables for the boundary conditions.
+	 */
+	template <typename scalar, typename States>
+	void extrapolateToBoundaryFaces(const amat::Array2d<scalar>& phi, States& st) const;
+
+	/// Assembles face fluxes into the residual by the loop selected by \ref usecellgather
+	/** The arguments are the same as those of \ref assembleResidual_faceColoured.
+	 */
+	template <typename Flux>
+	void assembleResidual(ResidualWorkspace& ws,
+			const bool gettimesteps, Eigen::Map<MVector>& residual,
+			const JacobianAssembly *const jac) const;
+
+	/// Adds the derivative part of the face fluxes of dual states to the residual
+	/** Faces are looped over one colour at a time. Time steps and the Jacobian
+	 * are not computed, so gettimesteps must be false and jac null.
+	 */
+	template <typename Flux>
+	void assembleResidual(DualStates& ds,
+			const bool gettimesteps, Eigen::Map<MVector>& residual,
+			const JacobianAssembly *const jac) const;
+
+	/// Computes the residual, calling the numerical schemes through the given types
+	/** The template parameters Flux, Gradient and Limiter are the types of \ref inviflux,
+	 * \ref gradcomp and \ref lim.
+	 * If they are the abstract base classes, the schemes are called through virtual functions.
+	 * If they are the concrete (final) classes of the schemes actually in use, the calls
+	 * are resolved at compile time and can be inlined into the loops over faces.
+	 *
+	 * If scalar is \ref Dual, the residual is evaluated at the states u + e x and only its
+	 * derivative part, the Jacobian-vector product, is added to the output residual; see
+	 * \ref compute_jacobian_vector_product. The states are then kept in
+	 * \ref ResidualWorkspace::dual. Only the abstract base classes of the schemes are
+	 * supported in this case, as only they provide the dual-number kernels.
+	 *
+	 * The arguments are the same as those of \ref compute_residual_and_jacobian, except
+	 * \param x The direction of the dual states; not used, and can be null, for real states
+	 * \param A If not null, the Jacobian is computed into this matrix as well
+	 * \param fr If not null, the limiter factors and boundary states are computed from this
+	 *   instead of from u, see \ref compute_frozen_residual
+	 */
+	template <typename scalar, typename Flux, typename Gradient, typename Limiter>
+	StatusCode computeResidualWith(const Vec u, const Vec x, Vec residual, 
+			const bool gettimesteps, std::vector<a_real>& dtm, Mat A,
+			const FrozenFlowReconstruction *const fr) const;
+
+	/// Computes the contribution of a boundary face to the Jacobian
+	/** \param[in] iface Boundary face index
+	 * \param[in] uarr Cell-centred conserved variables of all cells
+	 * \param[out] dblock The contribution to the diagonal block of the face's cell,
+	 *   NVARS x NVARS stored as a 1D row-major array
+	 */
+	void computeBoundaryFaceJacobian(const a_int iface, const a_real *const uarr,
+			a_real *const __restrict dblock) const;
+
+	/// Computes the off-diagonal Jacobian blocks of an interior face
+	/** The negatives of L and U are the face's contributions to the diagonal blocks of the left
+	 * and right cells respectively.
+	 * \param[in] iface Interior face index
+	 * \param[in] uarr Cell-centred conserved variables of all cells
+	 * \param[out] L The block in the right cell's row and left cell's column, row-major
+	 * \param[out] U The block in the left cell's row and right cell's column, row-major
+	 * \param[out] flux If not null, the inviscid flux computed along with the Jacobian by
+	 *   \ref InviscidFlux::get_flux_jacobian, not integrated over the face. This is the flux of
+	 *   the first-order residual only if \ref jacobianfluxsameasresidual.
+	 * \tparam Flux The type of \ref jflux, if known, so that its functions are called directly
+	 *   instead of through the virtual interface
+	 */
+	template <typename Flux = InviscidFlux>
+	void computeInteriorFaceJacobian(const a_int iface, const a_real *const uarr,
+			a_real *const __restrict L, a_real *const __restrict U,
+			a_real *const __restrict flux = nullptr) const;
+
+	/// Adds the Jacobian blocks of a face to the matrix storage
+	/** \param jac The matrix storage
+	 * \param iface The face
+	 * \param L For a boundary face, the contribution to the diagonal block as given by
+	 *   \ref computeBoundaryFaceJacobian; otherwise, the lower block as given by
+	 *   \ref computeInteriorFaceJacobian
+	 * \param U The upper block of an interior face; not used for boundary faces
+	 */
+	void addFaceJacobian(const JacobianAssembly& jac, const a_int iface,
+			const a_real *const L, const a_real *const U) const;
+
 	/// Compues the first-order "thin-layer" viscous flux Jacobian
 	/** This is the same sign as is needed in the residual; note that the viscous flux Jacobian is
 	 * added to the output matrices - they are not zeroed or directly assigned to.
@@ -341,6 +955,54 @@ protected:
 			a_real *const __restrict vfluxi, a_real *const __restrict vfluxj) const;
 };
 
+/// Flow solver whose residual calls the numerical schemes without virtual dispatch
+/** The inviscid flux, gradient scheme and reconstruction named in the numerics configuration
+ * must be of the types given as template parameters; 
+ * use \ref create_mutable_flowSpatialDiscretization to get the right instantiation.
+ * Everything other than the residual is inherited from \ref FlowFV.
+ */
+template <
+	bool secondOrderRequested,
+	bool constVisc,
+	typename Flux,                  ///< Type of the inviscid numerical flux
+	typename Gradient,              ///< Type of the gradient scheme
+	typename Limiter                ///< Type of the solution reconstruction
+>
+class FlowFVStatic : public FlowFV<secondOrderRequested,constVisc>
+{
+public:
+	/// Sets data and initializes the numerics \sa FlowFV::FlowFV
+	FlowFVStatic(const UMesh2dh *const mesh,
+		const FlowPhysicsConfig& pconfiguration,
+		const FlowNumericsConfig& nconfiguration
+	);
+
+	/// Computes the residual using the concrete scheme types \sa FlowFV::compute_residual
+	StatusCode compute_residual(const Vec u, Vec residual, 
+			const bool gettimesteps, std::vector<a_real>& dtm) const;
+
+	/// Computes the residual using the concrete scheme types, and the Jacobian
+	/** \sa FlowFV::compute_residual_and_jacobian
+	 */
+	StatusCode compute_residual_and_jacobian(const Vec u, Vec residual, 
+			const bool gettimesteps, std::vector<a_real>& dtm, Mat A) const;
+
+	/// Computes the frozen residual using the concrete scheme types
+	/** \sa FlowFV::compute_frozen_residual
+	 */
+	StatusCode compute_frozen_residual(const Vec u,
+			const Spatial<NVARS>::FrozenReconstruction *const fr, Vec residual) const;
+};
+
+/// Creates a flow solver that calls the numerical schemes named in nconf without virtual dispatch
+/** Returns nullptr if that combination of schemes was not compiled; 
+ * the combinations compiled are controlled by STATIC_DISPATCH in the top-level CMakeLists.txt.
+ */
+template <bool secondOrderRequested, bool constVisc>
+Spatial<NVARS>* create_static_flowfv(const UMesh2dh *const m,
+	const FlowPhysicsConfig& pconf,
+	const FlowNumericsConfig& nconf);
+
 /// Spatial discretization of diffusion operator with constant difusivity
 template <int nvars>
 class Diffusion : public Spatial<nvars>
@@ -180,7 +180,7 @@ const FlowParserOptions parse_flow_controlfile(const int argc, const char *const
 	control >> dum; control >> opts.firstrampstart >> opts.firstrampend;
 	control >> dum; control >> opts.firsttolerance;
 	control >> dum; control >> opts.firstmaxiter;
-	if(opts.timesteptype == "IMPLICIT") {
+	if(opts.timesteptype == "IMPLICIT" || opts.timesteptype == "MULTIGRID") {
 		control >> dum;
 		control >> dum; control >> opts.invfluxjac;
 	}
@@ -193,6 +193,22 @@ const FlowParserOptions parse_flow_controlfile(const int argc, const char *const
 	if(set)
 		opts.logfile = petsclogfile;
 
+	char resengine[200];
+	set = PETSC_FALSE;
+	PetscOptionsGetString(NULL, NULL, "-residual_engine", resengine, 200, &set);
+	if(set)
+		opts.residual_engine = resengine;
+	else
+		opts.residual_engine = "FACECOLOURING";
+
+	char jacassembly[200];
+	set = PETSC_FALSE;
+	PetscOptionsGetString(NULL, NULL, "-jacobian_assembly", jacassembly, 200, &set);
+	if(set)
+		opts.jacobian_assembly = jacassembly;
+	else
+		opts.jacobian_assembly = "APPROXIMATE";
+
 	return opts;
 }
 
@@ -212,7 +228,8 @@ FlowPhysicsConfig extract_spatial_physics_config(const FlowParserOptions& opts)
 FlowNumericsConfig extract_spatial_numerics_config(const FlowParserOptions& opts)
 {
 	const FlowNumericsConfig nconf {opts.invflux, opts.invfluxjac, 
-		opts.gradientmethod, opts.limiter, opts.order2};
+		opts.gradientmethod, opts.limiter, opts.order2, opts.residual_engine,
+		opts.jacobian_assembly};
 	return nconf;
 }
 
@@ -29,11 +29,13 @@ struct FlowParserOptions
 		init_soln_file,                    ///< File to read initial solution from (not implemented)
 		invflux, invfluxjac,               ///< Inviscid numerical flux
 		gradientmethod, limiter,           ///< Reconstruction type
-		timesteptype,                      ///< Explicit or implicit time stepping
+		timesteptype,                      ///< Explicit, implicit or multigrid time stepping
 		constvisc,                         ///< NO for Sutherland viscosity
 		surfnameprefix, volnameprefix,     ///< Filename prefixes for output files
-		vol_output_reqd;                   ///< Whether volume output is required in a text file
+		vol_output_reqd,                   ///< Whether volume output is required in a text file
 		                                   ///<  in addition to the main VTU output
+		residual_engine,                   ///< How fluxes are assembled into the residual
+		jacobian_assembly;                 ///< How the Jacobian matrix is computed
 	
 	a_real initcfl, endcfl,                     ///< Starting CFL number and max CFL number
 		tolerance,                              ///< Relative tolerance for the whole nonlinear problem
@@ -13,6 +13,8 @@
 
 #ifdef USE_BLASTED
 #include <blasted_petsc.h>
+#else
+#include "ashellpc.hpp"
 #endif
 
 using namespace amat;
@@ -48,7 +50,8 @@ int main(int argc, char *argv[])
 	// numerics for main solver
 	const FlowNumericsConfig nconfmain = extract_spatial_numerics_config(opts);
 	// simpler numerics for startup
-	const FlowNumericsConfig nconfstart {opts.invflux, opts.invfluxjac, "NONE", "NONE", false};
+	const FlowNumericsConfig nconfstart {opts.invflux, opts.invfluxjac, "NONE", "NONE", false,
+		opts.residual_engine};
 
 	std::cout << "Setting up main spatial scheme.\n";
 	const Spatial<NVARS> *const prob = create_const_flowSpatialDiscretization(&m, pconf, nconfmain);
@@ -60,8 +63,9 @@ int main(int argc, char *argv[])
 	std::cout << "\n***\n";
 
 	/* NOTE: Since the "startup" solver (meant to generate an initial solution) and the "main" solver
-	 * have the same number of unknowns and use first-order Jacobians, we have just one set of
-	 * solution vector, Jacobian matrix, preconditioning matrix and KSP solver.
+	 * have the same number of unknowns, we have just one set of solution vector, Jacobian matrix,
+	 * preconditioning matrix and KSP solver. The matrix is preallocated for the Jacobian of the
+	 * main solver, whose stencil contains that of the startup solver.
 	 */
 
 	// solution vector
@@ -69,16 +73,27 @@ int main(int argc, char *argv[])
 
 	// Initialize Jacobian for implicit schemes
 	Mat M;
-	ierr = setupSystemMatrix<NVARS>(&m, &M); CHKERRQ(ierr);
+	ierr = setupSystemMatrix<NVARS>(&m, &M, prob->jacobian_stencil_radius()); CHKERRQ(ierr);
 	ierr = MatCreateVecs(M, &u, NULL); CHKERRQ(ierr);
 
-	// setup matrix-free Jacobian if requested
+	/* Setup matrix-free Jacobian if requested. The matrix M is then only used to build the 
+	 * preconditioner; it is the Jacobian computed as selected by -jacobian_assembly, so the
+	 * finite-difference Jacobian of the second-order residual gives a better preconditioner
+	 * than the default first-order Jacobian.
+	 * EXACT and DIFFERENCE assembly colour the cells at twice the stencil radius of the
+	 * Jacobian and need one residual evaluation per colour and variable. With WENO the
+	 * radius is 3, so the colouring is at distance 6; this needs many more colours, and so
+	 * residual evaluations, than the radius 2 of the cell limiters.
+	 */
 	Mat A;
 	MatrixFreeSpatialJacobian<NVARS> mfjac;
 	PetscBool mf_flg = PETSC_FALSE;
 	ierr = PetscOptionsHasName(NULL, NULL, "-matrix_free_jacobian", &mf_flg); CHKERRQ(ierr);
 	if(mf_flg) {
 		std::cout << " Allocating matrix-free Jac\n";
+		std::cout << " Preconditioning matrix: "
+			<< (opts.jacobian_assembly.empty() ? "APPROXIMATE" : opts.jacobian_assembly)
+			<< " Jacobian\n";
 		ierr = setup_matrixfree_jacobian<NVARS>(&m, &mfjac, &A); 
 		CHKERRQ(ierr);
 	}
@@ -137,6 +152,15 @@ int main(int argc, char *argv[])
 	if(opts.timesteptype == "IMPLICIT") {
 		ierr = setup_blasted<NVARS>(ksp,u,startprob,bctx); CHKERRQ(ierr);
 	}
+#else
+	// otherwise, shell preconditioners are native block preconditioners
+	NativeShellPreconditioner<NVARS> *nativepc = nullptr;
+	if(opts.timesteptype == "IMPLICIT") {
+		BlockSolverConfig bconf;
+		ierr = getBlockSolverConfig(ksp, &bconf); CHKERRQ(ierr);
+		nativepc = new NativeShellPreconditioner<NVARS>(&m, bconf);
+		ierr = setup_native_shellpc<NVARS>(ksp,u,startprob,*nativepc); CHKERRQ(ierr);
+	}
 #endif
 
 	std::cout << "\n***\n";
@@ -169,6 +193,16 @@ int main(int argc, char *argv[])
 	if(opts.timesteptype == "IMPLICIT") {
 		ierr = setup_blasted<NVARS>(ksp,u,startprob,bctx); CHKERRQ(ierr);
 	}
+#else
+	// the old preconditioner can only be deleted once the solver using it is destroyed
+	delete nativepc;
+	nativepc = nullptr;
+	if(opts.timesteptype == "IMPLICIT") {
+		BlockSolverConfig bconf;
+		ierr = getBlockSolverConfig(ksp, &bconf); CHKERRQ(ierr);
+		nativepc = new NativeShellPreconditioner<NVARS>(&m, bconf);
+		ierr = setup_native_shellpc<NVARS>(ksp,u,startprob,*nativepc); CHKERRQ(ierr);
+	}
 #endif
 
 	// setup nonlinear ODE solver for main solve - MUST be done AFTER KSPCreate
@@ -177,6 +211,11 @@ int main(int argc, char *argv[])
 		time = new SteadyBackwardEulerSolver<4>(prob, maintconf, ksp);
 		std::cout << "\nSet up backward Euler temporal scheme for main solve.\n";
 	}
+	else if(opts.timesteptype == "MULTIGRID")
+	{
+		time = new SteadyMultigridSolver<4>(prob, u, maintconf, opts.periodic_marker);
+		std::cout << "\nSet up agglomeration multigrid for main solve.\n";
+	}
 	else
 	{
 		time = new SteadyForwardEulerSolver<4>(prob, u, maintconf);
@@ -187,12 +226,21 @@ int main(int argc, char *argv[])
 
 	// Solve the main problem
 	ierr = time->solve(u); CHKERRQ(ierr);
+#ifndef USE_BLASTED
+	if(nativepc)
+		std::cout << " Native shell preconditioner: set-up wall time = " << nativepc->factorwalltime
+			<< ", application wall time = " << nativepc->applywalltime << ", storage = "
+			<< nativepc->storageBytes()/1048576.0 << " MiB" << std::endl;
+#endif
 
 	std::cout << "***\n";
 
 	delete starttime;
 	delete time;
 	ierr = KSPDestroy(&ksp); CHKERRQ(ierr);
+#ifndef USE_BLASTED
+	delete nativepc;
+#endif
 	ierr = MatDestroy(&M); CHKERRQ(ierr);
 	if(mf_flg) {
 		ierr = MatDestroy(&A); 
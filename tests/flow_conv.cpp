@@ -1,6 +1,7 @@
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <algorithm>
 #include <omp.h>
 #include <petscksp.h>
 
@@ -70,6 +71,15 @@ int main(int argc, char *argv[])
 		opts.firsttolerance, opts.firstmaxiter,
 	};
 
+	/* Jacobian lagging, linear forcing terms and matrix-free Jacobians, if requested,
+	 * are checked on every mesh
+	 */
+	PetscInt jacobianlag = 1;
+	ierr = PetscOptionsGetInt(NULL, NULL, "-jacobian_lag", &jacobianlag, &set); CHKERRQ(ierr);
+	PetscBool forcingterm = PETSC_FALSE;
+	ierr = PetscOptionsHasName(NULL, NULL, "-linear_forcing_term", &forcingterm); CHKERRQ(ierr);
+	bool solverpassed = true;
+
 	std::vector<double> lh(nmesh), lerrors(nmesh), slopes(nmesh-1);
 
 	for(int imesh = 0; imesh < nmesh; imesh++) {
@@ -210,6 +220,27 @@ int main(int argc, char *argv[])
 		// Solve the main problem
 		ierr = time->solve(u); CHKERRQ(ierr);
 
+		if(opts.timesteptype == "IMPLICIT" && (jacobianlag > 1 || forcingterm || mf_flg))
+		{
+			const TimingData tdata = time->getTimingData();
+			if(!tdata.converged)
+				solverpassed = false;
+			if(jacobianlag > 1) {
+				std::cout << " Jacobian assembled in " << tdata.num_jacobian_evals << " of "
+					<< tdata.num_timesteps << " time steps" << std::endl;
+				if(tdata.num_jacobian_evals >= tdata.num_timesteps)
+					solverpassed = false;
+			}
+			if(forcingterm) {
+				const auto rtolrange = std::minmax_element(tdata.lin_rtols.begin(),
+						tdata.lin_rtols.end());
+				std::cout << " Linear relative tolerances between " << *rtolrange.first << " and "
+					<< *rtolrange.second << std::endl;
+				if(!(*rtolrange.first < *rtolrange.second))
+					solverpassed = false;
+			}
+		}
+
 		std::cout << "***\n";
 		
 		a_real err;
@@ -267,6 +298,11 @@ int main(int argc, char *argv[])
 			passed = 1;
 	}
 
+	if(!solverpassed) {
+		std::cout << " The nonlinear solver did not behave as expected!\n";
+		passed = 0;
+	}
+
 	std::cout << '\n';
 	ierr = PetscFinalize(); CHKERRQ(ierr);
 	std::cout << "\n--------------- End --------------------- \n\n";
@@ -1,15 +1,1534 @@
 #include <string>
 #include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <typeinfo>
+#include <chrono>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "../src/autilities.hpp"
+#include "../src/afactory.hpp"
+#include "../src/alinalg.hpp"
+#include "../src/ameshutils.hpp"
+#include "../src/akrylov.hpp"
+#include "../src/ashellpc.hpp"
 #include "testflowspatial.hpp"
+#include "test.hpp"
 
 using namespace acfd;
 
+/// Sets the isothermal wall temperature to the free-stream temperature
+/** The wall temperature in the control file is not non-dimensional.
+ */
+void set_freestream_wall_temperature(FlowPhysicsConfig& pconf)
+{
+	const IdealGasPhysics phy(pconf.gamma, pconf.Minf, pconf.Tinf, pconf.Reinf, pconf.Pr);
+	const std::array<a_real,NVARS> uinf = phy.compute_freestream_state(pconf.aoa);
+	pconf.isothermalwall_temp = phy.getTemperatureFromConserved(&uinf[0]);
+}
+
+/// Creates a state vector perturbed smoothly from the free-stream state of a discretization
+/** Neighbouring cells have different states, so that all face fluxes and Jacobians contribute.
+ * \param[out] u The new vector, which the caller must destroy
+ */
+int create_perturbed_state(const UMesh2dh& m, const Spatial<NVARS>& fv, Vec *const u)
+{
+	const a_int n = m.gnelem()*NVARS;
+	int ierr = VecCreateSeq(PETSC_COMM_SELF, n, u); CHKERRQ(ierr);
+	ierr = fv.initializeUnknowns(*u); CHKERRQ(ierr);
+	PetscScalar *uarr;
+	ierr = VecGetArray(*u, &uarr); CHKERRQ(ierr);
+	for(a_int i = 0; i < n; i++)
+		uarr[i] *= 1.0 + 0.05*std::sin(0.37*i);
+	ierr = VecRestoreArray(*u, &uarr); CHKERRQ(ierr);
+	return ierr;
+}
+
+/// Sets a direction for Jacobian-vector products, of the same scale as the state u
+int set_test_direction(const Vec u, Vec x)
+{
+	PetscInt n;
+	int ierr = VecGetLocalSize(u, &n); CHKERRQ(ierr);
+	const PetscScalar *uarr;
+	PetscScalar *xarr;
+	ierr = VecGetArrayRead(u, &uarr); CHKERRQ(ierr);
+	ierr = VecGetArray(x, &xarr); CHKERRQ(ierr);
+	for(a_int i = 0; i < n; i++)
+		xarr[i] = uarr[i]*std::cos(0.23*i);
+	ierr = VecRestoreArrayRead(u, &uarr); CHKERRQ(ierr);
+	ierr = VecRestoreArray(x, &xarr); CHKERRQ(ierr);
+	return ierr;
+}
+
+/// Runs a check on a flow discretization of the order given by nconf.order2
+/** \param check Called with the discretization and nconf, returning non-zero on failure
+ */
+template <typename Check>
+int check_flowfv(const UMesh2dh& m, const FlowPhysicsConfig& pconf,
+		const FlowNumericsConfig& nconf, const Check& check)
+{
+	if(nconf.order2) {
+		const FlowFV<true,false> fv(&m, pconf, nconf);
+		return check(fv, nconf);
+	}
+	const FlowFV<false,false> fv(&m, pconf, nconf);
+	return check(fv, nconf);
+}
+
+/// Runs a check on a first-order flow discretization, then on second-order ones with each of
+/// the given limiters
+template <typename Check>
+int check_flowfv_orders(const UMesh2dh& m, const FlowPhysicsConfig& pconf,
+		FlowNumericsConfig nconf, const std::vector<std::string>& limiters, const Check& check)
+{
+	nconf.order2 = false;
+	nconf.reconstruction = "NONE";
+	int err = check_flowfv(m, pconf, nconf, check);
+	if(err) return err;
+
+	nconf.order2 = true;
+	for(const std::string& limiter : limiters)
+	{
+		nconf.reconstruction = limiter;
+		err = check_flowfv(m, pconf, nconf, check);
+		if(err) return err;
+	}
+	return 0;
+}
+
+/// Checks that batched numerical fluxes agree with fluxes computed one face at a time
+/** The states in the batch cover subsonic and supersonic flow in both directions across faces
+ * with various orientations, so that all branches of the flux schemes are exercised. The faces
+ * are split into batches of FLUX_BATCH_SIZE, the last of which is only partly filled.
+ * Batches of primitive states are also checked, as are fluxes computed together with their
+ * Jacobians.
+ */
+int test_flux_batch(const FlowPhysicsConfig& pconf)
+{
+	const IdealGasPhysics phy(pconf.gamma, pconf.Minf, pconf.Tinf, pconf.Reinf, pconf.Pr);
+	const a_int nfaces = 2*FLUX_BATCH_SIZE+5;
+	const a_int nbatches = (nfaces + FLUX_BATCH_SIZE-1)/FLUX_BATCH_SIZE;
+
+	// index of a component of a face's vector in the batched storage
+	const auto bidx = [](const int ncomp, const int icomp, const a_int i) {
+		return (i/FLUX_BATCH_SIZE)*ncomp*FLUX_BATCH_SIZE + icomp*FLUX_BATCH_SIZE + i%FLUX_BATCH_SIZE;
+	};
+
+	const a_int nvb = NVARS*FLUX_BATCH_SIZE*nbatches, ndb = NDIM*FLUX_BATCH_SIZE*nbatches;
+	std::vector<a_real> ulb(nvb), urb(nvb), nb(ndb), fluxb(nvb), wlb(nvb), wrb(nvb), fluxpb(nvb);
+	for(a_int i = 0; i < nfaces; i++)
+	{
+		const a_real angle = 0.7*i;
+		nb[bidx(NDIM,0,i)] = std::cos(angle); nb[bidx(NDIM,1,i)] = std::sin(angle);
+
+		// normal Mach numbers range from about -3 to 3
+		const a_real rhol = 1.0 + 0.1*std::sin(1.3*i), rhor = 1.0 + 0.1*std::cos(0.9*i);
+		const a_real pl = 1.0/(pconf.gamma*0.9), pr = 1.0/(pconf.gamma*1.1);
+		const a_real vl[NDIM] = {3.0*std::sin(0.37*i), 0.5*std::cos(1.1*i)};
+		const a_real vr[NDIM] = {3.0*std::sin(0.37*i+0.2), 0.5*std::cos(1.1*i+0.3)};
+		const a_real upl[NVARS] = {rhol, vl[0], vl[1], pl}, upr[NVARS] = {rhor, vr[0], vr[1], pr};
+		a_real ucl[NVARS], ucr[NVARS];
+		phy.getConservedFromPrimitive(upl, ucl);
+		phy.getConservedFromPrimitive(upr, ucr);
+		for(int ivar = 0; ivar < NVARS; ivar++) {
+			ulb[bidx(NVARS,ivar,i)] = ucl[ivar];
+			urb[bidx(NVARS,ivar,i)] = ucr[ivar];
+			wlb[bidx(NVARS,ivar,i)] = upl[ivar];
+			wrb[bidx(NVARS,ivar,i)] = upr[ivar];
+		}
+	}
+
+	for(std::string fluxname : {"LLF", "VANLEER", "AUSM", "AUSMPLUS", "ROE", "HLL", "HLLC"})
+	{
+		const InviscidFlux *const flux = create_const_inviscidflux(fluxname, &phy);
+		const bool hasjacobian = fluxname != "VANLEER" && fluxname != "AUSMPLUS";
+		for(a_int ib = 0; ib < nbatches; ib++)
+		{
+			const a_int nbf = std::min(FLUX_BATCH_SIZE, nfaces-ib*FLUX_BATCH_SIZE);
+			const a_int vs = ib*NVARS*FLUX_BATCH_SIZE, ds = ib*NDIM*FLUX_BATCH_SIZE;
+			flux->get_flux_batch(nbf, &ulb[vs], &urb[vs], &nb[ds], &fluxb[vs]);
+			flux->get_flux_batch_primitive(nbf, &wlb[vs], &wrb[vs], &nb[ds], &fluxpb[vs]);
+		}
+
+		a_real maxdiff = 0, maxdiffprim = 0, maxdiffjac = 0;
+		for(a_int i = 0; i < nfaces; i++)
+		{
+			a_real ul[NVARS], ur[NVARS], n[NDIM], f[NVARS];
+			for(int ivar = 0; ivar < NVARS; ivar++) {
+				ul[ivar] = ulb[bidx(NVARS,ivar,i)];
+				ur[ivar] = urb[bidx(NVARS,ivar,i)];
+			}
+			for(int idim = 0; idim < NDIM; idim++)
+				n[idim] = nb[bidx(NDIM,idim,i)];
+
+			flux->get_flux(ul, ur, n, f);
+			for(int ivar = 0; ivar < NVARS; ivar++) {
+				const a_real fb = fluxb[bidx(NVARS,ivar,i)], fpb = fluxpb[bidx(NVARS,ivar,i)];
+				const a_real diff = std::fabs(f[ivar]-fb)/(1.0+std::fabs(f[ivar]));
+				maxdiff = std::max(maxdiff, diff);
+				const a_real diffp = std::fabs(f[ivar]-fpb)/(1.0+std::fabs(f[ivar]));
+				maxdiffprim = std::max(maxdiffprim, diffp);
+			}
+
+			if(!hasjacobian)
+				continue;
+			a_real fj[NVARS], dfdl[NVARS*NVARS], dfdr[NVARS*NVARS], 
+			       dfdlj[NVARS*NVARS], dfdrj[NVARS*NVARS];
+			flux->get_jacobian(ul, ur, n, dfdl, dfdr);
+			flux->get_flux_jacobian(ul, ur, n, fj, dfdlj, dfdrj);
+			for(int ivar = 0; ivar < NVARS; ivar++)
+				maxdiffjac = std::max(maxdiffjac, std::fabs(f[ivar]-fj[ivar])/(1.0+std::fabs(f[ivar])));
+			for(int k = 0; k < NVARS*NVARS; k++) {
+				maxdiffjac = std::max(maxdiffjac, std::fabs(dfdl[k]-dfdlj[k])/(1.0+std::fabs(dfdl[k])));
+				maxdiffjac = std::max(maxdiffjac, std::fabs(dfdr[k]-dfdrj[k])/(1.0+std::fabs(dfdr[k])));
+			}
+		}
+		delete flux;
+
+		std::cout << " " << fluxname << ": max relative difference " << maxdiff 
+			<< ", from primitive states " << maxdiffprim 
+			<< ", with Jacobians " << maxdiffjac << std::endl;
+		TASSERT(maxdiff < 1e-13);
+		TASSERT(maxdiffprim < 1e-13);
+		TASSERT(maxdiffjac < 1e-13);
+	}
+	return 0;
+}
+
+/// Checks that the face-colouring and cell-gather residual engines give the same results
+/** The state is a perturbed free-stream state, so that all face fluxes contribute.
+ */
+int test_residual_engines(const UMesh2dh& m, FlowPhysicsConfig pconf,
+		FlowNumericsConfig nconf)
+{
+	set_freestream_wall_temperature(pconf);
+
+	nconf.residual_engine = "FACECOLOURING";
+	const TestFlowFV facefv(&m, pconf, nconf);
+	nconf.residual_engine = "CELLGATHER";
+	const TestFlowFV cellfv(&m, pconf, nconf);
+
+	Vec u, rface, rcell;
+	int ierr = create_perturbed_state(m, facefv, &u); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &rface); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &rcell); CHKERRQ(ierr);
+
+	ierr = VecSet(rface, 0.0); CHKERRQ(ierr);
+	ierr = VecSet(rcell, 0.0); CHKERRQ(ierr);
+	std::vector<a_real> dtface(m.gnelem()), dtcell(m.gnelem());
+	ierr = facefv.compute_residual(u, rface, true, dtface); CHKERRQ(ierr);
+	ierr = cellfv.compute_residual(u, rcell, true, dtcell); CHKERRQ(ierr);
+
+	const PetscScalar *rfarr, *rcarr;
+	ierr = VecGetArrayRead(rface, &rfarr); CHKERRQ(ierr);
+	ierr = VecGetArrayRead(rcell, &rcarr); CHKERRQ(ierr);
+	a_real rmax = 0, rdiff = 0;
+	for(a_int i = 0; i < m.gnelem()*NVARS; i++) {
+		TASSERT(std::isfinite(rfarr[i]));
+		rmax = std::max(rmax, std::fabs(rfarr[i]));
+		rdiff = std::max(rdiff, std::fabs(rfarr[i]-rcarr[i]));
+	}
+	ierr = VecRestoreArrayRead(rface, &rfarr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(rcell, &rcarr); CHKERRQ(ierr);
+
+	std::cout << " Max residual " << rmax << ", max difference " << rdiff << std::endl;
+	TASSERT(rmax > 0);
+	TASSERT(rdiff <= 1e-12*rmax);
+
+	for(a_int iel = 0; iel < m.gnelem(); iel++)
+		TASSERT(std::fabs(dtface[iel]-dtcell[iel]) <= 1e-12*dtface[iel]);
+
+	ierr = VecDestroy(&u); CHKERRQ(ierr);
+	ierr = VecDestroy(&rface); CHKERRQ(ierr);
+	ierr = VecDestroy(&rcell); CHKERRQ(ierr);
+	return 0;
+}
+
+/// Checks agglomerated meshes and the residual computed on them
+/** Each level must cover the finer one with cells of the same total area, coarsen it by a
+ * reasonable factor and have closed cells. On the finest level, which has the cells of the mesh,
+ * the residual, time steps and diagonal Jacobian blocks must agree with those of the
+ * first-order inviscid discretization.
+ */
+int test_agglomeration(const UMesh2dh& m, FlowPhysicsConfig pconf, FlowNumericsConfig nconf)
+{
+	set_freestream_wall_temperature(pconf);
+	// the walls of the viscous test case become inviscid boundaries
+	pconf.viscous_sim = false;
+	pconf.farfield_id = pconf.adiabaticwall_id;
+	pconf.extrapolation_id = pconf.isothermalwall_id;
+	nconf.order2 = false;
+	nconf.gradientscheme = "NONE";
+	nconf.reconstruction = "NONE";
+	nconf.conv_numflux_jac = nconf.conv_numflux;
+
+	const int nlevels = 4;
+	std::vector<AgglomeratedMesh> levels;
+	levels.reserve(nlevels);
+	levels.emplace_back(&m, -1);
+	TASSERT(levels[0].gnelem() == m.gnelem());
+	TASSERT(levels[0].gnaface() == m.gnaface());
+
+	for(int ilevel = 1; ilevel < nlevels; ilevel++)
+	{
+		levels.emplace_back(&levels[ilevel-1]);
+		const AgglomeratedMesh& fine = levels[ilevel-1];
+		const AgglomeratedMesh& coarse = levels[ilevel];
+		std::cout << " Level " << ilevel << ": " << coarse.gnelem() << " cells, "
+			<< coarse.gnaface() << " faces" << std::endl;
+		TASSERT(coarse.gnelem() > 0);
+		TASSERT(2*coarse.gnelem() < fine.gnelem());
+		TASSERT(coarse.gnfineelem() == fine.gnelem());
+		TASSERT(coarse.gnbface() == fine.gnbface());
+
+		// every cell belongs to an agglomerate, and the areas add up
+		std::vector<a_real> area(coarse.gnelem(), 0);
+		for(a_int iel = 0; iel < fine.gnelem(); iel++) {
+			const a_int icoarse = coarse.gcoarsecell(iel);
+			TASSERT(icoarse >= 0 && icoarse < coarse.gnelem());
+			area[icoarse] += fine.garea(iel);
+		}
+		for(a_int iel = 0; iel < coarse.gnelem(); iel++) {
+			TASSERT(area[iel] > 0);
+			TASSERT(std::fabs(area[iel]-coarse.garea(iel)) <= 1e-12*area[iel]);
+		}
+
+		// the lists of finer cells in each cell are the inverse of the fine-to-coarse map
+		TASSERT(coarse.gfinecell_p(coarse.gnelem()) == fine.gnelem());
+		for(a_int iel = 0; iel < coarse.gnelem(); iel++)
+			for(a_int j = coarse.gfinecell_p(iel); j < coarse.gfinecell_p(iel+1); j++)
+				TASSERT(coarse.gcoarsecell(coarse.gfinecell(j)) == iel);
+
+		// the normals of the faces of each cell add up to zero
+		for(a_int iel = 0; iel < coarse.gnelem(); iel++)
+		{
+			a_real sum[NDIM] = {0,0}, perimeter = 0;
+			for(a_int j = coarse.gcellface_p(iel); j < coarse.gcellface_p(iel+1); j++) {
+				const a_int iface = coarse.gcellface(j);
+				TASSERT(coarse.gintfac(iface, coarse.gcellfacesign(j) > 0 ? 0 : 1) == iel);
+				for(int idim = 0; idim < NDIM; idim++)
+					sum[idim] += coarse.gcellfacesign(j)*coarse.gfacemetric(iface,idim)
+						*coarse.gfacemetric(iface,2);
+				perimeter += coarse.gfacemetric(iface,2);
+			}
+			TASSERT(std::fabs(sum[0]) <= 1e-12*perimeter);
+			TASSERT(std::fabs(sum[1]) <= 1e-12*perimeter);
+		}
+	}
+
+	// on the finest level, the residual is the usual first-order one
+	const TestFlowFV fv(&m, pconf, nconf);
+	const a_int n = m.gnelem()*NVARS;
+	Vec u, r;
+	int ierr = create_perturbed_state(m, fv, &u); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &r); CHKERRQ(ierr);
+
+	Mat A;
+	ierr = setupSystemMatrix<NVARS>(&m, &A); CHKERRQ(ierr);
+	ierr = MatZeroEntries(A); CHKERRQ(ierr);
+	std::vector<a_real> dtm(m.gnelem());
+	ierr = VecSet(r, 0.0); CHKERRQ(ierr);
+	ierr = fv.compute_residual_and_jacobian(u, r, true, dtm, A); CHKERRQ(ierr);
+
+	std::vector<a_real> ares(n, 0), adtm(m.gnelem()), adiag(n*NVARS);
+	const PetscScalar *ucarr, *rarr;
+	ierr = VecGetArrayRead(u, &ucarr); CHKERRQ(ierr);
+	ierr = fv.compute_agglomerated_residual(levels[0], ucarr, &ares[0], true, &adtm[0],
+			&adiag[0]);
+	CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(u, &ucarr); CHKERRQ(ierr);
+
+	ierr = VecGetArrayRead(r, &rarr); CHKERRQ(ierr);
+	a_real rmax = 0, rdiff = 0;
+	for(a_int i = 0; i < n; i++) {
+		rmax = std::max(rmax, std::fabs(rarr[i]));
+		rdiff = std::max(rdiff, std::fabs(rarr[i]-ares[i]));
+	}
+	ierr = VecRestoreArrayRead(r, &rarr); CHKERRQ(ierr);
+	std::cout << " Max residual " << rmax << ", max difference " << rdiff << std::endl;
+	TASSERT(rmax > 0);
+	TASSERT(rdiff <= 1e-12*rmax);
+	for(a_int iel = 0; iel < m.gnelem(); iel++)
+		TASSERT(std::fabs(dtm[iel]-adtm[iel]) <= 1e-12*dtm[iel]);
+
+	// Jacobian blocks are stored column-major, the diagonal blocks here row-major
+	const JacobianBlockLocations *blocks;
+	ierr = getJacobianBlockLocations(A, &blocks); CHKERRQ(ierr);
+	TASSERT(blocks != NULL);
+	PetscScalar *vals;
+	ierr = getJacobianBlockValues(A, &vals); CHKERRQ(ierr);
+	a_real jmax = 0, jdiff = 0;
+	for(a_int iel = 0; iel < m.gnelem(); iel++)
+		for(int i = 0; i < NVARS; i++)
+			for(int j = 0; j < NVARS; j++) {
+				const a_real jval = vals[blocks->diag[iel]*NVARS*NVARS + j*NVARS+i];
+				jmax = std::max(jmax, std::fabs(jval));
+				jdiff = std::max(jdiff, std::fabs(jval - adiag[iel*NVARS*NVARS + i*NVARS+j]));
+			}
+	ierr = restoreJacobianBlockValues(A, &vals); CHKERRQ(ierr);
+	std::cout << " Max diagonal Jacobian entry " << jmax << ", max difference " << jdiff
+		<< std::endl;
+	TASSERT(jdiff <= 1e-12*jmax);
+
+	ierr = MatDestroy(&A); CHKERRQ(ierr);
+	ierr = VecDestroy(&u); CHKERRQ(ierr);
+	ierr = VecDestroy(&r); CHKERRQ(ierr);
+	return 0;
+}
+
+/// Checks that the residual of a flow discretization from the factory agrees with the residual
+/// computed through virtual functions
+/** \param specialized Whether the factory is expected to return a residual specialized for the
+ *   numerical schemes in nconf
+ */
+int test_static_dispatch_schemes(const UMesh2dh& m, const FlowPhysicsConfig& pconf,
+		const Spatial<NVARS>& virt, const FlowNumericsConfig& nconf, const bool specialized)
+{
+	const Spatial<NVARS> *const spec = create_const_flowSpatialDiscretization(&m, pconf, nconf);
+	const bool isvirtual = typeid(*spec) == typeid(virt);
+	std::cout << " " << nconf.conv_numflux << " " << nconf.gradientscheme << " " 
+		<< nconf.reconstruction << (isvirtual ? ": virtual" : ": specialized") << std::endl;
+	TASSERT(isvirtual == !specialized);
+
+	Vec u, rvirt, rspec;
+	int ierr = create_perturbed_state(m, virt, &u); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &rvirt); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &rspec); CHKERRQ(ierr);
+
+	ierr = VecSet(rvirt, 0.0); CHKERRQ(ierr);
+	ierr = VecSet(rspec, 0.0); CHKERRQ(ierr);
+	std::vector<a_real> dtvirt(m.gnelem()), dtspec(m.gnelem());
+	ierr = virt.compute_residual(u, rvirt, true, dtvirt); CHKERRQ(ierr);
+	ierr = spec->compute_residual(u, rspec, true, dtspec); CHKERRQ(ierr);
+
+	const PetscScalar *rvarr, *rsarr;
+	ierr = VecGetArrayRead(rvirt, &rvarr); CHKERRQ(ierr);
+	ierr = VecGetArrayRead(rspec, &rsarr); CHKERRQ(ierr);
+	a_real rmax = 0, rdiff = 0;
+	for(a_int i = 0; i < m.gnelem()*NVARS; i++) {
+		TASSERT(std::isfinite(rvarr[i]));
+		rmax = std::max(rmax, std::fabs(rvarr[i]));
+		rdiff = std::max(rdiff, std::fabs(rvarr[i]-rsarr[i]));
+	}
+	ierr = VecRestoreArrayRead(rvirt, &rvarr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(rspec, &rsarr); CHKERRQ(ierr);
+
+	TASSERT(rmax > 0);
+	TASSERT(rdiff <= 1e-14*rmax);
+	for(a_int iel = 0; iel < m.gnelem(); iel++)
+		TASSERT(std::fabs(dtvirt[iel]-dtspec[iel]) <= 1e-14*dtvirt[iel]);
+
+	// report the gain from having the schemes inlined into the residual, as the best of a few
+	// alternating rounds so that neither variant is favoured by the state of the caches
+	const int nres = 20, nrounds = 5;
+	double vtime = 1e30, stime = 1e30;
+	for(int iround = 0; iround < nrounds; iround++)
+	{
+		const auto t0 = std::chrono::steady_clock::now();
+		for(int i = 0; i < nres; i++) {
+			ierr = virt.compute_residual(u, rvirt, true, dtvirt); CHKERRQ(ierr);
+		}
+		const auto t1 = std::chrono::steady_clock::now();
+		for(int i = 0; i < nres; i++) {
+			ierr = spec->compute_residual(u, rspec, true, dtspec); CHKERRQ(ierr);
+		}
+		const auto t2 = std::chrono::steady_clock::now();
+		vtime = std::min(vtime, std::chrono::duration<double>(t1-t0).count()/nres);
+		stime = std::min(stime, std::chrono::duration<double>(t2-t1).count()/nres);
+	}
+	std::cout << "  Residual time " << stime << " s specialized vs " << vtime 
+		<< " s virtual, speed-up " << vtime/stime << std::endl;
+
+	ierr = VecDestroy(&u); CHKERRQ(ierr);
+	ierr = VecDestroy(&rvirt); CHKERRQ(ierr);
+	ierr = VecDestroy(&rspec); CHKERRQ(ierr);
+	delete spec;
+	return 0;
+}
+
+/// Checks that residuals specialized for the numerical schemes in use agree with the
+/// residual computed through virtual functions
+/** Combinations of schemes that are compiled by default are checked to be specialized by the
+ * factory, and one combination that is not is checked to fall back to virtual functions
+ * unless all combinations are compiled. The time taken by residual evaluations is reported for
+ * both.
+ */
+int test_static_dispatch(const UMesh2dh& m, FlowPhysicsConfig pconf, FlowNumericsConfig nconf)
+{
+	set_freestream_wall_temperature(pconf);
+	pconf.const_visc = false;
+
+	struct Schemes {
+		std::string flux, gradient, limiter, engine;
+		bool order2;
+		bool specialized;
+	};
+#if !defined(STATIC_DISPATCH_LEVEL) || STATIC_DISPATCH_LEVEL > 0
+	const bool compiled = true;
+#else
+	const bool compiled = false;
+#endif
+#if defined(STATIC_DISPATCH_LEVEL) && STATIC_DISPATCH_LEVEL > 1
+	const bool compiledall = true;
+#else
+	const bool compiledall = false;
+#endif
+	const Schemes cases[] = {
+		{"ROE", "LEASTSQUARES", "NONE", "FACECOLOURING", true, compiled},
+		{"HLLC", "GREENGAUSS", "WENO", "CELLGATHER", true, compiled},
+		{"HLL", "GREENGAUSS", "NONE", "CELLGATHER", false, compiled},
+		{"LLF", "LEASTSQUARES", "NONE", "FACECOLOURING", true, compiledall}
+	};
+
+	for(const Schemes& sch : cases)
+	{
+		nconf.conv_numflux = sch.flux;
+		nconf.gradientscheme = sch.gradient;
+		nconf.reconstruction = sch.limiter;
+		nconf.residual_engine = sch.engine;
+		nconf.order2 = sch.order2;
+
+		const int err = check_flowfv(m, pconf, nconf,
+			[&](const Spatial<NVARS>& virt, const FlowNumericsConfig& nc) {
+				return test_static_dispatch_schemes(m, pconf, virt, nc, sch.specialized);
+			});
+		if(err)
+			return err;
+	}
+	return 0;
+}
+
+/// Compares two Jacobian matrices at the non-zero locations of a cell-centred discretization
+/** \param[out] jmax The largest magnitude of an entry of the first matrix
+ * \param[out] jdiff The largest magnitude of the difference between the matrices
+ */
+int compareJacobians(const UMesh2dh& m, Mat A, Mat B, a_real& jmax, a_real& jdiff)
+{
+	int ierr = 0;
+	jmax = 0; jdiff = 0;
+	// compare the diagonal block of each cell and the blocks coupling it to its neighbours
+	for(a_int iel = 0; iel < m.gnelem(); iel++)
+	{
+		for(int jfa = -1; jfa < m.gnfael(iel); jfa++)
+		{
+			const a_int jel = jfa < 0 ? iel : m.gesuel(iel,jfa);
+			if(jel >= m.gnelem())
+				continue;
+			PetscInt rows[NVARS], cols[NVARS];
+			for(int i = 0; i < NVARS; i++) {
+				rows[i] = iel*NVARS+i;
+				cols[i] = jel*NVARS+i;
+			}
+			PetscScalar bvals[NVARS*NVARS], avals[NVARS*NVARS];
+			ierr = MatGetValues(B, NVARS, rows, NVARS, cols, bvals); CHKERRQ(ierr);
+			ierr = MatGetValues(A, NVARS, rows, NVARS, cols, avals); CHKERRQ(ierr);
+			for(int i = 0; i < NVARS*NVARS; i++) {
+				TASSERT(std::isfinite(bvals[i]));
+				jmax = std::max(jmax, std::fabs(avals[i]));
+				jdiff = std::max(jdiff, std::fabs(avals[i]-bvals[i]));
+			}
+		}
+	}
+	return ierr;
+}
+
+/// Checks that the Jacobian assembled directly into block storage agrees with the Jacobian
+/// assembled entry-wise into a scalar (AIJ) matrix
+/** The state is a perturbed free-stream state, so that all face Jacobians contribute.
+ */
+int test_jacobian_blocks(const UMesh2dh& m, FlowPhysicsConfig pconf,
+		FlowNumericsConfig nconf)
+{
+	set_freestream_wall_temperature(pconf);
+	nconf.conv_numflux_jac = nconf.conv_numflux;
+	const TestFlowFV fv(&m, pconf, nconf);
+
+	Vec u;
+	int ierr = create_perturbed_state(m, fv, &u); CHKERRQ(ierr);
+
+	Mat B, A;
+	ierr = setupSystemMatrix<NVARS>(&m, &B); CHKERRQ(ierr);
+	const JacobianBlockLocations *blocks;
+	ierr = getJacobianBlockLocations(B, &blocks); CHKERRQ(ierr);
+	TASSERT(blocks != NULL);
+
+	const PetscInt n = m.gnelem()*NVARS;
+	ierr = MatCreate(PETSC_COMM_SELF, &A); CHKERRQ(ierr);
+	ierr = MatSetType(A, MATSEQAIJ); CHKERRQ(ierr);
+	ierr = MatSetSizes(A, n, n, n, n); CHKERRQ(ierr);
+	ierr = MatSetBlockSize(A, NVARS); CHKERRQ(ierr);
+	ierr = setJacobianPreallocation<NVARS>(&m, A); CHKERRQ(ierr);
+	ierr = MatSetUp(A); CHKERRQ(ierr);
+	const JacobianBlockLocations *ablocks;
+	ierr = getJacobianBlockLocations(A, &ablocks); CHKERRQ(ierr);
+	TASSERT(ablocks == NULL);
+
+	ierr = MatZeroEntries(B); CHKERRQ(ierr);
+	ierr = MatZeroEntries(A); CHKERRQ(ierr);
+	ierr = fv.compute_jacobian(u, B); CHKERRQ(ierr);
+	ierr = fv.compute_jacobian(u, A); CHKERRQ(ierr);
+
+	a_real jmax, jdiff;
+	ierr = compareJacobians(m, A, B, jmax, jdiff); CHKERRQ(ierr);
+	std::cout << " Max Jacobian entry " << jmax << ", max difference " << jdiff << std::endl;
+	TASSERT(jmax > 0);
+	TASSERT(jdiff <= 1e-13*jmax);
+
+	ierr = MatDestroy(&A); CHKERRQ(ierr);
+	ierr = MatDestroy(&B); CHKERRQ(ierr);
+	ierr = VecDestroy(&u); CHKERRQ(ierr);
+	return 0;
+}
+
+/// Checks that the residual and Jacobian computed together agree with those computed separately
+/** The Jacobian flux is set to the residual flux, so that the first-order scheme computes
+ * interior face fluxes together with their Jacobians, and then to a different flux.
+ */
+int test_residual_and_jacobian_scheme(const UMesh2dh& m, const Spatial<NVARS>& fv,
+		const FlowNumericsConfig& nconf)
+{
+	std::cout << " Order " << (nconf.order2 ? 2 : 1) << ", " << nconf.conv_numflux 
+		<< " flux with " << nconf.conv_numflux_jac << " Jacobian" << std::endl;
+
+	Vec u, rsep, rfused;
+	int ierr = create_perturbed_state(m, fv, &u); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &rsep); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &rfused); CHKERRQ(ierr);
+
+	Mat Asep, Afused;
+	ierr = setupSystemMatrix<NVARS>(&m, &Asep); CHKERRQ(ierr);
+	ierr = setupSystemMatrix<NVARS>(&m, &Afused); CHKERRQ(ierr);
+	ierr = MatZeroEntries(Asep); CHKERRQ(ierr);
+	ierr = MatZeroEntries(Afused); CHKERRQ(ierr);
+
+	ierr = VecSet(rsep, 0.0); CHKERRQ(ierr);
+	ierr = VecSet(rfused, 0.0); CHKERRQ(ierr);
+	std::vector<a_real> dtsep(m.gnelem()), dtfused(m.gnelem());
+	ierr = fv.compute_residual(u, rsep, true, dtsep); CHKERRQ(ierr);
+	ierr = fv.compute_jacobian(u, Asep); CHKERRQ(ierr);
+	ierr = fv.compute_residual_and_jacobian(u, rfused, true, dtfused, Afused); CHKERRQ(ierr);
+
+	const PetscScalar *rsarr, *rfarr;
+	ierr = VecGetArrayRead(rsep, &rsarr); CHKERRQ(ierr);
+	ierr = VecGetArrayRead(rfused, &rfarr); CHKERRQ(ierr);
+	a_real rmax = 0, rdiff = 0;
+	for(a_int i = 0; i < m.gnelem()*NVARS; i++) {
+		TASSERT(std::isfinite(rfarr[i]));
+		rmax = std::max(rmax, std::fabs(rsarr[i]));
+		rdiff = std::max(rdiff, std::fabs(rsarr[i]-rfarr[i]));
+	}
+	ierr = VecRestoreArrayRead(rsep, &rsarr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(rfused, &rfarr); CHKERRQ(ierr);
+
+	a_real jmax, jdiff;
+	ierr = compareJacobians(m, Asep, Afused, jmax, jdiff); CHKERRQ(ierr);
+	std::cout << "  Max residual difference " << rdiff/rmax 
+		<< ", max Jacobian difference " << jdiff/jmax << " (relative)" << std::endl;
+
+	/* Fluxes computed along with their Jacobians take conserved variables instead of primitive
+	 * ones, which changes each face flux by up to 1e-13 relative (see test_flux_batch). The
+	 * state is perturbed by 5% from the free stream, so the residual is some 20 times smaller
+	 * than the face fluxes that cancel in it, and differs by correspondingly more in relative
+	 * terms. The Jacobian and time steps are computed the same way in both, so they match to
+	 * round-off.
+	 */
+	TASSERT(rmax > 0);
+	TASSERT(rdiff <= 1e-12*rmax);
+	for(a_int iel = 0; iel < m.gnelem(); iel++)
+		TASSERT(std::fabs(dtsep[iel]-dtfused[iel]) <= 1e-14*dtsep[iel]);
+	TASSERT(jmax > 0);
+	TASSERT(jdiff <= 1e-14*jmax);
+
+	ierr = MatDestroy(&Asep); CHKERRQ(ierr);
+	ierr = MatDestroy(&Afused); CHKERRQ(ierr);
+	ierr = VecDestroy(&u); CHKERRQ(ierr);
+	ierr = VecDestroy(&rsep); CHKERRQ(ierr);
+	ierr = VecDestroy(&rfused); CHKERRQ(ierr);
+	return 0;
+}
+
+/// Checks the residual and Jacobian computed together for first- and second-order schemes
+int test_residual_and_jacobian(const UMesh2dh& m, FlowPhysicsConfig pconf,
+		FlowNumericsConfig nconf)
+{
+	set_freestream_wall_temperature(pconf);
+
+	for(std::string jflux : {nconf.conv_numflux, std::string("LLF")})
+	{
+		nconf.conv_numflux_jac = jflux;
+		const int err = check_flowfv_orders(m, pconf, nconf, {nconf.reconstruction},
+			[&](const Spatial<NVARS>& fv, const FlowNumericsConfig& nc) {
+				return test_residual_and_jacobian_scheme(m, fv, nc);
+			});
+		if(err) return err;
+	}
+	return 0;
+}
+
+/// Checks exact Jacobian-vector products against central differences of the residual
+int test_dual_jacobian_vector_product_scheme(const UMesh2dh& m, const Spatial<NVARS>& fv,
+		const FlowNumericsConfig& nconf)
+{
+	std::cout << " Order " << (nconf.order2 ? 2 : 1) << ", " << nconf.conv_numflux << " flux"
+		<< (nconf.order2 ? ", " + nconf.reconstruction + " limiter" : "") << std::endl;
+
+	const a_int n = m.gnelem()*NVARS;
+	Vec u, x, jx, upert, rplus, rminus;
+	int ierr = create_perturbed_state(m, fv, &u); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &x); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &jx); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &upert); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &rplus); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &rminus); CHKERRQ(ierr);
+
+	ierr = set_test_direction(u, x); CHKERRQ(ierr);
+
+	ierr = fv.compute_jacobian_vector_product(u, x, jx); CHKERRQ(ierr);
+
+	// compute_residual gives -r(u)
+	const a_real h = 1e-6;
+	std::vector<a_real> dummy;
+	ierr = VecWAXPY(upert, h, x, u); CHKERRQ(ierr);
+	ierr = fv.compute_residual(upert, rplus, false, dummy); CHKERRQ(ierr);
+	ierr = VecWAXPY(upert, -h, x, u); CHKERRQ(ierr);
+	ierr = fv.compute_residual(upert, rminus, false, dummy); CHKERRQ(ierr);
+
+	const PetscScalar *jarr, *rparr, *rmarr;
+	ierr = VecGetArrayRead(jx, &jarr); CHKERRQ(ierr);
+	ierr = VecGetArrayRead(rplus, &rparr); CHKERRQ(ierr);
+	ierr = VecGetArrayRead(rminus, &rmarr); CHKERRQ(ierr);
+	a_real jmax = 0, jdiff = 0;
+	for(a_int i = 0; i < n; i++) {
+		TASSERT(std::isfinite(jarr[i]));
+		const a_real fd = -(rparr[i]-rmarr[i])/(2.0*h);
+		jmax = std::max(jmax, std::fabs(fd));
+		jdiff = std::max(jdiff, std::fabs(fd-jarr[i]));
+	}
+	ierr = VecRestoreArrayRead(jx, &jarr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(rplus, &rparr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(rminus, &rmarr); CHKERRQ(ierr);
+
+	std::cout << "  Max difference from central difference " << jdiff/jmax << " (relative)" 
+		<< std::endl;
+	TASSERT(jmax > 0);
+	TASSERT(jdiff <= 1e-7*jmax);
+
+	ierr = VecDestroy(&u); CHKERRQ(ierr);
+	ierr = VecDestroy(&x); CHKERRQ(ierr);
+	ierr = VecDestroy(&jx); CHKERRQ(ierr);
+	ierr = VecDestroy(&upert); CHKERRQ(ierr);
+	ierr = VecDestroy(&rplus); CHKERRQ(ierr);
+	ierr = VecDestroy(&rminus); CHKERRQ(ierr);
+	return 0;
+}
+
+/// Checks exact Jacobian-vector products for first- and second-order schemes
+int test_dual_jacobian_vector_product(const UMesh2dh& m, FlowPhysicsConfig pconf,
+		FlowNumericsConfig nconf)
+{
+	set_freestream_wall_temperature(pconf);
+
+	for(std::string flux : {"ROE", "HLLC", "AUSM"})
+	{
+		nconf.conv_numflux = flux;
+		nconf.conv_numflux_jac = flux;
+		const int err = check_flowfv_orders(m, pconf, nconf, {"NONE", "VENKATAKRISHNAN"},
+			[&](const Spatial<NVARS>& fv, const FlowNumericsConfig& nc) {
+				return test_dual_jacobian_vector_product_scheme(m, fv, nc);
+			});
+		if(err) return err;
+	}
+	return 0;
+}
+
+/// Checks the residual with the reconstruction frozen at a state
+/** At the frozen state it must be the full residual. Without limiting, only the boundary
+ * states are linearised, so its central difference is the exact Jacobian-vector product.
+ */
+int test_frozen_reconstruction_scheme(const UMesh2dh& m, const Spatial<NVARS>& fv,
+		const FlowNumericsConfig& nconf)
+{
+	std::cout << " Order " << (nconf.order2 ? 2 : 1) << ", " << nconf.conv_numflux << " flux"
+		<< (nconf.order2 ? ", " + nconf.reconstruction + " limiter" : "") << std::endl;
+
+	const a_int n = m.gnelem()*NVARS;
+	Vec u, x, jx, upert, r, rfrozen, rminus;
+	int ierr = create_perturbed_state(m, fv, &u); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &x); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &jx); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &upert); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &r); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &rfrozen); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &rminus); CHKERRQ(ierr);
+
+	ierr = set_test_direction(u, x); CHKERRQ(ierr);
+
+	std::vector<a_real> dummy;
+	ierr = VecSet(r, 0.0); CHKERRQ(ierr);
+	ierr = VecSet(rfrozen, 0.0); CHKERRQ(ierr);
+	ierr = fv.compute_residual(u, r, false, dummy); CHKERRQ(ierr);
+	Spatial<NVARS>::FrozenReconstruction *frozen = nullptr;
+	ierr = fv.freeze_reconstruction(u, &frozen); CHKERRQ(ierr);
+	ierr = fv.compute_frozen_residual(u, frozen, rfrozen); CHKERRQ(ierr);
+
+	const PetscScalar *rarr, *rfarr;
+	ierr = VecGetArrayRead(r, &rarr); CHKERRQ(ierr);
+	ierr = VecGetArrayRead(rfrozen, &rfarr); CHKERRQ(ierr);
+	a_real rmax = 0, rdiff = 0;
+	for(a_int i = 0; i < n; i++) {
+		rmax = std::max(rmax, std::fabs(rarr[i]));
+		rdiff = std::max(rdiff, std::fabs(rarr[i]-rfarr[i]));
+	}
+	ierr = VecRestoreArrayRead(r, &rarr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(rfrozen, &rfarr); CHKERRQ(ierr);
+	std::cout << "  Max residual difference at the frozen state " << rdiff/rmax 
+		<< " (relative)" << std::endl;
+	TASSERT(rmax > 0);
+	TASSERT(rdiff <= 1e-14*rmax);
+
+	if(nconf.reconstruction == "NONE")
+	{
+		ierr = fv.compute_jacobian_vector_product(u, x, jx); CHKERRQ(ierr);
+
+		const a_real h = 1e-6;
+		ierr = VecSet(rfrozen, 0.0); CHKERRQ(ierr);
+		ierr = VecSet(rminus, 0.0); CHKERRQ(ierr);
+		ierr = VecWAXPY(upert, h, x, u); CHKERRQ(ierr);
+		ierr = fv.compute_frozen_residual(upert, frozen, rfrozen); CHKERRQ(ierr);
+		ierr = VecWAXPY(upert, -h, x, u); CHKERRQ(ierr);
+		ierr = fv.compute_frozen_residual(upert, frozen, rminus); CHKERRQ(ierr);
+
+		const PetscScalar *jarr, *rmarr;
+		ierr = VecGetArrayRead(jx, &jarr); CHKERRQ(ierr);
+		ierr = VecGetArrayRead(rfrozen, &rfarr); CHKERRQ(ierr);
+		ierr = VecGetArrayRead(rminus, &rmarr); CHKERRQ(ierr);
+		a_real jmax = 0, jdiff = 0;
+		for(a_int i = 0; i < n; i++) {
+			const a_real fd = -(rfarr[i]-rmarr[i])/(2.0*h);
+			jmax = std::max(jmax, std::fabs(jarr[i]));
+			jdiff = std::max(jdiff, std::fabs(fd-jarr[i]));
+		}
+		ierr = VecRestoreArrayRead(jx, &jarr); CHKERRQ(ierr);
+		ierr = VecRestoreArrayRead(rfrozen, &rfarr); CHKERRQ(ierr);
+		ierr = VecRestoreArrayRead(rminus, &rmarr); CHKERRQ(ierr);
+		std::cout << "  Max difference of frozen central difference from exact product " 
+			<< jdiff/jmax << " (relative)" << std::endl;
+		TASSERT(jmax > 0);
+		TASSERT(jdiff <= 1e-7*jmax);
+	}
+
+	delete frozen;
+	ierr = VecDestroy(&u); CHKERRQ(ierr);
+	ierr = VecDestroy(&x); CHKERRQ(ierr);
+	ierr = VecDestroy(&jx); CHKERRQ(ierr);
+	ierr = VecDestroy(&upert); CHKERRQ(ierr);
+	ierr = VecDestroy(&r); CHKERRQ(ierr);
+	ierr = VecDestroy(&rfrozen); CHKERRQ(ierr);
+	ierr = VecDestroy(&rminus); CHKERRQ(ierr);
+	return 0;
+}
+
+/// Checks frozen reconstructions for first- and second-order schemes
+int test_frozen_reconstruction(const UMesh2dh& m, FlowPhysicsConfig pconf,
+		FlowNumericsConfig nconf)
+{
+	set_freestream_wall_temperature(pconf);
+
+	return check_flowfv_orders(m, pconf, nconf, {"NONE", "VENKATAKRISHNAN", "BARTHJESPERSEN"},
+		[&](const Spatial<NVARS>& fv, const FlowNumericsConfig& nc) {
+			return test_frozen_reconstruction_scheme(m, fv, nc);
+		});
+}
+
+/// Checks a Jacobian assembled from coloured products against Jacobian-vector products
+/** The reference products are exact products for the exact Jacobian, and central differences
+ * of the residual otherwise. The matrix is preallocated for the stencil radius of the scheme,
+ * so assembling blocks outside the preallocated structure is an error.
+ * \param tol Relative tolerance for the difference of the products
+ */
+int test_coloured_jacobian_scheme(const UMesh2dh& m, const Spatial<NVARS>& fv,
+		const FlowNumericsConfig& nconf, const a_real tol)
+{
+	std::cout << " Order " << (nconf.order2 ? 2 : 1) << ", " << nconf.conv_numflux << " flux"
+		<< (nconf.order2 ? ", " + nconf.reconstruction + " limiter" : "") 
+		<< ", stencil radius " << fv.jacobian_stencil_radius() << std::endl;
+	TASSERT(fv.jacobian_stencil_radius() >= (nconf.order2 ? 2 : 1));
+
+	const a_int n = m.gnelem()*NVARS;
+	Vec u, x, jx, ax, upert, rminus;
+	int ierr = create_perturbed_state(m, fv, &u); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &x); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &jx); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &ax); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &upert); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &rminus); CHKERRQ(ierr);
+
+	ierr = set_test_direction(u, x); CHKERRQ(ierr);
+
+	Mat A;
+	ierr = setupSystemMatrix<NVARS>(&m, &A, fv.jacobian_stencil_radius()); CHKERRQ(ierr);
+	ierr = MatZeroEntries(A); CHKERRQ(ierr);
+	ierr = fv.compute_jacobian(u, A); CHKERRQ(ierr);
+	ierr = MatAssemblyBegin(A, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+	ierr = MatAssemblyEnd(A, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+	ierr = MatMult(A, x, ax); CHKERRQ(ierr);
+
+	if(nconf.jacobian_assembly == "EXACT") {
+		ierr = fv.compute_jacobian_vector_product(u, x, jx); CHKERRQ(ierr);
+	}
+	else {
+		// compute_residual gives -r(u)
+		const a_real h = 1e-6;
+		std::vector<a_real> dummy;
+		ierr = VecSet(jx, 0.0); CHKERRQ(ierr);
+		ierr = VecSet(rminus, 0.0); CHKERRQ(ierr);
+		ierr = VecWAXPY(upert, h, x, u); CHKERRQ(ierr);
+		ierr = fv.compute_residual(upert, jx, false, dummy); CHKERRQ(ierr);
+		ierr = VecWAXPY(upert, -h, x, u); CHKERRQ(ierr);
+		ierr = fv.compute_residual(upert, rminus, false, dummy); CHKERRQ(ierr);
+		ierr = VecAXPY(jx, -1.0, rminus); CHKERRQ(ierr);
+		ierr = VecScale(jx, -0.5/h); CHKERRQ(ierr);
+	}
+
+	const PetscScalar *jarr, *aarr;
+	ierr = VecGetArrayRead(jx, &jarr); CHKERRQ(ierr);
+	ierr = VecGetArrayRead(ax, &aarr); CHKERRQ(ierr);
+	a_real jmax = 0, jdiff = 0;
+	for(a_int i = 0; i < n; i++) {
+		jmax = std::max(jmax, std::fabs(jarr[i]));
+		jdiff = std::max(jdiff, std::fabs(aarr[i]-jarr[i]));
+	}
+	ierr = VecRestoreArrayRead(jx, &jarr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(ax, &aarr); CHKERRQ(ierr);
+
+	std::cout << "  Max difference of the assembled product from the reference product " 
+		<< jdiff/jmax << " (relative)" << std::endl;
+	TASSERT(jmax > 0);
+	TASSERT(jdiff <= tol*jmax);
+
+	ierr = MatDestroy(&A); CHKERRQ(ierr);
+	ierr = VecDestroy(&u); CHKERRQ(ierr);
+	ierr = VecDestroy(&x); CHKERRQ(ierr);
+	ierr = VecDestroy(&jx); CHKERRQ(ierr);
+	ierr = VecDestroy(&ax); CHKERRQ(ierr);
+	ierr = VecDestroy(&upert); CHKERRQ(ierr);
+	ierr = VecDestroy(&rminus); CHKERRQ(ierr);
+	return 0;
+}
+
+/// Checks exact Jacobians for first- and second-order schemes
+int test_exact_jacobian(const UMesh2dh& m, FlowPhysicsConfig pconf, FlowNumericsConfig nconf)
+{
+	set_freestream_wall_temperature(pconf);
+	nconf.jacobian_assembly = "EXACT";
+
+	return check_flowfv_orders(m, pconf, nconf, {"NONE", "VENKATAKRISHNAN"},
+		[&](const Spatial<NVARS>& fv, const FlowNumericsConfig& nc) {
+			return test_coloured_jacobian_scheme(m, fv, nc, 1e-12);
+		});
+}
+
+/// Checks finite-difference Jacobians for first- and second-order schemes, including
+/// reconstructions without cell limiters
+int test_difference_jacobian(const UMesh2dh& m, FlowPhysicsConfig pconf, 
+		FlowNumericsConfig nconf)
+{
+	set_freestream_wall_temperature(pconf);
+	nconf.jacobian_assembly = "DIFFERENCE";
+
+	int err = check_flowfv_orders(m, pconf, nconf, {"NONE", "VENKATAKRISHNAN"},
+		[&](const Spatial<NVARS>& fv, const FlowNumericsConfig& nc) {
+			return test_coloured_jacobian_scheme(m, fv, nc, 1e-5);
+		});
+	if(err) return err;
+
+	// the limiting of these varies rapidly with the state, so one-sided differences are coarser
+	nconf.order2 = true;
+	for(std::string limiter : {"VANALBADA", "WENO"})
+	{
+		nconf.reconstruction = limiter;
+		err = check_flowfv(m, pconf, nconf,
+			[&](const Spatial<NVARS>& fv, const FlowNumericsConfig& nc) {
+				return test_coloured_jacobian_scheme(m, fv, nc, 1e-4);
+			});
+		if(err) return err;
+	}
+	return 0;
+}
+
+/// Checks the level-scheduled preconditioners on a matrix
+/** ILU(0) and SGS are exact for block triangular matrices. For the full matrix, the result must
+ * not depend on the number of threads.
+ */
+int test_level_scheduled_preconditioners(const UMesh2dh& m, const BSRMatrix<NVARS>& bmat)
+{
+	const a_int n = m.gnelem()*NVARS;
+	std::vector<a_real> x(n), b(n), z(n), zserial(n);
+	for(a_int i = 0; i < n; i++)
+		x[i] = std::cos(0.11*i);
+
+	for(std::string prectype : {"ILU0", "SGS"})
+	{
+		BlockPreconditioner<NVARS> *const prec = create_blockpreconditioner<NVARS>(prectype, &m);
+		TASSERT(prec);
+
+		for(int upper = 0; upper < 2; upper++)
+		{
+			// keep only the lower or only the upper triangular part
+			BSRMatrix<NVARS> tmat(bmat);
+			for(a_int irow = 0; irow < tmat.nbrows(); irow++)
+				for(a_int jj = tmat.rowPtr()[irow]; jj < tmat.rowPtr()[irow+1]; jj++)
+					if((upper && jj < tmat.diagInd()[irow]) || (!upper && jj > tmat.diagInd()[irow]))
+						for(int k = 0; k < NVARS*NVARS; k++)
+							tmat.values()[jj*NVARS*NVARS+k] = 0;
+
+			int ierr = prec->compute(tmat); CHKERRQ(ierr);
+			tmat.apply(&x[0], &b[0]);
+			prec->apply(&b[0], &z[0]);
+			a_real zdiff = 0;
+			for(a_int i = 0; i < n; i++)
+				zdiff = std::max(zdiff, std::fabs(z[i]-x[i]));
+			std::cout << "  " << prectype << (upper ? " upper" : " lower") 
+				<< " triangular: max error " << zdiff << std::endl;
+			TASSERT(zdiff <= 1e-10);
+		}
+
+#ifdef _OPENMP
+		const int nthreads = omp_get_max_threads();
+		omp_set_num_threads(1);
+		int ierr = prec->compute(bmat); CHKERRQ(ierr);
+		prec->apply(&x[0], &zserial[0]);
+		omp_set_num_threads(nthreads);
+		ierr = prec->compute(bmat); CHKERRQ(ierr);
+		prec->apply(&x[0], &z[0]);
+		for(a_int i = 0; i < n; i++)
+			TASSERT(z[i] == zserial[i]);
+#endif
+		delete prec;
+	}
+	return 0;
+}
+
+/// Checks that the line preconditioner solves systems which only couple cells in the same line,
+/// and that its result does not depend on the number of threads
+int test_line_preconditioner(const UMesh2dh& m, const BSRMatrix<NVARS>& bmat)
+{
+	const a_int n = m.gnelem()*NVARS;
+	std::vector<a_real> x(n), b(n), z(n), zserial(n);
+	for(a_int i = 0; i < n; i++)
+		x[i] = std::cos(0.11*i);
+
+	const a_real anisotropy = 1.0;
+	std::vector<a_int> lineptr, cells;
+	implicitLines(m, anisotropy, lineptr, cells);
+	std::vector<a_int> lineof(m.gnelem()), posinline(m.gnelem());
+	for(a_int iline = 0; iline+1 < static_cast<a_int>(lineptr.size()); iline++)
+		for(a_int ic = lineptr[iline]; ic < lineptr[iline+1]; ic++) {
+			lineof[cells[ic]] = iline;
+			posinline[cells[ic]] = ic;
+		}
+
+	// keep only the blocks coupling consecutive cells of a line
+	BSRMatrix<NVARS> tmat(bmat);
+	for(a_int irow = 0; irow < tmat.nbrows(); irow++)
+		for(a_int jj = tmat.rowPtr()[irow]; jj < tmat.rowPtr()[irow+1]; jj++) {
+			const a_int jcol = tmat.colInd()[jj];
+			if(lineof[jcol] != lineof[irow] || std::abs(posinline[jcol]-posinline[irow]) > 1)
+				for(int k = 0; k < NVARS*NVARS; k++)
+					tmat.values()[jj*NVARS*NVARS+k] = 0;
+		}
+
+	BlockPreconditioner<NVARS> *const prec
+		= create_blockpreconditioner<NVARS>("LINE", &m, 1, 1, 0.0, anisotropy);
+	TASSERT(prec);
+	int ierr = prec->compute(tmat); CHKERRQ(ierr);
+	tmat.apply(&x[0], &b[0]);
+	prec->apply(&b[0], &z[0]);
+	a_real zdiff = 0;
+	for(a_int i = 0; i < n; i++)
+		zdiff = std::max(zdiff, std::fabs(z[i]-x[i]));
+	std::cout << "  LINE block tridiagonal: max error " << zdiff << std::endl;
+	TASSERT(zdiff <= 1e-10);
+
+#ifdef _OPENMP
+	const int nthreads = omp_get_max_threads();
+	omp_set_num_threads(1);
+	ierr = prec->compute(bmat); CHKERRQ(ierr);
+	prec->apply(&x[0], &zserial[0]);
+	omp_set_num_threads(nthreads);
+	ierr = prec->compute(bmat); CHKERRQ(ierr);
+	prec->apply(&x[0], &z[0]);
+	for(a_int i = 0; i < n; i++)
+		TASSERT(z[i] == zserial[i]);
+#endif
+	delete prec;
+	return 0;
+}
+
+/// Checks the asynchronous preconditioners against the corresponding sequential ones
+/** With one thread and one sweep, the asynchronous preconditioners must give the same result as
+ * the level-scheduled ones, up to round-off.
+ */
+int test_async_preconditioners(const UMesh2dh& m, const BSRMatrix<NVARS>& bmat)
+{
+	const a_int n = m.gnelem()*NVARS;
+	std::vector<a_real> x(n), z(n), zasync(n);
+	for(a_int i = 0; i < n; i++)
+		x[i] = std::cos(0.11*i);
+
+#ifdef _OPENMP
+	const int nthreads = omp_get_max_threads();
+	omp_set_num_threads(1);
+#endif
+	for(std::string prectype : {"ILU0", "SGS"})
+	{
+		BlockPreconditioner<NVARS> *const prec = create_blockpreconditioner<NVARS>(prectype, &m);
+		BlockPreconditioner<NVARS> *const aprec
+			= create_blockpreconditioner<NVARS>("ASYNC"+prectype, &m, 1, 1);
+		TASSERT(prec && aprec);
+		int ierr = prec->compute(bmat); CHKERRQ(ierr);
+		ierr = aprec->compute(bmat); CHKERRQ(ierr);
+		prec->apply(&x[0], &z[0]);
+		aprec->apply(&x[0], &zasync[0]);
+
+		a_real zmax = 0, zdiff = 0;
+		for(a_int i = 0; i < n; i++) {
+			zmax = std::max(zmax, std::fabs(z[i]));
+			zdiff = std::max(zdiff, std::fabs(z[i]-zasync[i]));
+		}
+		std::cout << "  ASYNC" << prectype << " with 1 thread: max difference " << zdiff << std::endl;
+		TASSERT(zmax > 0);
+		TASSERT(zdiff <= 1e-12*zmax);
+
+		delete prec;
+		delete aprec;
+	}
+#ifdef _OPENMP
+	omp_set_num_threads(nthreads);
+#endif
+	return 0;
+}
+
+/// Checks incremental refreshes of the block Jacobi and ILU(0) preconditioners
+/** Small changes in all the blocks must not cause any row to be computed again. If a few rows
+ * change a lot and the others not at all, refreshing only the changed rows and the rows which
+ * depend on them must give the preconditioner computed from scratch.
+ */
+int test_incremental_preconditioners(const UMesh2dh& m, const BSRMatrix<NVARS>& bmat)
+{
+	const a_int n = m.gnelem()*NVARS;
+	std::vector<a_real> x(n), z(n), zfull(n);
+	for(a_int i = 0; i < n; i++)
+		x[i] = std::cos(0.11*i);
+
+	for(std::string prectype : {"JACOBI", "ILU0"})
+	{
+		BlockPreconditioner<NVARS> *const prec
+			= create_blockpreconditioner<NVARS>(prectype, &m, 1, 1, 1e-2);
+		BlockPreconditioner<NVARS> *const fullprec = create_blockpreconditioner<NVARS>(prectype, &m);
+		TASSERT(prec && fullprec);
+
+		BSRMatrix<NVARS> tmat(bmat);
+		const a_int nvals = tmat.nnzb()*NVARS*NVARS;
+		for(a_int k = 0; k < nvals; k++)
+			tmat.values()[k] *= 1.0 + 1e-3*std::sin(0.3*k);
+		int ierr = prec->compute(bmat); CHKERRQ(ierr);
+		TASSERT(prec->refreshedFraction() == 1.0);
+		ierr = prec->compute(tmat); CHKERRQ(ierr);
+		TASSERT(prec->refreshedFraction() == 0.0);
+
+		// change the rows of every 10th cell; the preconditioner is still that of bmat
+		std::copy(bmat.values(), bmat.values()+nvals, tmat.values());
+		for(a_int irow = 0; irow < tmat.nbrows(); irow += 10)
+			for(a_int k = tmat.rowPtr()[irow]*NVARS*NVARS; k < tmat.rowPtr()[irow+1]*NVARS*NVARS; k++)
+				tmat.values()[k] *= 1.5;
+		ierr = prec->compute(tmat); CHKERRQ(ierr);
+		const a_real frac = prec->refreshedFraction();
+		ierr = fullprec->compute(tmat); CHKERRQ(ierr);
+		prec->apply(&x[0], &z[0]);
+		fullprec->apply(&x[0], &zfull[0]);
+
+		a_real zmax = 0, zdiff = 0;
+		for(a_int i = 0; i < n; i++) {
+			zmax = std::max(zmax, std::fabs(zfull[i]));
+			zdiff = std::max(zdiff, std::fabs(z[i]-zfull[i]));
+		}
+		std::cout << "  Incremental " << prectype << ": fraction of rows refreshed " << frac
+			<< ", max difference " << zdiff << std::endl;
+		TASSERT(frac > 0.0 && frac < 1.0);
+		TASSERT(zmax > 0);
+		TASSERT(zdiff <= 1e-12*zmax);
+
+		delete prec;
+		delete fullprec;
+	}
+	return 0;
+}
+
+/// Checks that preconditioners stored in single precision are close to the double precision ones
+/** Also reports the storage and the time taken by applications, for both precisions, and checks
+ * that a solve preconditioned in single precision still reaches a tight tolerance.
+ */
+int test_single_precision_preconditioners(const UMesh2dh& m, const BSRMatrix<NVARS>& bmat)
+{
+	const a_int n = m.gnelem()*NVARS;
+	std::vector<a_real> x(n), b(n), z(n), zdouble(n);
+	for(a_int i = 0; i < n; i++)
+		x[i] = std::cos(0.11*i);
+	bmat.apply(&x[0], &b[0]);
+
+	for(std::string prectype : {"JACOBI", "ILU0"})
+	{
+		BlockPreconditioner<NVARS> *const prec
+			= create_blockpreconditioner<NVARS>(prectype, &m, 1, 1, 0.0, 4.0, true);
+		BlockPreconditioner<NVARS> *const dprec = create_blockpreconditioner<NVARS>(prectype, &m);
+		TASSERT(prec && dprec);
+		int ierr = prec->compute(bmat); CHKERRQ(ierr);
+		ierr = dprec->compute(bmat); CHKERRQ(ierr);
+		TASSERT(2*prec->storageBytes() == dprec->storageBytes());
+
+		const int napply = 20;
+		const auto t0 = std::chrono::steady_clock::now();
+		for(int i = 0; i < napply; i++)
+			prec->apply(&x[0], &z[0]);
+		const auto t1 = std::chrono::steady_clock::now();
+		for(int i = 0; i < napply; i++)
+			dprec->apply(&x[0], &zdouble[0]);
+		const auto t2 = std::chrono::steady_clock::now();
+		const std::chrono::duration<double> stime = t1-t0, dtime = t2-t1;
+
+		a_real zmax = 0, zdiff = 0;
+		for(a_int i = 0; i < n; i++) {
+			zmax = std::max(zmax, std::fabs(zdouble[i]));
+			zdiff = std::max(zdiff, std::fabs(z[i]-zdouble[i]));
+		}
+		std::cout << "  Single-precision " << prectype << ": storage " << prec->storageBytes()
+			<< " vs " << dprec->storageBytes() << " bytes, apply time " << stime.count()/napply
+			<< " vs " << dtime.count()/napply << " s, max difference " << zdiff << std::endl;
+		TASSERT(zmax > 0);
+		TASSERT(zdiff <= 1e-4*zmax);
+
+		// the Krylov solver works in double precision, so it converges as tightly as before
+		const BlockSolverConfig bconf {"GMRES", prectype, 30, 1e-10, 1e-50, 2000, 2, 2, 0.0, 4.0,
+			true, 10};
+		BlockKrylovSolver<NVARS> *const solver = create_blocksolver<NVARS>(bconf, m.gnelem());
+		TASSERT(solver);
+		solver->setOperators(&bmat, prec);
+		const int iters = solver->solve(&b[0], &z[0]);
+		a_real bnorm = 0;
+		for(a_int i = 0; i < n; i++)
+			bnorm += b[i]*b[i];
+		bnorm = std::sqrt(bnorm);
+		TASSERT(iters < bconf.maxiter);
+		TASSERT(solver->residualNorm() <= 1e-10*bnorm);
+
+		delete solver;
+		delete prec;
+		delete dprec;
+	}
+	return 0;
+}
+
+/// Checks a native preconditioner used as a PETSc shell preconditioner
+int test_native_shellpc(const UMesh2dh& m, Mat A, Vec b, Vec x, Vec r)
+{
+	KSP ksp;
+	PC pc;
+	int ierr = KSPCreate(PETSC_COMM_SELF, &ksp); CHKERRQ(ierr);
+	ierr = KSPSetOperators(ksp, A, A); CHKERRQ(ierr);
+	ierr = KSPSetType(ksp, KSPFGMRES); CHKERRQ(ierr);
+	ierr = KSPSetTolerances(ksp, 1e-10, 1e-50, 1e5, 1000); CHKERRQ(ierr);
+	ierr = KSPGetPC(ksp, &pc); CHKERRQ(ierr);
+	ierr = PCSetType(pc, PCSHELL); CHKERRQ(ierr);
+
+	const BlockSolverConfig bconf {"FGMRES", "ASYNCILU0", 30, 1e-10, 1e-50, 1000, 2, 2, 0.0, 4.0,
+		false, 10};
+	NativeShellPreconditioner<NVARS> npc(&m, bconf);
+	ierr = npc.attach(ksp); CHKERRQ(ierr);
+
+	ierr = KSPSolve(ksp, b, x); CHKERRQ(ierr);
+	PetscInt iters;
+	ierr = KSPGetIterationNumber(ksp, &iters); CHKERRQ(ierr);
+	ierr = MatMult(A, x, r); CHKERRQ(ierr);
+	ierr = VecAYPX(r, -1.0, b); CHKERRQ(ierr);
+	a_real resnorm, bnorm;
+	ierr = VecNorm(r, NORM_2, &resnorm); CHKERRQ(ierr);
+	ierr = VecNorm(b, NORM_2, &bnorm); CHKERRQ(ierr);
+	std::cout << "  PETSc FGMRES with shell ASYNCILU0: iterations " << iters
+		<< ", relative residual " << resnorm/bnorm << std::endl;
+
+	TASSERT(iters < 1000);
+	TASSERT(resnorm <= 1e-7*bnorm);
+	TASSERT(npc.factorwalltime > 0);
+	TASSERT(npc.applywalltime > 0);
+
+	ierr = KSPDestroy(&ksp); CHKERRQ(ierr);
+	return 0;
+}
+
+/// Checks GCRO-DR on a sequence of systems whose pseudo-time terms decrease, as in CFL ramping
+/** The operator is the matrix-free Jacobian of the spatial discretization seen through a
+ * PetscBlockOperator, and the preconditioner is computed from the assembled Jacobian, as in
+ * implicit time stepping with a matrix-free Jacobian. GCRO-DR must need fewer iterations in total
+ * than GMRES.
+ * \param bmat Assembled Jacobian at u including the pseudo-time term area/(cfl dt)
+ */
+int test_krylov_recycling(const UMesh2dh& m, const TestFlowFV& fv, const Vec u,
+		const BSRMatrix<NVARS>& bmat, const std::vector<a_real>& dtm, const a_real cfl)
+{
+	const a_int n = m.gnelem()*NVARS;
+	std::vector<a_real> x(n), b(n), ax(n);
+	// finite difference products limit the attainable accuracy
+	const BlockSolverConfig gconf {"GMRES", "ILU0", 20, 1e-6, 1e-50, 2000, 2, 2, 0.0, 4.0,
+		false, 10};
+	BlockSolverConfig rconf = gconf;
+	rconf.solver = "GCRODR";
+
+	Vec r;
+	int ierr = VecDuplicate(u, &r); CHKERRQ(ierr);
+	ierr = VecSet(r, 0.0); CHKERRQ(ierr);
+	std::vector<a_real> dummy;
+	ierr = fv.compute_residual(u, r, false, dummy); CHKERRQ(ierr);
+
+	MatrixFreeSpatialJacobian<NVARS> mfjac;
+	Mat A;
+	ierr = setup_matrixfree_jacobian<NVARS>(&m, &mfjac, &A); CHKERRQ(ierr);
+	mfjac.set_spatial(&fv);
+	std::vector<a_real> mdts(m.gnelem());
+	mfjac.set_state(u, r, &mdts);
+	ierr = mfjac.update_state(); CHKERRQ(ierr);
+
+	int totalgmres = 0, totalgcrodr = 0, totalsetup = 0;
+	{
+		const PetscBlockOperator<NVARS> op(A);
+		BSRMatrix<NVARS> pmat(bmat);
+		BlockPreconditioner<NVARS> *const prec
+			= create_blockpreconditioner<NVARS>(gconf.precond, &m);
+		BlockKrylovSolver<NVARS> *const gmres = create_blocksolver<NVARS>(gconf, m.gnelem());
+		BlockGCRODR<NVARS> *const gcrodr
+			= dynamic_cast<BlockGCRODR<NVARS>*>(create_blocksolver<NVARS>(rconf, m.gnelem()));
+		TASSERT(prec && gmres && gcrodr);
+		gmres->setOperators(&op, prec);
+		gcrodr->setOperators(&op, prec);
+
+		const int nsystems = 5;
+		for(int isys = 0; isys < nsystems; isys++)
+		{
+			// the pseudo-time term goes from 2 area/(cfl dt) to area/(cfl dt)
+			const a_real factor = 2.0/(1.0 + 0.25*isys);
+			std::copy(bmat.values(), bmat.values() + bmat.nnzb()*NVARS*NVARS, pmat.values());
+			for(a_int iel = 0; iel < m.gnelem(); iel++) {
+				mdts[iel] = factor*m.garea(iel)/(cfl*dtm[iel]);
+				for(int i = 0; i < NVARS; i++)
+					pmat.values()[bmat.diagInd()[iel]*NVARS*NVARS + i*NVARS+i]
+						+= (factor-1.0)*m.garea(iel)/(cfl*dtm[iel]);
+			}
+			ierr = prec->compute(pmat); CHKERRQ(ierr);
+
+			for(a_int i = 0; i < n; i++)
+				x[i] = std::cos(0.11*i + 0.05*isys);
+			op.apply(&x[0], &b[0]);
+			a_real bnorm = 0;
+			for(a_int i = 0; i < n; i++)
+				bnorm += b[i]*b[i];
+			bnorm = std::sqrt(bnorm);
+
+			int iters[2];
+			BlockKrylovSolver<NVARS> *const solvers[2] = {gmres, gcrodr};
+			for(int is = 0; is < 2; is++)
+			{
+				iters[is] = solvers[is]->solve(&b[0], &x[0]);
+				op.apply(&x[0], &ax[0]);
+				a_real resnorm = 0;
+				for(a_int i = 0; i < n; i++)
+					resnorm += (b[i]-ax[i])*(b[i]-ax[i]);
+				resnorm = std::sqrt(resnorm);
+				TASSERT(iters[is] < gconf.maxiter);
+				TASSERT(resnorm <= 2e-6*bnorm);
+				TASSERT(std::fabs(resnorm - solvers[is]->residualNorm()) <= 5e-7*bnorm);
+			}
+			std::cout << "  System " << isys << ": GMRES iterations " << iters[0]
+				<< ", GCRO-DR iterations " << iters[1] << " and recycle set-up products "
+				<< gcrodr->recycleSetupApplications() << ", recycled dimension "
+				<< gcrodr->recycledDimension() << std::endl;
+			totalgmres += iters[0];
+			totalgcrodr += iters[1];
+			totalsetup += gcrodr->recycleSetupApplications();
+		}
+
+		std::cout << "  Total iterations: GMRES " << totalgmres << ", GCRO-DR " << totalgcrodr
+			<< " (and " << totalsetup << " set-up products)" << std::endl;
+		TASSERT(gcrodr->recycledDimension() == rconf.recycle);
+		// recycling must pay off even when its set-up products are counted
+		TASSERT(totalgcrodr + totalsetup < totalgmres);
+
+		delete gcrodr;
+		delete gmres;
+		delete prec;
+	}
+
+	ierr = MatDestroy(&A); CHKERRQ(ierr);
+	ierr = VecDestroy(&r); CHKERRQ(ierr);
+	return 0;
+}
+
+/// Checks products with the native block sparse matrix and solves with the native solvers
+/** The matrix is the first-order Jacobian with a pseudo-time term, as in implicit time stepping.
+ * Products are compared with those of the PETSc matrix the Jacobian is copied from, and the
+ * residuals of the solutions are computed with the PETSc matrix too.
+ */
+int test_native_solvers(const UMesh2dh& m, FlowPhysicsConfig pconf, FlowNumericsConfig nconf)
+{
+	set_freestream_wall_temperature(pconf);
+	nconf.conv_numflux_jac = nconf.conv_numflux;
+	const TestFlowFV fv(&m, pconf, nconf);
+	const a_int n = m.gnelem()*NVARS;
+
+	Vec u, r, x, y;
+	int ierr = create_perturbed_state(m, fv, &u); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &r); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &x); CHKERRQ(ierr);
+	ierr = VecDuplicate(u, &y); CHKERRQ(ierr);
+
+	Mat A;
+	ierr = setupSystemMatrix<NVARS>(&m, &A); CHKERRQ(ierr);
+	ierr = MatZeroEntries(A); CHKERRQ(ierr);
+	std::vector<a_real> dtm(m.gnelem());
+	ierr = VecSet(r, 0.0); CHKERRQ(ierr);
+	ierr = fv.compute_residual_and_jacobian(u, r, true, dtm, A); CHKERRQ(ierr);
+
+	const a_real cfl = 100.0;
+	const JacobianBlockLocations *blocks;
+	ierr = getJacobianBlockLocations(A, &blocks); CHKERRQ(ierr);
+	TASSERT(blocks != NULL);
+	PetscScalar *vals;
+	ierr = getJacobianBlockValues(A, &vals); CHKERRQ(ierr);
+	for(a_int iel = 0; iel < m.gnelem(); iel++)
+		for(int i = 0; i < NVARS; i++)
+			vals[blocks->diag[iel]*NVARS*NVARS + i*NVARS+i] += m.garea(iel)/(cfl*dtm[iel]);
+	ierr = restoreJacobianBlockValues(A, &vals); CHKERRQ(ierr);
+	ierr = MatAssemblyBegin(A, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+	ierr = MatAssemblyEnd(A, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+
+	BSRMatrix<NVARS> bmat(&m);
+	ierr = bmat.copyFrom(A); CHKERRQ(ierr);
+	TASSERT(bmat.nbrows() == m.gnelem());
+	TASSERT(bmat.nnzb() == m.gnelem() + 2*(m.gnaface()-m.gnbface()));
+
+	// products
+	PetscScalar *xarr;
+	ierr = VecGetArray(x, &xarr); CHKERRQ(ierr);
+	for(a_int i = 0; i < n; i++)
+		xarr[i] = std::cos(0.11*i);
+	ierr = VecRestoreArray(x, &xarr); CHKERRQ(ierr);
+	ierr = MatMult(A, x, y); CHKERRQ(ierr);
+
+	std::vector<a_real> ynative(n);
+	const PetscScalar *cxarr, *yarr;
+	ierr = VecGetArrayRead(x, &cxarr); CHKERRQ(ierr);
+	ierr = VecGetArrayRead(y, &yarr); CHKERRQ(ierr);
+	bmat.apply(cxarr, &ynative[0]);
+	a_real ymax = 0, ydiff = 0;
+	for(a_int i = 0; i < n; i++) {
+		ymax = std::max(ymax, std::fabs(yarr[i]));
+		ydiff = std::max(ydiff, std::fabs(yarr[i]-ynative[i]));
+	}
+	ierr = VecRestoreArrayRead(x, &cxarr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(y, &yarr); CHKERRQ(ierr);
+	std::cout << " Max product entry " << ymax << ", max difference " << ydiff << std::endl;
+	TASSERT(ymax > 0);
+	TASSERT(ydiff <= 1e-13*ymax);
+
+	ierr = test_level_scheduled_preconditioners(m, bmat);
+	if(ierr) return ierr;
+	ierr = test_line_preconditioner(m, bmat);
+	if(ierr) return ierr;
+	ierr = test_async_preconditioners(m, bmat);
+	if(ierr) return ierr;
+	ierr = test_incremental_preconditioners(m, bmat);
+	if(ierr) return ierr;
+	ierr = test_single_precision_preconditioners(m, bmat);
+	if(ierr) return ierr;
+
+	// solves; the right hand side is y = A x
+	for(std::string solvertype : {"GMRES", "FGMRES", "GCRODR", "BICGSTAB"})
+		for(std::string prectype : {"NONE", "JACOBI", "ILU0", "SGS", "LINE", "ASYNCILU0",
+				"ASYNCSGS"})
+		{
+			// with several threads, asynchronous preconditioners are not fixed linear operators,
+			// so they need a flexible solver
+			if(prectype.compare(0,5,"ASYNC") == 0 && solvertype != "FGMRES")
+				continue;
+			const BlockSolverConfig bconf {solvertype, prectype, 30, 1e-8, 1e-50, 2000, 2, 2, 0.0, 1.0,
+				false, 10};
+			BlockPreconditioner<NVARS> *const prec = create_blockpreconditioner<NVARS>(prectype, &m,
+					bconf.nbuildsweeps, bconf.napplysweeps, bconf.refreshtol, bconf.lineanisotropy);
+			BlockKrylovSolver<NVARS> *const solver = create_blocksolver<NVARS>(bconf, m.gnelem());
+			TASSERT(prec && solver);
+			ierr = prec->compute(bmat); CHKERRQ(ierr);
+			solver->setOperators(&bmat, prec);
+
+			ierr = VecGetArrayRead(y, &yarr); CHKERRQ(ierr);
+			ierr = VecGetArray(x, &xarr); CHKERRQ(ierr);
+			const int iters = solver->solve(yarr, xarr);
+			ierr = VecRestoreArrayRead(y, &yarr); CHKERRQ(ierr);
+			ierr = VecRestoreArray(x, &xarr); CHKERRQ(ierr);
+
+			ierr = MatMult(A, x, r); CHKERRQ(ierr);
+			ierr = VecAYPX(r, -1.0, y); CHKERRQ(ierr);
+			a_real resnorm, bnorm;
+			ierr = VecNorm(r, NORM_2, &resnorm); CHKERRQ(ierr);
+			ierr = VecNorm(y, NORM_2, &bnorm); CHKERRQ(ierr);
+			std::cout << "  " << solvertype << " with " << prectype << ": iterations " << iters
+				<< ", relative residual " << resnorm/bnorm 
+				<< ", estimated " << solver->residualNorm()/bnorm << std::endl;
+
+			TASSERT(iters < bconf.maxiter);
+			TASSERT(resnorm <= 2e-8*bnorm);
+			TASSERT(std::fabs(resnorm - solver->residualNorm()) <= 1e-8*bnorm);
+
+			delete solver;
+			delete prec;
+		}
+
+	ierr = test_native_shellpc(m, A, y, x, r);
+	if(ierr) return ierr;
+	ierr = test_krylov_recycling(m, fv, u, bmat, dtm, cfl);
+	if(ierr) return ierr;
+
+	ierr = MatDestroy(&A); CHKERRQ(ierr);
+	ierr = VecDestroy(&u); CHKERRQ(ierr);
+	ierr = VecDestroy(&r); CHKERRQ(ierr);
+	ierr = VecDestroy(&x); CHKERRQ(ierr);
+	ierr = VecDestroy(&y); CHKERRQ(ierr);
+	return 0;
+}
+
 /** The first command line argument is the control file.
  * The second is a string that decides which test to perform.
  * Currently avaiable:
  * - 'wall_boundaries': Tests whether certain components of the numerical inviscid flux
  *     are zero for the 3 types of solid walls - adiabatic, isothermal and slip.
+ * - 'residual_engines': Tests whether the face-based and cell-based assembly of the residual
+ *     give the same result.
+ * - 'flux_batch': Tests whether batched inviscid fluxes agree with those computed per face.
+ * - 'cell_limiters': Tests whether face values computed from the limiter factors of each cell
+ *     agree with those computed by the reconstruction named in the third argument.
+ * - 'static_dispatch': Tests whether residuals specialized for particular numerical schemes
+ *     agree with the residual computed through virtual functions.
+ * - 'jacobian_blocks': Tests whether the Jacobian assembled directly into block storage agrees
+ *     with the Jacobian assembled entry-wise.
+ * - 'residual_and_jacobian': Tests whether the residual and Jacobian computed together agree
+ *     with those computed separately.
+ * - 'exact_jacobian': Tests whether the exact Jacobian assembled from coloured products agrees
+ *     with exact Jacobian-vector products.
+ * - 'difference_jacobian': Tests whether the Jacobian assembled from coloured finite differences
+ *     agrees with central differences of the residual.
+ * - 'native_solvers': Tests products with the native block sparse matrix and solves with the
+ *     native Krylov solvers.
+ * - 'agglomeration': Tests agglomerated coarse meshes and the first-order residual on them,
+ *     on the mesh of the control file and on any further mesh files given as arguments.
  */
 int main(int argc, char *argv[])
 {
@@ -66,6 +1585,97 @@ int main(int argc, char *argv[])
 		finerr = finerr || err;
 	}
 
+	if(testchoice == "residual_engines")
+	{
+		int err = test_residual_engines(m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "flux_batch")
+	{
+		int err = test_flux_batch(pconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "cell_limiters")
+	{
+		if(argc < 4) {
+			std::cerr << "Not enough command-line arguments!\n";
+			return -2;
+		}
+		nconf.reconstruction = argv[3];
+		TestFlowFV testfv(&m, pconf, nconf);
+		int err = testfv.testCellLimiters();
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "static_dispatch")
+	{
+		int err = test_static_dispatch(m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "jacobian_blocks")
+	{
+		int err = test_jacobian_blocks(m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "residual_and_jacobian")
+	{
+		int err = test_residual_and_jacobian(m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "dual_jacobian_vector_product")
+	{
+		int err = test_dual_jacobian_vector_product(m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "frozen_reconstruction")
+	{
+		int err = test_frozen_reconstruction(m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "exact_jacobian")
+	{
+		int err = test_exact_jacobian(m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "difference_jacobian")
+	{
+		int err = test_difference_jacobian(m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "native_solvers")
+	{
+		int err = test_native_solvers(m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "agglomeration")
+	{
+		int err = test_agglomeration(m, pconf, nconf);
+		finerr = finerr || err;
+
+		// further meshes, such as refinements of one another, may be given after the test name
+		for(int iarg = 3; iarg < argc; iarg++)
+		{
+			std::cout << " Mesh " << argv[iarg] << std::endl;
+			UMesh2dh mref;
+			mref.readMesh(argv[iarg]);
+			mref.compute_topological();
+			mref.compute_areas();
+			mref.compute_face_data();
+			err = test_agglomeration(mref, pconf, nconf);
+			finerr = finerr || err;
+		}
+	}
+
 	ierr = PetscFinalize(); CHKERRQ(ierr);
 	return finerr;
 }
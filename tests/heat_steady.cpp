@@ -84,6 +84,16 @@ int main(int argc, char* argv[])
 
 	std::vector<double> lh(nmesh), lerrors(nmesh), slopes(nmesh-1);
 
+	/* With Anderson acceleration, the coarsest mesh is solved again without it, and the
+	 * accelerated solve must need fewer time steps. With depth 5 it needs well under half
+	 * as many for both the explicit and the implicit cases, so the check has a wide margin.
+	 */
+	char andersondepth[PETSCOPTION_STR_LEN];
+	PetscBool anderson = PETSC_FALSE;
+	ierr = PetscOptionsGetString(NULL, NULL, "-anderson_depth", andersondepth,
+			PETSCOPTION_STR_LEN, &anderson); CHKERRQ(ierr);
+	bool andersonpassed = true;
+
 	for(int imesh = 0; imesh < nmesh; imesh++) {
 		
 		std::string meshfile = meshprefix + std::to_string(imesh) + ".msh";
@@ -180,6 +190,31 @@ int main(int argc, char* argv[])
 			ierr = time->solve(u); CHKERRQ(ierr);
 		}
 
+		if(anderson && imesh == 0)
+		{
+			const int accsteps = time->getTimingData().num_timesteps;
+
+			ierr = PetscOptionsClearValue(NULL, "-anderson_depth"); CHKERRQ(ierr);
+			Vec v;
+			ierr = VecDuplicate(u, &v); CHKERRQ(ierr);
+			prob->initializeUnknowns(v);
+			SteadySolver<1> *plaintime = nullptr;
+			if(timesteptype == "IMPLICIT")
+				plaintime = new SteadyBackwardEulerSolver<1>(prob, tconf, ksp);
+			else
+				plaintime = new SteadyForwardEulerSolver<1>(prob, v, tconf);
+			ierr = plaintime->solve(v); CHKERRQ(ierr);
+			const int plainsteps = plaintime->getTimingData().num_timesteps;
+			delete plaintime;
+			ierr = VecDestroy(&v); CHKERRQ(ierr);
+			ierr = PetscOptionsSetValue(NULL, "-anderson_depth", andersondepth); CHKERRQ(ierr);
+
+			std::cout << " Time steps with Anderson acceleration " << accsteps
+				<< ", without " << plainsteps << std::endl;
+			if(accsteps >= plainsteps)
+				andersonpassed = false;
+		}
+
 		// postprocess
 
 		const a_real *uarr;
@@ -232,6 +267,9 @@ int main(int argc, char* argv[])
 		else
 			throw "Order not correct!";
 	}
+
+	if(!andersonpassed)
+		throw "Anderson acceleration did not reduce the number of time steps!";
 	
 	cout << "\n--------------- End --------------------- \n\n";
 	ierr = PetscFinalize(); CHKERRQ(ierr);
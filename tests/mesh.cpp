@@ -118,6 +118,151 @@ int test_levelscheduling_internalconsistency(const UMesh2dh& m)
 	return 0;
 }
 
+/// Checks that each cell is in exactly one level, and that the neighbours of a cell numbered
+/// before it are in earlier levels while those numbered after it are in later levels
+int test_triangular_levelscheduling(const UMesh2dh& m)
+{
+	std::vector<a_int> levelptr, cells;
+	triangularLevelSchedule(m, levelptr, cells);
+	const a_int nlevels = static_cast<a_int>(levelptr.size())-1;
+	TASSERT(nlevels > 0);
+	TASSERT(levelptr[0] == 0);
+	TASSERT(levelptr[nlevels] == m.gnelem());
+	std::cout << " Number of levels = " << nlevels << " for " << m.gnelem() << " cells\n";
+
+	std::vector<a_int> celllevel(m.gnelem(), -1);
+	for(a_int ilevel = 0; ilevel < nlevels; ilevel++)
+		for(a_int ic = levelptr[ilevel]; ic < levelptr[ilevel+1]; ic++) {
+			TASSERT(celllevel[cells[ic]] == -1);
+			celllevel[cells[ic]] = ilevel;
+			if(ic > levelptr[ilevel]) {
+				TASSERT(cells[ic] > cells[ic-1]);
+			}
+		}
+
+	for(a_int icell = 0; icell < m.gnelem(); icell++) {
+		TASSERT(celllevel[icell] >= 0);
+		for(int iface = 0; iface < m.gnfael(icell); iface++) {
+			const a_int other = m.gesuel(icell,iface);
+			if(other >= m.gnelem())
+				continue;
+			if(other < icell) {
+				TASSERT(celllevel[other] < celllevel[icell]);
+			}
+			else {
+				TASSERT(celllevel[other] > celllevel[icell]);
+			}
+		}
+	}
+	return 0;
+}
+
+/// Checks that each cell is in exactly one implicit line and that consecutive cells in a line are
+/// neighbours, and that no lines of more than one cell are made if the anisotropy is too high
+int test_implicit_lines(UMesh2dh& m)
+{
+	m.compute_areas();
+	m.compute_face_data();
+	for(const a_real anisotropy : {1.0, 4.0, 1e10})
+	{
+		std::vector<a_int> lineptr, cells;
+		implicitLines(m, anisotropy, lineptr, cells);
+		const a_int nlines = static_cast<a_int>(lineptr.size())-1;
+		TASSERT(lineptr[0] == 0);
+		TASSERT(lineptr[nlines] == m.gnelem());
+		std::cout << " Anisotropy " << anisotropy << ": " << nlines << " lines for " 
+			<< m.gnelem() << " cells\n";
+
+		std::vector<int> visited(m.gnelem(), 0);
+		for(a_int iline = 0; iline < nlines; iline++)
+		{
+			TASSERT(lineptr[iline+1] > lineptr[iline]);
+			if(anisotropy > 1e9) {
+				TASSERT(lineptr[iline+1] == lineptr[iline]+1);
+			}
+			for(a_int ic = lineptr[iline]; ic < lineptr[iline+1]; ic++)
+			{
+				TASSERT(!visited[cells[ic]]);
+				visited[cells[ic]] = 1;
+				if(ic > lineptr[iline]) {
+					bool isneighbour = false;
+					for(int iface = 0; iface < m.gnfael(cells[ic]); iface++)
+						if(m.gesuel(cells[ic],iface) == cells[ic-1])
+							isneighbour = true;
+					TASSERT(isneighbour);
+				}
+			}
+		}
+
+		if(anisotropy == 1.0) {
+			TASSERT(nlines < m.gnelem()/2);
+		}
+	}
+	return 0;
+}
+
+/// Checks that every face has exactly one colour and that faces of a colour share no cell
+int test_face_colouring(const UMesh2dh& m)
+{
+	TASSERT(m.gnfacecolours() > 0);
+	TASSERT(m.gfacecolour_p(0) == 0);
+	TASSERT(m.gfacecolour_p(m.gnfacecolours()) == m.gnaface());
+
+	std::vector<int> facevisited(m.gnaface(), 0);
+	for(int icolour = 0; icolour < m.gnfacecolours(); icolour++)
+	{
+		std::vector<int> cellvisited(m.gnelem(), 0);
+		for(a_int ifc = m.gfacecolour_p(icolour); ifc < m.gfacecolour_p(icolour+1); ifc++)
+		{
+			const a_int iface = m.gfacecolour(ifc);
+			TASSERT(iface >= 0 && iface < m.gnaface());
+			facevisited[iface]++;
+
+			for(int iside = 0; iside < 2; iside++) {
+				const a_int iel = m.gintfac(iface,iside);
+				if(iel >= m.gnelem())
+					continue;
+				TASSERT(!cellvisited[iel]);
+				cellvisited[iel] = 1;
+			}
+		}
+	}
+
+	for(a_int iface = 0; iface < m.gnaface(); iface++)
+		TASSERT(facevisited[iface] == 1);
+
+	return 0;
+}
+
+/// Checks that the cell-to-face map lists exactly the faces of each cell with the correct sign
+int test_cell_face_map(const UMesh2dh& m)
+{
+	TASSERT(m.gcellface_p(0) == 0);
+	std::vector<int> facecount(m.gnaface(), 0);
+	for(a_int iel = 0; iel < m.gnelem(); iel++)
+	{
+		TASSERT(m.gcellface_p(iel+1)-m.gcellface_p(iel) == m.gnfael(iel));
+		for(a_int icf = m.gcellface_p(iel); icf < m.gcellface_p(iel+1); icf++)
+		{
+			const a_int iface = m.gcellface(icf);
+			TASSERT(iface >= 0 && iface < m.gnaface());
+			facecount[iface]++;
+			if(m.gcellfacesign(icf) > 0) {
+				TASSERT(m.gintfac(iface,0) == iel);
+			}
+			else {
+				TASSERT(m.gcellfacesign(icf) == -1);
+				TASSERT(m.gintfac(iface,1) == iel);
+			}
+		}
+	}
+
+	// boundary faces belong to one cell, interior faces to two
+	for(a_int iface = 0; iface < m.gnaface(); iface++)
+		TASSERT(facecount[iface] == (iface < m.gnbface() ? 1 : 2));
+	return 0;
+}
+
 int main(int argc, char *argv[])
 {
 	if(argc < 3) {
@@ -149,6 +294,18 @@ int main(int argc, char *argv[])
 	else if(whichtest == "levelscheduleInternal") {
 		err = test_levelscheduling_internalconsistency(m);
 	}
+	else if(whichtest == "levelscheduleTriangular") {
+		err = test_triangular_levelscheduling(m);
+	}
+	else if(whichtest == "implicitlines") {
+		err = test_implicit_lines(m);
+	}
+	else if(whichtest == "facecolouring") {
+		err = test_face_colouring(m);
+	}
+	else if(whichtest == "cellfacemap") {
+		err = test_cell_face_map(m);
+	}
 	else
 		throw "Invalid test";
 
@@ -0,0 +1,137 @@
+/** \file residual_allocations.cpp
+ * \brief Checks that computing the residual and Jacobian-vector products does not
+ *   allocate memory
+ *
+ * This is a separate executable because it replaces the global operator new,
+ * which would otherwise count allocations made by every other test.
+ */
+
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../src/autilities.hpp"
+#include "testflowspatial.hpp"
+#include "test.hpp"
+
+using namespace acfd;
+
+/// Number of calls to the global operator new
+static std::atomic<long> numallocs {0};
+
+void *operator new(std::size_t size)
+{
+	numallocs++;
+	void *const ptr = std::malloc(size > 0 ? size : 1);
+	if(!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+/// Checks that evaluating the residual does not allocate memory after the first evaluation
+/** Two workspaces are set up first, since two concurrent callers need one each; whether the
+ * callers actually overlap depends on timing. The residual is then computed once by each
+ * caller, after which neither serial nor concurrent evaluations should allocate.
+ * Likewise, Jacobian-vector products should not allocate after the first one.
+ */
+int test_residual_allocations(const UMesh2dh& m, const FlowPhysicsConfig& pconf,
+		FlowNumericsConfig nconf)
+{
+	for(std::string engine : {"FACECOLOURING", "CELLGATHER"})
+	{
+		nconf.residual_engine = engine;
+		const TestFlowFV fv(&m, pconf, nconf);
+
+		Vec u, r[2];
+		int ierr = VecCreateSeq(PETSC_COMM_SELF, m.gnelem()*NVARS, &u); CHKERRQ(ierr);
+		ierr = VecDuplicate(u, &r[0]); CHKERRQ(ierr);
+		ierr = VecDuplicate(u, &r[1]); CHKERRQ(ierr);
+		ierr = fv.initializeUnknowns(u); CHKERRQ(ierr);
+		std::vector<a_real> dtm[2] = {std::vector<a_real>(m.gnelem()), 
+			std::vector<a_real>(m.gnelem())};
+
+		fv.reserveWorkspaces(2);
+
+		int errs = 0;
+		long concurrentallocs = 0;
+		for(int irun = 0; irun < 2; irun++)
+		{
+			const long startallocs = numallocs;
+#pragma omp parallel num_threads(2) default(shared) reduction(+:errs)
+			{
+#ifdef _OPENMP
+				const int ithread = omp_get_thread_num();
+#else
+				const int ithread = 0;
+#endif
+				errs += fv.compute_residual(u, r[ithread], true, dtm[ithread]);
+			}
+			concurrentallocs = numallocs - startallocs;
+		}
+		TASSERT(errs == 0);
+		std::cout << " " << engine << ": allocations in concurrent residual evaluations: " 
+			<< concurrentallocs << std::endl;
+
+		const long startallocs = numallocs;
+		ierr = fv.compute_residual(u, r[0], true, dtm[0]); CHKERRQ(ierr);
+		ierr = fv.compute_residual(u, r[0], false, dtm[0]); CHKERRQ(ierr);
+		const long serialallocs = numallocs - startallocs;
+		std::cout << " " << engine << ": allocations in serial residual evaluations: " 
+			<< serialallocs << std::endl;
+
+		TASSERT(concurrentallocs == 0);
+		TASSERT(serialallocs == 0);
+
+		// the first product creates the dual states in the workspace
+		ierr = fv.compute_jacobian_vector_product(u, r[1], r[0]); CHKERRQ(ierr);
+		const long startprodallocs = numallocs;
+		ierr = fv.compute_jacobian_vector_product(u, r[1], r[0]); CHKERRQ(ierr);
+		ierr = fv.compute_jacobian_vector_product(u, r[0], r[1]); CHKERRQ(ierr);
+		const long prodallocs = numallocs - startprodallocs;
+		std::cout << " " << engine << ": allocations in Jacobian-vector products: " 
+			<< prodallocs << std::endl;
+		TASSERT(prodallocs == 0);
+
+		ierr = VecDestroy(&u); CHKERRQ(ierr);
+		ierr = VecDestroy(&r[0]); CHKERRQ(ierr);
+		ierr = VecDestroy(&r[1]); CHKERRQ(ierr);
+	}
+	return 0;
+}
+
+/** The only command line argument is the control file.
+ */
+int main(int argc, char *argv[])
+{
+	if(argc < 2) {
+		std::cout << "Not enough command-line arguments!\n";
+		return -2;
+	}
+	
+	int ierr = PetscInitialize(&argc, &argv, NULL, NULL); CHKERRQ(ierr);
+	
+	const FlowParserOptions opts = parse_flow_controlfile(argc, argv);
+
+	UMesh2dh m;
+	m.readMesh(opts.meshfile);
+	m.compute_topological();
+	m.compute_areas();
+	m.compute_face_data();
+		
+	const FlowPhysicsConfig pconf = extract_spatial_physics_config(opts);
+	const FlowNumericsConfig nconf = extract_spatial_numerics_config(opts);
+
+	const int finerr = test_residual_allocations(m, pconf, nconf);
+
+	ierr = PetscFinalize(); CHKERRQ(ierr);
+	return finerr;
+}
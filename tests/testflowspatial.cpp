@@ -4,6 +4,8 @@
  * \date 2017-10
  */
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 #include "testflowspatial.hpp"
 
 #define FLUX_TOL 10*ZERO_TOL
@@ -68,6 +70,85 @@ int TestFlowFV::testWalls(const a_real *const u) const
 	return ierr;
 }
 
+int TestFlowFV::testCellLimiters() const
+{
+	if(!lim->has_cell_limiters()) {
+		std::cerr << "! Reconstruction is not limited by one factor per cell!\n";
+		return 1;
+	}
+
+	// a smooth but non-linear field, so that limiters are active somewhere
+	auto field = [](const a_real x, const a_real y, const int ivar) {
+		return 1.0 + ivar + 0.5*std::sin(3.0*x+ivar)*std::cos(2.0*y);
+	};
+	MVector up(m->gnelem(), NVARS);
+	amat::Array2d<a_real> ug(m->gnbface(), NVARS);
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			up(iel,ivar) = field(rc(iel,0), rc(iel,1), ivar);
+	for(a_int ied = 0; ied < m->gnbface(); ied++)
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			ug(ied,ivar) = field(rc(m->gnelem()+ied,0), rc(m->gnelem()+ied,1), ivar);
+
+	std::vector<FArray<NDIM,NVARS>,aligned_allocator<FArray<NDIM,NVARS>>> grads(m->gnelem());
+	gradcomp->compute_gradients(up, ug, grads);
+
+	amat::Array2d<a_real> ufl(m->gnaface(), NVARS), ufr(m->gnaface(), NVARS);
+	lim->compute_face_values(up, ug, grads, ufl, ufr);
+	amat::Array2d<a_real> phi(m->gnelem(), NVARS);
+	lim->compute_limiters(up, ug, grads, phi);
+
+	auto extrapolate = [&](const a_int ied, const a_int iel, const int ivar) {
+		a_real uface = up(iel,ivar);
+		for(int idim = 0; idim < NDIM; idim++)
+			uface += phi(iel,ivar)*grads[iel](idim,ivar)*(gr[ied](0,idim) - rc(iel,idim));
+		return uface;
+	};
+
+	int ierr = 0;
+	a_real minphi = 1.0;
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		for(int ivar = 0; ivar < NVARS; ivar++) {
+			if(phi(iel,ivar) < 0 || phi(iel,ivar) > 1) {
+				ierr = 1;
+				std::cerr << "! Limiter factor out of range in cell " << iel << "!\n";
+			}
+			minphi = std::min(minphi, phi(iel,ivar));
+		}
+	std::cout << " Minimum limiter factor " << minphi << std::endl;
+
+	for(a_int ied = 0; ied < m->gnaface(); ied++)
+	{
+		const a_int lelem = m->gintfac(ied,0);
+		const a_int relem = m->gintfac(ied,1);
+		for(int ivar = 0; ivar < NVARS; ivar++)
+		{
+			if(std::fabs(extrapolate(ied,lelem,ivar) - ufl(ied,ivar)) > 1e-14*std::fabs(ufl(ied,ivar)))
+			{
+				ierr = 1;
+				std::cerr << "! Left face value mismatch at face " << ied << "!\n";
+			}
+			if(ied >= m->gnbface() && 
+				std::fabs(extrapolate(ied,relem,ivar) - ufr(ied,ivar)) > 1e-14*std::fabs(ufr(ied,ivar)))
+			{
+				ierr = 1;
+				std::cerr << "! Right face value mismatch at face " << ied << "!\n";
+			}
+		}
+	}
+
+	return ierr;
+}
+
+void TestFlowFV::reserveWorkspaces(const int nworkspaces) const
+{
+	std::vector<ResidualWorkspace*> ws(nworkspaces);
+	for(int i = 0; i < nworkspaces; i++)
+		ws[i] = acquireWorkspace();
+	for(int i = 0; i < nworkspaces; i++)
+		releaseWorkspace(ws[i]);
+}
+
 std::array<a_real,NVARS> get_test_state()
 {
 	const a_real p_nondim = 10.0;
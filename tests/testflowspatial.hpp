@@ -28,9 +28,20 @@ public:
 	 */
 	int testWalls(const a_real *const u) const;
 
+	/// Tests whether face values computed from the limiter factors of each cell agree with
+	/// those computed by the reconstruction
+	/** The reconstruction must be limited by one factor per cell.
+	 */
+	int testCellLimiters() const;
+
+	/// Makes sure that the pool holds at least the given number of residual workspaces
+	void reserveWorkspaces(const int nworkspaces) const;
+
 protected:
 	using FlowFV<true,false>::compute_boundary_state;
 	using FlowFV<true,false>::inviflux;
+	using FlowFV<true,false>::gradcomp;
+	using FlowFV<true,false>::lim;
 };
 
 /// Returns a state vector in conserved variables that can be used in testing